@@ -0,0 +1,2611 @@
+/*
+ * s730b_bench.c
+ *
+ * - 센서 없이 sample/ 밑의 .raw 캡처 파일로 이미지 처리 단계 속도/효과 재보는 오프라인 도구
+ * - 사용법: ./s730b_bench <command> [raw파일...]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "s730b_caplog.h"
+#include "s730b_codec.h"
+#include "s730b_detect.h"
+#include "s730b_enhance.h"
+#include "s730b_enroll.h"
+#include "s730b_frame.h"
+#include "s730b_fusion.h"
+#include "s730b_gallery.h"
+#include "s730b_ident.h"
+#include "s730b_integrity.h"
+#include "s730b_match.h"
+#include "s730b_metrics.h"
+#include "s730b_minutiae.h"
+#include "s730b_pool.h"
+#include "s730b_png.h"
+#include "s730b_prefilter.h"
+#include "s730b_proto.h"
+#include "s730b_quality.h"
+#include "s730b_session.h"
+#include "s730b_sim.h"
+#include "s730b_texture.h"
+
+#define BENCH_ITERS 20000
+#define BULK_CHUNK  256     // USB bulk IN chunk 크기
+
+static unsigned char *load_raw(const char *path, int *out_len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "[-] %s 열기 실패\n", path);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(f);
+        return NULL;
+    }
+
+    unsigned char *buf = malloc(size);
+    if (!buf || fread(buf, 1, size, f) != (size_t)size) {
+        fprintf(stderr, "[-] %s 읽기 실패\n", path);
+        free(buf);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+
+    *out_len = (int)size;
+    return buf;
+}
+
+// raw 파일에서 offset 180 / 112x96 프레임만 복사
+static int load_frame(const char *path, unsigned char *img) {
+    int len = 0;
+    unsigned char *raw = load_raw(path, &len);
+    if (!raw)
+        return -1;
+    if (len < IMG_OFFSET + IMG_SIZE) {
+        fprintf(stderr, "[-] %s: RAW 길이가 너무 짧음 (len=%d)\n", path, len);
+        free(raw);
+        return -1;
+    }
+    memcpy(img, raw + IMG_OFFSET, IMG_SIZE);
+    free(raw);
+    return 0;
+}
+
+static int bench_destripe(int argc, char **argv) {
+    unsigned char img[IMG_SIZE];
+    unsigned char work[IMG_SIZE];
+
+    for (int i = 0; i < argc; i++) {
+        if (load_frame(argv[i], img) < 0)
+            return 1;
+
+        double c0 = s730b_ridge_contrast(img, IMG_WIDTH, IMG_HEIGHT);
+        double s0 = s730b_stripe_energy(img, IMG_WIDTH, IMG_HEIGHT);
+
+        memcpy(work, img, IMG_SIZE);
+        s730b_destripe(work, IMG_WIDTH, IMG_HEIGHT);
+        double c1 = s730b_ridge_contrast(work, IMG_WIDTH, IMG_HEIGHT);
+        double s1 = s730b_stripe_energy(work, IMG_WIDTH, IMG_HEIGHT);
+
+        uint64_t t0 = s730b_now_ns();
+        for (int k = 0; k < BENCH_ITERS; k++) {
+            memcpy(work, img, IMG_SIZE);
+            s730b_destripe(work, IMG_WIDTH, IMG_HEIGHT);
+        }
+        uint64_t t1 = s730b_now_ns();
+        for (int k = 0; k < BENCH_ITERS; k++) {
+            memcpy(work, img, IMG_SIZE);
+            __asm__ volatile("" : : "r"(work) : "memory");
+        }
+        uint64_t t2 = s730b_now_ns();
+
+        double ns = ((double)(t1 - t0) - (double)(t2 - t1)) / BENCH_ITERS;
+        printf("[+] %s\n", argv[i]);
+        printf("    ridge contrast : %6.2f -> %6.2f\n", c0, c1);
+        printf("    stripe energy  : %6.2f -> %6.2f\n", s0, s1);
+        printf("    ridge/stripe   : %6.2f -> %6.2f\n",
+               s0 > 0 ? c0 / s0 : 0.0, s1 > 0 ? c1 / s1 : 0.0);
+        printf("    destripe       : %.2f us/frame\n", ns / 1000.0);
+    }
+    return 0;
+}
+
+static int bench_quality(int argc, char **argv) {
+    unsigned char img[IMG_SIZE];
+
+    for (int i = 0; i < argc; i++) {
+        struct s730b_quality q;
+
+        if (load_frame(argv[i], img) < 0)
+            return 1;
+
+        uint64_t t0 = s730b_now_ns();
+        for (int k = 0; k < BENCH_ITERS; k++) {
+            s730b_frame_quality(img, IMG_WIDTH, IMG_HEIGHT, &q);
+            __asm__ volatile("" : : "r"(&q) : "memory");
+        }
+        uint64_t t1 = s730b_now_ns();
+
+        printf("[+] %s\n", argv[i]);
+        printf("    coverage=%.2f contrast=%.1f coherence=%.2f score=%d (%s)\n",
+               q.coverage, q.contrast, q.coherence, q.score,
+               q.score >= QUALITY_MIN_SCORE ? "OK" : "재캡처");
+        printf("    quality        : %.2f us/frame\n", (double)(t1 - t0) / BENCH_ITERS / 1000.0);
+    }
+    return 0;
+}
+
+/*
+ * burst 흉내: 깨끗한 프레임을 sub-pixel로 밀고 노이즈 섞어서 K장 만듦
+ * - img(x + dx, y + dy) = clean(x, y) 가 되게 생성 -> 정합 결과가 (dx, dy)로 나와야 정답
+ */
+static uint32_t bench_rng = 0x730b;
+
+static int bench_noise(int amp) {
+    bench_rng = bench_rng * 1103515245u + 12345u;
+    return (int)((bench_rng >> 16) % (2 * amp + 1)) - amp;
+}
+
+static void synth_shifted(const unsigned char *clean, unsigned char *dst, float dx, float dy, int noise) {
+    for (int y = 0; y < IMG_HEIGHT; y++) {
+        for (int x = 0; x < IMG_WIDTH; x++) {
+            float sx = x - dx, sy = y - dy;
+            sx = sx < 0 ? 0 : (sx > IMG_WIDTH - 1.001f ? IMG_WIDTH - 1.001f : sx);
+            sy = sy < 0 ? 0 : (sy > IMG_HEIGHT - 1.001f ? IMG_HEIGHT - 1.001f : sy);
+            int x0 = (int)sx, y0 = (int)sy;
+            float fx = sx - x0, fy = sy - y0;
+            const unsigned char *p = clean + y0 * IMG_WIDTH + x0;
+            float v = (p[0] * (1 - fx) + p[1] * fx) * (1 - fy) +
+                      (p[IMG_WIDTH] * (1 - fx) + p[IMG_WIDTH + 1] * fx) * fy;
+            int iv = (int)(v + 0.5f) + bench_noise(noise);
+            dst[y * IMG_WIDTH + x] = iv < 0 ? 0 : (iv > 255 ? 255 : iv);
+        }
+    }
+}
+
+static double psnr_center(const unsigned char *a, const unsigned char *b, int w, int h, int margin) {
+    double se = 0.0;
+    int n = 0;
+    for (int y = margin; y < h - margin; y++) {
+        for (int x = margin; x < w - margin; x++) {
+            double d = (double)a[y * w + x] - b[y * w + x];
+            se += d * d;
+            n++;
+        }
+    }
+    return se > 0 ? 10.0 * log10(255.0 * 255.0 / (se / n)) : 99.0;
+}
+
+static int bench_fuse(int argc, char **argv) {
+    static const float burst_shift[FUSION_MAX_FRAMES][2] = {
+        { 0.0f, 0.0f }, { 0.5f, 0.25f }, { -0.75f, 0.5f }, { 1.25f, -0.5f },
+        { -0.25f, -1.0f }, { 2.0f, 0.75f }, { 0.25f, 1.5f }, { -1.5f, -0.25f },
+    };
+    const int W = IMG_WIDTH * FUSION_SCALE, H = IMG_HEIGHT * FUSION_SCALE;
+    const int noise = 24;
+    unsigned char clean[IMG_SIZE];
+    unsigned char burst[FUSION_MAX_FRAMES][IMG_SIZE];
+    const unsigned char *frames[FUSION_MAX_FRAMES];
+    struct s730b_shift shifts[FUSION_MAX_FRAMES];
+    unsigned char *truth = malloc((size_t)W * H);
+    unsigned char *single = malloc((size_t)W * H);
+    unsigned char *fused = malloc((size_t)W * H);
+
+    if (!truth || !single || !fused) {
+        free(truth); free(single); free(fused);
+        return 1;
+    }
+
+    for (int i = 0; i < argc; i++) {
+        if (load_frame(argv[i], clean) < 0)
+            break;
+
+        s730b_upscale2x(clean, IMG_WIDTH, IMG_HEIGHT, truth);
+        for (int k = 0; k < FUSION_MAX_FRAMES; k++) {
+            synth_shifted(clean, burst[k], burst_shift[k][0], burst_shift[k][1], noise);
+            frames[k] = burst[k];
+        }
+
+        s730b_upscale2x(burst[0], IMG_WIDTH, IMG_HEIGHT, single);
+        printf("[+] %s (noise +-%d)\n", argv[i], noise);
+        printf("    single 2x upscale : PSNR %.2f dB\n", psnr_center(truth, single, W, H, 16));
+
+        for (int n = 2; n <= FUSION_MAX_FRAMES; n *= 2) {
+            double err = 0.0;
+            shifts[0] = (struct s730b_shift){ 0.0f, 0.0f, 0 };
+
+            uint64_t t0 = s730b_now_ns();
+            for (int k = 1; k < n; k++) {
+                s730b_register_shift(burst[0], burst[k], IMG_WIDTH, IMG_HEIGHT, &shifts[k]);
+                err += hypot(shifts[k].dx - burst_shift[k][0], shifts[k].dy - burst_shift[k][1]);
+            }
+            uint64_t t1 = s730b_now_ns();
+            s730b_fuse_frames(frames, shifts, n, IMG_WIDTH, IMG_HEIGHT, fused);
+            uint64_t t2 = s730b_now_ns();
+
+            printf("    fuse K=%d          : PSNR %.2f dB, shift err %.2f px, register %.2f ms/frame, fuse %.2f ms\n",
+                   n, psnr_center(truth, fused, W, H, 16), err / (n - 1),
+                   (t1 - t0) / 1e6 / (n - 1), (t2 - t1) / 1e6);
+        }
+    }
+
+    free(truth);
+    free(single);
+    free(fused);
+    return 0;
+}
+
+static double bench_gabor_one(const struct s730b_gabor_bank *bank, const unsigned char *img, int w, int h,
+                              unsigned char *out, struct s730b_pool *pool, int iters) {
+    uint64_t t0 = s730b_now_ns();
+    for (int k = 0; k < iters; k++)
+        s730b_gabor_enhance(bank, img, w, h, out, pool);
+    return (double)(s730b_now_ns() - t0) / iters / 1e6;
+}
+
+static int bench_gabor(int argc, char **argv) {
+    const int W = IMG_WIDTH * FUSION_SCALE, H = IMG_HEIGHT * FUSION_SCALE;
+    const int iters = 200;
+    static struct s730b_gabor_bank bank1, bank2;
+    struct s730b_pool pool;
+    unsigned char img[IMG_SIZE], enh[IMG_SIZE];
+    unsigned char *up = malloc((size_t)W * H), *enh2 = malloc((size_t)W * H);
+
+    if (!up || !enh2) {
+        free(up);
+        free(enh2);
+        return 1;
+    }
+
+    uint64_t t0 = s730b_now_ns();
+    s730b_gabor_bank_init(&bank1, ENH_PERIOD_NATIVE);
+    s730b_gabor_bank_init(&bank2, ENH_PERIOD_NATIVE * FUSION_SCALE);
+    uint64_t t1 = s730b_now_ns();
+    int nthreads = s730b_pool_init(&pool, 0);
+
+    printf("[*] filter bank: %d orients, %dx%d / %dx%d taps, init %.2fms, pool %d threads\n",
+           ENH_ORIENTS, bank1.ksize, bank1.ksize, bank2.ksize, bank2.ksize, (t1 - t0) / 1e6, nthreads);
+
+    for (int i = 0; i < argc; i++) {
+        struct s730b_quality q0, q1;
+
+        if (load_frame(argv[i], img) < 0)
+            break;
+        s730b_destripe(img, IMG_WIDTH, IMG_HEIGHT);
+        s730b_upscale2x(img, IMG_WIDTH, IMG_HEIGHT, up);
+
+        s730b_gabor_enhance(&bank1, img, IMG_WIDTH, IMG_HEIGHT, enh, NULL);
+        s730b_frame_quality(img, IMG_WIDTH, IMG_HEIGHT, &q0);
+        s730b_frame_quality(enh, IMG_WIDTH, IMG_HEIGHT, &q1);
+
+        printf("[+] %s\n", argv[i]);
+        printf("    contrast %.1f -> %.1f, coherence %.2f -> %.2f\n",
+               q0.contrast, q1.contrast, q0.coherence, q1.coherence);
+        printf("    112x96  : %.3f ms/frame (1 thread), %.3f ms/frame (pool)\n",
+               bench_gabor_one(&bank1, img, IMG_WIDTH, IMG_HEIGHT, enh, NULL, iters),
+               bench_gabor_one(&bank1, img, IMG_WIDTH, IMG_HEIGHT, enh, &pool, iters));
+        printf("    224x192 : %.3f ms/frame (1 thread), %.3f ms/frame (pool)\n",
+               bench_gabor_one(&bank2, up, W, H, enh2, NULL, iters / 4),
+               bench_gabor_one(&bank2, up, W, H, enh2, &pool, iters / 4));
+    }
+
+    s730b_pool_destroy(&pool);
+    free(up);
+    free(enh2);
+    return 0;
+}
+
+static void minutiae_count(const struct s730b_minutiae *m, int *endings, int *bifurcations) {
+    *endings = *bifurcations = 0;
+    for (int i = 0; i < m->count; i++) {
+        if (m->type[i] == MINU_ENDING)
+            (*endings)++;
+        else
+            (*bifurcations)++;
+    }
+}
+
+/*
+ * destripe -> Gabor -> 특징점 추출, 단계별 시간
+ * - NBIS(mindtct)는 PGM 파일 쓰고 프로세스 띄우는 비용이 더 크니 여기선 in-process 숫자만 냄
+ *   (비교하려면 같은 capture_enhanced.pgm을 mindtct에 넣고 time으로 재면 됨)
+ */
+static int bench_minutiae(int argc, char **argv) {
+    const int W = IMG_WIDTH * FUSION_SCALE, H = IMG_HEIGHT * FUSION_SCALE;
+    const int iters = 200;
+    static struct s730b_gabor_bank bank1, bank2;
+    struct s730b_minutiae m;
+    unsigned char img[IMG_SIZE], enh[IMG_SIZE];
+    unsigned char *up = malloc((size_t)W * H), *enh2 = malloc((size_t)W * H);
+
+    if (!up || !enh2) {
+        free(up);
+        free(enh2);
+        return 1;
+    }
+
+    s730b_gabor_bank_init(&bank1, ENH_PERIOD_NATIVE);
+    s730b_gabor_bank_init(&bank2, ENH_PERIOD_NATIVE * FUSION_SCALE);
+
+    for (int i = 0; i < argc; i++) {
+        int ne, nb;
+
+        if (load_frame(argv[i], img) < 0)
+            break;
+        printf("[+] %s\n", argv[i]);
+
+        uint64_t t0 = s730b_now_ns();
+        for (int k = 0; k < iters; k++)
+            s730b_destripe(img, IMG_WIDTH, IMG_HEIGHT);
+        uint64_t t1 = s730b_now_ns();
+        for (int k = 0; k < iters; k++)
+            s730b_gabor_enhance(&bank1, img, IMG_WIDTH, IMG_HEIGHT, enh, NULL);
+        uint64_t t2 = s730b_now_ns();
+        for (int k = 0; k < iters; k++)
+            s730b_extract_minutiae(enh, IMG_WIDTH, IMG_HEIGHT, &m);
+        uint64_t t3 = s730b_now_ns();
+
+        minutiae_count(&m, &ne, &nb);
+        printf("    112x96  : %3d minutiae (%d endings, %d bifurcations)\n", m.count, ne, nb);
+        printf("              destripe %.3f + gabor %.3f + minutiae %.3f = %.3f ms/frame\n",
+               (t1 - t0) / 1e6 / iters, (t2 - t1) / 1e6 / iters, (t3 - t2) / 1e6 / iters,
+               (t3 - t0) / 1e6 / iters);
+
+        s730b_upscale2x(img, IMG_WIDTH, IMG_HEIGHT, up);
+        t0 = s730b_now_ns();
+        for (int k = 0; k < iters / 4; k++)
+            s730b_gabor_enhance(&bank2, up, W, H, enh2, NULL);
+        t1 = s730b_now_ns();
+        for (int k = 0; k < iters / 4; k++)
+            s730b_extract_minutiae(enh2, W, H, &m);
+        t2 = s730b_now_ns();
+
+        minutiae_count(&m, &ne, &nb);
+        printf("    224x192 : %3d minutiae (%d endings, %d bifurcations)\n", m.count, ne, nb);
+        printf("              gabor %.3f + minutiae %.3f ms/frame\n",
+               (t1 - t0) / 1e6 / (iters / 4), (t2 - t1) / 1e6 / (iters / 4));
+    }
+
+    free(up);
+    free(enh2);
+    return 0;
+}
+
+/*
+ * 같은 손가락 다른 터치 흉내: 중심 기준 회전 + 평행이동 + 노이즈
+ * - 센서 밖으로 나간 부분은 0 (신호없음)
+ */
+static void synth_impression(const unsigned char *clean, unsigned char *dst, float deg, float dx, float dy,
+                             int noise) {
+    const float c = cosf(deg * (float)M_PI / 180.0f), s = sinf(deg * (float)M_PI / 180.0f);
+    const float cx = (IMG_WIDTH - 1) * 0.5f, cy = (IMG_HEIGHT - 1) * 0.5f;
+
+    for (int y = 0; y < IMG_HEIGHT; y++) {
+        for (int x = 0; x < IMG_WIDTH; x++) {
+            float ux = x - cx - dx, uy = y - cy - dy;
+            float sx = c * ux + s * uy + cx, sy = -s * ux + c * uy + cy;
+            int x0 = (int)floorf(sx), y0 = (int)floorf(sy);
+            if (x0 < 0 || y0 < 0 || x0 >= IMG_WIDTH - 1 || y0 >= IMG_HEIGHT - 1) {
+                dst[y * IMG_WIDTH + x] = 0;
+                continue;
+            }
+            float fx = sx - x0, fy = sy - y0;
+            const unsigned char *p = clean + y0 * IMG_WIDTH + x0;
+            float v = (p[0] * (1 - fx) + p[1] * fx) * (1 - fy) +
+                      (p[IMG_WIDTH] * (1 - fx) + p[IMG_WIDTH + 1] * fx) * fy;
+            int iv = (int)(v + 0.5f) + bench_noise(noise);
+            dst[y * IMG_WIDTH + x] = iv < 1 ? 1 : (iv > 255 ? 255 : iv);
+        }
+    }
+}
+
+// 파일 이름에서 손가락 label: "dir/alice_03.raw" -> "alice", '_' 없으면 확장자 뺀 이름 전체
+static void finger_label(const char *path, char *out, size_t len) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    const char *end = strrchr(base, '_');
+    if (!end)
+        end = strrchr(base, '.');
+    if (!end)
+        end = base + strlen(base);
+
+    size_t n = (size_t)(end - base) < len - 1 ? (size_t)(end - base) : len - 1;
+    memcpy(out, base, n);
+    out[n] = '\0';
+}
+
+#define MATCH_SYNTH 6   // 파일 하나당 만드는 가짜 터치 수 (원본 포함 +1)
+
+struct bench_finger {
+    char label[64];
+    struct s730b_template t;
+};
+
+/*
+ * 1:1 매처 TAR/FAR + 초당 비교 횟수
+ * - 파일마다 원본 + 회전/이동/노이즈 섞은 가짜 터치 MATCH_SYNTH장을 템플릿으로 만듦
+ * - label(파일 이름 '_' 앞부분) 같으면 genuine, 다르면 impostor
+ * - 실제 캡처 세트 (alice_01.raw, alice_02.raw, bob_01.raw ...)를 그대로 넣어도 됨
+ */
+static int bench_match(int argc, char **argv) {
+    static struct s730b_gabor_bank bank;
+    const int per_file = MATCH_SYNTH + 1;
+    unsigned char clean[IMG_SIZE], img[IMG_SIZE], enh[IMG_SIZE];
+    struct s730b_minutiae m;
+
+    if (argc < 1)
+        return 1;
+
+    struct bench_finger *f = calloc((size_t)argc * per_file, sizeof(*f));
+    if (!f)
+        return 1;
+
+    s730b_gabor_bank_init(&bank, ENH_PERIOD_NATIVE);
+
+    int n = 0, fte = 0;
+    double minu_total = 0.0;
+    for (int i = 0; i < argc; i++) {
+        if (load_frame(argv[i], clean) < 0)
+            break;
+        s730b_destripe(clean, IMG_WIDTH, IMG_HEIGHT);
+
+        for (int k = 0; k < per_file; k++) {
+            if (k == 0)
+                memcpy(img, clean, IMG_SIZE);
+            else
+                synth_impression(clean, img, (float)bench_noise(15), (float)bench_noise(10),
+                                 (float)bench_noise(8), 12);
+
+            s730b_gabor_enhance(&bank, img, IMG_WIDTH, IMG_HEIGHT, enh, NULL);
+            s730b_extract_minutiae(enh, IMG_WIDTH, IMG_HEIGHT, &m);
+            if (m.count < MATCH_MIN_MINUTIAE) {
+                fte++;
+                continue;
+            }
+            finger_label(argv[i], f[n].label, sizeof(f[n].label));
+            s730b_template_build(&m, &f[n].t);
+            minu_total += m.count;
+            n++;
+        }
+    }
+    if (n < 2) {
+        free(f);
+        return 1;
+    }
+
+    // 점수 분포
+    int gen_hist[64] = {0}, imp_hist[64] = {0}, ngen = 0, nimp = 0;
+    for (int a = 0; a < n; a++) {
+        for (int b = a + 1; b < n; b++) {
+            int sc = s730b_match(&f[a].t, &f[b].t, 0);
+            sc = sc > 63 ? 63 : sc;
+            if (strcmp(f[a].label, f[b].label) == 0) {
+                gen_hist[sc]++;
+                ngen++;
+            } else {
+                imp_hist[sc]++;
+                nimp++;
+            }
+        }
+    }
+
+    printf("[*] %d templates (%d per file), %d rejected (< %d minutiae), minutiae %.1f/template\n",
+           n, per_file, fte, MATCH_MIN_MINUTIAE, minu_total / n);
+    printf("    genuine %d pairs, impostor %d pairs\n", ngen, nimp);
+    printf("    threshold   TAR      FAR\n");
+    int gen_ge = ngen, imp_ge = nimp;
+    for (int th = 1; th < 64; th++) {
+        gen_ge -= gen_hist[th - 1];
+        imp_ge -= imp_hist[th - 1];
+        if (!gen_ge && !imp_ge)
+            break;
+        printf("    %3d%s      %6.2f%%  %6.2f%%\n", th, th == MATCH_THRESHOLD ? "*" : " ",
+               ngen ? 100.0 * gen_ge / ngen : 0.0, nimp ? 100.0 * imp_ge / nimp : 0.0);
+    }
+
+    // 속도: 전체 쌍을 반복해서 0.5초 이상
+    for (int pass = 0; pass < 2; pass++) {
+        const int th = pass ? MATCH_THRESHOLD : 0;
+        uint64_t cmps = 0, t0 = s730b_now_ns(), t1;
+        volatile int sink = 0;
+        do {
+            for (int a = 0; a < n; a++)
+                for (int b = 0; b < n; b++)
+                    sink += s730b_match(&f[a].t, &f[b].t, th);
+            cmps += (uint64_t)n * n;
+            t1 = s730b_now_ns();
+        } while (t1 - t0 < 500000000ull);
+        (void)sink;
+        printf("    %-28s: %.0f comparisons/s (%.2f us/cmp)\n",
+               pass ? "early exit (threshold)" : "full score (threshold=0)",
+               cmps / ((t1 - t0) / 1e9), (t1 - t0) / 1e3 / cmps);
+    }
+
+    free(f);
+    return 0;
+}
+
+/*
+ * 특징점 좌표에서 바로 다른 터치 흉내 (영상 처리 안 거쳐서 큰 갤러리 빨리 만들기용)
+ * - 회전 +-20도, 이동 +-10px, 위치 +-1px / 방향 +-4 흔들기, 20% 빠짐
+ */
+static void perturb_minutiae(const struct s730b_minutiae *src, struct s730b_minutiae *dst) {
+    const float a = bench_noise(20) * (float)M_PI / 180.0f;
+    const float c = cosf(a), s = sinf(a);
+    const float cx = src->width * 0.5f, cy = src->height * 0.5f;
+    const float tx = (float)bench_noise(10), ty = (float)bench_noise(10);
+    const int rot = (int)lrintf(a * 128.0f / (float)M_PI);
+
+    memset(dst, 0, sizeof(*dst));
+    dst->width = src->width;
+    dst->height = src->height;
+    for (int i = 0; i < src->count; i++) {
+        if (bench_noise(50) < -30)
+            continue;
+        float x = src->x[i] - cx, y = src->y[i] - cy;
+        int nx = (int)lrintf(c * x - s * y + cx + tx) + bench_noise(1);
+        int ny = (int)lrintf(s * x + c * y + cy + ty) + bench_noise(1);
+        if (nx < 0 || ny < 0 || nx >= src->width || ny >= src->height)
+            continue;
+        int n = dst->count++;
+        dst->x[n] = (int16_t)nx;
+        dst->y[n] = (int16_t)ny;
+        dst->angle[n] = (uint8_t)(src->angle[i] + rot + bench_noise(4));
+        dst->type[n] = src->type[i];
+    }
+}
+
+// w x h 영역에 특징점 want개를 아무데나 (서로 5px 이상 떨어지게)
+static void random_minutiae_area(struct s730b_minutiae *m, int w, int h, int want) {
+    memset(m, 0, sizeof(*m));
+    m->width = w;
+    m->height = h;
+    for (int tries = 0; m->count < want && m->count < MINU_MAX && tries < 1000; tries++) {
+        int x = 8 + (int)((bench_noise(32767) + 32767) % (w - 16));
+        int y = 8 + (int)((bench_noise(32767) + 32767) % (h - 16));
+        int ok = 1;
+        for (int i = 0; i < m->count && ok; i++)
+            ok = (m->x[i] - x) * (m->x[i] - x) + (m->y[i] - y) * (m->y[i] - y) >= 25;
+        if (!ok)
+            continue;
+        int n = m->count++;
+        m->x[n] = (int16_t)x;
+        m->y[n] = (int16_t)y;
+        m->angle[n] = (uint8_t)bench_noise(128);
+        m->type[n] = bench_noise(1) > 0 ? MINU_BIFURCATION : MINU_ENDING;
+    }
+}
+
+// 다른 사람 흉내: 112x96에 특징점 8~16개
+static void random_minutiae(struct s730b_minutiae *m) {
+    random_minutiae_area(m, IMG_WIDTH, IMG_HEIGHT, 12 + bench_noise(4));
+}
+
+/*
+ * 1:N 식별 속도
+ * - 갤러리: 무작위 특징점 템플릿 N-1개 + 진짜(첫 sample 파일 특징점을 흔든 것) 1개를 아무 위치에
+ * - probe: 같은 파일 특징점을 다시 흔든 것 -> top-1이 진짜 위치면 정답
+ * - 스레드 1, 2, 4 .. nproc 개로 돌려서 comparisons/s/core 비교
+ * - 사용법: ident [-n 갤러리크기] raw파일
+ */
+static int bench_ident(int argc, char **argv) {
+    static struct s730b_gabor_bank bank;
+    unsigned char img[IMG_SIZE], enh[IMG_SIZE];
+    struct s730b_minutiae base, m;
+    int n = 5000;
+
+    if (argc >= 2 && strcmp(argv[0], "-n") == 0) {
+        n = atoi(argv[1]);
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 1 || n < 1 || load_frame(argv[0], img) < 0)
+        return 1;
+
+    s730b_gabor_bank_init(&bank, ENH_PERIOD_NATIVE);
+    s730b_destripe(img, IMG_WIDTH, IMG_HEIGHT);
+    s730b_gabor_enhance(&bank, img, IMG_WIDTH, IMG_HEIGHT, enh, NULL);
+    s730b_extract_minutiae(enh, IMG_WIDTH, IMG_HEIGHT, &base);
+    if (base.count < MATCH_MIN_MINUTIAE) {
+        fprintf(stderr, "[-] %s: 특징점 %d개라 못 씀\n", argv[0], base.count);
+        return 1;
+    }
+
+    struct s730b_template *gallery = malloc((size_t)n * sizeof(*gallery));
+    struct s730b_template *probe = malloc(sizeof(*probe));
+    if (!gallery || !probe) {
+        free(gallery);
+        free(probe);
+        return 1;
+    }
+
+    const int truth = (bench_noise(32767) + 32767) % n;
+    uint64_t t0 = s730b_now_ns();
+    for (int i = 0; i < n; i++) {
+        if (i == truth)
+            perturb_minutiae(&base, &m);
+        else
+            random_minutiae(&m);
+        s730b_template_build(&m, &gallery[i]);
+    }
+    perturb_minutiae(&base, &m);
+    s730b_template_build(&m, probe);
+    printf("[*] gallery %d templates (%.1f MB, build %.0f ms), true match at #%d, probe %d minutiae\n",
+           n, (double)n * sizeof(*gallery) / 1e6, (s730b_now_ns() - t0) / 1e6, truth, m.count);
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int threads = 1; threads <= (ncpu > 0 ? ncpu : 1); threads *= 2) {
+        struct s730b_pool pool;
+        s730b_pool_init(&pool, threads);
+
+        for (int pass = 0; pass < 2; pass++) {
+            struct s730b_ident_opts o = { .topk = 5, .threshold = MATCH_THRESHOLD, .accept = pass ? 12 : 0 };
+            struct s730b_ident_hit hits[IDENT_MAX_TOPK];
+            struct s730b_ident_stats st;
+            const int reps = 5;
+            int nh = 0;
+
+            t0 = s730b_now_ns();
+            for (int r = 0; r < reps; r++)
+                nh = s730b_identify(&pool, probe, gallery, n, sizeof(*gallery), &o, hits, &st);
+            double ms = (s730b_now_ns() - t0) / 1e6 / reps;
+
+            printf("    %2d threads, %-12s: %7.2f ms/search, %8.0f cmp/s, %8.0f cmp/s/core, compared %ld, "
+                   "top-1 %s (score %d)\n",
+                   pool.nthreads, pass ? "accept=12" : "full search", ms, st.compared / (ms / 1e3),
+                   st.compared / (ms / 1e3) / pool.nthreads, st.compared,
+                   nh > 0 && hits[0].index == truth ? "OK" : "miss", nh > 0 ? hits[0].score : 0);
+        }
+        s730b_pool_destroy(&pool);
+    }
+
+    free(gallery);
+    free(probe);
+    return 0;
+}
+
+/*
+ * mmap 갤러리 파일
+ * - 새 파일 만들고 템플릿 N개 append (record마다 fdatasync 두 번이라 디스크 속도에 좌우됨)
+ * - 다시 열기(mmap)까지 걸리는 시간, 열린 상태에서 다른 핸들이 append 한 거 refresh로 보이는지
+ * - 매핑된 레코드 위에서 바로 1:N 검색 (진짜는 첫 record)
+ * - 사용법: gallery [-n N] 갤러리파일 raw파일
+ */
+static int bench_gallery(int argc, char **argv) {
+    static struct s730b_gabor_bank bank;
+    static struct s730b_template t, probe;
+    unsigned char img[IMG_SIZE], enh[IMG_SIZE];
+    struct s730b_minutiae base, m;
+    struct s730b_gallery g, g2;
+    int n = 2000;
+
+    if (argc >= 2 && strcmp(argv[0], "-n") == 0) {
+        n = atoi(argv[1]);
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 2 || n < 1 || load_frame(argv[1], img) < 0)
+        return 1;
+
+    s730b_gabor_bank_init(&bank, ENH_PERIOD_NATIVE);
+    s730b_destripe(img, IMG_WIDTH, IMG_HEIGHT);
+    s730b_gabor_enhance(&bank, img, IMG_WIDTH, IMG_HEIGHT, enh, NULL);
+    s730b_extract_minutiae(enh, IMG_WIDTH, IMG_HEIGHT, &base);
+
+    if (s730b_gallery_create(argv[0], 0) < 0 || s730b_gallery_open(&g, argv[0], 1) < 0) {
+        fprintf(stderr, "[-] %s 만들기 실패\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t t0 = s730b_now_ns();
+    for (int i = 0; i < n; i++) {
+        if (i == 0)
+            perturb_minutiae(&base, &m);
+        else
+            random_minutiae(&m);
+        s730b_template_build(&m, &t);
+        if (s730b_gallery_append(&g, &t, (uint32_t)i) != i) {
+            fprintf(stderr, "[-] append %d 실패\n", i);
+            s730b_gallery_close(&g);
+            return 1;
+        }
+    }
+    uint64_t t1 = s730b_now_ns();
+    printf("[*] %s: %d records x %u B, append %.0f records/s\n",
+           argv[0], n, g.hdr->record_size, n / ((t1 - t0) / 1e9));
+
+    // 다른 프로세스 흉내: 읽기 전용 핸들 하나 더 열고 append 하나 더 한 다음 refresh
+    t0 = s730b_now_ns();
+    if (s730b_gallery_open(&g2, argv[0], 0) < 0) {
+        s730b_gallery_close(&g);
+        return 1;
+    }
+    t1 = s730b_now_ns();
+    random_minutiae(&m);
+    s730b_template_build(&m, &t);
+    s730b_gallery_append(&g, &t, (uint32_t)n);
+    int before = g2.count;
+    s730b_gallery_refresh(&g2);
+    printf("    open (mmap) %.1f us, reader count %d -> %d after append + refresh\n",
+           (t1 - t0) / 1e3, before, g2.count);
+
+    perturb_minutiae(&base, &m);
+    s730b_template_build(&m, &probe);
+
+    struct s730b_ident_opts o = { .topk = 5, .threshold = MATCH_THRESHOLD, .accept = 0 };
+    struct s730b_ident_hit hits[IDENT_MAX_TOPK];
+    size_t stride;
+    const void *records = s730b_gallery_records(&g2, &stride);
+
+    for (int pass = 0; pass < 2; pass++) {
+        t0 = s730b_now_ns();
+        int nh = s730b_identify(NULL, &probe, records, g2.count, stride, &o, hits, NULL);
+        t1 = s730b_now_ns();
+        printf("    identify on mapped records (%s): %.2f ms, top-1 #%d id=%u (score %d)\n",
+               pass ? "warm" : "cold", (t1 - t0) / 1e6, nh ? hits[0].index : -1,
+               nh ? g2.index[hits[0].index].id : 0, nh ? hits[0].score : 0);
+    }
+
+    s730b_gallery_close(&g2);
+    s730b_gallery_close(&g);
+    return 0;
+}
+
+/*
+ * descriptor pre-filter로 후보 줄인 뒤 1:N vs 전체 1:N
+ * - 사람 N명: sample 파일 특징점 + 나머지는 무작위 특징점, 각자 흔든 템플릿 하나씩 갤러리에
+ * - probe 200개: 아무나 골라서 다시 흔든 템플릿 -> 정답 = 그 사람 갤러리 번호
+ * - 후보 비율별로 정답이 후보에서 빠진 비율(lost), top-1 정확도, 전체 대비 속도
+ * - 사용법: prefilter [-n N] raw파일...
+ */
+#define PREFILTER_PROBES 200
+
+static int bench_prefilter(int argc, char **argv) {
+    static const int keep_pct[] = { 1, 2, 5, 10, 20 };
+    static struct s730b_gabor_bank bank;
+    unsigned char img[IMG_SIZE], enh[IMG_SIZE];
+    struct s730b_minutiae m;
+    int n = 5000;
+
+    if (argc >= 2 && strcmp(argv[0], "-n") == 0) {
+        n = atoi(argv[1]);
+        argc -= 2;
+        argv += 2;
+    }
+    if (n < PREFILTER_PROBES)
+        return 1;
+
+    struct s730b_minutiae *base = malloc((size_t)n * sizeof(*base));
+    struct s730b_template *gallery = malloc((size_t)n * sizeof(*gallery));
+    struct s730b_template *probes = malloc((size_t)PREFILTER_PROBES * sizeof(*probes));
+    struct s730b_descriptor *gdesc = aligned_alloc(64, (size_t)n * sizeof(*gdesc));
+    struct s730b_descriptor *pdesc = aligned_alloc(64, (size_t)PREFILTER_PROBES * sizeof(*pdesc));
+    int *truth = malloc(PREFILTER_PROBES * sizeof(*truth));
+    int *list = malloc((size_t)n * sizeof(*list));
+    if (!base || !gallery || !probes || !gdesc || !pdesc || !truth || !list)
+        goto out;
+
+    s730b_gabor_bank_init(&bank, ENH_PERIOD_NATIVE);
+    int nsample = 0;
+    for (int i = 0; i < argc && nsample < n; i++) {
+        if (load_frame(argv[i], img) < 0)
+            continue;
+        s730b_destripe(img, IMG_WIDTH, IMG_HEIGHT);
+        s730b_gabor_enhance(&bank, img, IMG_WIDTH, IMG_HEIGHT, enh, NULL);
+        s730b_extract_minutiae(enh, IMG_WIDTH, IMG_HEIGHT, &base[nsample]);
+        if (base[nsample].count >= MATCH_MIN_MINUTIAE)
+            nsample++;
+    }
+    for (int i = nsample; i < n; i++)
+        random_minutiae(&base[i]);
+
+    for (int i = 0; i < n; i++) {
+        perturb_minutiae(&base[i], &m);
+        s730b_template_build(&m, &gallery[i]);
+        s730b_descriptor_build(&gallery[i], 1, &gdesc[i]);
+    }
+    for (int p = 0; p < PREFILTER_PROBES; p++) {
+        truth[p] = p < nsample ? p : (bench_noise(32767) + 32767) % n;
+        perturb_minutiae(&base[truth[p]], &m);
+        s730b_template_build(&m, &probes[p]);
+        s730b_descriptor_build(&probes[p], 0, &pdesc[p]);
+    }
+
+    int bits = 0;
+    for (int i = 0; i < n; i++)
+        for (int k = 0; k < PREFILTER_WORDS; k++)
+            bits += __builtin_popcountll(gdesc[i].bits[k]);
+    printf("[*] gallery %d (%d from sample files), %d probes, descriptor %d bits (%.0f%% set)\n",
+           n, nsample, PREFILTER_PROBES, PREFILTER_BITS, 100.0 * bits / n / PREFILTER_BITS);
+
+    struct s730b_ident_opts o = { .topk = 1, .threshold = MATCH_THRESHOLD, .accept = 0 };
+    struct s730b_ident_hit hits[IDENT_MAX_TOPK];
+
+    // 전체 검색 기준
+    int ok = 0;
+    uint64_t t0 = s730b_now_ns();
+    for (int p = 0; p < PREFILTER_PROBES; p++) {
+        int nh = s730b_identify(NULL, &probes[p], gallery, n, sizeof(*gallery), &o, hits, NULL);
+        ok += nh > 0 && hits[0].index == truth[p];
+    }
+    double full_ms = (s730b_now_ns() - t0) / 1e6 / PREFILTER_PROBES;
+    printf("    full search   : %7.3f ms/probe, top-1 %5.1f%%\n", full_ms, 100.0 * ok / PREFILTER_PROBES);
+
+    // descriptor 비교 속도
+    volatile int sink = 0;
+    t0 = s730b_now_ns();
+    for (int p = 0; p < PREFILTER_PROBES; p++)
+        for (int i = 0; i < n; i++)
+            sink += s730b_descriptor_score(&pdesc[p], &gdesc[i]);
+    (void)sink;
+    printf("    descriptor    : %.1f M compares/s\n",
+           (double)PREFILTER_PROBES * n / ((s730b_now_ns() - t0) / 1e9) / 1e6);
+
+    for (size_t k = 0; k < sizeof(keep_pct) / sizeof(keep_pct[0]); k++) {
+        int keep = n * keep_pct[k] / 100, lost = 0;
+        ok = 0;
+        t0 = s730b_now_ns();
+        for (int p = 0; p < PREFILTER_PROBES; p++) {
+            int nl = s730b_prefilter(&pdesc[p], gdesc, n, keep, list);
+            int found = 0;
+            for (int j = 0; j < nl && !found; j++)
+                found = list[j] == truth[p];
+            lost += !found;
+            int nh = s730b_identify_list(NULL, &probes[p], gallery, sizeof(*gallery), list, nl, &o, hits, NULL);
+            ok += nh > 0 && hits[0].index == truth[p];
+        }
+        double ms = (s730b_now_ns() - t0) / 1e6 / PREFILTER_PROBES;
+        printf("    keep %3d%% (%5d): %7.3f ms/probe (x%.1f), pruned %5.1f%%, lost %5.1f%%, top-1 %5.1f%%\n",
+               keep_pct[k], keep, ms, full_ms / ms, 100.0 - keep_pct[k],
+               100.0 * lost / PREFILTER_PROBES, 100.0 * ok / PREFILTER_PROBES);
+    }
+
+out:
+    free(base);
+    free(gallery);
+    free(probes);
+    free(gdesc);
+    free(pdesc);
+    free(truth);
+    free(list);
+    return 0;
+}
+
+/*
+ * 손가락 전체(finger, 112x96보다 큼)에서 아무 위치 112x96 창으로 한 번 누른 것 흉내
+ * - 창 위치 아무데나, 창 중심 기준 회전 +-15도, 위치 +-1px / 방향 +-4 흔들기, 10% 빠짐
+ */
+static void press_window(const struct s730b_minutiae *finger, struct s730b_minutiae *dst) {
+    const float a = bench_noise(15) * (float)M_PI / 180.0f;
+    const float c = cosf(a), s = sinf(a);
+    const int ox = (bench_noise(32767) + 32767) % (finger->width - IMG_WIDTH + 1);
+    const int oy = (bench_noise(32767) + 32767) % (finger->height - IMG_HEIGHT + 1);
+    const float cx = ox + IMG_WIDTH * 0.5f, cy = oy + IMG_HEIGHT * 0.5f;
+    const int rot = (int)lrintf(a * 128.0f / (float)M_PI);
+
+    memset(dst, 0, sizeof(*dst));
+    dst->width = IMG_WIDTH;
+    dst->height = IMG_HEIGHT;
+    for (int i = 0; i < finger->count; i++) {
+        if (bench_noise(50) < -40)
+            continue;
+        float x = finger->x[i] - cx, y = finger->y[i] - cy;
+        int nx = (int)lrintf(c * x - s * y + IMG_WIDTH * 0.5f) + bench_noise(1);
+        int ny = (int)lrintf(s * x + c * y + IMG_HEIGHT * 0.5f) + bench_noise(1);
+        // 창 가장자리 5px은 추출기가 버리는 영역
+        if (nx < 5 || ny < 5 || nx >= IMG_WIDTH - 5 || ny >= IMG_HEIGHT - 5)
+            continue;
+        int n = dst->count++;
+        dst->x[n] = (int16_t)nx;
+        dst->y[n] = (int16_t)ny;
+        dst->angle[n] = (uint8_t)(finger->angle[i] + rot + bench_noise(4));
+        dst->type[n] = finger->type[i];
+    }
+}
+
+/*
+ * 여러 번 눌러 등록: 캡처별 템플릿 5개 (verify = 5번 비교) vs 합성 템플릿 1개 (verify = 1번 비교)
+ * - 손가락: 200x170 영역에 특징점 ~40개 (112x96에 12개 정도랑 같은 밀도)
+ * - 등록 5번 + verify 3번, 전부 손가락 안 아무 위치
+ * - genuine = 자기 손가락 등록, impostor = 다음 손가락 등록
+ * - 사용법: enroll [-n 손가락수]
+ */
+#define ENROLL_FINGER_W  200
+#define ENROLL_FINGER_H  170
+#define ENROLL_VERIFY    3
+
+static int bench_enroll(int argc, char **argv) {
+    int nf = 200;
+
+    if (argc >= 2 && strcmp(argv[0], "-n") == 0)
+        nf = atoi(argv[1]);
+    if (nf < 2)
+        return 1;
+
+    struct s730b_template *stages = malloc((size_t)nf * ENROLL_STAGES * sizeof(*stages));
+    struct s730b_template *comp = malloc((size_t)nf * sizeof(*comp));
+    struct s730b_template *probes = malloc((size_t)nf * ENROLL_VERIFY * sizeof(*probes));
+    struct s730b_enroll_info *info = malloc((size_t)nf * sizeof(*info));
+    if (!stages || !comp || !probes || !info) {
+        free(stages);
+        free(comp);
+        free(probes);
+        free(info);
+        return 1;
+    }
+
+    struct s730b_minutiae finger, m;
+    double used = 0.0, minu = 0.0, stage_minu = 0.0;
+    uint64_t compose_ns = 0;
+
+    for (int f = 0; f < nf; f++) {
+        const struct s730b_template *sp[ENROLL_STAGES];
+
+        random_minutiae_area(&finger, ENROLL_FINGER_W, ENROLL_FINGER_H, 40);
+        for (int k = 0; k < ENROLL_STAGES; k++) {
+            press_window(&finger, &m);
+            s730b_template_build(&m, &stages[f * ENROLL_STAGES + k]);
+            sp[k] = &stages[f * ENROLL_STAGES + k];
+            stage_minu += m.count;
+        }
+        for (int k = 0; k < ENROLL_VERIFY; k++) {
+            press_window(&finger, &m);
+            s730b_template_build(&m, &probes[f * ENROLL_VERIFY + k]);
+        }
+
+        uint64_t t0 = s730b_now_ns();
+        s730b_enroll_compose(sp, ENROLL_STAGES, &comp[f], &info[f]);
+        compose_ns += s730b_now_ns() - t0;
+        used += info[f].used;
+        minu += comp[f].count;
+    }
+
+    printf("[*] %d fingers, %d presses each, stage template %.1f minutiae, composite %.1f minutiae "
+           "(%.1f/%d presses merged)\n", nf, ENROLL_STAGES, stage_minu / nf / ENROLL_STAGES, minu / nf,
+           used / nf, ENROLL_STAGES);
+    printf("    compose: %.3f ms/enrollment\n", compose_ns / 1e6 / nf);
+
+    for (int mode = 0; mode < 2; mode++) {
+        int gen_ok = 0, imp_ok = 0, ncmp = 0;
+        uint64_t t0 = s730b_now_ns();
+
+        for (int f = 0; f < nf; f++) {
+            for (int k = 0; k < ENROLL_VERIFY; k++) {
+                const struct s730b_template *p = &probes[f * ENROLL_VERIFY + k];
+                for (int who = 0; who < 2; who++) {
+                    int g = who ? (f + 1) % nf : f, hit = 0;
+                    if (mode == 0) {
+                        // 캡처별: 하나라도 threshold 넘으면 통과
+                        for (int s = 0; s < ENROLL_STAGES && !hit; s++, ncmp++)
+                            hit = s730b_match(p, &stages[g * ENROLL_STAGES + s], MATCH_THRESHOLD) >= MATCH_THRESHOLD;
+                    } else {
+                        // 합성 템플릿 먼저, 실패하면 합성에 못 붙은 캡처만
+                        hit = s730b_match(p, &comp[g], MATCH_THRESHOLD) >= MATCH_THRESHOLD;
+                        ncmp++;
+                        for (int s = 0; s < ENROLL_STAGES && !hit; s++) {
+                            if (info[g].stage_score[s] >= 0)
+                                continue;
+                            hit = s730b_match(p, &stages[g * ENROLL_STAGES + s], MATCH_THRESHOLD) >= MATCH_THRESHOLD;
+                            ncmp++;
+                        }
+                    }
+                    if (who)
+                        imp_ok += hit;
+                    else
+                        gen_ok += hit;
+                }
+            }
+        }
+
+        double ms = (s730b_now_ns() - t0) / 1e6;
+        int nv = nf * ENROLL_VERIFY;
+        printf("    %-22s: TAR %5.1f%%, FAR %5.2f%%, %.1f comparisons/verify, %.1f us/verify\n",
+               mode ? "composite (+ leftovers)" : "per-stage (5 templates)", 100.0 * gen_ok / nv,
+               100.0 * imp_ok / nv, (double)ncmp / (2 * nv), ms * 1e3 / (2 * nv));
+    }
+
+    free(stages);
+    free(comp);
+    free(probes);
+    free(info);
+    return 0;
+}
+
+/*
+ * pcapng에서 bulk IN(0x82) 256B chunk 이어붙여서 프레임으로 (detect bench용 최소 파서)
+ * - USBPcap(linktype 249, Windows)이랑 usbmon(220, Linux mmap 헤더 64B)만
+ * - 256B 미만 bulk IN(상태 응답)이 오면 프레임 하나 끝난 걸로 봄
+ * - chunk_us: 같은 프레임 안에서 chunk 사이 평균 간격 (타임스탬프 있으면)
+ */
+#define PCAP_MAX_CHUNKS 96
+
+static int load_pcap_frames(const char *path, unsigned char *frames, int max_frames, int *nchunks,
+                            double *chunk_us) {
+    int len = 0;
+    unsigned char *d = load_raw(path, &len);
+    if (!d)
+        return -1;
+
+    int linktype = 0, nframes = 0, cur = 0;
+    double tsres = 1e-6, prev_ts = 0, gap_sum = 0;
+    long gaps = 0;
+    for (int i = 0; i + 12 <= len;) {
+        uint32_t type, blen;
+        memcpy(&type, d + i, 4);
+        memcpy(&blen, d + i + 4, 4);
+        if (blen < 12 || i + (int)blen > len)
+            break;
+        const unsigned char *b = d + i;
+
+        if (type == 1) {
+            linktype = b[8] | b[9] << 8;
+            // option if_tsresol (9)
+            for (uint32_t o = 16; o + 4 <= blen - 4;) {
+                int code = b[o] | b[o + 1] << 8, olen = b[o + 2] | b[o + 3] << 8;
+                if (code == 0)
+                    break;
+                if (code == 9 && olen >= 1)
+                    tsres = b[o + 4] & 0x80 ? ldexp(1.0, -(b[o + 4] & 0x7f)) : pow(10.0, -b[o + 4]);
+                o += 4 + ((olen + 3) & ~3);
+            }
+        } else if (type == 6 && blen >= 32) {
+            uint32_t ts_hi, ts_lo, caplen;
+            memcpy(&ts_hi, b + 12, 4);
+            memcpy(&ts_lo, b + 16, 4);
+            memcpy(&caplen, b + 20, 4);
+            const unsigned char *p = b + 28;
+            const unsigned char *payload = NULL;
+            int plen = 0, bulk_in = 0;
+            double ts = (((uint64_t)ts_hi << 32) | ts_lo) * tsres;
+
+            if (linktype == 249 && caplen >= 27) {
+                int hl = p[0] | p[1] << 8;
+                uint32_t dl;
+                memcpy(&dl, p + 23, 4);
+                bulk_in = p[21] == 0x82 && p[22] == 3 && (p[16] & 1);
+                payload = p + hl;
+                plen = hl + (int)dl <= (int)caplen ? (int)dl : (int)caplen - hl;
+            } else if (linktype == 220 && caplen >= 64) {
+                uint32_t lc;
+                memcpy(&lc, p + 36, 4);
+                bulk_in = p[8] == 'C' && p[9] == 3 && p[10] == 0x82;
+                payload = p + 64;
+                plen = (int)(caplen - 64 < lc ? caplen - 64 : lc);
+            }
+
+            if (bulk_in && plen > 0) {
+                if (plen >= BULK_CHUNK && nframes < max_frames && cur < PCAP_MAX_CHUNKS) {
+                    if (cur > 0) {
+                        gap_sum += ts - prev_ts;
+                        gaps++;
+                    }
+                    memcpy(frames + ((size_t)nframes * PCAP_MAX_CHUNKS + cur) * BULK_CHUNK, payload, BULK_CHUNK);
+                    cur++;
+                    prev_ts = ts;
+                } else if (plen < BULK_CHUNK && cur > 0) {
+                    nchunks[nframes++] = cur;
+                    cur = 0;
+                }
+            }
+        }
+        i += (int)blen;
+    }
+    if (cur > 0 && nframes < max_frames)
+        nchunks[nframes++] = cur;
+    if (chunk_us && gaps > 0)
+        *chunk_us = gap_sum / gaps * 1e6;
+    free(d);
+    return nframes;
+}
+
+/*
+ * samsung_730b.c has_fingerprint_in_detect() 판정 그대로 (비교 기준)
+ * - 점수 = 0xFF 비율 (0이 95% 넘으면 0), 원래 문턱 0.30
+ */
+static double detect_heuristic_score(const unsigned char *data, int len) {
+    if (len < 512)
+        return 0.0;
+    int total = len < 4096 ? len : 4096, zeros = 0, ff = 0;
+    for (int i = 0; i < total; i++) {
+        zeros += data[i] == 0x00;
+        ff += data[i] == 0xFF;
+    }
+    return zeros < total * 0.95 ? (double)ff / total : 0.0;
+}
+
+// 점수 목록에서 문턱 훑으면서 AUC + 목표 FAR에서 TPR
+static double detect_roc(const double *on, int non, const double *off, int noff, double far_target) {
+    double best_tpr = 0;
+    long below = 0, ties = 0;
+    for (int i = 0; i < non; i++) {
+        for (int j = 0; j < noff; j++) {
+            below += on[i] > off[j];
+            ties += on[i] == off[j];
+        }
+    }
+    for (int i = 0; i < non; i++) {
+        double thr = on[i];
+        int fp = 0, tp = 0;
+        for (int j = 0; j < noff; j++)
+            fp += off[j] >= thr;
+        for (int j = 0; j < non; j++)
+            tp += on[j] >= thr;
+        if ((double)fp / noff <= far_target && (double)tp / non > best_tpr)
+            best_tpr = (double)tp / non;
+    }
+    printf(" AUC=%.4f, TPR@FAR<=%.1f%%=%5.1f%%", (below + 0.5 * ties) / ((double)non * noff), far_target * 100,
+           best_tpr * 100);
+    return best_tpr;
+}
+
+#define DETECT_SESSIONS   200
+#define DETECT_SESSION_LEN 40   // probe 수 (손가락은 가운데 10개 동안)
+#define DETECT_DRIFT      24    // 세션 동안 빈 센서 밝기가 0 -> 이만큼 올라감
+#define DETECT_NOISE      4
+
+static int bench_detect(int argc, char **argv) {
+    static const int probe_chunks[] = { 1, 2, 6 };
+    const int max_frames = 64;
+    unsigned char *on_frames = calloc((size_t)max_frames * PCAP_MAX_CHUNKS, BULK_CHUNK);
+    unsigned char off_frame[PCAP_MAX_CHUNKS * BULK_CHUNK];
+    int on_chunks[64], n_on = 0, off_chunks = 0;
+    double chunk_us = 0;
+
+    if (!on_frames)
+        return 1;
+    memset(off_frame, 0, sizeof(off_frame));
+
+    /*
+     * 파일 이름에 none/off 들어가면 손가락 없는 데이터, 나머지는 손가락 있는 데이터
+     * - .pcapng면 bulk IN chunk로 프레임 복원, .raw면 파일 자체가 chunk 이어붙인 것
+     */
+    for (int i = 0; i < argc; i++) {
+        int off = strstr(argv[i], "none") || strstr(argv[i], "off");
+        unsigned char tmp[8 * PCAP_MAX_CHUNKS * BULK_CHUNK];
+        int nch[8], nf;
+        size_t sl = strlen(argv[i]);
+
+        if (sl > 7 && strcmp(argv[i] + sl - 7, ".pcapng") == 0) {
+            double us = 0;
+            nf = load_pcap_frames(argv[i], tmp, 8, nch, &us);
+            if (us > 0)
+                chunk_us = us;
+        } else {
+            int len = 0;
+            unsigned char *raw = load_raw(argv[i], &len);
+            nf = 0;
+            if (raw) {
+                nch[0] = len / BULK_CHUNK < PCAP_MAX_CHUNKS ? len / BULK_CHUNK : PCAP_MAX_CHUNKS;
+                memcpy(tmp, raw, (size_t)nch[0] * BULK_CHUNK);
+                nf = nch[0] >= 6;
+                free(raw);
+            }
+        }
+        printf("[*] %s: %s, 프레임 %d개\n", argv[i], off ? "손가락 없음" : "손가락 있음", nf < 0 ? 0 : nf);
+
+        for (int k = 0; k < nf; k++) {
+            if (off && off_chunks == 0) {
+                memcpy(off_frame, tmp + (size_t)k * PCAP_MAX_CHUNKS * BULK_CHUNK, (size_t)nch[k] * BULK_CHUNK);
+                off_chunks = nch[k];
+            } else if (!off && n_on < max_frames) {
+                memcpy(on_frames + (size_t)n_on * PCAP_MAX_CHUNKS * BULK_CHUNK,
+                       tmp + (size_t)k * PCAP_MAX_CHUNKS * BULK_CHUNK, (size_t)nch[k] * BULK_CHUNK);
+                on_chunks[n_on++] = nch[k];
+            }
+        }
+    }
+    if (n_on == 0 || off_chunks < 6) {
+        fprintf(stderr, "[-] 손가락 있는 프레임 / 없는 프레임(6 chunk 이상) 둘 다 필요\n");
+        free(on_frames);
+        return 1;
+    }
+
+    /*
+     * 세션 시뮬레이션: probe DETECT_SESSION_LEN개
+     * - 빈 센서 = off 프레임 + 밝기 drift (0 -> DETECT_DRIFT) + 노이즈
+     * - 가운데 10개는 손가락: 세션 절반은 on 프레임 임의 위치 chunk 그대로 (꾹 누름),
+     *   나머지 절반은 접촉 세기 a(0.3..1)만큼 빈 센서랑 섞음 (살짝 댄 손가락)
+     * - probe 앞 IMG_OFFSET 바이트(레지스터 값)는 항상 빈 센서 것 (실제 probe도 chunk 0부터라 같음)
+     * - 같은 세션을 두 판정기에 똑같이 넣고 점수 모아서 ROC
+     */
+    const int nprobe = DETECT_SESSIONS * DETECT_SESSION_LEN;
+    double *on_h = malloc(nprobe * sizeof(double)), *off_h = malloc(nprobe * sizeof(double));
+    double *on_b = malloc(nprobe * sizeof(double)), *off_b = malloc(nprobe * sizeof(double));
+    if (!on_h || !off_h || !on_b || !off_b)
+        goto out;
+
+    for (size_t pc = 0; pc < sizeof(probe_chunks) / sizeof(probe_chunks[0]); pc++) {
+        const int nch = probe_chunks[pc], plen = nch * BULK_CHUNK;
+        int non = 0, noff = 0, tp_h = 0, fp_h = 0, tp_b = 0, fp_b = 0;
+        uint64_t ns_h = 0, ns_b = 0;
+        struct s730b_detect det;
+        unsigned char probe[DETECT_MAX_BYTES];
+
+        bench_rng = 0x730b;
+        for (int s = 0; s < DETECT_SESSIONS; s++) {
+            s730b_detect_reset(&det);
+            for (int t = 0; t < DETECT_SESSION_LEN; t++) {
+                int finger = t >= DETECT_SESSION_LEN / 2 - 5 && t < DETECT_SESSION_LEN / 2 + 5;
+                int drift = DETECT_DRIFT * t / DETECT_SESSION_LEN;
+                int f = 0, c0 = 0, a = 0;
+                if (finger) {
+                    f = (int)((bench_rng >> 8) % (uint32_t)n_on);
+                    bench_noise(1);
+                    c0 = (int)((bench_rng >> 8) % (uint32_t)(on_chunks[f] - nch + 1));
+                    bench_noise(1);
+                    a = 77 + (int)((bench_rng >> 8) % 180);     // 0.3..1.0 (Q8)
+                    if (s & 1)
+                        a = -1;                                 // 꾹 누름: 캡처 데이터 그대로
+                }
+                for (int i = 0; i < plen; i++) {
+                    int v = off_frame[i] + drift + bench_noise(DETECT_NOISE);
+                    if (i < IMG_OFFSET)
+                        v = off_frame[i];                       // 앞쪽 레지스터 값은 손가락이랑 상관없음
+                    else if (a < 0) {
+                        v = on_frames[((size_t)f * PCAP_MAX_CHUNKS + c0) * BULK_CHUNK + i];
+                    } else if (finger) {
+                        int fv = on_frames[((size_t)f * PCAP_MAX_CHUNKS + c0) * BULK_CHUNK + i];
+                        v += ((fv - v) * a) >> 8;
+                    }
+                    probe[i] = (unsigned char)(v < 0 ? 0 : v > 255 ? 255 : v);
+                }
+
+                uint64_t t0 = s730b_now_ns();
+                double hs = detect_heuristic_score(probe, plen);
+                uint64_t t1 = s730b_now_ns();
+                struct s730b_detect_score sc;
+                int bd = s730b_detect_probe(&det, probe, plen, &sc);
+                uint64_t t2 = s730b_now_ns();
+                ns_h += t1 - t0;
+                ns_b += t2 - t1;
+
+                // 판정기 점수를 문턱 대비 비율 하나로 (1 넘으면 손가락)
+                double bs = (double)sc.var / DETECT_VAR_MIN;
+                if (det.len > 0 && (double)sc.sad / sc.sad_limit > bs)
+                    bs = (double)sc.sad / sc.sad_limit;
+                if (finger) {
+                    on_h[non] = hs;
+                    on_b[non++] = bs;
+                    tp_h += hs > 0.30;
+                    tp_b += bd == 1;
+                } else {
+                    off_h[noff] = hs;
+                    off_b[noff++] = bs;
+                    fp_h += hs > 0.30;
+                    fp_b += bd == 1;
+                }
+            }
+        }
+
+        double probe_ms = chunk_us > 0 ? nch * chunk_us / 1e3 : 0;
+        printf("[*] probe %d chunk (%d B, USB 약 %.1fms)\n", nch, plen, probe_ms);
+        printf("    heuristic (ff>0.30): TPR %5.1f%%, FPR %5.2f%%, %.2f us/probe,", 100.0 * tp_h / non,
+               100.0 * fp_h / noff, ns_h / 1e3 / nprobe);
+        detect_roc(on_h, non, off_h, noff, 0.01);
+        printf("\n    baseline diff      : TPR %5.1f%%, FPR %5.2f%%, %.2f us/probe,", 100.0 * tp_b / non,
+               100.0 * fp_b / noff, ns_b / 1e3 / nprobe);
+        detect_roc(on_b, non, off_b, noff, 0.01);
+        printf("\n");
+    }
+    if (chunk_us > 0)
+        printf("[*] pcap chunk 간격 %.2fms (control 0xCA + bulk IN + ACK)\n", chunk_us / 1e3);
+
+out:
+    free(on_h);
+    free(off_h);
+    free(on_b);
+    free(off_b);
+    free(on_frames);
+    return 0;
+}
+
+/*
+ * 감지 probe 무늬 분류기 vs 0xFF 비율 heuristic
+ * - probe = 빈 센서 레지스터 180B + 이미지 줄 (r0부터), chunk 2개 / 6개
+ * - 경우별로 TEXTURE_PROBES개씩 만들어서 "손가락 있음" 판정 비율 + 스침 판정 + coverage 오차 + 판정 시간
+ */
+#define TEXTURE_PROBES 400
+
+enum { TEX_CAPTURED, TEX_FULL, TEX_GRAZE, TEX_HALF, TEX_WET_FINGER, TEX_EMPTY, TEX_WET_SENSOR, TEX_DIRTY, TEX_CASES };
+
+static const struct {
+    const char *name;
+    int finger;
+} tex_cases[TEX_CASES] = {
+    [TEX_CAPTURED]   = { "as captured", 1 },
+    [TEX_FULL]       = { "full press", 1 },
+    [TEX_GRAZE]      = { "graze (sim)", 1 },
+    [TEX_HALF]       = { "half.raw", 1 },
+    [TEX_WET_FINGER] = { "wet finger", 1 },
+    [TEX_EMPTY]      = { "empty", 0 },
+    [TEX_WET_SENSOR] = { "wet sensor", 0 },
+    [TEX_DIRTY]      = { "dirty sensor", 0 },
+};
+
+static inline unsigned char clamp_u8(int v) {
+    return (unsigned char)(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+static inline int bench_rand(int n) {
+    bench_noise(1);
+    return (int)((bench_rng >> 8) % (uint32_t)n);
+}
+
+/*
+ * 경우 하나에 맞는 112x96 가짜 이미지 + 실제 손가락 닿은 비율
+ * - as captured: 파일 그대로, full press: 게인 0.6..1 + 밝기 이동 + 노이즈 (다른 센서/압력)
+ */
+static double texture_scene(int kind, const unsigned char *on, int n_on, const unsigned char *half,
+                            const unsigned char *none, unsigned char *img) {
+    const unsigned char *src = on + (size_t)bench_rand(n_on) * IMG_SIZE;
+    double cov = 1.0;
+
+    switch (kind) {
+    case TEX_CAPTURED:
+        memcpy(img, src, IMG_SIZE);
+        break;
+    case TEX_FULL:
+    case TEX_WET_FINGER: {
+        int gain = 150 + bench_rand(106), off = bench_rand(40) - 20;    // 0.6..1.0
+        for (int i = 0; i < IMG_SIZE; i++) {
+            int v = (src[i] * gain >> 8) + off + bench_noise(4);
+            if (kind == TEX_WET_FINGER)
+                v = v * 3 / 2 + 60;
+            img[i] = clamp_u8(v);
+        }
+        break;
+    }
+    case TEX_GRAZE: {
+        int wid = 16 + bench_rand(41), x0 = bench_rand(IMG_WIDTH - wid + 1);
+        for (int y = 0; y < IMG_HEIGHT; y++)
+            for (int x = 0; x < IMG_WIDTH; x++)
+                img[y * IMG_WIDTH + x] = x >= x0 && x < x0 + wid ? src[y * IMG_WIDTH + x]
+                                                                 : clamp_u8(none[y * IMG_WIDTH + x] + bench_noise(3));
+        cov = (double)wid / IMG_WIDTH;
+        break;
+    }
+    case TEX_HALF:
+        for (int i = 0; i < IMG_SIZE; i++)
+            img[i] = clamp_u8(half[i] + bench_noise(3));
+        cov = -1.0;     // 줄마다 다름 -> probe 줄에서 계산
+        break;
+    case TEX_EMPTY: {
+        int off = bench_rand(11);
+        for (int i = 0; i < IMG_SIZE; i++)
+            img[i] = clamp_u8(none[i] + off + bench_noise(3));
+        cov = 0.0;
+        break;
+    }
+    case TEX_WET_SENSOR: {
+        // 물 막: 원 몇 개 안은 포화(0xFF), 가장자리는 부드럽게
+        int cx[3], cy[3], r[3];
+        for (int k = 0; k < 3; k++) {
+            cx[k] = bench_rand(IMG_WIDTH);
+            cy[k] = bench_rand(IMG_HEIGHT);
+            r[k] = 20 + bench_rand(40);
+        }
+        for (int y = 0; y < IMG_HEIGHT; y++) {
+            for (int x = 0; x < IMG_WIDTH; x++) {
+                int v = 0;
+                for (int k = 0; k < 3; k++) {
+                    int d = (int)sqrtf((float)((x - cx[k]) * (x - cx[k]) + (y - cy[k]) * (y - cy[k])));
+                    int e = (r[k] - d) * 32;
+                    v = e > v ? e : v;
+                }
+                img[y * IMG_WIDTH + x] = clamp_u8(v + bench_noise(3));
+            }
+        }
+        cov = 0.0;
+        break;
+    }
+    case TEX_DIRTY: {
+        // 얼룩 하나 + 먼지 점
+        int cx = bench_rand(IMG_WIDTH), cy = bench_rand(IMG_HEIGHT), r = 10 + bench_rand(20);
+        int amp = 60 + bench_rand(60);
+        for (int y = 0; y < IMG_HEIGHT; y++) {
+            for (int x = 0; x < IMG_WIDTH; x++) {
+                float d2 = (float)((x - cx) * (x - cx) + (y - cy) * (y - cy));
+                int v = none[y * IMG_WIDTH + x] + (int)(amp * expf(-d2 / (float)(r * r))) + bench_noise(3);
+                if (bench_rand(100) < 3)
+                    v += 100 + bench_rand(156);
+                img[y * IMG_WIDTH + x] = clamp_u8(v);
+            }
+        }
+        cov = 0.0;
+        break;
+    }
+    }
+    return cov;
+}
+
+static int bench_texture(int argc, char **argv) {
+    static const int probe_chunks[] = { 2, 6 };
+    const int max_on = 16;
+    unsigned char *on = malloc((size_t)max_on * IMG_SIZE);
+    unsigned char half[IMG_SIZE], none[IMG_SIZE], header[IMG_OFFSET];
+    int n_on = 0, have_half = 0, have_none = 0;
+
+    if (!on)
+        return 1;
+
+    // 이름에 none -> 빈 센서, half -> 스침, 나머지(.raw / .pcapng) -> 꾹 누른 손가락
+    for (int i = 0; i < argc; i++) {
+        size_t sl = strlen(argv[i]);
+        if (sl > 7 && strcmp(argv[i] + sl - 7, ".pcapng") == 0) {
+            unsigned char *tmp = malloc((size_t)8 * PCAP_MAX_CHUNKS * BULK_CHUNK);
+            int nch[8];
+            int nf = tmp ? load_pcap_frames(argv[i], tmp, 8, nch, NULL) : -1;
+            for (int k = 0; k < nf && n_on < max_on; k++) {
+                if (nch[k] * BULK_CHUNK < IMG_OFFSET + IMG_WIDTH * 48)
+                    continue;
+                // pcap 프레임은 줄 수가 모자랄 수 있음 -> 있는 만큼 + 나머지는 위쪽 반복
+                int avail = (nch[k] * BULK_CHUNK - IMG_OFFSET) / IMG_WIDTH;
+                for (int y = 0; y < IMG_HEIGHT; y++)
+                    memcpy(on + (size_t)n_on * IMG_SIZE + y * IMG_WIDTH,
+                           tmp + (size_t)k * PCAP_MAX_CHUNKS * BULK_CHUNK + IMG_OFFSET + (y % avail) * IMG_WIDTH,
+                           IMG_WIDTH);
+                n_on++;
+            }
+            free(tmp);
+            continue;
+        }
+
+        unsigned char img[IMG_SIZE];
+        if (load_frame(argv[i], img) < 0)
+            continue;
+        if (strstr(argv[i], "none")) {
+            int len = 0;
+            unsigned char *raw = load_raw(argv[i], &len);
+            if (raw) {
+                memcpy(header, raw, IMG_OFFSET);
+                free(raw);
+            }
+            memcpy(none, img, IMG_SIZE);
+            have_none = 1;
+        } else if (strstr(argv[i], "half")) {
+            memcpy(half, img, IMG_SIZE);
+            have_half = 1;
+        } else if (n_on < max_on) {
+            memcpy(on + (size_t)n_on * IMG_SIZE, img, IMG_SIZE);
+            n_on++;
+        }
+    }
+    if (!n_on || !have_half || !have_none) {
+        fprintf(stderr, "[-] 손가락 있는 파일 + half.raw + none.raw 필요\n");
+        free(on);
+        return 1;
+    }
+
+    for (size_t pc = 0; pc < sizeof(probe_chunks) / sizeof(probe_chunks[0]); pc++) {
+        const int plen = probe_chunks[pc] * BULK_CHUNK;
+        const int rows = (plen - IMG_OFFSET) / IMG_WIDTH;
+        unsigned char img[IMG_SIZE], probe[6 * BULK_CHUNK];
+        uint64_t ns_h = 0, ns_t = 0;
+        int nprobe = 0;
+
+        printf("[*] probe %d chunk (이미지 %d줄)\n", probe_chunks[pc], rows);
+        printf("    %-14s %10s %10s %8s %10s\n", "case", "heuristic", "texture", "graze", "cov err");
+        bench_rng = 0x730b;
+        for (int kind = 0; kind < TEX_CASES; kind++) {
+            int hit_h = 0, hit_t = 0, graze = 0;
+            double cov_err = 0;
+
+            for (int n = 0; n < TEXTURE_PROBES; n++) {
+                double cov = texture_scene(kind, on, n_on, half, none, img);
+                int r0 = bench_rand(IMG_HEIGHT - rows - 1);
+
+                memcpy(probe, header, IMG_OFFSET);
+                memcpy(probe + IMG_OFFSET, img + r0 * IMG_WIDTH, plen - IMG_OFFSET);
+                if (cov < 0) {
+                    // half.raw: probe 줄에서 실제로 닿은(밝은) 셀 비율
+                    int c = 0;
+                    for (int x = 0; x < IMG_WIDTH; x += TEXTURE_CELL) {
+                        int s = 0;
+                        for (int y = 0; y < rows; y++)
+                            for (int k = 0; k < TEXTURE_CELL; k++)
+                                s += half[(r0 + y) * IMG_WIDTH + x + k];
+                        c += s > 32 * TEXTURE_CELL * rows;
+                    }
+                    cov = (double)c / (IMG_WIDTH / TEXTURE_CELL);
+                }
+
+                struct s730b_texture t;
+                uint64_t t0 = s730b_now_ns();
+                int h = detect_heuristic_score(probe, plen) > 0.30;
+                uint64_t t1 = s730b_now_ns();
+                s730b_texture_classify(probe + IMG_OFFSET, plen - IMG_OFFSET, IMG_WIDTH, &t);
+                uint64_t t2 = s730b_now_ns();
+                ns_h += t1 - t0;
+                ns_t += t2 - t1;
+                nprobe++;
+
+                hit_h += h;
+                hit_t += t.present;
+                graze += t.graze;
+                cov_err += fabs(t.coverage - cov);
+            }
+            printf("    %-14s %9.1f%% %9.1f%% %7.1f%% %10.3f   (%s)\n", tex_cases[kind].name,
+                   100.0 * hit_h / TEXTURE_PROBES, 100.0 * hit_t / TEXTURE_PROBES, 100.0 * graze / TEXTURE_PROBES,
+                   cov_err / TEXTURE_PROBES, tex_cases[kind].finger ? "손가락 있음: 높을수록 좋음" : "손가락 없음: 0%가 정답");
+        }
+        printf("    판정 시간: heuristic %.2f us/probe, texture %.2f us/probe\n", ns_h / 1e3 / nprobe,
+               ns_t / 1e3 / nprobe);
+    }
+    free(on);
+    return 0;
+}
+
+/*
+ * burst 저장: 예전 save_pgm (회전 복사본 malloc + fprintf + fwrite) vs 버퍼 PGM vs PNG stored / fast
+ * - burst 8장을 outdir에 파일로 씀 (파일 쓰기 포함 frames/s), PNG는 인코딩만 따로도
+ * - 사용법: png outdir raw파일...
+ */
+#define PNG_BURST  8
+#define PNG_ROUNDS 200
+
+static int legacy_save_pgm(const unsigned char *src, int w, int h, const char *fname) {
+    unsigned char *rotated = malloc(w * h);
+    if (!rotated)
+        return -1;
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            rotated[(w - 1 - x) * h + y] = src[y * w + x];
+
+    FILE *f = fopen(fname, "wb");
+    if (!f) {
+        free(rotated);
+        return -1;
+    }
+    fprintf(f, "P5\n%d %d\n255\n", h, w);
+    size_t n = fwrite(rotated, 1, (size_t)w * h, f);
+    fclose(f);
+    free(rotated);
+    return n == (size_t)w * h ? 0 : -1;
+}
+
+static int bench_png(int argc, char **argv) {
+    static const char *names[] = { "legacy PGM", "buffered PGM", "PNG stored", "PNG fast" };
+    static unsigned char frames[PNG_BURST][IMG_SIZE];
+    char fname[512];
+
+    if (argc < 2)
+        return 1;
+    const char *dir = argv[0];
+    int nfiles = argc - 1;
+
+    for (int f = 0; f < nfiles; f++) {
+        if (load_frame(argv[1 + f], frames[0]) < 0)
+            return 1;
+        printf("[*] %s\n", argv[1 + f]);
+
+        // burst 흉내: 같은 프레임에 노이즈만 다르게
+        for (int k = 1; k < PNG_BURST; k++)
+            for (int i = 0; i < IMG_SIZE; i++)
+                frames[k][i] = clamp_u8(frames[0][i] + bench_noise(3));
+
+        printf("    %-14s %10s %12s %8s\n", "writer", "frames/s", "bytes/frame", "ratio");
+        for (int mode = 0; mode < 4; mode++) {
+            long bytes = 0;
+            uint64_t t0 = s730b_now_ns();
+            for (int r = 0; r < PNG_ROUNDS; r++) {
+                for (int k = 0; k < PNG_BURST; k++) {
+                    const unsigned char *img = frames[k];
+                    int ret;
+                    snprintf(fname, sizeof(fname), "%s/burst_%d.%s", dir, k, mode >= 2 ? "png" : "pgm");
+                    if (mode == 0)
+                        ret = legacy_save_pgm(img, IMG_WIDTH, IMG_HEIGHT, fname);
+                    else if (mode == 1)
+                        ret = s730b_write_pgm(fname, img, IMG_WIDTH, IMG_HEIGHT, 1);
+                    else
+                        ret = s730b_write_png(fname, img, IMG_WIDTH, IMG_HEIGHT, 1,
+                                              mode == 2 ? PNG_LEVEL_STORED : PNG_LEVEL_FAST);
+                    if (ret < 0) {
+                        fprintf(stderr, "[-] %s 쓰기 실패\n", fname);
+                        return 1;
+                    }
+                }
+            }
+            uint64_t t1 = s730b_now_ns();
+
+            for (int k = 0; k < PNG_BURST; k++) {
+                FILE *fp;
+                snprintf(fname, sizeof(fname), "%s/burst_%d.%s", dir, k, mode >= 2 ? "png" : "pgm");
+                if ((fp = fopen(fname, "rb"))) {
+                    fseek(fp, 0, SEEK_END);
+                    bytes += ftell(fp);
+                    fclose(fp);
+                }
+            }
+            double n = (double)PNG_ROUNDS * PNG_BURST;
+            printf("    %-14s %10.0f %12ld %7.2fx\n", names[mode], n / ((t1 - t0) / 1e9),
+                   bytes / PNG_BURST, (double)IMG_SIZE * PNG_BURST / bytes);
+        }
+
+        // 파일 쓰기 빼고 인코딩만
+        size_t cap = s730b_png_bound(IMG_WIDTH, IMG_HEIGHT);
+        unsigned char *out = malloc(cap);
+        if (!out)
+            return 1;
+        for (int level = PNG_LEVEL_STORED; level <= PNG_LEVEL_FAST; level++) {
+            uint64_t t0 = s730b_now_ns();
+            for (int r = 0; r < PNG_ROUNDS; r++)
+                for (int k = 0; k < PNG_BURST; k++)
+                    s730b_png_encode(frames[k], IMG_WIDTH, IMG_HEIGHT, 1, level, out, cap);
+            uint64_t t1 = s730b_now_ns();
+            printf("    encode only %-6s %.1f us/frame\n", level ? "fast" : "stored",
+                   (t1 - t0) / 1e3 / (PNG_ROUNDS * PNG_BURST));
+        }
+        free(out);
+    }
+
+    for (int k = 0; k < PNG_BURST; k++) {
+        snprintf(fname, sizeof(fname), "%s/burst_%d.pgm", dir, k);
+        unlink(fname);
+        snprintf(fname, sizeof(fname), "%s/burst_%d.png", dir, k);
+        unlink(fname);
+    }
+    return 0;
+}
+
+/*
+ * 캡처 로그 writer/reader vs 프레임마다 파일 하나
+ * - raw 파일들을 돌려가며 CAPLOG_BENCH_FRAMES개 append: 캡처 속도 흉내(2ms 간격)랑 쉬지 않고 몰아넣기 두 번
+ *   -> append 한 번 걸리는 시간 (캡처 루프가 막히는 시간) p50/p99/max, 버린 수, fdatasync 횟수
+ * - 닫기 전에 쓰는 중인 세그먼트를 열어서 (footer 없음 -> record 따라가며 index) 다 보이는지
+ * - 닫은 뒤 mmap reader: 열기 시간, 임의 접근 get 시간
+ * - 사용법: caplog 디렉터리 raw파일...
+ */
+#define CAPLOG_BENCH_FRAMES 2000
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int bench_caplog(int argc, char **argv) {
+    unsigned char *raws[16];
+    int lens[16], nraw = 0;
+    char path[600];
+
+    if (argc < 2)
+        return 1;
+    const char *dir = argv[0];
+    for (int i = 1; i < argc && nraw < 16; i++) {
+        if (!(raws[nraw] = load_raw(argv[i], &lens[nraw])))
+            return 1;
+        nraw++;
+    }
+
+    uint64_t *lat = malloc(CAPLOG_BENCH_FRAMES * sizeof(*lat));
+    if (!lat)
+        return 1;
+
+    for (int paced = 1; paced >= 0; paced--) {
+        struct s730b_caplog log;
+        if (s730b_caplog_open(&log, dir, 0) < 0) {
+            fprintf(stderr, "[-] %s 캡처 로그 열기 실패\n", dir);
+            return 1;
+        }
+        uint32_t seg = log.segment;
+
+        uint64_t t0 = s730b_now_ns();
+        for (int i = 0; i < CAPLOG_BENCH_FRAMES; i++) {
+            struct s730b_caplog_meta m = { 0 };
+            m.ts_ns = (uint64_t)time(NULL) * 1000000000ull + i;
+            m.flags = CAPLOG_COMPLETE;
+            m.quality = -1;
+            m.chunks_expected = m.chunks_received = (uint16_t)(lens[i % nraw] / BULK_CHUNK);
+
+            uint64_t a = s730b_now_ns();
+            s730b_caplog_append(&log, raws[i % nraw], lens[i % nraw], &m);
+            lat[i] = s730b_now_ns() - a;
+            if (paced) {
+                struct timespec ts = { 0, 2 * 1000 * 1000 };
+                nanosleep(&ts, NULL);
+            }
+        }
+        uint64_t t1 = s730b_now_ns();
+
+        // 아직 안 닫은 세그먼트 (footer 없음) 열어보기
+        struct s730b_caplog_reader rd;
+        struct timespec ts = { 0, 50 * 1000 * 1000 };
+        nanosleep(&ts, NULL);
+        s730b_caplog_segment_path(dir, seg, path, sizeof(path));
+        int live = -1;
+        if (s730b_caplog_reader_open(&rd, path) == 0) {
+            live = rd.count;
+            s730b_caplog_reader_close(&rd);
+        }
+
+        uint64_t tc = s730b_now_ns();
+        int cr = s730b_caplog_close(&log);
+        uint64_t t2 = s730b_now_ns();
+
+        qsort(lat, CAPLOG_BENCH_FRAMES, sizeof(*lat), cmp_u64);
+        printf("[*] %s: %d frames, %llu written, %llu dropped, %llu segment(s), %llu fdatasync, close %s\n",
+               paced ? "2ms 간격" : "몰아넣기", CAPLOG_BENCH_FRAMES, (unsigned long long)log.written,
+               (unsigned long long)log.dropped, (unsigned long long)log.segments, (unsigned long long)log.syncs,
+               cr == 0 ? "ok" : "실패");
+        printf("    append p50 %.1f us, p99 %.1f us, max %.1f us, 루프 %.0f ms, close(seal) %.2f ms, %.1f MB 씀\n",
+               lat[CAPLOG_BENCH_FRAMES / 2] / 1e3, lat[CAPLOG_BENCH_FRAMES * 99 / 100] / 1e3,
+               lat[CAPLOG_BENCH_FRAMES - 1] / 1e3, (t1 - t0) / 1e6, (t2 - tc) / 1e6, log.bytes / 1e6);
+        printf("    쓰는 중 세그먼트 (footer 없음) 열었을 때 보인 레코드: %d\n", live);
+
+        if (paced) {
+            // 닫은 세그먼트 reader
+            uint64_t r0 = s730b_now_ns();
+            if (s730b_caplog_reader_open(&rd, path) < 0) {
+                fprintf(stderr, "[-] %s 열기 실패\n", path);
+                return 1;
+            }
+            uint64_t r1 = s730b_now_ns();
+            int bad = 0;
+            uint64_t r2 = s730b_now_ns();
+            for (int i = 0; i < CAPLOG_BENCH_FRAMES; i++) {
+                const unsigned char *f;
+                const struct s730b_caplog_meta *m;
+                int k = (int)((i * 2654435761u) % (unsigned)rd.count), len;
+                if (s730b_caplog_get(&rd, k, &f, &len, &m) < 0 || len != lens[k % nraw] ||
+                    memcmp(f, raws[k % nraw], len) != 0)
+                    bad++;
+            }
+            uint64_t r3 = s730b_now_ns();
+            printf("    reader: sealed=%d, %d records, open(mmap) %.1f us, 임의 get+검증 %.2f us/record, 불일치 %d\n",
+                   rd.sealed, rd.count, (r1 - r0) / 1e3, (r3 - r2) / 1e3 / CAPLOG_BENCH_FRAMES, bad);
+            s730b_caplog_reader_close(&rd);
+        }
+    }
+
+    // 비교: 프레임마다 파일 하나 (Python save_image 식)
+    uint64_t f0 = s730b_now_ns();
+    for (int i = 0; i < CAPLOG_BENCH_FRAMES; i++) {
+        snprintf(path, sizeof(path), "%s/frame_%06d.raw", dir, i);
+        FILE *f = fopen(path, "wb");
+        if (!f)
+            return 1;
+        fwrite(raws[i % nraw], 1, lens[i % nraw], f);
+        fclose(f);
+    }
+    uint64_t f1 = s730b_now_ns();
+    for (int i = 0; i < CAPLOG_BENCH_FRAMES; i++) {
+        snprintf(path, sizeof(path), "%s/frame_%06d.raw", dir, i);
+        unlink(path);
+    }
+    printf("[*] 비교: 프레임마다 파일 %d개 (fsync 없음) %.1f us/frame\n", CAPLOG_BENCH_FRAMES,
+           (f1 - f0) / 1e3 / CAPLOG_BENCH_FRAMES);
+
+    free(lat);
+    for (int i = 0; i < nraw; i++)
+        free(raws[i]);
+    return 0;
+}
+
+/*
+ * raw 프레임 무손실 codec
+ * - 파일마다: 압축률, 인코드/디코드 MB/s (raw 기준), 왕복 검증 + 잘린 입력 거부하는지
+ *   비교로 이미지만 PNG fast (deflate) 크기
+ * - 노이즈 섞은 가짜 burst (이미지 구간만 바꿈)도 같이
+ * - 마지막에 CAPLOG_OPEN_CODEC 캡처 로그에 써서 파일 크기 / s730b_caplog_read로 다시 읽어 검증
+ * - 사용법: codec 디렉터리 raw파일...
+ */
+#define CODEC_ROUNDS      200
+#define CODEC_LOG_FRAMES  500
+
+static int bench_codec(int argc, char **argv) {
+    unsigned char *raws[16];
+    int lens[16], nraw = 0;
+    long raw_total = 0, coded_total = 0;
+    char path[600];
+
+    if (argc < 2)
+        return 1;
+    const char *dir = argv[0];
+    for (int i = 1; i < argc && nraw < 16; i++) {
+        if (!(raws[nraw] = load_raw(argv[i], &lens[nraw])))
+            return 1;
+        nraw++;
+    }
+
+    size_t cap = s730b_codec_bound(CODEC_MAX_RAW);
+    size_t png_cap = s730b_png_bound(IMG_WIDTH, IMG_HEIGHT);
+    unsigned char *out = malloc(cap), *back = malloc(CODEC_MAX_RAW), *noisy = malloc(CODEC_MAX_RAW);
+    unsigned char *png = malloc(png_cap);
+    if (!out || !back || !noisy || !png)
+        return 1;
+
+    printf("    %-28s %7s %7s %6s %7s %10s %10s %s\n", "file", "raw", "coded", "ratio", "img png", "enc MB/s",
+           "dec MB/s", "check");
+    for (int f = 0; f < nraw * 2; f++) {
+        // 뒤 절반은 같은 파일 이미지 구간에 노이즈 (센서 잡음 흉내)
+        const unsigned char *raw = raws[f % nraw];
+        int len = lens[f % nraw];
+        if (f >= nraw) {
+            memcpy(noisy, raw, len);
+            if (len >= IMG_OFFSET + IMG_SIZE)
+                for (int i = 0; i < IMG_SIZE; i++)
+                    noisy[IMG_OFFSET + i] = clamp_u8(noisy[IMG_OFFSET + i] + bench_noise(3));
+            raw = noisy;
+        }
+
+        long coded = 0, dec = 0;
+        uint64_t t0 = s730b_now_ns();
+        for (int r = 0; r < CODEC_ROUNDS; r++)
+            coded = s730b_codec_encode(raw, len, out, cap);
+        uint64_t t1 = s730b_now_ns();
+        for (int r = 0; r < CODEC_ROUNDS; r++)
+            dec = s730b_codec_decode(out, (size_t)coded, back, CODEC_MAX_RAW);
+        uint64_t t2 = s730b_now_ns();
+
+        int ok = coded > 0 && dec == len && memcmp(raw, back, len) == 0 &&
+                 s730b_codec_decode(out, (size_t)coded - 1, back, CODEC_MAX_RAW) < 0;
+        long png_len = len >= IMG_OFFSET + IMG_SIZE
+                           ? s730b_png_encode(raw + IMG_OFFSET, IMG_WIDTH, IMG_HEIGHT, 0, PNG_LEVEL_FAST, png, png_cap)
+                           : 0;
+
+        const char *name = strrchr(argv[1 + f % nraw], '/');
+        name = name ? name + 1 : argv[1 + f % nraw];
+        snprintf(path, sizeof(path), "%s%s", name, f >= nraw ? " +noise" : "");
+        printf("    %-28s %7d %7ld %5.2fx %7ld %10.1f %10.1f %s\n", path, len, coded, (double)len / coded, png_len,
+               (double)len * CODEC_ROUNDS / 1e3 / ((t1 - t0) / 1e6), (double)len * CODEC_ROUNDS / 1e3 / ((t2 - t1) / 1e6),
+               ok ? "ok" : "불일치");
+        if (!ok)
+            return 1;
+        raw_total += len;
+        coded_total += coded;
+    }
+    printf("[*] 전체 %ld -> %ld bytes (%.2fx)\n", raw_total, coded_total, (double)raw_total / coded_total);
+
+    // 캡처 로그에 압축해서 쓰기 -> 다시 읽기
+    struct s730b_caplog log;
+    if (s730b_caplog_open(&log, dir, CAPLOG_OPEN_CODEC) < 0) {
+        fprintf(stderr, "[-] %s 캡처 로그 열기 실패\n", dir);
+        return 1;
+    }
+    uint32_t seg = log.segment;
+    for (int i = 0; i < CODEC_LOG_FRAMES; i++) {
+        struct s730b_caplog_meta m = { 0 };
+        m.flags = CAPLOG_COMPLETE;
+        m.quality = -1;
+        while (s730b_caplog_append(&log, raws[i % nraw], lens[i % nraw], &m) < 0 && !log.error) {
+            // 큐 꽉 참: writer가 압축하느라 밀림, 잠깐 기다렸다 다시 (버린 수엔 들어감)
+            struct timespec ts = { 0, 1000 * 1000 };
+            nanosleep(&ts, NULL);
+        }
+    }
+    if (s730b_caplog_close(&log) < 0) {
+        fprintf(stderr, "[-] 캡처 로그 닫기 실패\n");
+        return 1;
+    }
+
+    struct s730b_caplog_reader rd;
+    s730b_caplog_segment_path(dir, seg, path, sizeof(path));
+    if (s730b_caplog_reader_open(&rd, path) < 0) {
+        fprintf(stderr, "[-] %s 열기 실패\n", path);
+        return 1;
+    }
+    int bad = 0;
+    uint64_t r0 = s730b_now_ns();
+    for (int i = 0; i < rd.count; i++) {
+        int n = s730b_caplog_read(&rd, i, back, CODEC_MAX_RAW, NULL);
+        if (n != lens[i % nraw] || memcmp(back, raws[i % nraw], n) != 0)
+            bad++;
+    }
+    uint64_t r1 = s730b_now_ns();
+    printf("[*] 압축 캡처 로그: %d records, raw %.1f KB -> 파일 %.1f KB (%.2fx), read+풀기 %.1f us/record, 불일치 %d\n",
+           rd.count, log.raw_bytes / 1e3, log.bytes / 1e3, (double)log.raw_bytes / log.bytes,
+           rd.count ? (r1 - r0) / 1e3 / rd.count : 0.0, bad);
+    s730b_caplog_reader_close(&rd);
+
+    free(out);
+    free(back);
+    free(noisy);
+    free(png);
+    for (int i = 0; i < nraw; i++)
+        free(raws[i]);
+    return bad ? 1 : 0;
+}
+
+/*
+ * 센서 모델(s730b_sim) 위에서 프로토콜 코드(s730b_proto) 돌려보기
+ * 1) 규칙: 예전 chunk 0 ACK 버그 시퀀스 -> 500ms timeout 뒤 계속 감, 0xCA 순서 틀림 -> 멈춤 -> init으로 복구
+ * 2) host 쪽 처리량: 안 기다리고 (scale 0) init + 캡처 반복, 받은 프레임이 원본 raw랑 같은지
+ * 3) 트레이스 타이밍 (scale 1): 캡처 벽시계 시간 vs 장치 시간 합
+ * 4) 오류 주입: 종류별로 transfer마다 0.2% -> 온전한 프레임 / 잘린 프레임 / 실패 수
+ * - 사용법: sim raw파일... (프레임 순서대로 돌려가며 보냄)
+ */
+#define SIM_CYCLES       2000
+#define SIM_TIMED        3
+#define SIM_FAULT_CYCLES 500
+
+static int sim_cycle(struct s730b_transport *t, const struct s730b_sim *s, unsigned char *buf,
+                     struct s730b_proto_stats *st) {
+    if (s730b_proto_init(t, st) < 0)
+        return -1;
+    int len = s730b_proto_capture(t, S730B_NUM_PACKETS, 0, buf, S730B_FRAME_BYTES, st);
+    if (len < 0)
+        return -1;
+    return len == S730B_FRAME_BYTES && memcmp(buf, s->frames[s->frame], len) == 0 ? 1 : 0;
+}
+
+static int bench_sim(int argc, char **argv) {
+    static struct s730b_sim sim;
+    static unsigned char buf[S730B_FRAME_BYTES];
+    struct s730b_transport t;
+    struct s730b_proto_stats st;
+    int transferred, ok = 0;
+
+    if (argc < 1)
+        return 1;
+    s730b_sim_init(&sim, 0x730b);
+    for (int i = 0; i < argc; i++) {
+        if (s730b_sim_load(&sim, argv[i], 0) < 0) {
+            fprintf(stderr, "[-] %s: 84 chunk raw 아님\n", argv[i]);
+            return 1;
+        }
+    }
+    s730b_sim_transport(&sim, &t);
+
+    // 1) 규칙: 시간은 안 기다리고 장치 시간만 셈
+    sim.timing.scale = 0;
+    unsigned char ack[S730B_CHUNK] = { 0 }, start[S730B_CHUNK] = { 0xa8, 0x06 };
+    s730b_proto_init(&t, &st);
+    s730b_control(&t, 0x40, 0xCA, 3, s730b_capture_indices[0], NULL, 0, 500);
+    s730b_bulk(&t, S730B_EP_OUT, start, sizeof(start), &transferred, 500);
+    s730b_bulk(&t, S730B_EP_IN, buf, S730B_CHUNK, &transferred, 500);
+    uint64_t d0 = sim.device_ns;
+    int r_ack = s730b_bulk(&t, S730B_EP_OUT, ack, sizeof(ack), &transferred, 500);
+    uint64_t d1 = sim.device_ns;
+    s730b_control(&t, 0x40, 0xCA, 3, s730b_capture_indices[1], NULL, 0, 500);
+    int r_in = s730b_bulk(&t, S730B_EP_IN, buf, S730B_CHUNK, &transferred, 1000);
+    printf("[*] chunk 0 뒤 ACK (예전 C 드라이버): err=%d, 장치 %.1f ms (\"%s\"), 그 뒤 packet 1 bulk IN err=%d %dB\n", r_ack,
+           (d1 - d0) / 1e6, sim.last_violation, r_in, transferred);
+    s730b_bulk(&t, S730B_EP_OUT, ack, sizeof(ack), &transferred, 500);
+    s730b_control(&t, 0x40, 0xCA, 3, s730b_capture_indices[3], NULL, 0, 500);
+    printf("[*] 0xCA packet 2 건너뜀: \"%s\"", sim.last_violation);
+    r_in = s730b_bulk(&t, S730B_EP_IN, buf, S730B_CHUNK, &transferred, 1000);
+    printf(" -> bulk IN err=%d", r_in);
+    r_in = sim_cycle(&t, &sim, buf, &st);
+    printf(", init 다시 하고 캡처 %s\n", r_in == 1 ? "ok" : "실패");
+    if (r_ack != S730B_ETIMEDOUT || r_in != 1)
+        return 1;
+
+    // 2) host 쪽 처리량
+    uint64_t dev0 = sim.device_ns, tr0 = sim.transfers;
+    uint64_t t0 = s730b_now_ns();
+    for (int i = 0; i < SIM_CYCLES; i++)
+        ok += sim_cycle(&t, &sim, buf, &st) == 1;
+    uint64_t t1 = s730b_now_ns();
+    double per = (t1 - t0) / 1e3 / SIM_CYCLES;
+    printf("[*] init + 캡처 %d번 (안 기다림): 원본이랑 같음 %d, host %.1f us/cycle (%.0f cycle/s), transfer %.0f/cycle "
+           "(%.2f us/transfer), 장치 시간 %.1f ms/cycle\n",
+           SIM_CYCLES, ok, per, 1e6 / per, (double)(sim.transfers - tr0) / SIM_CYCLES,
+           (t1 - t0) / 1e3 / (sim.transfers - tr0), (sim.device_ns - dev0) / 1e6 / SIM_CYCLES);
+    if (ok != SIM_CYCLES)
+        return 1;
+
+    // 3) 트레이스 타이밍으로 진짜 기다림
+    sim.timing.scale = 1.0;
+    for (int i = 0; i < SIM_TIMED; i++) {
+        dev0 = sim.device_ns;
+        t0 = s730b_now_ns();
+        int c = sim_cycle(&t, &sim, buf, &st);
+        t1 = s730b_now_ns();
+        printf("[*] scale 1 cycle %d: %s, 벽시계 %.1f ms (캡처 %.1f ms, chunk avg %u us / max %u us), 장치 %.1f ms\n",
+               i + 1, c == 1 ? "ok" : "실패", (t1 - t0) / 1e6, st.total_us / 1e3, st.chunk_avg_us, st.chunk_max_us,
+               (sim.device_ns - dev0) / 1e6);
+    }
+
+    // 4) 오류 주입 (안 기다림)
+    sim.timing.scale = 0;
+    printf("    %-11s %8s %8s %8s %8s %10s   (0.2%%/transfer, %d cycle)\n", "fault", "ok", "partial", "fail",
+           "injected", "dev ms/c", SIM_FAULT_CYCLES);
+    for (int f = 0; f < SIM_FAULTS; f++) {
+        int good = 0, partial = 0, failed = 0;
+        uint64_t inj = sim.faults[f];
+        dev0 = sim.device_ns;
+        s730b_sim_set_fault(&sim, PROTO_AT_NONE, f, 0.002);
+        for (int i = 0; i < SIM_FAULT_CYCLES; i++) {
+            int c = sim_cycle(&t, &sim, buf, &st);
+            good += c == 1;
+            partial += c == 0;
+            failed += c < 0;
+            // 복구 안 함 (bench stress에서): 빠짐 / stall 남은 건 cycle마다 되돌림
+            if (sim.gone || sim.halted)
+                s730b_sim_replug(&sim);
+        }
+        s730b_sim_set_fault(&sim, PROTO_AT_NONE, f, 0);
+        printf("    %-11s %8d %8d %8d %8llu %10.1f\n", s730b_sim_fault_name[f], good, partial, failed,
+               (unsigned long long)(sim.faults[f] - inj), (sim.device_ns - dev0) / 1e6 / SIM_FAULT_CYCLES);
+    }
+    return 0;
+}
+
+/*
+ * 오류 주입 스트레스: 지점 x fault 종류마다 N cycle (init + 캡처), cycle마다 한 번짜리 fault를 아무 index에
+ * - 첫 시도 성공 = 예전 드라이버 (init 실패 die / 잘린 프레임 그대로), 복구 = s730b_proto_*_recover
+ * - 복구 시간 = 처음 실패한 시도 시작 ~ 온전한 프레임 (sim 가상 시계, 장치 timeout / 열거 시간 포함)
+ * - tries = init + 캡처 시도 수 (fault 없으면 2)
+ * - 사용법: stress [-n N] raw파일...
+ */
+#define STRESS_CYCLES 1000
+
+static const int stress_points[] = {
+    PROTO_AT_C3, PROTO_AT_INIT, PROTO_AT_CA, PROTO_AT_START, PROTO_AT_STATUS, PROTO_AT_DATA, PROTO_AT_ACK,
+};
+#define STRESS_POINTS ((int)(sizeof(stress_points) / sizeof(stress_points[0])))
+
+// 표에 찍을 짧은 이름 (PROTO_AT_* 순서)
+static const char *const stress_at_name[PROTO_AT_KINDS] = { "-", "c3", "init", "ca", "start", "status", "data", "ack" };
+
+// 지점별 index 범위 (sim_arm 기준)
+static int stress_index(int at) {
+    switch (at) {
+    case PROTO_AT_INIT:
+        return bench_rand((int)s730b_init_cmds_len);
+    case PROTO_AT_CA:
+        return bench_rand(S730B_NUM_PACKETS);
+    case PROTO_AT_DATA:
+    case PROTO_AT_ACK:
+        return 1 + bench_rand(S730B_NUM_PACKETS - 1);
+    }
+    return 0;
+}
+
+static double pct_ms(uint64_t *v, int n, double p) {
+    if (!n)
+        return 0;
+    int i = (int)(p * (n - 1) + 0.5);
+    return v[i] / 1e6;
+}
+
+static int bench_stress(int argc, char **argv) {
+    static struct s730b_sim sim;
+    static unsigned char buf[S730B_FRAME_BYTES];
+    struct s730b_transport t;
+    struct s730b_proto_stats st;
+    struct s730b_recover rc_init, rc_cap;
+    int cycles = STRESS_CYCLES, argi = 0;
+
+    if (argc >= 2 && strcmp(argv[0], "-n") == 0) {
+        cycles = atoi(argv[1]);
+        argi = 2;
+    }
+    if (argc - argi < 1 || cycles <= 0)
+        return 1;
+    s730b_sim_init(&sim, 0x730b);
+    for (int i = argi; i < argc; i++) {
+        if (s730b_sim_load(&sim, argv[i], 0) < 0) {
+            fprintf(stderr, "[-] %s: 84 chunk raw 아님\n", argv[i]);
+            return 1;
+        }
+    }
+    s730b_sim_transport(&sim, &t);
+    sim.timing.scale = 0;
+    s730b_recover_init(&rc_init);
+    s730b_recover_init(&rc_cap);
+
+    uint64_t *rec = malloc(sizeof(*rec) * cycles * STRESS_POINTS);
+    if (!rec)
+        return 1;
+    printf("[*] %d cycle / 지점, 시도 최대 %d, 시간은 sim 가상 시계\n", cycles, PROTO_MAX_ATTEMPTS);
+    printf("    %-11s %-7s %6s %7s %7s %6s %6s %6s %9s %9s %9s\n", "fault", "at", "hit", "1st %", "recov %",
+           "tries", "reinit", "reopen", "p50 ms", "p99 ms", "max ms");
+
+    uint64_t t0 = s730b_now_ns(), dev0 = sim.device_ns;
+    int bad = 0;
+    for (int f = 0; f < SIM_FAULTS; f++) {
+        int nrec_all = 0, hit_all = 0, first_all = 0, ok_all = 0;
+        for (int p = 0; p < STRESS_POINTS; p++) {
+            int at = stress_points[p];
+            if (f == SIM_FAULT_SHORT && at != PROTO_AT_STATUS && at != PROTO_AT_DATA)
+                continue;
+            uint64_t *r = rec + nrec_all;
+            int hit = 0, first = 0, ok = 0, nrec = 0, tries = 0, reinits = 0, reopens = 0;
+            for (int i = 0; i < cycles; i++) {
+                s730b_sim_arm(&sim, at, stress_index(at), f);
+                int len = s730b_proto_init_recover(&t, &rc_init, &st);
+                if (len == 0)
+                    len = s730b_proto_capture_recover(&t, S730B_NUM_PACKETS, 0, buf, S730B_FRAME_BYTES, &rc_cap, &st);
+                else
+                    rc_cap.attempts = rc_cap.reinits = rc_cap.reopens = 0, rc_cap.recover_ns = 0;
+                int good = len == S730B_FRAME_BYTES && memcmp(buf, sim.frames[sim.frame], len) == 0;
+                // 안 걸렸으면 (init 실패로 그 지점까지 안 감 등) 다음 cycle로 안 넘김
+                if (sim.arm_fault >= 0)
+                    sim.arm_fault = -1;
+                else
+                    hit++;
+                int attempts = rc_init.attempts + rc_cap.attempts;
+                first += good && attempts == 2;
+                ok += good;
+                tries += attempts;
+                reinits += rc_init.reinits + rc_cap.reinits;
+                reopens += rc_init.reopens + rc_cap.reopens;
+                if (good && attempts > 2)
+                    r[nrec++] = rc_init.recover_ns + rc_cap.recover_ns;
+                if (!good && sim.gone)
+                    s730b_sim_replug(&sim);
+            }
+            qsort(r, nrec, sizeof(*r), cmp_u64);
+            printf("    %-11s %-7s %6d %7.1f %7.1f %6.2f %6d %6d %9.1f %9.1f %9.1f\n", s730b_sim_fault_name[f],
+                   stress_at_name[at], hit, 100.0 * first / cycles, 100.0 * ok / cycles, (double)tries / cycles,
+                   reinits, reopens, pct_ms(r, nrec, 0.5), pct_ms(r, nrec, 0.99), nrec ? r[nrec - 1] / 1e6 : 0);
+            nrec_all += nrec;
+            hit_all += hit;
+            first_all += first;
+            ok_all += ok;
+            bad += ok != cycles;
+        }
+        qsort(rec, nrec_all, sizeof(*rec), cmp_u64);
+        int total = hit_all ? hit_all : 1;
+        printf("    %-11s %-7s %6d %7.1f %7.1f %6s %6s %6s %9.1f %9.1f %9.1f\n\n", s730b_sim_fault_name[f], "all",
+               hit_all, 100.0 * first_all / total, 100.0 * ok_all / total, "", "", "", pct_ms(rec, nrec_all, 0.5),
+               pct_ms(rec, nrec_all, 0.99), nrec_all ? rec[nrec_all - 1] / 1e6 : 0);
+    }
+    uint64_t t1 = s730b_now_ns();
+    printf("[*] host %.2f s, 장치 시간 %.1f s, 위반 %llu, 온전한 프레임 못 받은 지점 %d\n", (t1 - t0) / 1e9,
+           (sim.device_ns - dev0) / 1e9, (unsigned long long)sim.violations, bad);
+    free(rec);
+    return 0;
+}
+
+/*
+ * 뽑았다 꽂기 (hotplug) 세션: 시뮬레이터 위 s730b_session, 요청 스레드 여러 개가 캡처 계속 넣는 동안
+ * plug 스레드가 아무 때나 뽑고 (하던 transfer -4) 잠깐 뒤 꽂음 (붙음 이벤트)
+ * - 예전 드라이버는 -4 받으면 die -> 여기선 요청이 큐에 남았다가 다시 붙으면 끝나는지
+ * - 재연결 = 붙음 이벤트 ~ reopen + init 끝, 요청 지연 p50/p99 (빠짐 겪은 요청 따로)
+ * - scale 0.02 (캡처 약 3ms, 열거 6ms), 사용법: session [-n 뽑는 횟수] raw파일...
+ */
+#define SESSION_REPLUGS   30
+#define SESSION_CLIENTS   3
+#define SESSION_SCALE     0.02
+#define SESSION_OFF_MS    20        // 빠져 있는 시간
+#define SESSION_MAX_REQ   20000
+
+struct session_bench {
+    struct s730b_sim *sim;
+    struct s730b_session *ses;
+    int replugs;
+    volatile int plug_done;
+    // 요청 스레드별
+    uint64_t lat[SESSION_CLIENTS][SESSION_MAX_REQ];
+    uint64_t lat_hit[SESSION_CLIENTS][SESSION_MAX_REQ];     // 빠짐 겪은 요청
+    int nlat[SESSION_CLIENTS], nhit[SESSION_CLIENTS];
+    int ok[SESSION_CLIENTS], bad[SESSION_CLIENTS], failed[SESSION_CLIENTS];
+};
+
+struct session_client {
+    struct session_bench *b;
+    int id;
+};
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void *session_plug_main(void *arg) {
+    struct session_bench *b = arg;
+    for (int i = 0; i < b->replugs; i++) {
+        sleep_ms(40 + bench_rand(80));
+        s730b_sim_unplug(b->sim);
+        s730b_session_detached(b->ses);
+        sleep_ms(SESSION_OFF_MS);
+        s730b_session_attached(b->ses);
+    }
+    sleep_ms(50);
+    b->plug_done = 1;
+    return NULL;
+}
+
+static void *session_client_main(void *arg) {
+    struct session_client *c = arg;
+    struct session_bench *b = c->b;
+    unsigned char buf[S730B_FRAME_BYTES];
+
+    while (!b->plug_done && b->nlat[c->id] < SESSION_MAX_REQ) {
+        struct s730b_session_req req = {
+            .kind = SESSION_CAPTURE, .packets = S730B_NUM_PACKETS, .buf = buf, .cap = sizeof(buf),
+        };
+        int len = s730b_session_submit(b->ses, &req, 5000);
+        if (len != S730B_FRAME_BYTES) {
+            b->failed[c->id]++;
+            continue;
+        }
+        // 프레임이 sample 중 하나랑 같아야 함 (어느 건지는 다른 스레드 순서 따라)
+        int same = 0;
+        for (int f = 0; f < b->sim->nframes && !same; f++)
+            same = memcmp(buf, b->sim->frames[f], len) == 0;
+        b->ok[c->id] += same;
+        b->bad[c->id] += !same;
+        uint64_t ns = req.done_ns - req.submit_ns;
+        b->lat[c->id][b->nlat[c->id]++] = ns;
+        if (req.requeued)
+            b->lat_hit[c->id][b->nhit[c->id]++] = ns;
+    }
+    return NULL;
+}
+
+static int bench_session(int argc, char **argv) {
+    static struct s730b_sim sim;
+    static struct s730b_session ses;
+    static struct session_bench b;
+    struct s730b_transport t;
+    struct s730b_proto_stats st;
+    pthread_t plug, clients[SESSION_CLIENTS];
+    struct session_client cl[SESSION_CLIENTS];
+    int argi = 0;
+
+    b.replugs = SESSION_REPLUGS;
+    if (argc >= 2 && strcmp(argv[0], "-n") == 0) {
+        b.replugs = atoi(argv[1]);
+        argi = 2;
+    }
+    if (argc - argi < 1)
+        return 1;
+    s730b_sim_init(&sim, 0x730b);
+    for (int i = argi; i < argc; i++) {
+        if (s730b_sim_load(&sim, argv[i], 0) < 0) {
+            fprintf(stderr, "[-] %s: 84 chunk raw 아님\n", argv[i]);
+            return 1;
+        }
+    }
+    s730b_sim_transport(&sim, &t);
+    sim.timing.scale = SESSION_SCALE;
+    if (s730b_proto_init(&t, &st) < 0 || s730b_session_start(&ses, &t, 1) < 0)
+        return 1;
+    b.sim = &sim;
+    b.ses = &ses;
+
+    uint64_t t0 = s730b_now_ns();
+    pthread_create(&plug, NULL, session_plug_main, &b);
+    for (int i = 0; i < SESSION_CLIENTS; i++) {
+        cl[i] = (struct session_client){ &b, i };
+        pthread_create(&clients[i], NULL, session_client_main, &cl[i]);
+    }
+    pthread_join(plug, NULL);
+    for (int i = 0; i < SESSION_CLIENTS; i++)
+        pthread_join(clients[i], NULL);
+    uint64_t t1 = s730b_now_ns();
+
+    struct s730b_session_stats x;
+    s730b_session_get_stats(&ses, &x);
+    s730b_session_stop(&ses);
+
+    // 스레드별 지연 합쳐서 정렬
+    static uint64_t all[SESSION_CLIENTS * SESSION_MAX_REQ], hit[SESSION_CLIENTS * SESSION_MAX_REQ];
+    int nall = 0, nh = 0, ok = 0, bad = 0, failed = 0;
+    for (int i = 0; i < SESSION_CLIENTS; i++) {
+        memcpy(all + nall, b.lat[i], b.nlat[i] * sizeof(all[0]));
+        memcpy(hit + nh, b.lat_hit[i], b.nhit[i] * sizeof(hit[0]));
+        nall += b.nlat[i];
+        nh += b.nhit[i];
+        ok += b.ok[i];
+        bad += b.bad[i];
+        failed += b.failed[i];
+    }
+    qsort(all, nall, sizeof(all[0]), cmp_u64);
+    qsort(hit, nh, sizeof(hit[0]), cmp_u64);
+
+    printf("[*] %.2f s, 요청 스레드 %d, 뽑기 %d번 (%d ms씩), scale %.2f\n", (t1 - t0) / 1e9, SESSION_CLIENTS, b.replugs,
+           SESSION_OFF_MS, SESSION_SCALE);
+    printf("[*] 요청 %llu: 원본 프레임 %d, 다른 프레임 %d, 실패 %d (timeout %llu), 큐 최대 %d\n",
+           (unsigned long long)x.requests, ok, bad, failed, (unsigned long long)x.timed_out, x.queue_max);
+    printf("[*] 빠짐 %llu, 다시 붙음 %llu, replay 실패 %llu, 하다가 -4 받고 다시 한 요청 %llu (예전 드라이버면 die)\n",
+           (unsigned long long)x.detaches, (unsigned long long)x.reattaches, (unsigned long long)x.replay_failures,
+           (unsigned long long)x.requeued);
+    double re_avg = x.reattaches ? x.reattach_ns_sum / 1e6 / x.reattaches : 0;
+    printf("[*] 재연결 (붙음 -> reopen + init): avg %.2f ms (scale 1이면 약 %.0f ms), max %.2f ms / 빠짐 -> 준비 max %.2f ms\n",
+           re_avg, re_avg / SESSION_SCALE, x.reattach_ns_max / 1e6, x.outage_ns_max / 1e6);
+    printf("[*] 요청 지연 p50 %.2f / p99 %.2f / max %.2f ms, 빠짐 겪은 요청 %d개 p50 %.2f / p99 %.2f / max %.2f ms\n",
+           pct_ms(all, nall, 0.5), pct_ms(all, nall, 0.99), nall ? all[nall - 1] / 1e6 : 0, nh, pct_ms(hit, nh, 0.5),
+           pct_ms(hit, nh, 0.99), nh ? hit[nh - 1] / 1e6 : 0);
+    return bad || failed ? 1 : 0;
+}
+
+/*
+ * 단계별 카운터 (s730b_metrics)
+ * 1) hot path 비용: inc / observe 한 번 ns vs 그냥 전역 변수 ++
+ * 2) 스레드 4개가 동시에 올리고 읽을 때 합 맞는지 (slot 나눠 써서 lock 없음)
+ * 3) 시뮬레이터 캡처: transport 그대로 vs 카운터로 감싼 것 host us/cycle, 세어진 transfer / 오류
+ * 4) 내보내기: Prometheus text / JSON 크기 + 시간, -o FILE이면 거기 (textfile collector, .json이면 JSON)
+ * - 사용법: metrics [-o FILE] raw파일...
+ */
+#define METRICS_OPS     50000000
+#define METRICS_THREADS 4
+#define METRICS_PER_THR 2000000
+#define METRICS_CYCLES  2000
+
+static volatile uint64_t metrics_plain;
+
+static void *metrics_thread_main(void *arg) {
+    (void)arg;
+    for (int i = 0; i < METRICS_PER_THR; i++) {
+        s730b_metric_inc(MC_DETECT_PROBE);
+        s730b_metric_observe(MH_QUALITY, (uint64_t)(i % 101));
+    }
+    return NULL;
+}
+
+static double metrics_cycles_us(struct s730b_transport *t, struct s730b_sim *sim, unsigned char *buf, int *ok) {
+    struct s730b_proto_stats st;
+    uint64_t t0 = s730b_now_ns();
+    *ok = 0;
+    for (int i = 0; i < METRICS_CYCLES; i++) {
+        *ok += sim_cycle(t, sim, buf, &st) == 1;
+        if (sim->halted)
+            s730b_sim_replug(sim);
+    }
+    return (s730b_now_ns() - t0) / 1e3 / METRICS_CYCLES;
+}
+
+static int bench_metrics(int argc, char **argv) {
+    static struct s730b_sim sim;
+    static unsigned char buf[S730B_FRAME_BYTES];
+    struct s730b_transport plain, metered;
+    struct s730b_metrics_tap tap;
+    struct s730b_metrics_snapshot m;
+    const char *out = NULL;
+    int argi = 0;
+
+    if (argc >= 2 && strcmp(argv[0], "-o") == 0) {
+        out = argv[1];
+        argi = 2;
+    }
+    if (argc - argi < 1)
+        return 1;
+
+    // 1) hot path
+    uint64_t t0 = s730b_now_ns();
+    for (int i = 0; i < METRICS_OPS; i++)
+        metrics_plain++;
+    uint64_t t1 = s730b_now_ns();
+    for (int i = 0; i < METRICS_OPS; i++)
+        s730b_metric_inc(MC_DETECT_PROBE);
+    uint64_t t2 = s730b_now_ns();
+    for (int i = 0; i < METRICS_OPS; i++)
+        s730b_metric_observe(MH_CAPTURE_US, (uint64_t)(i & 0xfffff));
+    uint64_t t3 = s730b_now_ns();
+    printf("[*] %d번: 전역 변수 ++ %.2f ns, s730b_metric_inc %.2f ns, observe (12칸) %.2f ns\n", METRICS_OPS,
+           (double)(t1 - t0) / METRICS_OPS, (double)(t2 - t1) / METRICS_OPS, (double)(t3 - t2) / METRICS_OPS);
+
+    // 2) 여러 스레드
+    s730b_metrics_reset();
+    pthread_t th[METRICS_THREADS];
+    for (int i = 0; i < METRICS_THREADS; i++)
+        pthread_create(&th[i], NULL, metrics_thread_main, NULL);
+    for (int i = 0; i < METRICS_THREADS; i++)
+        pthread_join(th[i], NULL);
+    s730b_metrics_read(&m);
+    uint64_t hcount = 0;
+    for (int b = 0; b < METRICS_BUCKETS; b++)
+        hcount += m.h[MH_QUALITY][b];
+    uint64_t want = (uint64_t)METRICS_THREADS * METRICS_PER_THR;
+    int threads_ok = m.c[MC_DETECT_PROBE] == want && hcount == want;
+    printf("[*] 스레드 %d개 x %d: probe 합 %llu, 품질 히스토그램 합 %llu (기대 %llu) %s, slot %d개\n", METRICS_THREADS,
+           METRICS_PER_THR, (unsigned long long)m.c[MC_DETECT_PROBE], (unsigned long long)hcount,
+           (unsigned long long)want, threads_ok ? "ok" : "틀림", m.threads);
+
+    // 3) 시뮬레이터 캡처
+    s730b_sim_init(&sim, 0x730b);
+    for (int i = argi; i < argc; i++) {
+        if (s730b_sim_load(&sim, argv[i], 0) < 0) {
+            fprintf(stderr, "[-] %s: 84 chunk raw 아님\n", argv[i]);
+            return 1;
+        }
+    }
+    s730b_sim_transport(&sim, &plain);
+    sim.timing.scale = 0;
+    s730b_metrics_transport(&tap, &plain, &metered);
+    s730b_metrics_reset();
+    int ok_plain, ok_metered;
+    metrics_cycles_us(&plain, &sim, buf, &ok_plain);            // 워밍업
+    double us_plain = metrics_cycles_us(&plain, &sim, buf, &ok_plain);
+    double us_metered = metrics_cycles_us(&metered, &sim, buf, &ok_metered);
+    s730b_sim_set_fault(&sim, PROTO_AT_DATA, SIM_FAULT_TIMEOUT, 0.01);
+    s730b_sim_set_fault(&sim, PROTO_AT_ACK, SIM_FAULT_STALL, 0.01);
+    int ok_fault;
+    metrics_cycles_us(&metered, &sim, buf, &ok_fault);
+    s730b_metrics_read(&m);
+    printf("[*] init + 캡처 %d번: 그대로 %.1f us/cycle, 카운터 감쌈 %.1f us/cycle (%+.1f%%), 원본 프레임 %d / %d\n",
+           METRICS_CYCLES, us_plain, us_metered, 100.0 * (us_metered - us_plain) / us_plain, ok_plain, ok_metered);
+    printf("[*] 세어진 transfer: control %llu, bulk OUT %llu, bulk IN %llu (IN %.1f MB) / 오류 주입 %d cycle 뒤 "
+           "IN timeout %llu, OUT stall %llu (sim 주입 timeout %llu, stall %llu)\n",
+           (unsigned long long)m.c[MC_XFER_CTRL], (unsigned long long)m.c[MC_XFER_OUT],
+           (unsigned long long)m.c[MC_XFER_IN], m.c[MC_BYTES_IN] / 1e6, METRICS_CYCLES,
+           (unsigned long long)m.c[MC_ERR_IN_TIMEOUT], (unsigned long long)m.c[MC_ERR_OUT_STALL],
+           (unsigned long long)sim.faults[SIM_FAULT_TIMEOUT], (unsigned long long)sim.faults[SIM_FAULT_STALL]);
+    int count_ok = m.c[MC_ERR_IN_TIMEOUT] == sim.faults[SIM_FAULT_TIMEOUT] &&
+                   m.c[MC_ERR_OUT_STALL] >= sim.faults[SIM_FAULT_STALL];
+
+    // 4) 내보내기
+    char *text = NULL, *json = NULL;
+    size_t text_len = 0, json_len = 0;
+    FILE *f = open_memstream(&text, &text_len);
+    t0 = s730b_now_ns();
+    s730b_metrics_write_prom(f, &m);
+    fclose(f);
+    t1 = s730b_now_ns();
+    f = open_memstream(&json, &json_len);
+    s730b_metrics_write_json(f, &m);
+    fclose(f);
+    t2 = s730b_now_ns();
+    printf("[*] 내보내기: Prometheus text %zu B %.1f us, JSON %zu B %.1f us\n", text_len, (t1 - t0) / 1e3, json_len,
+           (t2 - t1) / 1e3);
+    free(text);
+    free(json);
+    if (out) {
+        if (s730b_metrics_export(out) < 0) {
+            fprintf(stderr, "[-] %s 쓰기 실패\n", out);
+            return 1;
+        }
+        printf("[+] %s\n", out);
+    }
+    return threads_ok && count_ok && ok_plain == METRICS_CYCLES && ok_metered == METRICS_CYCLES ? 0 : 1;
+}
+
+/*
+ * 프레임 검사 (s730b_integrity)
+ * 1) CRC32C 맞는지 ("123456789" = e3069283) + SSE4.2 vs 표 버전 속도 (이미지 부분 / raw 전체)
+ * 2) 시뮬레이터 캡처 (복구 없이) 에 짧은 chunk / timeout / 예전 버퍼 다시 보냄(stale) 섞어서
+ *    진짜 망가진 프레임 (원본이랑 다름 / 잘림) vs s730b_frame_check가 잡은 것, 예전 길이 검사 (save_pgm_from_raw)랑 비교
+ *    - 센서 잡음 흉내: 캡처마다 이미지 픽셀 하나 bit 바꿈 (그래야 진짜 프레임끼리 CRC 안 같음)
+ * - 사용법: integrity raw파일...
+ */
+#define INTEGRITY_CRC_ITERS 20000
+#define INTEGRITY_CYCLES    3000
+#define INTEGRITY_STALE     0.02
+
+static int bench_integrity(int argc, char **argv) {
+    static struct s730b_sim sim;
+    static unsigned char buf[S730B_FRAME_BYTES];
+    struct s730b_transport t;
+    struct s730b_proto_stats st;
+    struct s730b_integrity ig;
+    struct s730b_frame_desc fd;
+
+    if (argc < 1)
+        return 1;
+    s730b_sim_init(&sim, 0x730b);
+    for (int i = 0; i < argc; i++) {
+        if (s730b_sim_load(&sim, argv[i], 0) < 0) {
+            fprintf(stderr, "[-] %s: 84 chunk raw 아님\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // 1) CRC32C
+    const char *vec = "123456789";
+    uint32_t c_hw = s730b_crc32c(0, vec, 9), c_sw = s730b_crc32c_sw(0, vec, 9);
+    uint32_t f_hw = s730b_crc32c(0, sim.frames[0], S730B_FRAME_BYTES);
+    uint32_t f_sw = s730b_crc32c_sw(s730b_crc32c_sw(0, sim.frames[0], 1000), sim.frames[0] + 1000,
+                                    S730B_FRAME_BYTES - 1000);
+    int crc_ok = c_hw == 0xe3069283u && c_sw == 0xe3069283u && f_hw == f_sw;
+    printf("[*] CRC32C \"123456789\": %08x / 표 %08x, 프레임 전체 %08x / 표 (나눠서) %08x %s, SSE4.2 %s\n", c_hw, c_sw,
+           f_hw, f_sw, crc_ok ? "ok" : "틀림", s730b_crc32c_hw() ? "씀" : "없음");
+    const size_t lens[2] = { IMG_SIZE, S730B_FRAME_BYTES };
+    const char *names[2] = { "이미지 부분", "raw 전체" };
+    for (int k = 0; k < 2; k++) {
+        volatile uint32_t sink = 0;
+        uint64_t t0 = s730b_now_ns();
+        for (int i = 0; i < INTEGRITY_CRC_ITERS; i++)
+            sink ^= s730b_crc32c(0, sim.frames[0] + (k ? 0 : IMG_OFFSET), lens[k]);
+        uint64_t t1 = s730b_now_ns();
+        for (int i = 0; i < INTEGRITY_CRC_ITERS; i++)
+            sink ^= s730b_crc32c_sw(0, sim.frames[0] + (k ? 0 : IMG_OFFSET), lens[k]);
+        uint64_t t2 = s730b_now_ns();
+        double n = (double)lens[k] * INTEGRITY_CRC_ITERS;
+        printf("    %-12s %6zu B: 기본 %.2f us (%.0f MB/s), 표 %.2f us (%.0f MB/s)\n", names[k], lens[k],
+               (t1 - t0) / 1e3 / INTEGRITY_CRC_ITERS, n / ((t1 - t0) / 1e3), (t2 - t1) / 1e3 / INTEGRITY_CRC_ITERS,
+               n / ((t2 - t1) / 1e3));
+    }
+
+    // 2) 캡처 검사
+    s730b_sim_transport(&sim, &t);
+    sim.timing.scale = 0;
+    s730b_sim_set_fault(&sim, PROTO_AT_DATA, SIM_FAULT_SHORT, 0.0003);
+    s730b_sim_set_fault(&sim, PROTO_AT_DATA, SIM_FAULT_TIMEOUT, 0.0003);
+    s730b_integrity_init(&ig);
+    int bad = 0, stale = 0, flagged = 0, missed = 0, false_flag = 0, old_pass_bad = 0, dup_hit = 0;
+    int why[4] = { 0 }, prev_ok = 0;
+    uint64_t check_ns = 0;
+    for (int i = 0; i < INTEGRITY_CYCLES; i++) {
+        int is_stale = i > 0 && bench_rand(1000) < INTEGRITY_STALE * 1000;
+        if (is_stale) {
+            sim.next_frame--;       // 바로 앞 프레임 그대로 다시
+        } else {
+            int f = sim.next_frame % sim.nframes;
+            sim.frames[f][IMG_OFFSET + bench_rand(IMG_SIZE)] ^= 1;
+        }
+        // 앞 캡처가 온전히 넘어간 경우만 stale (앞이 망가졌으면 다시 보낸 게 처음 보는 프레임)
+        is_stale = is_stale && prev_ok;
+        prev_ok = 0;
+        if (s730b_proto_init(&t, &st) < 0)
+            continue;
+        int len = s730b_proto_capture(&t, S730B_NUM_PACKETS, 0, buf, S730B_FRAME_BYTES, &st);
+        if (len < 0)
+            continue;
+        int corrupt = len != S730B_FRAME_BYTES || memcmp(buf, sim.frames[sim.frame], len) != 0;
+        uint64_t t0 = s730b_now_ns();
+        uint32_t flags = s730b_frame_check(&ig, buf, len, &st, &fd);
+        check_ns += s730b_now_ns() - t0;
+        int want = corrupt || is_stale;
+        prev_ok = !want;
+        bad += corrupt;
+        stale += is_stale;
+        flagged += flags != 0;
+        missed += want && !flags;
+        false_flag += !want && flags;
+        dup_hit += is_stale && (flags & FRAME_DUPLICATE);
+        old_pass_bad += want && len >= IMG_OFFSET + IMG_SIZE;
+        for (int k = 0; k < 4; k++)
+            why[k] += !!(flags & (1u << k));
+    }
+    printf("[*] 캡처 %d번 (짧은 chunk / timeout 0.03%%/chunk, stale %.0f%%): 망가짐 %d + stale %d, 잡음 %d "
+           "(truncated %d, short_chunk %d, no_image %d, duplicate %d)\n",
+           INTEGRITY_CYCLES, INTEGRITY_STALE * 100, bad, stale, flagged, why[0], why[1], why[2], why[3]);
+    printf("[*] 놓침 %d, 멀쩡한데 버림 %d, stale 중 중복으로 잡음 %d / %d, 검사 %.2f us/프레임\n", missed, false_flag,
+           dup_hit, stale, check_ns / 1e3 / INTEGRITY_CYCLES);
+    printf("[*] 예전 길이 검사 (save_pgm_from_raw, 이미지 부분까지 오면 통과)였으면 망가진 / stale 프레임 %d개 그대로 씀\n",
+           old_pass_bad);
+    return crc_ok && !missed && !false_flag ? 0 : 1;
+}
+
+struct bench_cmd {
+    const char *name;
+    int (*fn)(int, char **);
+    const char *help;
+};
+
+static const struct bench_cmd bench_cmds[] = {
+    { "destripe", bench_destripe, "세로줄/가로줄 제거 전후 ridge contrast + 속도" },
+    { "quality",  bench_quality,  "프레임 품질 점수 (coverage/contrast/coherence) + 속도" },
+    { "fuse",     bench_fuse,     "burst K장 정합 + 2배 격자 합성 vs 한장 업스케일 (합성 burst)" },
+    { "gabor",    bench_gabor,    "방향장 + Gabor 융선 강조, 112x96 / 224x192 프레임당 시간" },
+    { "minutiae", bench_minutiae, "Gabor 강조 프레임에서 끝점/분기점 추출, 단계별 프레임당 시간" },
+    { "match",    bench_match,    "1:1 매처 TAR/FAR (파일이름 label + 가짜 터치) + 초당 비교 횟수" },
+    { "ident",    bench_ident,    "1:N 식별, 가짜 갤러리 (-n 크기) 대상 스레드 수별 검색 시간 / 코어당 비교 횟수" },
+    { "gallery",  bench_gallery,  "mmap 갤러리 파일 append/열기 시간 + 매핑된 레코드에서 바로 1:N 검색" },
+    { "prefilter", bench_prefilter, "비트 descriptor로 후보 줄이기: 후보 비율별 정답 놓친 비율 + 전체 검색 대비 속도" },
+    { "detect",   bench_detect,   "손가락 감지: 0xFF 비율 heuristic vs baseline 차이, probe chunk 수별 ROC + probe 시간" },
+    { "texture",  bench_texture,  "probe 무늬 분류기 (gradient/융선 주기/entropy) vs 0xFF 비율: 경우별 판정 + coverage + 시간" },
+    { "enroll",   bench_enroll,   "5번 눌러 등록: 캡처별 템플릿 5개 vs 합성 템플릿 1개 TAR/FAR + 등록/verify 시간" },
+    { "png",      bench_png,      "burst 저장: 예전 PGM vs 버퍼 PGM vs PNG stored/fast, frames/s + 파일 크기" },
+    { "caplog",   bench_caplog,   "캡처 로그 append 지연(p50/p99), 버린 수, fdatasync 횟수 + mmap reader vs 프레임마다 파일" },
+    { "codec",    bench_codec,    "raw 무손실 codec: 파일별 압축률 vs PNG, 인코드/디코드 MB/s, 압축 캡처 로그 왕복" },
+    { "sim",      bench_sim,      "센서 모델로 프로토콜 돌리기: 규칙 위반 반응, host 처리량, 트레이스 타이밍, 오류 주입별 결과" },
+    { "stress",   bench_stress,   "fault 주입 (stall/timeout/short/disconnect x init/chunk/ACK 지점): 첫 시도 vs 복구 성공률, 복구 p99" },
+    { "metrics",  bench_metrics,  "단계별 카운터: inc/observe ns, 스레드 여러 개 합, 캡처에 감쌌을 때 비용, Prometheus/JSON 내보내기" },
+    { "integrity", bench_integrity, "프레임 검사: CRC32C SSE4.2 vs 표 속도, 잘린 / 밀린 / stale 프레임 잡는 비율 vs 예전 길이 검사" },
+    { "session",  bench_session,  "뽑았다 꽂기 세션: 캡처 요청 큐에 남았다가 다시 붙으면 끝나는지, 재연결 시간 + 요청 지연 p99" },
+};
+static const size_t bench_cmds_len = sizeof(bench_cmds) / sizeof(bench_cmds[0]);
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s <command> [args...]\n\n", prog);
+    for (size_t i = 0; i < bench_cmds_len; i++)
+        fprintf(stderr, "  %-12s %s\n", bench_cmds[i].name, bench_cmds[i].help);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (size_t i = 0; i < bench_cmds_len; i++) {
+        if (strcmp(argv[1], bench_cmds[i].name) == 0)
+            return bench_cmds[i].fn(argc - 2, argv + 2);
+    }
+
+    usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,423 @@
+/*
+ * s730b_caplog.c
+ *
+ * - append는 slot 큐에 복사만, writer 스레드가 레코드 쓰고 16개 / 500ms마다 fdatasync
+ * - 세그먼트 다 차면 index + footer 붙이고 다음 파일, reader는 mmap (footer 없으면 레코드 훑어서 복구)
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "s730b_caplog.h"
+#include "s730b_codec.h"
+
+#define ALIGN8(x)  (((x) + 7) & ~(size_t)7)
+
+_Static_assert(sizeof(struct s730b_caplog_meta) == 64, "caplog meta must be 64 bytes");
+_Static_assert(sizeof(struct s730b_caplog_header) == 64, "caplog header must be 64 bytes");
+_Static_assert(sizeof(struct s730b_caplog_record) == 16, "caplog record header must be 16 bytes");
+_Static_assert(sizeof(struct s730b_caplog_entry) == 24, "caplog index entry must be 24 bytes");
+_Static_assert(sizeof(struct s730b_caplog_footer) == 24, "caplog footer must be 24 bytes");
+_Static_assert((CAPLOG_QUEUE & (CAPLOG_QUEUE - 1)) == 0, "CAPLOG_QUEUE must be a power of two");
+
+static uint64_t now_ns(clockid_t clk) {
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int write_full(int fd, const void *buf, size_t len) {
+    const unsigned char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+void s730b_caplog_segment_path(const char *dir, uint32_t segment, char *out, size_t len) {
+    snprintf(out, len, "%s/seg_%06u.s7l", dir, segment);
+}
+
+/* ---------------- writer ---------------- */
+
+static int segment_open(struct s730b_caplog *log) {
+    char path[600];
+    struct s730b_caplog_header h;
+
+    s730b_caplog_segment_path(log->dir, log->segment, path, sizeof(path));
+    log->fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (log->fd < 0)
+        return -1;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CAPLOG_MAGIC, sizeof(h.magic));
+    h.version = CAPLOG_VERSION;
+    h.header_size = sizeof(h);
+    h.segment = log->segment;
+    h.meta_size = sizeof(struct s730b_caplog_meta);
+    h.created_ns = now_ns(CLOCK_REALTIME);
+    if (write_full(log->fd, &h, sizeof(h)) < 0) {
+        close(log->fd);
+        log->fd = -1;
+        return -1;
+    }
+    log->seg_bytes = sizeof(h);
+    log->count = 0;
+    log->segments++;
+    return 0;
+}
+
+// index + footer 붙이고 닫음
+static int segment_seal(struct s730b_caplog *log) {
+    struct s730b_caplog_footer f;
+
+    if (log->fd < 0)
+        return 0;
+    memset(&f, 0, sizeof(f));
+    memcpy(f.magic, CAPLOG_INDEX_MAGIC, sizeof(f.magic));
+    f.index_offset = log->seg_bytes;
+    f.count = (uint32_t)log->count;
+
+    int r = 0;
+    if (write_full(log->fd, log->index, (size_t)log->count * sizeof(log->index[0])) < 0 ||
+        write_full(log->fd, &f, sizeof(f)) < 0 || fdatasync(log->fd) < 0)
+        r = -1;
+    if (close(log->fd) < 0)
+        r = -1;
+    log->fd = -1;
+    log->syncs++;
+    return r;
+}
+
+static int write_record(struct s730b_caplog *log, const struct s730b_caplog_slot *s) {
+    static const unsigned char pad[8];
+    struct s730b_caplog_meta meta = s->meta;
+    const unsigned char *data = s->data;
+    uint32_t len = s->len;
+
+    // 압축은 여기서 (writer 스레드), 안 줄면 그대로
+    if (log->coded) {
+        long n = s730b_codec_encode(s->data, (int)s->len, log->coded, s730b_codec_bound(CAPLOG_MAX_FRAME));
+        if (n > 0 && n < (long)s->len) {
+            data = log->coded;
+            len = (uint32_t)n;
+            meta.flags |= CAPLOG_CODED;
+        }
+    }
+
+    struct s730b_caplog_record rec = { CAPLOG_REC_MAGIC, len, log->seq };
+    size_t padded = ALIGN8(len);
+    struct iovec iov[4] = {
+        { &rec, sizeof(rec) },
+        { &meta, sizeof(meta) },
+        { (void *)data, len },
+        { (void *)pad, padded - len },
+    };
+    size_t total = sizeof(rec) + sizeof(meta) + padded;
+
+    if (log->seg_bytes + total > CAPLOG_SEGMENT_MAX && log->count > 0) {
+        if (segment_seal(log) < 0)
+            return -1;
+        log->segment++;
+        if (segment_open(log) < 0)
+            return -1;
+    }
+
+    if (log->count == log->cap) {
+        int cap = log->cap ? log->cap * 2 : 256;
+        struct s730b_caplog_entry *idx = realloc(log->index, cap * sizeof(*idx));
+        if (!idx)
+            return -1;
+        log->index = idx;
+        log->cap = cap;
+    }
+
+    ssize_t n;
+    do {
+        n = writev(log->fd, iov, 4);
+    } while (n < 0 && errno == EINTR);
+    if (n != (ssize_t)total) {
+        // 짧게 써졌으면 나머지 마저
+        if (n < 0)
+            return -1;
+        size_t done = (size_t)n;
+        for (int k = 0; k < 4; k++) {
+            if (done >= iov[k].iov_len) {
+                done -= iov[k].iov_len;
+                continue;
+            }
+            if (write_full(log->fd, (const unsigned char *)iov[k].iov_base + done, iov[k].iov_len - done) < 0)
+                return -1;
+            done = 0;
+        }
+    }
+
+    struct s730b_caplog_entry *e = &log->index[log->count++];
+    e->offset = log->seg_bytes;
+    e->ts_ns = meta.ts_ns;
+    e->len = len;
+    e->flags = meta.flags;
+    log->seg_bytes += total;
+    log->bytes += total;
+    log->raw_bytes += s->len;
+    log->seq++;
+    log->written++;
+    return 0;
+}
+
+static void *writer_main(void *arg) {
+    struct s730b_caplog *log = arg;
+    int unsynced = 0;
+    uint64_t last_sync = now_ns(CLOCK_MONOTONIC);
+
+    for (;;) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += CAPLOG_SYNC_MS * 1000000L;
+        ts.tv_sec += ts.tv_nsec / 1000000000L;
+        ts.tv_nsec %= 1000000000L;
+        while (sem_timedwait(&log->wake, &ts) < 0 && errno == EINTR)
+            ;
+
+        // 쌓인 거 전부
+        uint64_t head = __atomic_load_n(&log->head, __ATOMIC_ACQUIRE);
+        while (log->tail != head) {
+            struct s730b_caplog_slot *s = &log->slots[log->tail & (CAPLOG_QUEUE - 1)];
+            if (!log->error && write_record(log, s) < 0)
+                __atomic_store_n(&log->error, 1, __ATOMIC_RELEASE);
+            __atomic_store_n(&log->tail, log->tail + 1, __ATOMIC_RELEASE);
+            unsynced++;
+            head = __atomic_load_n(&log->head, __ATOMIC_ACQUIRE);
+        }
+
+        uint64_t now = now_ns(CLOCK_MONOTONIC);
+        if (unsynced && log->fd >= 0 && !log->error &&
+            (unsynced >= CAPLOG_SYNC_RECORDS || now - last_sync >= CAPLOG_SYNC_MS * 1000000ull)) {
+            if (fdatasync(log->fd) < 0)
+                __atomic_store_n(&log->error, 1, __ATOMIC_RELEASE);
+            log->syncs++;
+            unsynced = 0;
+            last_sync = now;
+        }
+
+        if (__atomic_load_n(&log->stop, __ATOMIC_ACQUIRE) &&
+            log->tail == __atomic_load_n(&log->head, __ATOMIC_ACQUIRE))
+            break;
+    }
+    return NULL;
+}
+
+// dir 안 세그먼트 번호 중 제일 큰 것 + 1
+static uint32_t next_segment(const char *dir) {
+    uint32_t next = 0;
+    DIR *d = opendir(dir);
+    struct dirent *e;
+
+    if (!d)
+        return 0;
+    while ((e = readdir(d))) {
+        unsigned n;
+        if (sscanf(e->d_name, "seg_%u.s7l", &n) == 1 && n + 1 > next)
+            next = n + 1;
+    }
+    closedir(d);
+    return next;
+}
+
+int s730b_caplog_open(struct s730b_caplog *log, const char *dir, int flags) {
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+    snprintf(log->dir, sizeof(log->dir), "%s", dir);
+
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST)
+        return -1;
+    log->segment = next_segment(dir);
+    log->slots = malloc(CAPLOG_QUEUE * sizeof(*log->slots));
+    if (flags & CAPLOG_OPEN_CODEC)
+        log->coded = malloc(s730b_codec_bound(CAPLOG_MAX_FRAME));
+    if (!log->slots || ((flags & CAPLOG_OPEN_CODEC) && !log->coded))
+        goto fail;
+    if (segment_open(log) < 0 || sem_init(&log->wake, 0, 0) < 0)
+        goto fail;
+    if (pthread_create(&log->thread, NULL, writer_main, log) != 0) {
+        sem_destroy(&log->wake);
+        close(log->fd);
+        goto fail;
+    }
+    return 0;
+
+fail:
+    free(log->slots);
+    free(log->coded);
+    log->slots = NULL;
+    log->coded = NULL;
+    return -1;
+}
+
+int s730b_caplog_append(struct s730b_caplog *log, const void *frame, int len, const struct s730b_caplog_meta *meta) {
+    uint64_t head = log->head;
+
+    if (len < 0 || len > CAPLOG_MAX_FRAME || __atomic_load_n(&log->error, __ATOMIC_ACQUIRE) ||
+        head - __atomic_load_n(&log->tail, __ATOMIC_ACQUIRE) >= CAPLOG_QUEUE) {
+        __atomic_add_fetch(&log->dropped, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    struct s730b_caplog_slot *s = &log->slots[head & (CAPLOG_QUEUE - 1)];
+    s->meta = *meta;
+    s->len = (uint32_t)len;
+    memcpy(s->data, frame, len);
+    __atomic_store_n(&log->head, head + 1, __ATOMIC_RELEASE);
+    sem_post(&log->wake);
+    return 0;
+}
+
+int s730b_caplog_close(struct s730b_caplog *log) {
+    if (!log->slots)
+        return -1;
+    __atomic_store_n(&log->stop, 1, __ATOMIC_RELEASE);
+    sem_post(&log->wake);
+    pthread_join(log->thread, NULL);
+
+    int r = log->error ? -1 : 0;
+    if (segment_seal(log) < 0)
+        r = -1;
+    sem_destroy(&log->wake);
+    free(log->slots);
+    free(log->index);
+    free(log->coded);
+    log->slots = NULL;
+    log->index = NULL;
+    log->coded = NULL;
+    return r;
+}
+
+/* ---------------- reader ---------------- */
+
+// footer 없는 세그먼트: record header 따라가면서 index 다시 만듦 (중간에 잘린 마지막 레코드는 버림)
+static int scan_records(struct s730b_caplog_reader *r) {
+    size_t off = r->hdr->header_size, cap = 0;
+
+    while (off + sizeof(struct s730b_caplog_record) + sizeof(struct s730b_caplog_meta) <= r->map_len) {
+        const struct s730b_caplog_record *rec = (const void *)(r->map + off);
+        size_t total = sizeof(*rec) + sizeof(struct s730b_caplog_meta) + ALIGN8((size_t)rec->len);
+        if (rec->magic != CAPLOG_REC_MAGIC || rec->len > CAPLOG_MAX_FRAME || off + total > r->map_len)
+            break;
+
+        if ((size_t)r->count == cap) {
+            cap = cap ? cap * 2 : 256;
+            struct s730b_caplog_entry *idx = realloc(r->scanned, cap * sizeof(*idx));
+            if (!idx)
+                return -1;
+            r->scanned = idx;
+        }
+        const struct s730b_caplog_meta *m = (const void *)(rec + 1);
+        struct s730b_caplog_entry *e = &r->scanned[r->count++];
+        e->offset = off;
+        e->ts_ns = m->ts_ns;
+        e->len = rec->len;
+        e->flags = m->flags;
+        off += total;
+    }
+    r->index = r->scanned;
+    return 0;
+}
+
+int s730b_caplog_reader_open(struct s730b_caplog_reader *r, const char *path) {
+    struct stat st;
+
+    memset(r, 0, sizeof(*r));
+    r->fd = open(path, O_RDONLY);
+    if (r->fd < 0)
+        return -1;
+    if (fstat(r->fd, &st) < 0 || (size_t)st.st_size < sizeof(struct s730b_caplog_header))
+        goto fail;
+
+    r->map_len = (size_t)st.st_size;
+    r->map = mmap(NULL, r->map_len, PROT_READ, MAP_SHARED, r->fd, 0);
+    if (r->map == MAP_FAILED) {
+        r->map = NULL;
+        goto fail;
+    }
+    r->hdr = (const struct s730b_caplog_header *)r->map;
+    if (memcmp(r->hdr->magic, CAPLOG_MAGIC, 8) != 0 || r->hdr->version != CAPLOG_VERSION ||
+        r->hdr->meta_size != sizeof(struct s730b_caplog_meta) || r->hdr->header_size > r->map_len)
+        goto fail;
+
+    if (r->map_len >= sizeof(struct s730b_caplog_header) + sizeof(struct s730b_caplog_footer)) {
+        const struct s730b_caplog_footer *f = (const void *)(r->map + r->map_len - sizeof(*f));
+        if (memcmp(f->magic, CAPLOG_INDEX_MAGIC, 8) == 0 &&
+            f->index_offset + (uint64_t)f->count * sizeof(struct s730b_caplog_entry) + sizeof(*f) == r->map_len) {
+            r->index = (const struct s730b_caplog_entry *)(r->map + f->index_offset);
+            r->count = (int)f->count;
+            r->sealed = 1;
+            return 0;
+        }
+    }
+    if (scan_records(r) < 0)
+        goto fail;
+    return 0;
+
+fail:
+    s730b_caplog_reader_close(r);
+    return -1;
+}
+
+void s730b_caplog_reader_close(struct s730b_caplog_reader *r) {
+    if (r->map)
+        munmap(r->map, r->map_len);
+    if (r->fd >= 0)
+        close(r->fd);
+    free(r->scanned);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
+
+int s730b_caplog_get(const struct s730b_caplog_reader *r, int i, const unsigned char **frame, int *len,
+                     const struct s730b_caplog_meta **meta) {
+    if (i < 0 || i >= r->count)
+        return -1;
+    const struct s730b_caplog_entry *e = &r->index[i];
+    if (e->offset + sizeof(struct s730b_caplog_record) + sizeof(struct s730b_caplog_meta) + e->len > r->map_len)
+        return -1;
+
+    const unsigned char *p = r->map + e->offset + sizeof(struct s730b_caplog_record);
+    if (meta)
+        *meta = (const struct s730b_caplog_meta *)p;
+    *frame = p + sizeof(struct s730b_caplog_meta);
+    *len = (int)e->len;
+    return 0;
+}
+
+int s730b_caplog_read(const struct s730b_caplog_reader *r, int i, unsigned char *buf, int cap,
+                      const struct s730b_caplog_meta **meta) {
+    const struct s730b_caplog_meta *m;
+    const unsigned char *frame;
+    int len;
+
+    if (s730b_caplog_get(r, i, &frame, &len, &m) < 0)
+        return -1;
+    if (meta)
+        *meta = m;
+    if (m->flags & CAPLOG_CODED)
+        return (int)s730b_codec_decode(frame, (size_t)len, buf, (size_t)cap);
+    if (len > cap)
+        return -1;
+    memcpy(buf, frame, len);
+    return len;
+}
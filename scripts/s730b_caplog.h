@@ -0,0 +1,173 @@
+/*
+ * s730b_caplog.h
+ *
+ * - 캡처 로그: capture.raw 덮어쓰기 / 프레임마다 파일 하나 대신, 세그먼트 파일에 계속 append
+ * - 레코드 = raw 프레임 그대로 + 메타데이터 (시각, 감지 통계, 전송 시간, 완전한지)
+ * - 세그먼트 다 차면(CAPLOG_SEGMENT_MAX) 끝에 index 붙이고 닫음 -> 다음 세그먼트
+ *
+ * 세그먼트 파일 구조 (리틀엔디안, 이 머신 struct 그대로):
+ *
+ *   [header 64B][record][record]...[index: count x 24B][footer 24B]
+ *   record = [record header 16B][meta 64B][frame (8바이트 배수로 패딩)]
+ *
+ * - footer가 없으면 (쓰다가 죽었거나 아직 쓰는 중) reader가 record header 따라가면서 index 다시 만듦
+ * - writer: 캡처 루프는 큐에 복사만 하고 리턴, 파일 쓰기 / fdatasync는 writer 스레드가
+ *   (CAPLOG_SYNC_RECORDS개 또는 CAPLOG_SYNC_MS마다 한 번), 큐 꽉 차면 기다리지 않고 버림 (dropped)
+ * - append는 스레드 하나에서만 부름 (single producer)
+ * - CAPLOG_OPEN_CODEC으로 열면 writer 스레드가 s730b_codec으로 압축해서 씀 (캡처 루프 쪽 비용 없음)
+ *   -> meta.flags에 CAPLOG_CODED, record len은 압축된 길이, 읽을 땐 s730b_caplog_read가 풀어줌
+ */
+
+#ifndef S730B_CAPLOG_H
+#define S730B_CAPLOG_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CAPLOG_MAGIC        "S730BLOG"
+#define CAPLOG_INDEX_MAGIC  "S730BIDX"
+#define CAPLOG_VERSION      1
+#define CAPLOG_REC_MAGIC    0x314d5246u     // "FRM1"
+#define CAPLOG_SEGMENT_MAX  (64u << 20)     // 세그먼트 하나 최대 크기 (약 3000 프레임)
+#define CAPLOG_MAX_FRAME    32768           // 레코드 하나 최대 raw 크기
+#define CAPLOG_QUEUE        32              // writer 큐 칸 수 (2의 거듭제곱)
+#define CAPLOG_SYNC_RECORDS 16
+#define CAPLOG_SYNC_MS      500
+
+// meta.flags
+#define CAPLOG_COMPLETE     0x1     // chunk 다 받음
+#define CAPLOG_SHORT_CHUNK  0x2     // 256B 안 되는 chunk 있었음
+#define CAPLOG_RETRY        0x4     // 품질 미달로 다시 찍은 프레임
+#define CAPLOG_BURST        0x8     // burst 중 한 장
+#define CAPLOG_CODED        0x10    // frame이 s730b_codec으로 압축됨
+
+// s730b_caplog_open flags
+#define CAPLOG_OPEN_CODEC   0x1
+
+struct s730b_caplog_meta {
+    uint64_t ts_ns;             // 캡처 시각 (CLOCK_REALTIME)
+    uint32_t flags;
+    int16_t quality;            // 품질 점수, -1 = 모름
+    uint16_t chunks_expected;   // 데이터 chunk 수 (상태 응답 빼고)
+    uint16_t chunks_received;
+    uint16_t detect_probes;     // 손가락 기다리는 동안 probe 수
+    int32_t detect_score;       // 마지막 probe 판정 점수 (판정기마다 단위 다름, 0 = 없음)
+    uint32_t wait_us;           // 손가락 기다린 시간
+    uint32_t capture_us;        // 캡처 전송 전체
+    uint32_t chunk_max_us;      // chunk 하나 (control + bulk IN + ACK) 최대
+    uint32_t chunk_avg_us;
+    uint32_t image_crc;         // 이미지 부분 CRC32C (s730b_integrity, 0 = 모름)
+    uint8_t reserved[20];
+};
+
+struct s730b_caplog_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t segment;           // 세그먼트 번호
+    uint32_t meta_size;         // sizeof(struct s730b_caplog_meta)
+    uint64_t created_ns;
+    uint8_t reserved[32];
+};
+
+struct s730b_caplog_record {
+    uint32_t magic;             // CAPLOG_REC_MAGIC
+    uint32_t len;               // frame 바이트 수 (패딩 전)
+    uint64_t seq;               // 로그 전체에서 몇 번째 (세그먼트 넘어가도 이어짐)
+};
+
+struct s730b_caplog_entry {
+    uint64_t offset;            // record header 위치
+    uint64_t ts_ns;
+    uint32_t len;
+    uint32_t flags;
+};
+
+struct s730b_caplog_footer {
+    char magic[8];
+    uint64_t index_offset;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+/* ---------------- writer ---------------- */
+
+struct s730b_caplog_slot {
+    struct s730b_caplog_meta meta;
+    uint32_t len;
+    unsigned char data[CAPLOG_MAX_FRAME];
+};
+
+struct s730b_caplog {
+    char dir[512];
+    int fd;
+    uint32_t segment;
+    uint64_t seg_bytes;
+    uint64_t seq;
+    struct s730b_caplog_entry *index;   // 지금 세그먼트 index (seal 때 씀)
+    int count, cap;
+
+    // SPSC 큐: head는 append만, tail은 writer만 올림
+    struct s730b_caplog_slot *slots;
+    uint64_t head, tail;
+    sem_t wake;
+    pthread_t thread;
+    int stop;
+    unsigned char *coded;       // CAPLOG_OPEN_CODEC일 때 writer 스레드 압축 버퍼
+
+    // 통계 (writer 스레드가 씀, close 후 읽기)
+    uint64_t written;
+    uint64_t dropped;
+    uint64_t syncs;
+    uint64_t segments;
+    uint64_t bytes;
+    uint64_t raw_bytes;         // 압축 전 frame 바이트 합
+    int error;                  // 쓰기 실패하면 1 (이후 append 전부 버림)
+};
+
+/*
+ * dir 안에 새 세그먼트 열고 writer 스레드 시작 (dir 없으면 만듦, 기존 세그먼트 번호 다음부터)
+ * - flags: 0 또는 CAPLOG_OPEN_CODEC
+ */
+int s730b_caplog_open(struct s730b_caplog *log, const char *dir, int flags);
+
+/*
+ * 큐에 복사하고 바로 리턴 (파일 I/O 없음)
+ * - 0 = 큐에 넣음, -1 = 큐 꽉 참 / 너무 큼 / writer 오류 -> 버림 (dropped 증가)
+ */
+int s730b_caplog_append(struct s730b_caplog *log, const void *frame, int len, const struct s730b_caplog_meta *meta);
+
+/* 큐 다 쓰고 index 붙여서 닫음, 0 = 성공 */
+int s730b_caplog_close(struct s730b_caplog *log);
+
+/* ---------------- reader ---------------- */
+
+struct s730b_caplog_reader {
+    int fd;
+    unsigned char *map;
+    size_t map_len;
+    const struct s730b_caplog_header *hdr;
+    const struct s730b_caplog_entry *index;
+    struct s730b_caplog_entry *scanned;     // footer 없을 때 다시 만든 index (malloc)
+    int count;
+    int sealed;                             // footer 있었음
+};
+
+/* 세그먼트 파일 하나 mmap으로 열기 */
+int s730b_caplog_reader_open(struct s730b_caplog_reader *r, const char *path);
+void s730b_caplog_reader_close(struct s730b_caplog_reader *r);
+
+/* i번째 레코드 (매핑된 페이지 그대로, 복사 없음, CAPLOG_CODED면 압축된 그대로), 0 = 성공 */
+int s730b_caplog_get(const struct s730b_caplog_reader *r, int i, const unsigned char **frame, int *len,
+                     const struct s730b_caplog_meta **meta);
+
+/* i번째 레코드를 buf에 raw로 (압축됐으면 풀어서), 리턴 = raw 바이트 수, -1 = 실패 */
+int s730b_caplog_read(const struct s730b_caplog_reader *r, int i, unsigned char *buf, int cap,
+                      const struct s730b_caplog_meta **meta);
+
+/* dir/seg_NNNNNN.s7l */
+void s730b_caplog_segment_path(const char *dir, uint32_t segment, char *out, size_t len);
+
+#endif
@@ -0,0 +1,468 @@
+/*
+ * s730b_codec.c
+ *
+ * - 구간 3개 (앞 180B / 이미지 / 나머지) 줄 단위 예측 (left / up / median / copy) + 적응 range coder
+ * - 잔차는 zigzag, 윗줄 활동량으로 context 5개
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "s730b_codec.h"
+#include "s730b_frame.h"
+
+#define CODEC_REGIONS   3
+#define CODEC_HDR       16
+#define CODEC_DESC      12      // 구간마다 코딩 길이 / 원래 길이 / 줄 폭
+#define CODEC_MAX_WIDTH 256
+#define CODEC_CTX       5       // 윗줄 활동량 구간 수
+#define CODEC_INC       24      // 나온 기호 빈도 증가량
+#define CODEC_LIMIT     (1 << 13)   // 빈도 합이 이거 넘으면 반으로 (최근 것 위주)
+#define RC_TOP          (1u << 24)
+
+enum { PRED_LEFT, PRED_UP, PRED_MED, PRED_COPY, PRED_COUNT };
+
+// 윗줄 활동량 |b - c| + |d - b| 구간 경계
+static const int ctx_bounds[CODEC_CTX - 1] = { 4, 12, 32, 80 };
+
+/* ---------------- 적응 빈도 모델 ---------------- */
+
+struct model {
+    uint32_t total;
+    int nsym;
+    uint16_t freq[256];
+};
+
+static void model_init(struct model *m, int nsym) {
+    m->nsym = nsym;
+    m->total = (uint32_t)nsym;
+    for (int i = 0; i < nsym; i++)
+        m->freq[i] = 1;
+}
+
+static inline void model_update(struct model *m, int s) {
+    m->freq[s] += CODEC_INC;
+    m->total += CODEC_INC;
+    if (m->total > CODEC_LIMIT) {
+        m->total = 0;
+        for (int i = 0; i < m->nsym; i++) {
+            m->freq[i] = (uint16_t)((m->freq[i] + 1) >> 1);
+            m->total += m->freq[i];
+        }
+    }
+}
+
+/* ---------------- range coder (LZMA 방식 carry 처리) ---------------- */
+
+struct rc_enc {
+    uint64_t low;
+    uint32_t range;
+    uint8_t cache;
+    uint64_t cache_size;
+    unsigned char *p, *end;
+    int over;
+};
+
+static inline void rc_out(struct rc_enc *e, unsigned char b) {
+    if (e->p < e->end)
+        *e->p++ = b;
+    else
+        e->over = 1;
+}
+
+static inline void rc_shift_low(struct rc_enc *e) {
+    if ((uint32_t)e->low < 0xff000000u || (e->low >> 32) != 0) {
+        unsigned char carry = (unsigned char)(e->low >> 32);
+        unsigned char b = e->cache;
+        do {
+            rc_out(e, (unsigned char)(b + carry));
+            b = 0xff;
+        } while (--e->cache_size);
+        e->cache = (uint8_t)(e->low >> 24);
+    }
+    e->cache_size++;
+    e->low = (e->low & 0x00ffffffu) << 8;
+}
+
+static void rc_enc_init(struct rc_enc *e, unsigned char *out, size_t cap) {
+    e->low = 0;
+    e->range = 0xffffffffu;
+    e->cache = 0;
+    e->cache_size = 1;
+    e->p = out;
+    e->end = out + cap;
+    e->over = 0;
+}
+
+static void rc_flush(struct rc_enc *e) {
+    for (int i = 0; i < 5; i++)
+        rc_shift_low(e);
+}
+
+static inline void rc_encode(struct rc_enc *e, struct model *m, int s) {
+    uint32_t cum = 0;
+    for (int i = 0; i < s; i++)
+        cum += m->freq[i];
+    uint32_t r = e->range / m->total;
+    e->low += (uint64_t)r * cum;
+    e->range = r * m->freq[s];
+    while (e->range < RC_TOP) {
+        e->range <<= 8;
+        rc_shift_low(e);
+    }
+    model_update(m, s);
+}
+
+struct rc_dec {
+    uint32_t code, range;
+    const unsigned char *p, *end;
+    int past;           // 끝 지나서 읽은 바이트 수
+};
+
+static inline unsigned char rc_in(struct rc_dec *d) {
+    if (d->p < d->end)
+        return *d->p++;
+    d->past++;
+    return 0;
+}
+
+static void rc_dec_init(struct rc_dec *d, const unsigned char *in, size_t len) {
+    d->p = in;
+    d->end = in + len;
+    d->past = 0;
+    d->code = 0;
+    d->range = 0xffffffffu;
+    for (int i = 0; i < 5; i++)
+        d->code = (d->code << 8) | rc_in(d);
+}
+
+// 기호는 작은 값(잔차 0 근처)부터라 선형 탐색이 평균 몇 번 안 돎
+static inline int rc_decode(struct rc_dec *d, struct model *m) {
+    uint32_t r = d->range / m->total;
+    uint32_t v = d->code / r;
+    uint32_t cum = 0;
+    int s = 0;
+
+    if (v >= m->total)
+        v = m->total - 1;
+    while (cum + m->freq[s] <= v)
+        cum += m->freq[s++];
+    d->code -= r * cum;
+    d->range = r * m->freq[s];
+    while (d->range < RC_TOP) {
+        d->range <<= 8;
+        d->code = (d->code << 8) | rc_in(d);
+    }
+    model_update(m, s);
+    return s;
+}
+
+/* ---------------- 예측 / context ---------------- */
+
+static inline int med(int a, int b, int c) {
+    int mx = a > b ? a : b, mn = a < b ? a : b;
+    if (c >= mx)
+        return mn;
+    if (c <= mn)
+        return mx;
+    return a + b - c;
+}
+
+static inline unsigned zigzag(int r) {
+    r = (int8_t)r;
+    return (unsigned)((r << 1) ^ (r >> 31)) & 0xff;
+}
+
+static inline uint8_t ctx_at(const unsigned char *prev, int w, int i) {
+    int b = prev[i], c = i ? prev[i - 1] : b, d = i + 1 < w ? prev[i + 1] : b;
+    int act = abs(b - c) + abs(d - b), k = 0;
+    for (int t = 0; t < CODEC_CTX - 1; t++)
+        k += act > ctx_bounds[t];
+    return (uint8_t)k;
+}
+
+/*
+ * 픽셀마다 context = 윗줄 활동량 구간
+ * - 윗줄만 보니까 디코드할 때 줄 전체 잔차 먼저 풀고 한 번에 복원 가능
+ */
+static void row_context(const unsigned char *prev, int w, uint8_t *ctx) {
+    int i = 1;
+#ifdef __SSE2__
+    // 16개씩: |b - c| + |d - b| (saturating), 경계 비교는 unsigned라 max/cmpeq로
+    for (; i + 17 <= w; i += 16) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(prev + i));
+        __m128i c = _mm_loadu_si128((const __m128i *)(prev + i - 1));
+        __m128i d = _mm_loadu_si128((const __m128i *)(prev + i + 1));
+        __m128i bc = _mm_or_si128(_mm_subs_epu8(b, c), _mm_subs_epu8(c, b));
+        __m128i db = _mm_or_si128(_mm_subs_epu8(d, b), _mm_subs_epu8(b, d));
+        __m128i act = _mm_adds_epu8(bc, db);
+        __m128i k = _mm_setzero_si128();
+        for (int t = 0; t < CODEC_CTX - 1; t++) {
+            // act > th  <=>  max(act, th + 1) == act
+            __m128i th1 = _mm_set1_epi8((char)(ctx_bounds[t] + 1));
+            k = _mm_sub_epi8(k, _mm_cmpeq_epi8(_mm_max_epu8(act, th1), act));
+        }
+        _mm_storeu_si128((__m128i *)(ctx + i), k);
+    }
+#endif
+    ctx[0] = ctx_at(prev, w, 0);
+    for (; i < w; i++)
+        ctx[i] = ctx_at(prev, w, i);
+}
+
+// 줄 하나 잔차 (zigzag) + 그 합
+static int row_residual(const unsigned char *cur, const unsigned char *prev, int w, int pred, uint8_t *res) {
+    int sum = 0;
+    for (int i = 0; i < w; i++) {
+        int a = i ? cur[i - 1] : prev[i], b = prev[i], c = i ? prev[i - 1] : prev[i];
+        int p = pred == PRED_LEFT ? a : pred == PRED_UP ? b : med(a, b, c);
+        unsigned u = zigzag(cur[i] - p);
+        res[i] = (uint8_t)u;
+        sum += u;
+    }
+    return sum;
+}
+
+struct region_models {
+    struct model mode;
+    struct model res[CODEC_CTX];
+};
+
+static void models_init(struct region_models *m) {
+    model_init(&m->mode, PRED_COUNT);
+    for (int c = 0; c < CODEC_CTX; c++)
+        model_init(&m->res[c], 256);
+}
+
+/* ---------------- 구간 코딩 ---------------- */
+
+// data를 w폭 줄로 (마지막 줄은 짧을 수 있음) 코딩, 리턴 = 바이트 수 (-1 = 넘침)
+static long encode_region(const unsigned char *data, int len, int w, unsigned char *out, size_t cap) {
+    static const unsigned char zero[CODEC_MAX_WIDTH];
+    uint8_t res[3][CODEC_MAX_WIDTH], ctx[CODEC_MAX_WIDTH];
+    struct region_models *m = malloc(sizeof(*m));
+    struct rc_enc e;
+
+    if (!m)
+        return -1;
+    models_init(m);
+    rc_enc_init(&e, out, cap);
+
+    for (int y = 0; y * w < len && !e.over; y++) {
+        const unsigned char *cur = data + (size_t)y * w;
+        const unsigned char *prev = y ? cur - w : zero;
+        int rw = len - y * w < w ? len - y * w : w;
+
+        if (memcmp(cur, prev, rw) == 0) {
+            rc_encode(&e, &m->mode, PRED_COPY);
+            continue;
+        }
+
+        int best = PRED_LEFT, best_sum = row_residual(cur, prev, rw, PRED_LEFT, res[PRED_LEFT]);
+        for (int pr = PRED_UP; pr <= PRED_MED; pr++) {
+            int sum = row_residual(cur, prev, rw, pr, res[pr]);
+            if (sum < best_sum) {
+                best = pr;
+                best_sum = sum;
+            }
+        }
+
+        rc_encode(&e, &m->mode, best);
+        row_context(prev, rw, ctx);
+        for (int i = 0; i < rw; i++)
+            rc_encode(&e, &m->res[ctx[i]], res[best][i]);
+    }
+    rc_flush(&e);
+    free(m);
+    return e.over ? -1 : (long)(e.p - out);
+}
+
+#ifdef __SSE2__
+// 16바이트 prefix sum (mod 256) + carry
+static inline __m128i prefix16(__m128i x, unsigned char carry) {
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+    return _mm_add_epi8(x, _mm_set1_epi8((char)carry));
+}
+#endif
+
+static int decode_region(const unsigned char *in, size_t in_len, unsigned char *data, int len, int w) {
+    static const unsigned char zero[CODEC_MAX_WIDTH];
+    unsigned char res[CODEC_MAX_WIDTH];
+    uint8_t ctx[CODEC_MAX_WIDTH];
+    struct region_models *m = malloc(sizeof(*m));
+    struct rc_dec d;
+
+    if (!m)
+        return -1;
+    models_init(m);
+    rc_dec_init(&d, in, in_len);
+
+    for (int y = 0; y * w < len; y++) {
+        unsigned char *cur = data + (size_t)y * w;
+        const unsigned char *prev = y ? cur - w : zero;
+        int rw = len - y * w < w ? len - y * w : w;
+
+        int pred = rc_decode(&d, &m->mode);
+        if (pred == PRED_COPY) {
+            memcpy(cur, prev, rw);
+            continue;
+        }
+
+        // 줄 전체 잔차 먼저 (context가 윗줄에만 의존), zigzag 풀어서 바이트로
+        row_context(prev, rw, ctx);
+        for (int i = 0; i < rw; i++) {
+            unsigned u = (unsigned)rc_decode(&d, &m->res[ctx[i]]);
+            res[i] = (unsigned char)((u >> 1) ^ -(int)(u & 1));
+        }
+
+        int i = 0;
+        if (pred == PRED_UP) {
+#ifdef __SSE2__
+            for (; i + 16 <= rw; i += 16)
+                _mm_storeu_si128((__m128i *)(cur + i),
+                                 _mm_add_epi8(_mm_loadu_si128((const __m128i *)(res + i)),
+                                              _mm_loadu_si128((const __m128i *)(prev + i))));
+#endif
+            for (; i < rw; i++)
+                cur[i] = (unsigned char)(res[i] + prev[i]);
+        } else if (pred == PRED_LEFT) {
+            // 첫 픽셀은 윗줄 기준, 나머지는 왼쪽 누적합
+            unsigned char carry = (unsigned char)(res[0] + prev[0]);
+            cur[0] = carry;
+            i = 1;
+#ifdef __SSE2__
+            for (; i + 16 <= rw; i += 16) {
+                __m128i v = prefix16(_mm_loadu_si128((const __m128i *)(res + i)), carry);
+                _mm_storeu_si128((__m128i *)(cur + i), v);
+                carry = cur[i + 15];
+            }
+#endif
+            for (; i < rw; i++)
+                cur[i] = (unsigned char)(res[i] + cur[i - 1]);
+        } else {
+            for (; i < rw; i++) {
+                int a = i ? cur[i - 1] : prev[i], b = prev[i], c = i ? prev[i - 1] : prev[i];
+                cur[i] = (unsigned char)(res[i] + med(a, b, c));
+            }
+        }
+    }
+    free(m);
+    // flush가 5바이트 쓰니까 그 이상 모자랐으면 잘린 데이터
+    return d.past > 0 ? -1 : 0;
+}
+
+/* ---------------- 프레임 ---------------- */
+
+static inline void put_le32(unsigned char *p, uint32_t v) {
+    memcpy(p, &v, 4);
+}
+
+static inline uint32_t get_le32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// 이미지 뒤 나머지는 64바이트 주기로 반복되는 경우가 많음 -> 64폭이면 줄 통째 복사로 끝남
+static int trailer_width(const unsigned char *p, int len) {
+    int m64 = 0, m112 = 0;
+    for (int i = IMG_WIDTH; i < len; i++) {
+        m64 += p[i] == p[i - 64];
+        m112 += p[i] == p[i - IMG_WIDTH];
+    }
+    return m64 > m112 ? 64 : IMG_WIDTH;
+}
+
+// raw 길이에 따라 구간 나누기: [0, 180) / 이미지 / 나머지, 짧으면 통째로 한 구간
+static void split(int raw_len, int off[CODEC_REGIONS], int len[CODEC_REGIONS]) {
+    if (raw_len >= IMG_OFFSET + IMG_SIZE) {
+        off[0] = 0;
+        len[0] = IMG_OFFSET;
+        off[1] = IMG_OFFSET;
+        len[1] = IMG_SIZE;
+        off[2] = IMG_OFFSET + IMG_SIZE;
+        len[2] = raw_len - off[2];
+    } else {
+        off[0] = 0;
+        len[0] = raw_len;
+        off[1] = off[2] = raw_len;
+        len[1] = len[2] = 0;
+    }
+}
+
+size_t s730b_codec_bound(int raw_len) {
+    // 구간마다 안 줄면 그대로 저장하니까 raw + 헤더, 코딩 중엔 넘치면 멈춤 (여유 64)
+    return CODEC_HDR + CODEC_REGIONS * CODEC_DESC + (size_t)raw_len + 64;
+}
+
+long s730b_codec_encode(const unsigned char *raw, int raw_len, unsigned char *out, size_t cap) {
+    int off[CODEC_REGIONS], len[CODEC_REGIONS], width[CODEC_REGIONS];
+
+    if (!raw || raw_len < 0 || raw_len > CODEC_MAX_RAW || cap < s730b_codec_bound(raw_len))
+        return -1;
+    split(raw_len, off, len);
+    width[0] = raw_len >= IMG_OFFSET + IMG_SIZE ? IMG_OFFSET : IMG_WIDTH;
+    width[1] = IMG_WIDTH;
+    width[2] = len[2] > IMG_WIDTH ? trailer_width(raw + off[2], len[2]) : IMG_WIDTH;
+
+    memset(out, 0, CODEC_HDR);
+    put_le32(out, CODEC_MAGIC);
+    put_le32(out + 4, (uint32_t)raw_len);
+    size_t pos = CODEC_HDR + CODEC_REGIONS * CODEC_DESC;
+    for (int r = 0; r < CODEC_REGIONS; r++) {
+        size_t room = cap - pos < (size_t)len[r] ? cap - pos : (size_t)len[r];
+        long n = len[r] ? encode_region(raw + off[r], len[r], width[r], out + pos, room) : 0;
+        if (n < 0 || n >= len[r]) {
+            // 줄어들지 않으면 (잡음 같은 데이터) 그대로 저장, 폭 0 = 저장만
+            memcpy(out + pos, raw + off[r], len[r]);
+            n = len[r];
+            width[r] = 0;
+        }
+        unsigned char *desc = out + CODEC_HDR + r * CODEC_DESC;
+        put_le32(desc, (uint32_t)n);
+        put_le32(desc + 4, (uint32_t)len[r]);
+        put_le32(desc + 8, (uint32_t)width[r]);
+        pos += (size_t)n;
+    }
+    return (long)pos;
+}
+
+int s730b_codec_is_coded(const unsigned char *in, size_t in_len) {
+    return in_len >= CODEC_HDR + CODEC_REGIONS * CODEC_DESC && get_le32(in) == CODEC_MAGIC;
+}
+
+long s730b_codec_decode(const unsigned char *in, size_t in_len, unsigned char *raw, size_t cap) {
+    int off[CODEC_REGIONS], len[CODEC_REGIONS];
+
+    if (!s730b_codec_is_coded(in, in_len))
+        return -1;
+    uint32_t raw_len = get_le32(in + 4);
+    if (raw_len > cap || raw_len > CODEC_MAX_RAW)
+        return -1;
+    split((int)raw_len, off, len);
+
+    size_t pos = CODEC_HDR + CODEC_REGIONS * CODEC_DESC;
+    for (int r = 0; r < CODEC_REGIONS; r++) {
+        const unsigned char *desc = in + CODEC_HDR + r * CODEC_DESC;
+        uint32_t n = get_le32(desc), w = get_le32(desc + 8);
+        if (get_le32(desc + 4) != (uint32_t)len[r] || n > in_len - pos || w > CODEC_MAX_WIDTH)
+            return -1;
+        if (w == 0) {
+            if (n != (uint32_t)len[r])
+                return -1;
+            memcpy(raw + off[r], in + pos, n);
+        } else if (len[r] && decode_region(in + pos, n, raw + off[r], len[r], (int)w) < 0) {
+            return -1;
+        }
+        pos += n;
+    }
+    return (long)raw_len;
+}
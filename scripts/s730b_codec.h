@@ -0,0 +1,40 @@
+/*
+ * s730b_codec.h
+ *
+ * - raw 캡처(약 21.5KB) 무손실 압축, 의존성 없음
+ * - 구간 3개를 따로 코딩 (적응 상태도 따로)
+ *   1) 앞 180B 레지스터 덤프 (거의 0)
+ *   2) 112x96 이미지
+ *   3) 이미지 뒤 나머지 (센서 쪽 남는 줄, 0 / 0xFF 범벅이거나 이미지 비슷한 값)
+ *   -> 줄 단위로 보고 (1은 180폭 한 줄, 3은 64폭 / 112폭 중 위 줄과 더 많이 같은 쪽)
+ *      줄마다 left / up / median(LOCO-I) 예측 중 |잔차| 합 작은 쪽, 위 줄과 똑같으면 copy (잔차 없음)
+ * - 잔차는 zigzag 후 적응 range coder (기호 256개 빈도 모델, 윗줄 활동량으로 context 5개)
+ *   (Rice는 0 잔차가 많아 1bit 밑으로 못 내려가서 20% 손해, ANS는 적응 모델이면 거꾸로 인코딩해야 해서 range coder)
+ * - context가 윗줄에만 의존 -> 디코드는 줄 잔차 먼저 다 풀고, up / left 예측 줄은 SSE2로 한 번에 복원
+ * - 구간이 안 줄면 (잡음 등) 그대로 저장
+ *
+ * 코딩 결과 구조:
+ *   [header 16B][구간 3개 x (코딩 길이 4B, 원래 길이 4B, 줄 폭 4B, 0 = 저장만)][코딩 데이터 3개]
+ */
+
+#ifndef S730B_CODEC_H
+#define S730B_CODEC_H
+
+#include <stddef.h>
+
+#define CODEC_MAGIC     0x31433753u     // "S7C1"
+#define CODEC_MAX_RAW   65536
+
+/* s730b_codec_encode에 넘길 out 버퍼 최소 크기 (압축 안 돼도 들어감) */
+size_t s730b_codec_bound(int raw_len);
+
+/* raw -> out, 리턴 = 코딩된 바이트 수, -1 = 크기 오류 */
+long s730b_codec_encode(const unsigned char *raw, int raw_len, unsigned char *out, size_t cap);
+
+/* 코딩된 거 -> raw (cap 이상이면 실패), 리턴 = raw 바이트 수, -1 = 깨진 데이터 */
+long s730b_codec_decode(const unsigned char *in, size_t in_len, unsigned char *raw, size_t cap);
+
+/* in이 코딩된 프레임인지 (magic) */
+int s730b_codec_is_coded(const unsigned char *in, size_t in_len);
+
+#endif
@@ -0,0 +1,310 @@
+/*
+ * s730b_convert.c
+ *
+ * - .raw 캡처 여러 개(디렉터리째) -> PNG / PGM 일괄 변환 (raw_to_png.py 대신, 파일마다 Python 안 띄움)
+ * - 파일마다 mmap -> offset 180 / 112x96 -> (destripe / Gabor 강조) -> 회전하면서 인코딩 -> write 한 번
+ * - 스레드 풀(s730b_pool)로 파일 단위 병렬, 버퍼는 worker마다 하나씩 미리 잡아둠
+ *   -> 파일 몇 개든 메모리 = worker 수 x (프레임 2장 + PNG 버퍼)
+ * - 사용법: ./s730b_convert [옵션] raw파일/디렉터리...
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "s730b_enhance.h"
+#include "s730b_frame.h"
+#include "s730b_png.h"
+#include "s730b_pool.h"
+
+#define CONVERT_PATH_MAX 4096
+
+struct convert_opts {
+    const char *outdir;     // NULL이면 raw 파일 옆에
+    int pgm;                // PNG 대신 PGM
+    int level;              // PNG_LEVEL_STORED / PNG_LEVEL_FAST
+    int rotate_90;
+    int destripe;
+    int enhance;
+    int threads;
+};
+
+// worker마다 하나 (false sharing 안 나게 64B 정렬)
+struct convert_worker {
+    unsigned char img[IMG_SIZE];
+    unsigned char enh[IMG_SIZE];
+    unsigned char *png;
+    size_t png_cap;
+    long files;
+    long failed;
+    long in_bytes;
+    long out_bytes;
+} __attribute__((aligned(64)));
+
+struct convert_job {
+    const struct convert_opts *o;
+    char **paths;
+    struct convert_worker *workers;
+    struct s730b_gabor_bank bank;
+};
+
+/* ---------------- 파일 목록 ---------------- */
+
+struct path_list {
+    char **v;
+    int n, cap;
+};
+
+static int path_push(struct path_list *l, const char *path) {
+    if (l->n == l->cap) {
+        int cap = l->cap ? l->cap * 2 : 256;
+        char **v = realloc(l->v, cap * sizeof(*v));
+        if (!v)
+            return -1;
+        l->v = v;
+        l->cap = cap;
+    }
+    if (!(l->v[l->n] = strdup(path)))
+        return -1;
+    l->n++;
+    return 0;
+}
+
+static int has_raw_ext(const char *name) {
+    size_t n = strlen(name);
+    return n > 4 && strcmp(name + n - 4, ".raw") == 0;
+}
+
+static int cmp_path(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// 파일이면 그대로, 디렉터리면 바로 밑의 *.raw (하위 디렉터리는 안 내려감)
+static int collect(struct path_list *l, const char *path) {
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        fprintf(stderr, "[-] %s 없음\n", path);
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode))
+        return path_push(l, path);
+
+    DIR *d = opendir(path);
+    if (!d) {
+        fprintf(stderr, "[-] %s 열기 실패\n", path);
+        return -1;
+    }
+    int first = l->n;
+    char buf[CONVERT_PATH_MAX];
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        if (!has_raw_ext(e->d_name))
+            continue;
+        snprintf(buf, sizeof(buf), "%s/%s", path, e->d_name);
+        if (path_push(l, buf) < 0) {
+            closedir(d);
+            return -1;
+        }
+    }
+    closedir(d);
+    qsort(l->v + first, l->n - first, sizeof(char *), cmp_path);
+    return 0;
+}
+
+/* ---------------- 변환 ---------------- */
+
+// in = ".../name.raw" -> outdir/name.png (outdir 없으면 같은 디렉터리)
+static void out_path(const struct convert_opts *o, const char *in, char *out, size_t len) {
+    const char *base = strrchr(in, '/');
+    const char *dot = strrchr(in, '.');
+    base = base ? base + 1 : in;
+    if (!dot || dot < base)
+        dot = in + strlen(in);
+
+    const char *ext = o->pgm ? "pgm" : "png";
+    if (o->outdir)
+        snprintf(out, len, "%s/%.*s.%s", o->outdir, (int)(dot - base), base, ext);
+    else
+        snprintf(out, len, "%.*s.%s", (int)(dot - in), in, ext);
+}
+
+static int write_file(const char *path, const unsigned char *buf, size_t len) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+    while (len > 0) {
+        ssize_t k = write(fd, buf, len);
+        if (k <= 0) {
+            close(fd);
+            return -1;
+        }
+        buf += k;
+        len -= (size_t)k;
+    }
+    return close(fd);
+}
+
+static int convert_one(struct convert_job *job, struct convert_worker *wk, const char *path) {
+    const struct convert_opts *o = job->o;
+    char dst[CONVERT_PATH_MAX];
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[-] %s 열기 실패\n", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < IMG_OFFSET + IMG_SIZE) {
+        fprintf(stderr, "[-] %s: RAW 길이가 너무 짧음 (len=%ld)\n", path, (long)st.st_size);
+        close(fd);
+        return -1;
+    }
+    const unsigned char *raw = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (raw == MAP_FAILED) {
+        fprintf(stderr, "[-] %s mmap 실패\n", path);
+        return -1;
+    }
+
+    // 전처리 없으면 매핑된 페이지에서 바로 인코딩 (복사 없음)
+    const unsigned char *img = raw + IMG_OFFSET;
+    if (o->destripe || o->enhance) {
+        memcpy(wk->img, img, IMG_SIZE);
+        if (o->destripe)
+            s730b_destripe(wk->img, IMG_WIDTH, IMG_HEIGHT);
+        img = wk->img;
+        if (o->enhance) {
+            s730b_gabor_enhance(&job->bank, wk->img, IMG_WIDTH, IMG_HEIGHT, wk->enh, NULL);
+            img = wk->enh;
+        }
+    }
+
+    out_path(o, path, dst, sizeof(dst));
+    int r;
+    long out_len;
+    if (o->pgm) {
+        r = s730b_write_pgm(dst, img, IMG_WIDTH, IMG_HEIGHT, o->rotate_90);
+        out_len = r < 0 ? 0 : IMG_SIZE + snprintf(NULL, 0, "P5\n%d %d\n255\n", IMG_WIDTH, IMG_HEIGHT);
+    } else {
+        out_len = s730b_png_encode(img, IMG_WIDTH, IMG_HEIGHT, o->rotate_90, o->level, wk->png, wk->png_cap);
+        r = out_len < 0 ? -1 : write_file(dst, wk->png, (size_t)out_len);
+    }
+    munmap((void *)raw, st.st_size);
+
+    if (r < 0) {
+        fprintf(stderr, "[-] %s 쓰기 실패\n", dst);
+        return -1;
+    }
+    wk->in_bytes += st.st_size;
+    wk->out_bytes += out_len;
+    return 0;
+}
+
+static void convert_task(void *arg, int task, int worker) {
+    struct convert_job *job = arg;
+    struct convert_worker *wk = &job->workers[worker];
+
+    if (convert_one(job, wk, job->paths[task]) < 0)
+        wk->failed++;
+    else
+        wk->files++;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [옵션] raw파일/디렉터리...\n\n"
+            "  -o DIR          결과 저장 디렉터리 (기본: raw 파일 옆)\n"
+            "  -j N            스레드 수 (기본: CPU 개수)\n"
+            "  --pgm           PNG 대신 PGM\n"
+            "  --stored        PNG 압축 안 함 (제일 빠름, 파일 큼)\n"
+            "  --no-rotate     왼쪽 90도 회전 안 함\n"
+            "  --destripe      세로줄/가로줄 제거\n"
+            "  --enhance       Gabor 융선 강조한 결과로 저장\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    struct convert_opts o = { .level = PNG_LEVEL_FAST, .rotate_90 = 1 };
+    struct path_list list = {0};
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            o.outdir = argv[++i];
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            o.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pgm") == 0)
+            o.pgm = 1;
+        else if (strcmp(argv[i], "--stored") == 0)
+            o.level = PNG_LEVEL_STORED;
+        else if (strcmp(argv[i], "--no-rotate") == 0)
+            o.rotate_90 = 0;
+        else if (strcmp(argv[i], "--destripe") == 0)
+            o.destripe = 1;
+        else if (strcmp(argv[i], "--enhance") == 0)
+            o.enhance = 1;
+        else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else if (collect(&list, argv[i]) < 0) {
+            return 1;
+        }
+    }
+    if (list.n == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (o.outdir && mkdir(o.outdir, 0755) < 0 && access(o.outdir, W_OK) < 0) {
+        fprintf(stderr, "[-] %s 만들기 실패\n", o.outdir);
+        return 1;
+    }
+
+    static struct s730b_pool pool;
+    if (s730b_pool_init(&pool, o.threads) < 0) {
+        fprintf(stderr, "[-] 스레드 풀 만들기 실패\n");
+        return 1;
+    }
+
+    static struct convert_job job;
+    job.o = &o;
+    job.paths = list.v;
+    job.workers = aligned_alloc(64, pool.nthreads * sizeof(struct convert_worker));
+    if (!job.workers)
+        return 1;
+    memset(job.workers, 0, pool.nthreads * sizeof(struct convert_worker));
+    for (int t = 0; t < pool.nthreads; t++) {
+        job.workers[t].png_cap = s730b_png_bound(IMG_WIDTH, IMG_HEIGHT);
+        if (!(job.workers[t].png = malloc(job.workers[t].png_cap)))
+            return 1;
+    }
+    if (o.enhance)
+        s730b_gabor_bank_init(&job.bank, ENH_PERIOD_NATIVE);
+
+    uint64_t t0 = s730b_now_ns();
+    s730b_pool_run(&pool, list.n, convert_task, &job);
+    uint64_t t1 = s730b_now_ns();
+
+    long files = 0, failed = 0, in_bytes = 0, out_bytes = 0;
+    for (int t = 0; t < pool.nthreads; t++) {
+        files += job.workers[t].files;
+        failed += job.workers[t].failed;
+        in_bytes += job.workers[t].in_bytes;
+        out_bytes += job.workers[t].out_bytes;
+        free(job.workers[t].png);
+    }
+    double sec = (t1 - t0) / 1e9;
+    printf("[+] %ld개 변환 (실패 %ld), 스레드 %d, %.3f s\n", files, failed, pool.nthreads, sec);
+    printf("    %.0f files/s, 입력 %.1f MB/s, 출력 %.1f MB/s (%.1f KB/파일)\n",
+           files / sec, in_bytes / 1e6 / sec, out_bytes / 1e6 / sec, files ? out_bytes / 1e3 / files : 0.0);
+
+    s730b_pool_destroy(&pool);
+    free(job.workers);
+    for (int i = 0; i < list.n; i++)
+        free(list.v[i]);
+    free(list.v);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * s730b_detect.c
+ *
+ * - probe 바이트 합 / 제곱합 / baseline이랑 SAD (SSE2 psadbw, 없으면 스칼라)
+ * - 손가락 없을 때 SAD 이동평균으로 문턱 정하고 DETECT_REFRESH번 연속 없음이면 baseline 갈아끼움
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "s730b_detect.h"
+
+#define DETECT_MIN_BYTES 256
+
+// 합 / 제곱합 (분산용), 16바이트씩: psadbw(0)으로 합, pmaddwd로 제곱합
+static void byte_moments(const unsigned char *p, int n, uint32_t *sum, uint64_t *sq) {
+    uint32_t s = 0;
+    uint64_t q = 0;
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vs = zero, vq = zero;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+        vs = _mm_add_epi64(vs, _mm_sad_epu8(v, zero));
+        // 255^2 x 2 = 130050 -> 32bit 칸에 DETECT_MAX_BYTES/16번 더해도 안 넘침
+        vq = _mm_add_epi32(vq, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+    }
+    s = (uint32_t)(_mm_cvtsi128_si32(vs) + _mm_cvtsi128_si32(_mm_srli_si128(vs, 8)));
+    uint32_t qq[4];
+    _mm_storeu_si128((__m128i *)qq, vq);
+    q = (uint64_t)qq[0] + qq[1] + qq[2] + qq[3];
+#endif
+    for (; i < n; i++) {
+        s += p[i];
+        q += (uint32_t)p[i] * p[i];
+    }
+    *sum = s;
+    *sq = q;
+}
+
+static uint32_t byte_sad(const unsigned char *a, const unsigned char *b, int n) {
+    uint32_t s = 0;
+    int i = 0;
+#ifdef __SSE2__
+    __m128i vs = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+        vs = _mm_add_epi64(vs, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(a + i)),
+                                            _mm_loadu_si128((const __m128i *)(b + i))));
+    s = (uint32_t)(_mm_cvtsi128_si32(vs) + _mm_cvtsi128_si32(_mm_srli_si128(vs, 8)));
+#endif
+    for (; i < n; i++)
+        s += (uint32_t)abs(a[i] - b[i]);
+    return s;
+}
+
+static int byte_var(const unsigned char *p, int n) {
+    uint32_t sum;
+    uint64_t sq;
+    byte_moments(p, n, &sum, &sq);
+    return (int)((sq * n - (uint64_t)sum * sum) / ((uint64_t)n * n));
+}
+
+void s730b_detect_reset(struct s730b_detect *d) {
+    memset(d, 0, sizeof(*d));
+}
+
+int s730b_detect_probe(struct s730b_detect *d, const unsigned char *data, int len,
+                       struct s730b_detect_score *score) {
+    struct s730b_detect_score sc = { 0 };
+    const int full = len < DETECT_MAX_BYTES ? len : DETECT_MAX_BYTES;
+    int n = d->len > 0 && full > d->len ? d->len : full;
+    int finger;
+
+    if (!data || n < DETECT_MIN_BYTES)
+        return -1;
+
+    int var = byte_var(data, n);
+    if (d->len == 0) {
+        // baseline 없음: 첫 probe를 빈 센서로 보고 그대로 baseline
+        finger = 0;
+        d->quiet = DETECT_REFRESH;
+    } else {
+        int limit = d->noise * DETECT_NOISE_K;
+        sc.sad = (int)(byte_sad(data, d->base, n) * 16 / (uint32_t)n);
+        sc.var = var - d->base_var;
+        sc.sad_limit = limit > DETECT_SAD_MIN ? limit : DETECT_SAD_MIN;
+        finger = sc.sad > sc.sad_limit || sc.var > DETECT_VAR_MIN;
+
+        // baseline보다 무늬가 확 줄었으면 baseline 잡을 때 손가락이 있었던 것 -> 바로 다시 잡음
+        if (sc.var < -DETECT_VAR_MIN) {
+            finger = 0;
+            d->quiet = DETECT_REFRESH;
+        }
+    }
+
+    if (finger) {
+        d->quiet = 0;
+    } else {
+        if (d->len > 0 && d->quiet < DETECT_REFRESH)
+            d->noise += (sc.sad - d->noise) / 8;
+        if (++d->quiet >= DETECT_REFRESH) {
+            // probe가 baseline보다 길어졌으면 이때 길이도 늘림
+            memcpy(d->base, data, full);
+            d->len = full;
+            d->base_var = full == n ? var : byte_var(data, full);
+            d->quiet = 0;
+        }
+    }
+
+    if (score)
+        *score = sc;
+    return finger;
+}
@@ -0,0 +1,50 @@
+/*
+ * s730b_detect.h
+ *
+ * - 손가락 감지 probe (캡처 앞쪽 chunk 몇 개)를 "손가락 없을 때 probe"(baseline)랑 비교해서 판정
+ * - has_fingerprint_in_detect()는 0x00/0xFF 비율 절대값이라 센서/게인마다 맞춰야 하고,
+ *   chunk를 6개는 읽어야 안정적이었음 -> baseline 기준 차이로 보면 1~2 chunk로 충분
+ * - 점수 두 개 (SSE2 psadbw)
+ *   1) sad: baseline이랑 바이트별 절대차 평균 (손가락 올리면 밝기 자체가 바뀜)
+ *   2) var: probe 분산 - baseline 분산 (밝기가 비슷해도 융선 무늬가 생기면 커짐)
+ * - 손가락 없음으로 판정된 probe가 DETECT_REFRESH번 이어지면 baseline 새로 갈아끼움 (온도/게인 drift)
+ * - 첫 probe는 빈 센서로 보고 baseline으로 씀 (chunk 0 앞쪽 레지스터 값 때문에 절대 분산으로는 못 가림)
+ *   손가락 올린 채로 시작했으면 뗄 때 분산이 baseline보다 확 줄어듦 -> 그때 바로 다시 잡음
+ */
+
+#ifndef S730B_DETECT_H
+#define S730B_DETECT_H
+
+#include <stdint.h>
+
+#define DETECT_MAX_BYTES  1536      // chunk 6개
+#define DETECT_SAD_MIN    (12 * 16) // sad 문턱 최소값 (Q4, 바이트당 12)
+#define DETECT_NOISE_K    4         // sad 문턱 = max(DETECT_SAD_MIN, 손가락 없을 때 sad 평균 x K)
+#define DETECT_VAR_MIN    256       // 분산 변화 문턱 (표준편차 16)
+#define DETECT_REFRESH    8         // 연속 "없음" 이만큼이면 baseline 갱신
+
+struct s730b_detect {
+    unsigned char base[DETECT_MAX_BYTES];
+    int len;                    // baseline 길이 (0 = 아직 없음)
+    int base_var;
+    int noise;                  // 손가락 없을 때 sad 이동평균 (Q4)
+    int quiet;                  // 연속 "없음" 횟수
+};
+
+struct s730b_detect_score {
+    int sad;                    // 바이트당 절대차 평균 (Q4)
+    int var;                    // probe 분산 - baseline 분산 (baseline 없으면 probe 분산)
+    int sad_limit;              // 이번 판정에 쓴 sad 문턱
+};
+
+void s730b_detect_reset(struct s730b_detect *d);
+
+/*
+ * probe 하나 판정 (detect_finger로 읽은 chunk 데이터, 앞에 붙은 상태 응답은 빼고)
+ * - 1 = 손가락 있음, 0 = 없음 (baseline 갱신도 여기서), -1 = 데이터 너무 짧음 (chunk 1개 미만)
+ * - score != NULL 이면 점수도
+ */
+int s730b_detect_probe(struct s730b_detect *d, const unsigned char *data, int len,
+                       struct s730b_detect_score *score);
+
+#endif
@@ -0,0 +1,255 @@
+/*
+ * s730b_enhance.c
+ *
+ * - gradient로 블록 방향장 + mask, 방향별 Gabor 커널 bank 미리 계산
+ * - 블록 줄 단위로 s730b_pool에 나눠서 필터링
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "s730b_enhance.h"
+
+#define ENH_FG_MIN_STD  8.0     // 이보다 평평한 블록은 배경
+#define ENH_FG_MIN_MEAN 16.0    // 거의 0 = 센서 밖
+#define ENH_Q           4096    // 커널 양수 계수 합 (Q12)
+#define ENH_MAX_BLOCKS  (64 * 64)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+void s730b_gabor_bank_init(struct s730b_gabor_bank *bank, float period) {
+    int r = (int)lrintf(period * 0.8f);
+    if (r < 2)
+        r = 2;
+    if (r > ENH_MAX_RADIUS)
+        r = ENH_MAX_RADIUS;
+
+    memset(bank, 0, sizeof(*bank));
+    bank->period = period;
+    bank->radius = r;
+    bank->ksize = 2 * r + 1;
+
+    // 융선 가로방향(across)은 좁게, 융선 따라가는 방향(along)은 넓게 -> 끊긴 융선 이어붙이는 효과
+    const double sx = 0.40 * period;
+    const double sy = 0.55 * period;
+    const int ks = bank->ksize;
+    double g[ENH_KSIZE * ENH_KSIZE], env[ENH_KSIZE * ENH_KSIZE];
+
+    for (int o = 0; o < ENH_ORIENTS; o++) {
+        double th = o * M_PI / ENH_ORIENTS;     // 융선 방향
+        double c = cos(th), s = sin(th);
+        double gsum = 0.0, esum = 0.0;
+
+        for (int y = -r; y <= r; y++) {
+            for (int x = -r; x <= r; x++) {
+                double along = x * c + y * s;
+                double across = -x * s + y * c;
+                double e = exp(-0.5 * (across * across / (sx * sx) + along * along / (sy * sy)));
+                int i = (y + r) * ks + (x + r);
+                env[i] = e;
+                g[i] = e * cos(2.0 * M_PI * across / period);
+                gsum += g[i];
+                esum += e;
+            }
+        }
+
+        // DC 제거: 평평한 영역 응답이 0이 되게 envelope 비율만큼 빼줌
+        double pos = 0.0;
+        for (int i = 0; i < ks * ks; i++) {
+            g[i] -= env[i] * gsum / esum;
+            if (g[i] > 0)
+                pos += g[i];
+        }
+
+        for (int i = 0; i < ks * ks; i++)
+            bank->kern[o][i] = (int16_t)lrint(g[i] * ENH_Q / pos);
+    }
+}
+
+int s730b_orientation_field(const unsigned char *img, int w, int h, uint8_t *orient, uint8_t *mask) {
+    const int bw = w / ENH_BLOCK, bh = h / ENH_BLOCK;
+    double vx[ENH_MAX_BLOCKS], vy[ENH_MAX_BLOCKS];
+
+    if (!img || w % ENH_BLOCK || h % ENH_BLOCK || bw * bh > ENH_MAX_BLOCKS)
+        return -1;
+
+    for (int by = 0; by < bh; by++) {
+        for (int bx = 0; bx < bw; bx++) {
+            long gxx = 0, gyy = 0, gxy = 0;
+            int sum = 0, sumsq = 0;
+
+            for (int y = by * ENH_BLOCK; y < (by + 1) * ENH_BLOCK; y++) {
+                int ym = y > 0 ? y - 1 : y, yp = y < h - 1 ? y + 1 : y;
+                const unsigned char *rm = img + (size_t)ym * w;
+                const unsigned char *r0 = img + (size_t)y * w;
+                const unsigned char *rp = img + (size_t)yp * w;
+
+                for (int x = bx * ENH_BLOCK; x < (bx + 1) * ENH_BLOCK; x++) {
+                    int xm = x > 0 ? x - 1 : x, xp = x < w - 1 ? x + 1 : x;
+                    // Sobel
+                    int gx = (rm[xp] + 2 * r0[xp] + rp[xp]) - (rm[xm] + 2 * r0[xm] + rp[xm]);
+                    int gy = (rp[xm] + 2 * rp[x] + rp[xp]) - (rm[xm] + 2 * rm[x] + rm[xp]);
+                    gxx += gx * gx;
+                    gyy += gy * gy;
+                    gxy += gx * gy;
+                    sum += r0[x];
+                    sumsq += r0[x] * r0[x];
+                }
+            }
+
+            const double n = ENH_BLOCK * ENH_BLOCK;
+            double mean = sum / n;
+            double var = sumsq / n - mean * mean;
+            int b = by * bw + bx;
+
+            mask[b] = var >= ENH_FG_MIN_STD * ENH_FG_MIN_STD && mean >= ENH_FG_MIN_MEAN;
+            vx[b] = (double)(gxx - gyy);
+            vy[b] = 2.0 * (double)gxy;
+        }
+    }
+
+    // 이중각 벡터 3x3 블록 평활화 -> 각도 (gradient 방향 + 90도 = 융선 방향)
+    for (int by = 0; by < bh; by++) {
+        for (int bx = 0; bx < bw; bx++) {
+            double sx = 0.0, sy = 0.0;
+            for (int j = -1; j <= 1; j++) {
+                for (int i = -1; i <= 1; i++) {
+                    int x = bx + i, y = by + j;
+                    if (x < 0 || y < 0 || x >= bw || y >= bh)
+                        continue;
+                    sx += vx[y * bw + x];
+                    sy += vy[y * bw + x];
+                }
+            }
+
+            double th = 0.5 * atan2(sy, sx) + M_PI / 2.0;
+            if (th < 0)
+                th += M_PI;
+            if (th >= M_PI)
+                th -= M_PI;
+            orient[by * bw + bx] = (uint8_t)((int)lrint(th / M_PI * ENH_ORIENTS) % ENH_ORIENTS);
+        }
+    }
+    return 0;
+}
+
+struct enh_job {
+    const struct s730b_gabor_bank *bank;
+    const int16_t *pad;         // 테두리 radius만큼 복제해서 늘린 입력 (int16로 미리 넓혀둠)
+    int pw;
+    int w;
+    int bw;
+    const uint8_t *orient;
+    const uint8_t *mask;
+    int32_t *resp;
+};
+
+/*
+ * 타일(블록) 하나 = 커널 하나 -> 계수 하나당 8픽셀 row에 곱해서 누적
+ * - 안쪽 px 루프가 고정 8이라 SIMD로 펴짐 (픽셀마다 커널 고르는 방식보다 훨씬 빠름)
+ */
+static void enh_tile_row(void *arg, int by, int worker) {
+    struct enh_job *job = arg;
+    const int ks = job->bank->ksize;
+    (void)worker;
+
+    for (int bx = 0; bx < job->bw; bx++) {
+        int b = by * job->bw + bx;
+        int32_t acc[ENH_BLOCK][ENH_BLOCK];
+
+        if (!job->mask[b])
+            continue;
+
+        memset(acc, 0, sizeof(acc));
+        const int16_t *kern = job->bank->kern[job->orient[b]];
+        const int16_t *base = job->pad + (size_t)by * ENH_BLOCK * job->pw + bx * ENH_BLOCK;
+
+        for (int py = 0; py < ENH_BLOCK; py++) {
+            for (int ky = 0; ky < ks; ky++) {
+                const int16_t *s = base + (size_t)(py + ky) * job->pw;
+                const int16_t *k = kern + ky * ks;
+                for (int kx = 0; kx < ks; kx++) {
+                    int16_t c = k[kx];
+                    for (int px = 0; px < ENH_BLOCK; px++)
+                        acc[py][px] += c * s[kx + px];
+                }
+            }
+        }
+
+        for (int py = 0; py < ENH_BLOCK; py++)
+            memcpy(job->resp + (size_t)(by * ENH_BLOCK + py) * job->w + bx * ENH_BLOCK,
+                   acc[py], sizeof(acc[py]));
+    }
+}
+
+int s730b_gabor_enhance(const struct s730b_gabor_bank *bank, const unsigned char *img, int w, int h,
+                        unsigned char *out, struct s730b_pool *pool) {
+    const int bw = w / ENH_BLOCK, bh = h / ENH_BLOCK;
+    const int r = bank->radius;
+    const int pw = w + 2 * r, ph = h + 2 * r;
+    uint8_t orient[ENH_MAX_BLOCKS], mask[ENH_MAX_BLOCKS];
+
+    if (s730b_orientation_field(img, w, h, orient, mask) < 0)
+        return -1;
+
+    int16_t *pad = malloc((size_t)pw * ph * sizeof(*pad));
+    int32_t *resp = malloc((size_t)w * h * sizeof(*resp));
+    if (!pad || !resp) {
+        free(pad);
+        free(resp);
+        return -1;
+    }
+
+    // 테두리 복제 padding
+    for (int y = 0; y < ph; y++) {
+        int sy = y - r < 0 ? 0 : (y - r >= h ? h - 1 : y - r);
+        const unsigned char *src = img + (size_t)sy * w;
+        int16_t *dst = pad + (size_t)y * pw;
+        for (int x = 0; x < pw; x++) {
+            int sx = x - r < 0 ? 0 : (x - r >= w ? w - 1 : x - r);
+            dst[x] = src[sx];
+        }
+    }
+
+    struct enh_job job = { bank, pad, pw, w, bw, orient, mask, resp };
+    if (pool)
+        s730b_pool_run(pool, bh, enh_tile_row, &job);
+    else
+        for (int by = 0; by < bh; by++)
+            enh_tile_row(&job, by, 0);
+
+    // 전경 응답 평균 크기로 정규화 -> 128 기준 +-
+    double mabs = 0.0;
+    long cnt = 0;
+    for (int b = 0; b < bw * bh; b++) {
+        if (!mask[b])
+            continue;
+        int bx = b % bw, by = b / bw;
+        for (int py = 0; py < ENH_BLOCK; py++) {
+            const int32_t *rr = resp + (size_t)(by * ENH_BLOCK + py) * w + bx * ENH_BLOCK;
+            for (int px = 0; px < ENH_BLOCK; px++)
+                mabs += abs(rr[px]);
+        }
+        cnt += ENH_BLOCK * ENH_BLOCK;
+    }
+    double gain = cnt && mabs > 0 ? 64.0 * cnt / mabs : 0.0;
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int b = (y / ENH_BLOCK) * bw + x / ENH_BLOCK;
+            if (!mask[b]) {
+                out[(size_t)y * w + x] = 255;
+                continue;
+            }
+            int v = (int)lrint(128.0 + resp[(size_t)y * w + x] * gain);
+            out[(size_t)y * w + x] = v < 0 ? 0 : (v > 255 ? 255 : v);
+        }
+    }
+
+    free(pad);
+    free(resp);
+    return 0;
+}
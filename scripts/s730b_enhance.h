@@ -0,0 +1,50 @@
+/*
+ * s730b_enhance.h
+ *
+ * - 블록 방향장(orientation field) 추정 + 방향별 Gabor 필터로 융선 강조
+ * - CLAHE/unsharp mask만으로는 112x96에서 융선 끊긴 데가 안 이어져서 추가함
+ * - 112x96 원본이랑 224x192 (2배 업스케일/burst 합성) 둘 다 받음
+ *   -> 융선 주기(period)만 배율에 맞춰서 bank 만들면 됨
+ */
+
+#ifndef S730B_ENHANCE_H
+#define S730B_ENHANCE_H
+
+#include <stdint.h>
+
+#include "s730b_pool.h"
+
+#define ENH_BLOCK         8
+#define ENH_ORIENTS       16      // 0..180도를 16방향으로 양자화 (11.25도 간격)
+#define ENH_MAX_RADIUS    14
+#define ENH_KSIZE         (2 * ENH_MAX_RADIUS + 1)
+#define ENH_PERIOD_NATIVE 9.0f    // 112x96 기준 융선 주기 (sample 자기상관으로 확인, 약 9px)
+
+/* 방향별 Gabor 커널 묶음 (한 번 만들어두고 매 프레임 재사용) */
+struct s730b_gabor_bank {
+    float period;
+    int radius;
+    int ksize;
+    int16_t kern[ENH_ORIENTS][ENH_KSIZE * ENH_KSIZE];
+};
+
+/* period = 융선 주기(px). 112x96이면 ENH_PERIOD_NATIVE, 2배면 그 두배 */
+void s730b_gabor_bank_init(struct s730b_gabor_bank *bank, float period);
+
+/*
+ * ENH_BLOCK 블록마다 융선 방향(0..ENH_ORIENTS-1)과 전경 여부 계산
+ * - orient/mask 크기는 (w/ENH_BLOCK) * (h/ENH_BLOCK)
+ * - 이중각(doubled angle) 벡터를 주변 3x3 블록으로 평활화해서 노이즈 줄임
+ */
+int s730b_orientation_field(const unsigned char *img, int w, int h, uint8_t *orient, uint8_t *mask);
+
+/*
+ * 방향장 구하고 블록별로 해당 방향 커널로 convolution -> out (w x h)
+ * - 융선 = 어두움, 배경 블록은 255(흰색)
+ * - pool이 있으면 타일 row 단위로 나눠서 병렬 실행, NULL이면 현재 스레드에서
+ * - w, h는 ENH_BLOCK 배수
+ */
+int s730b_gabor_enhance(const struct s730b_gabor_bank *bank, const unsigned char *img, int w, int h,
+                        unsigned char *out, struct s730b_pool *pool);
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * s730b_enroll.c
+ *
+ * - 캡처 템플릿을 s730b_match_align으로 합성 템플릿에 정합 -> 변환해서 가까운 점은 가중 평균, 없으면 추가
+ * - 못 붙은 캡처는 한 바퀴 더 시도, 그래도 안 되면 stage_score = -1
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "s730b_enroll.h"
+
+#define ENROLL_MERGE_DIST   12      // Q2 (3px)
+#define ENROLL_MERGE_ANGLE  16      // 0..255 단위 (약 22도)
+
+static inline int adiff_u8(int a, int b) {
+    int d = (int8_t)(uint8_t)(a - b);
+    return d < 0 ? -d : d;
+}
+
+/*
+ * stage 특징점을 정합 변환해서 comp에 합치기
+ * - weight[]는 comp 특징점별로 지금까지 몇 번 합쳐졌는지 (가중 평균용)
+ */
+static int merge_stage(struct s730b_template *comp, uint8_t *weight, const struct s730b_template *st,
+                       const struct s730b_align *a) {
+    int merged = 0;
+    const int n0 = comp->count;
+
+    for (int i = 0; i < st->count; i++) {
+        float x = a->cos * st->x[i] - a->sin * st->y[i] + a->tx;
+        float y = a->sin * st->x[i] + a->cos * st->y[i] + a->ty;
+        uint8_t ang = (uint8_t)(st->angle[i] + a->rot);
+        int best = -1, bd = ENROLL_MERGE_DIST * ENROLL_MERGE_DIST + 1;
+
+        // 이번 stage에서 새로 넣은 점끼리는 안 합침 (n0까지만 봄)
+        for (int k = 0; k < n0; k++) {
+            float dx = comp->x[k] - x, dy = comp->y[k] - y;
+            int d2 = (int)(dx * dx + dy * dy);
+            if (d2 < bd && adiff_u8(comp->angle[k], ang) <= ENROLL_MERGE_ANGLE) {
+                bd = d2;
+                best = k;
+            }
+        }
+
+        if (best >= 0) {
+            int w = weight[best];
+            int da = (int8_t)(uint8_t)(ang - comp->angle[best]);
+            comp->x[best] = (int16_t)lrintf((comp->x[best] * w + x) / (w + 1));
+            comp->y[best] = (int16_t)lrintf((comp->y[best] * w + y) / (w + 1));
+            comp->angle[best] = (uint8_t)(comp->angle[best] + da / (w + 1));
+            if (w < 255)
+                weight[best] = (uint8_t)(w + 1);
+            merged++;
+        } else if (comp->count < MINU_MAX) {
+            int k = comp->count++;
+            comp->x[k] = (int16_t)lrintf(x);
+            comp->y[k] = (int16_t)lrintf(y);
+            comp->angle[k] = ang;
+            comp->type[k] = st->type[i];
+            weight[k] = 1;
+        }
+    }
+    return merged;
+}
+
+int s730b_enroll_compose(const struct s730b_template *const *stages, int n, struct s730b_template *out,
+                         struct s730b_enroll_info *info) {
+    uint8_t weight[MINU_MAX];
+    uint8_t done[ENROLL_MAX_STAGES] = {0};
+    struct s730b_align a;
+    struct s730b_enroll_info dummy;
+
+    if (!info)
+        info = &dummy;
+    memset(info, 0, sizeof(*info));
+    memset(out, 0, sizeof(*out));
+    if (n <= 0)
+        return 0;
+    if (n > ENROLL_MAX_STAGES)
+        n = ENROLL_MAX_STAGES;
+
+    /*
+     * 1) 기준 = 다른 캡처랑 제일 많이 겹치는 캡처 (threshold 넘는 상대 수, 같으면 특징점 많은 쪽)
+     * - 특징점 많은 걸 기준으로 잡았더니 혼자 동떨어진 위치인 경우 나머지가 다 안 붙었음
+     */
+    int ref = 0, ref_links = -1;
+    for (int i = 0; i < n; i++) {
+        int links = 0;
+        for (int j = 0; j < n; j++)
+            links += j != i && s730b_match(stages[j], stages[i], MATCH_THRESHOLD) >= MATCH_THRESHOLD;
+        if (links > ref_links || (links == ref_links && stages[i]->count > stages[ref]->count)) {
+            ref = i;
+            ref_links = links;
+        }
+    }
+
+    *out = *stages[ref];
+    memset(weight, 1, sizeof(weight));
+    done[ref] = 1;
+    info->used = 1;
+    for (int i = 0; i < n; i++)
+        info->stage_score[i] = -1;
+    info->stage_score[ref] = 0;
+
+    // 2) 두 바퀴: 처음에 못 붙은 캡처도 합성 템플릿이 커진 뒤 다시 시도
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < n; i++) {
+            if (done[i] || stages[i]->count < MATCH_MIN_MINUTIAE)
+                continue;
+            int score = s730b_match_align(stages[i], out, &a);
+            if (score < MATCH_THRESHOLD || a.matched < 3)
+                continue;
+
+            info->merged += merge_stage(out, weight, stages[i], &a);
+            info->stage_score[i] = score;
+            s730b_template_finish(out);
+            done[i] = 1;
+            info->used++;
+        }
+    }
+    return info->used;
+}
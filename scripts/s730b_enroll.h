@@ -0,0 +1,36 @@
+/*
+ * s730b_enroll.h
+ *
+ * - 여러 번 누른(기본 5번) 등록 캡처 템플릿을 서로 정합해서 템플릿 하나로 합치기 (minutiae 모자이크)
+ * - 112x96 한 장은 손가락 일부만 보여서, 나중에 다른 위치를 누르면 겹치는 부분이 적어 verify 실패함
+ *   -> 합치면 더 넓은 영역 템플릿 하나가 돼서 verify는 비교 한 번 + 겹침도 커짐
+ * - 좌표는 첫 번째로 받아들인 캡처 기준 (Q2, 음수/112 넘는 값 가능)
+ */
+
+#ifndef S730B_ENROLL_H
+#define S730B_ENROLL_H
+
+#include "s730b_match.h"
+
+#define ENROLL_STAGES     5
+#define ENROLL_MAX_STAGES 16
+
+struct s730b_enroll_info {
+    int used;                           // 합쳐진 캡처 수
+    int merged;                         // 기존 특징점이랑 겹쳐서 합쳐진 (평균낸) 수
+    int stage_score[ENROLL_MAX_STAGES]; // 각 캡처가 합성 템플릿에 붙을 때 점수 (-1 = 정합 실패로 버림)
+};
+
+/*
+ * n개 캡처 템플릿 -> out 합성 템플릿
+ * - 다른 캡처랑 제일 많이 겹치는 캡처에서 시작해서, 나머지를 지금까지 합친 템플릿에 정합
+ *   (점수 MATCH_THRESHOLD 이상만), 한 바퀴에 못 붙은 건 겹치는 영역이 커진 뒤 한 번 더 시도
+ * - 끝까지 못 붙은 캡처는 stage_score = -1 -> 호출하는 쪽에서 따로 템플릿으로 들고 있다가
+ *   합성 템플릿으로 verify 실패했을 때만 추가로 비교하면 됨
+ * - 정합 후 3px / 약 22도 안에 있는 특징점은 같은 점으로 보고 위치/방향 평균
+ * - 붙은 캡처 수 리턴 (1이면 합친 거 없음)
+ */
+int s730b_enroll_compose(const struct s730b_template *const *stages, int n, struct s730b_template *out,
+                         struct s730b_enroll_info *info);
+
+#endif
@@ -0,0 +1,259 @@
+/*
+ * s730b_frame.c
+ *
+ * - 세로줄/가로줄(stripe) 제거 + 평가용 점수 (ridge contrast, stripe energy)
+ * - 열/행 robust 평균 프로파일 -> 고주파 성분만 offset으로 빼줌, 16px 단위라 컴파일러가 벡터화함
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "s730b_frame.h"
+
+#define FRAME_MAX_DIM   256   // u16 누적이 안 넘치는 최대 크기 (224x192 업스케일까지 커버)
+#define LANES           16    // 안쪽 루프 고정폭 -> gcc -O2에서도 SIMD로 펴짐
+#define STRIPE_RADIUS   4     // 주변 평균 낼 때 좌우(위아래) 몇 줄까지 볼지
+#define STRIPE_MAX_FIX  64    // 한 줄당 최대 보정량
+#define DEAD_LINE_LEVEL 8     // 이보다 어두운 줄은 센서 밖(신호없음)으로 봄
+
+static inline unsigned char absdiff_u8(unsigned char a, unsigned char b) {
+    return a > b ? a - b : b - a;
+}
+
+/*
+ * column별 robust mean
+ * - 1) 평균  2) 평균절대편차  3) 평균에서 2*편차 안에 드는 값만 다시 평균
+ * - row 단위로 w개 column을 한꺼번에 u16 누적함 (LANES 단위로 끊어서 벡터화)
+ * - 나눗셈 대신 (1<<16)/n 곱하기, 결과는 x16 고정소수점
+ */
+static void column_robust_mean(const unsigned char *img, int w, int h, int *out) {
+    uint16_t sum[FRAME_MAX_DIM], dev[FRAME_MAX_DIM];
+    uint16_t acc[FRAME_MAX_DIM], cnt[FRAME_MAX_DIM];
+    unsigned char mean[FRAME_MAX_DIM], lim[FRAME_MAX_DIM];
+    const uint32_t inv_h = (65536u + h - 1) / h;
+
+    memset(sum, 0, w * sizeof(sum[0]));
+    memset(dev, 0, w * sizeof(dev[0]));
+    memset(acc, 0, w * sizeof(acc[0]));
+    memset(cnt, 0, w * sizeof(cnt[0]));
+
+    for (int y = 0; y < h; y++) {
+        const unsigned char *row = img + (size_t)y * w;
+        for (int x0 = 0; x0 < w; x0 += LANES)
+            for (int k = 0; k < LANES; k++)
+                sum[x0 + k] += row[x0 + k];
+    }
+    for (int x = 0; x < w; x++)
+        mean[x] = (unsigned char)((sum[x] * inv_h) >> 16);
+
+    for (int y = 0; y < h; y++) {
+        const unsigned char *row = img + (size_t)y * w;
+        for (int x0 = 0; x0 < w; x0 += LANES)
+            for (int k = 0; k < LANES; k++)
+                dev[x0 + k] += absdiff_u8(row[x0 + k], mean[x0 + k]);
+    }
+    for (int x = 0; x < w; x++) {
+        uint32_t l = ((2u * dev[x] * inv_h) >> 16) + 1;
+        lim[x] = l > 255 ? 255 : (unsigned char)l;
+    }
+
+    for (int y = 0; y < h; y++) {
+        const unsigned char *row = img + (size_t)y * w;
+        for (int x0 = 0; x0 < w; x0 += LANES) {
+            for (int k = 0; k < LANES; k++) {
+                int x = x0 + k;
+                uint16_t keep = absdiff_u8(row[x], mean[x]) <= lim[x];
+                acc[x] += row[x] & (uint16_t)-keep;
+                cnt[x] += keep;
+            }
+        }
+    }
+    for (int x = 0; x < w; x++)
+        out[x] = cnt[x] ? (acc[x] * 16) / cnt[x] : mean[x] * 16;
+}
+
+// row 하나 합계 (LANES개 부분합으로 나눠서 누적 후 마지막에 합침)
+static inline int row_reduce_sum(const unsigned char *row, int w) {
+    uint16_t part[LANES] = {0};
+    for (int x0 = 0; x0 < w; x0 += LANES)
+        for (int k = 0; k < LANES; k++)
+            part[k] += row[x0 + k];
+    int s = 0;
+    for (int k = 0; k < LANES; k++)
+        s += part[k];
+    return s;
+}
+
+static void row_robust_mean(const unsigned char *img, int w, int h, int *out) {
+    const uint32_t inv_w = (65536u + w - 1) / w;
+
+    for (int y = 0; y < h; y++) {
+        const unsigned char *row = img + (size_t)y * w;
+        unsigned char mean = (unsigned char)((row_reduce_sum(row, w) * inv_w) >> 16);
+
+        uint16_t dpart[LANES] = {0};
+        for (int x0 = 0; x0 < w; x0 += LANES)
+            for (int k = 0; k < LANES; k++)
+                dpart[k] += absdiff_u8(row[x0 + k], mean);
+        uint32_t dev = 0;
+        for (int k = 0; k < LANES; k++)
+            dev += dpart[k];
+        uint32_t l = ((2u * dev * inv_w) >> 16) + 1;
+        unsigned char lim = l > 255 ? 255 : (unsigned char)l;
+
+        uint16_t apart[LANES] = {0}, cpart[LANES] = {0};
+        for (int x0 = 0; x0 < w; x0 += LANES) {
+            for (int k = 0; k < LANES; k++) {
+                uint16_t keep = absdiff_u8(row[x0 + k], mean) <= lim;
+                apart[k] += row[x0 + k] & (uint16_t)-keep;
+                cpart[k] += keep;
+            }
+        }
+        int acc = 0, cnt = 0;
+        for (int k = 0; k < LANES; k++) {
+            acc += apart[k];
+            cnt += cpart[k];
+        }
+        out[y] = cnt ? (acc * 16) / cnt : mean * 16;
+    }
+}
+
+/*
+ * profile(x16)에서 줄무늬 성분만 뽑아서 보정값(offset, 픽셀단위)으로 만듦
+ * - 자기자신은 빼고 주변 STRIPE_RADIUS 줄 평균이랑 비교 (누적합으로 O(n))
+ * - 죽은 줄(신호 없음)은 보정도 안하고 주변 평균에도 안 넣음
+ */
+static void profile_to_offset(const int *prof, int n, int *off) {
+    int psum[FRAME_MAX_DIM + 1], pcnt[FRAME_MAX_DIM + 1];
+
+    psum[0] = pcnt[0] = 0;
+    for (int i = 0; i < n; i++) {
+        int live = prof[i] >= DEAD_LINE_LEVEL * 16;
+        psum[i + 1] = psum[i] + (live ? prof[i] : 0);
+        pcnt[i + 1] = pcnt[i] + live;
+    }
+
+    for (int i = 0; i < n; i++) {
+        off[i] = 0;
+        if (prof[i] < DEAD_LINE_LEVEL * 16)
+            continue;
+
+        int lo = i - STRIPE_RADIUS < 0 ? 0 : i - STRIPE_RADIUS;
+        int hi = i + STRIPE_RADIUS + 1 > n ? n : i + STRIPE_RADIUS + 1;
+        int s = psum[hi] - psum[lo] - prof[i];
+        int c = pcnt[hi] - pcnt[lo] - 1;
+        if (c <= 0)
+            continue;
+
+        int d = (s / c - prof[i]) / 16;
+        if (d > STRIPE_MAX_FIX)
+            d = STRIPE_MAX_FIX;
+        else if (d < -STRIPE_MAX_FIX)
+            d = -STRIPE_MAX_FIX;
+        off[i] = d;
+    }
+}
+
+// 0은 센서 밖(신호없음)이라 그대로 둠
+static inline unsigned char apply_offset(unsigned char v, int16_t d) {
+    int16_t r = (int16_t)(v + d);
+    r = r < 0 ? 0 : (r > 255 ? 255 : r);
+    return (unsigned char)(r & -(int16_t)(v != 0));
+}
+
+// LANES 단위로만 도니까 w는 16의 배수여야 함 (112, 96, 224, 192 전부 OK)
+static int frame_dims_ok(const unsigned char *img, int w, int h) {
+    return img && w > 2 && h > 2 && w <= FRAME_MAX_DIM && h <= FRAME_MAX_DIM && w % LANES == 0;
+}
+
+void s730b_destripe(unsigned char *img, int w, int h) {
+    int prof[FRAME_MAX_DIM];
+    int off[FRAME_MAX_DIM];
+    int16_t off16[FRAME_MAX_DIM];
+
+    if (!frame_dims_ok(img, w, h))
+        return;
+
+    // 1) 세로줄 (column)
+    column_robust_mean(img, w, h, prof);
+    profile_to_offset(prof, w, off);
+    for (int x = 0; x < w; x++)
+        off16[x] = (int16_t)off[x];
+    for (int y = 0; y < h; y++) {
+        unsigned char *row = img + (size_t)y * w;
+        for (int x0 = 0; x0 < w; x0 += LANES)
+            for (int k = 0; k < LANES; k++)
+                row[x0 + k] = apply_offset(row[x0 + k], off16[x0 + k]);
+    }
+
+    // 2) 가로줄 (row) - 세로줄 보정 끝난 이미지 기준으로 다시 계산
+    row_robust_mean(img, w, h, prof);
+    profile_to_offset(prof, h, off);
+    for (int y = 0; y < h; y++) {
+        if (!off[y])
+            continue;
+        unsigned char *row = img + (size_t)y * w;
+        int16_t d = (int16_t)off[y];
+        for (int x0 = 0; x0 < w; x0 += LANES)
+            for (int k = 0; k < LANES; k++)
+                row[x0 + k] = apply_offset(row[x0 + k], d);
+    }
+}
+
+double s730b_ridge_contrast(const unsigned char *img, int w, int h) {
+    const int bs = 8;
+    double total = 0.0;
+    int blocks = 0;
+
+    if (!img)
+        return 0.0;
+
+    for (int by = 0; by + bs <= h; by += bs) {
+        for (int bx = 0; bx + bs <= w; bx += bs) {
+            int s = 0, ss = 0;
+            for (int y = by; y < by + bs; y++) {
+                const unsigned char *row = img + (size_t)y * w + bx;
+                for (int x = 0; x < bs; x++) {
+                    s += row[x];
+                    ss += row[x] * row[x];
+                }
+            }
+            double n = (double)(bs * bs);
+            double m = s / n;
+            double var = ss / n - m * m;
+            total += var > 0 ? sqrt(var) : 0.0;
+            blocks++;
+        }
+    }
+    return blocks ? total / blocks : 0.0;
+}
+
+static double profile_highpass_sq(const int *prof, int n) {
+    double e = 0.0;
+    for (int i = 0; i < n; i++) {
+        int s = 0, c = 0;
+        for (int k = i - STRIPE_RADIUS; k <= i + STRIPE_RADIUS; k++) {
+            if (k < 0 || k >= n || k == i)
+                continue;
+            s += prof[k];
+            c++;
+        }
+        double d = (prof[i] - (double)s / c) / 16.0;
+        e += d * d;
+    }
+    return e;
+}
+
+double s730b_stripe_energy(const unsigned char *img, int w, int h) {
+    int prof[FRAME_MAX_DIM];
+
+    if (!frame_dims_ok(img, w, h))
+        return 0.0;
+
+    double e = 0.0;
+    column_robust_mean(img, w, h, prof);
+    e += profile_highpass_sq(prof, w);
+    row_robust_mean(img, w, h, prof);
+    e += profile_highpass_sq(prof, h);
+    return sqrt(e / (w + h));
+}
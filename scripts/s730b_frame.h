@@ -0,0 +1,43 @@
+/*
+ * s730b_frame.h
+ *
+ * - 캡처 버퍼(약 21.5KB)에서 뽑은 112x96 지문 프레임 처리용 함수들
+ * - samsung_730b.c (libusb 드라이버)랑 s730b_bench.c (오프라인 벤치)에서 같이 씀
+ * - 전부 libusb 없이 돌아가게 만들었음 (sample/ 밑의 .raw로 바로 테스트 가능)
+ */
+
+#ifndef S730B_FRAME_H
+#define S730B_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define IMG_OFFSET 180
+#define IMG_WIDTH  112
+#define IMG_HEIGHT 96
+#define IMG_SIZE   (IMG_WIDTH * IMG_HEIGHT)
+
+/* 벤치/latency 측정용 monotonic 시계 (ns) */
+static inline uint64_t s730b_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * 세로줄/가로줄(fixed-pattern stripe) 제거
+ * - column/row별 robust mean을 구해서 주변 column/row 평균과의 차이만큼 보정함
+ * - 손가락이 반만 올라간 경우(half.raw)처럼 완만한 밝기 변화는 안 건드리고
+ *   한두 줄짜리 튀는 라인만 평평하게 만듦
+ * - img를 그자리에서(in place) 수정함
+ */
+void s730b_destripe(unsigned char *img, int w, int h);
+
+/* 8x8 블록별 표준편차 평균 (융선/골 대비 지표, 클수록 선명함) */
+double s730b_ridge_contrast(const unsigned char *img, int w, int h);
+
+/* column/row profile의 고주파 성분 RMS (줄무늬 세기 지표, 작을수록 좋음) */
+double s730b_stripe_energy(const unsigned char *img, int w, int h);
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ * s730b_fusion.c
+ *
+ * - 정수 shift SSD 탐색 + 2차 보간으로 sub-pixel 정합, 2배 격자에 bilinear로 쌓아서 평균
+ * - 축별 좌표 표는 미리 만들어 둠 (픽셀마다 나눗셈 없음)
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "s730b_fusion.h"
+
+#define FUSION_MAX_DIM 256
+#define LANES          16
+#define MARGIN_X       (LANES / 2)   // 탐색범위(4)보다 크고 창 너비가 16의 배수로 유지되게 8
+#define MARGIN_Y       FUSION_SEARCH
+
+/*
+ * 중앙 창(window)에서 ref(x, y) vs img(x + dx, y + dy) SSD
+ * - row마다 LANES개 부분합에 누적 -> -O2에서도 벡터로 펴짐
+ * - SAD보다 최소점 근처가 포물면에 가까워서 sub-pixel fit이 덜 치우침
+ */
+static uint32_t window_ssd(const unsigned char *ref, const unsigned char *img, int w, int h, int dx, int dy) {
+    uint32_t total = 0;
+
+    for (int y = MARGIN_Y; y < h - MARGIN_Y; y++) {
+        const unsigned char *r = ref + (size_t)y * w + MARGIN_X;
+        const unsigned char *s = img + (size_t)(y + dy) * w + MARGIN_X + dx;
+        uint32_t part[LANES] = {0};
+
+        for (int x0 = 0; x0 < w - 2 * MARGIN_X; x0 += LANES) {
+            for (int k = 0; k < LANES; k++) {
+                int d = (int)r[x0 + k] - (int)s[x0 + k];
+                part[k] += (uint32_t)(d * d);
+            }
+        }
+        for (int k = 0; k < LANES; k++)
+            total += part[k];
+    }
+    return total;
+}
+
+/*
+ * 3x3 SSD 값으로 2차 곡면 맞춰서 최소점 찾음
+ * - 지문은 융선 방향으로 길게 골짜기가 생겨서(aperture 문제) x, y 따로 1차원 fit 하면
+ *   대각선 방향으로 크게 틀림 -> hxy까지 포함한 2D fit
+ * - 곡면이 이상하면(det <= 0) 정수 위치 그대로
+ */
+static void quadratic_peak(const double f[3][3], float *ux, float *uy) {
+    double gx = (f[1][2] - f[1][0]) / 2.0;
+    double gy = (f[2][1] - f[0][1]) / 2.0;
+    double hxx = f[1][2] - 2.0 * f[1][1] + f[1][0];
+    double hyy = f[2][1] - 2.0 * f[1][1] + f[0][1];
+    double hxy = (f[2][2] + f[0][0] - f[0][2] - f[2][0]) / 4.0;
+    double det = hxx * hyy - hxy * hxy;
+
+    *ux = *uy = 0.0f;
+    if (det <= 0.0 || hxx <= 0.0)
+        return;
+
+    double x = -(hyy * gx - hxy * gy) / det;
+    double y = -(hxx * gy - hxy * gx) / det;
+    *ux = (float)(x < -1.0 ? -1.0 : (x > 1.0 ? 1.0 : x));
+    *uy = (float)(y < -1.0 ? -1.0 : (y > 1.0 ? 1.0 : y));
+}
+
+int s730b_register_shift(const unsigned char *ref, const unsigned char *img, int w, int h,
+                         struct s730b_shift *out) {
+    const int R = FUSION_SEARCH;
+    uint32_t ssd[2 * FUSION_SEARCH + 1][2 * FUSION_SEARCH + 1];
+    uint32_t best = UINT32_MAX;
+    int bx = 0, by = 0;
+
+    if (!ref || !img || !out || w % LANES || w <= 2 * MARGIN_X || h <= 2 * MARGIN_Y)
+        return -1;
+
+    for (int dy = -R; dy <= R; dy++) {
+        for (int dx = -R; dx <= R; dx++) {
+            uint32_t s = window_ssd(ref, img, w, h, dx, dy);
+            ssd[dy + R][dx + R] = s;
+            if (s < best) {
+                best = s;
+                bx = dx;
+                by = dy;
+            }
+        }
+    }
+
+    out->dx = (float)bx;
+    out->dy = (float)by;
+    if (bx > -R && bx < R && by > -R && by < R) {
+        double f[3][3];
+        float ux, uy;
+        for (int j = 0; j < 3; j++)
+            for (int i = 0; i < 3; i++)
+                f[j][i] = (double)ssd[by + R + j - 1][bx + R + i - 1];
+        quadratic_peak(f, &ux, &uy);
+        out->dx += ux;
+        out->dy += uy;
+    }
+
+    // 픽셀당 RMS 차이 (정합 신뢰도 참고용)
+    out->rms = (int)sqrt((double)best / ((w - 2 * MARGIN_X) * (h - 2 * MARGIN_Y)));
+    return 0;
+}
+
+/*
+ * 출력 좌표 X(2배 격자) -> 원본 좌표 테이블
+ * - shift가 프레임마다 상수라서 x는 X에만, y는 Y에만 의존 -> 1차원 테이블 두 개로 끝남
+ * - 가장자리 1px 밖까지는 clamp, 그보다 멀면 그 프레임은 해당 픽셀에 기여 안 함
+ */
+struct axis_map {
+    int16_t i0[FUSION_MAX_DIM * FUSION_SCALE];
+    uint8_t frac[FUSION_MAX_DIM * FUSION_SCALE];    // 0..255
+    uint8_t valid[FUSION_MAX_DIM * FUSION_SCALE];
+};
+
+static void build_axis_map(struct axis_map *m, int n_src, float shift) {
+    for (int X = 0; X < n_src * FUSION_SCALE; X++) {
+        float src = ((float)X + 0.5f) / FUSION_SCALE - 0.5f + shift;
+
+        m->valid[X] = src >= -1.0f && src <= (float)n_src;
+        if (src < 0.0f)
+            src = 0.0f;
+        if (src > (float)(n_src - 1))
+            src = (float)(n_src - 1);
+
+        int i0 = (int)src;
+        if (i0 >= n_src - 1)
+            i0 = n_src - 2;
+        m->i0[X] = (int16_t)i0;
+
+        int f = (int)lrintf((src - (float)i0) * 256.0f);
+        m->frac[X] = (uint8_t)(f > 255 ? 255 : f);
+    }
+}
+
+static inline int bilinear(const unsigned char *img, int w, int x0, int fx, int y0, int fy) {
+    const unsigned char *p = img + (size_t)y0 * w + x0;
+    int top = p[0] * (256 - fx) + p[1] * fx;
+    int bot = p[w] * (256 - fx) + p[w + 1] * fx;
+    return (top * (256 - fy) + bot * fy + (1 << 15)) >> 16;
+}
+
+int s730b_fuse_frames(const unsigned char *const *frames, const struct s730b_shift *shifts, int n,
+                      int w, int h, unsigned char *out) {
+    struct axis_map mx[FUSION_MAX_FRAMES], my[FUSION_MAX_FRAMES];
+    const int W = w * FUSION_SCALE, H = h * FUSION_SCALE;
+
+    if (!frames || !shifts || !out || n <= 0 || n > FUSION_MAX_FRAMES ||
+        w < 2 || h < 2 || w > FUSION_MAX_DIM || h > FUSION_MAX_DIM)
+        return -1;
+
+    for (int k = 0; k < n; k++) {
+        build_axis_map(&mx[k], w, shifts[k].dx);
+        build_axis_map(&my[k], h, shifts[k].dy);
+    }
+
+    for (int Y = 0; Y < H; Y++) {
+        unsigned char *dst = out + (size_t)Y * W;
+
+        for (int X = 0; X < W; X++) {
+            int sum = 0, cnt = 0, lo = 255, hi = 0;
+
+            for (int k = 0; k < n; k++) {
+                if (!mx[k].valid[X] || !my[k].valid[Y])
+                    continue;
+                int v = bilinear(frames[k], w, mx[k].i0[X], mx[k].frac[X], my[k].i0[Y], my[k].frac[Y]);
+                sum += v;
+                cnt++;
+                lo = v < lo ? v : lo;
+                hi = v > hi ? v : hi;
+            }
+
+            /*
+             * robust mean: 6장 이상 겹치면 최소/최대 하나씩 버림
+             * - 그보다 적으면 버리는 만큼 평균 효과가 더 손해라 그냥 평균
+             */
+            if (cnt >= 6) {
+                sum -= lo + hi;
+                cnt -= 2;
+            }
+            dst[X] = cnt ? (unsigned char)((sum + cnt / 2) / cnt) : 0;
+        }
+    }
+    return 0;
+}
+
+void s730b_upscale2x(const unsigned char *img, int w, int h, unsigned char *out) {
+    const struct s730b_shift zero = { 0.0f, 0.0f, 0 };
+    s730b_fuse_frames(&img, &zero, 1, w, h, out);
+}
@@ -0,0 +1,38 @@
+/*
+ * s730b_fusion.h
+ *
+ * - burst로 찍은 K장 프레임을 서로 정합(sub-pixel shift)해서 2배 격자(224x192)에 합치는 함수들
+ * - 112x96 한 장을 그냥 2배 업스케일 하는 것보다 노이즈 적고 촘촘한 이미지 얻는 게 목적
+ * - 프레임 사이 손가락은 거의 안 움직인다고 보고 평행이동(dx, dy)만 추정함 (회전 X)
+ */
+
+#ifndef S730B_FUSION_H
+#define S730B_FUSION_H
+
+#define FUSION_MAX_FRAMES 8
+#define FUSION_SCALE      2
+#define FUSION_SEARCH     4    // 정수 shift 탐색 범위 (+-px)
+
+struct s730b_shift {
+    float dx;       // img(x + dx, y + dy) ~= ref(x, y)
+    float dy;
+    int rms;        // 최적 위치 픽셀당 RMS 차이 (정합 신뢰도 참고용)
+};
+
+/* ref 기준으로 img가 얼마나 밀렸는지 추정 (w는 16의 배수) */
+int s730b_register_shift(const unsigned char *ref, const unsigned char *img, int w, int h,
+                         struct s730b_shift *out);
+
+/*
+ * n장을 shift 보정해서 (w*2)x(h*2) 격자로 합침
+ * - 각 출력 픽셀마다 프레임별 bilinear 샘플을 모아서
+ *   6장 이상 겹치면 최소/최대 버리고 평균 (robust mean)
+ * - shifts[0]은 보통 {0, 0} (기준 프레임)
+ */
+int s730b_fuse_frames(const unsigned char *const *frames, const struct s730b_shift *shifts, int n,
+                      int w, int h, unsigned char *out);
+
+/* 한 장짜리 2배 bilinear 업스케일 (비교 기준용) */
+void s730b_upscale2x(const unsigned char *img, int w, int h, unsigned char *out);
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * s730b_gallery.c
+ *
+ * - 만들기 / 열기 (mmap) / 다른 프로세스가 늘린 것 다시 매핑 / append
+ * - append는 record 먼저 쓰고 index + header count는 마지막에 (count 보이는 record는 다 쓰여 있음)
+ * - append는 flock(LOCK_EX)로 프로세스끼리 직렬화, index offset은 매핑 범위 안인지 확인하고 씀
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "s730b_gallery.h"
+
+#define ALIGN_UP(x, a)  (((x) + (a) - 1) / (a) * (a))
+
+_Static_assert(sizeof(struct s730b_gallery_header) == 64, "gallery header must be 64 bytes");
+_Static_assert(sizeof(struct s730b_gallery_entry) == 16, "gallery index entry must be 16 bytes");
+
+static int write_full(int fd, const void *buf, size_t len, off_t off) {
+    const unsigned char *p = buf;
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, off);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        off += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int s730b_gallery_create(const char *path, int capacity) {
+    struct s730b_gallery_header h;
+
+    if (capacity <= 0)
+        capacity = GALLERY_DEFAULT_CAPACITY;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, GALLERY_MAGIC, sizeof(h.magic));
+    h.version = GALLERY_VERSION;
+    h.header_size = sizeof(h);
+    h.record_size = ALIGN_UP(sizeof(struct s730b_template), GALLERY_ALIGN);
+    h.template_size = sizeof(struct s730b_template);
+    h.max_pairs = MATCH_MAX_PAIRS;
+    h.capacity = (uint32_t)capacity;
+    h.count = 0;
+    h.index_offset = sizeof(h);
+    h.records_offset = ALIGN_UP(h.index_offset + (uint64_t)capacity * sizeof(struct s730b_gallery_entry), 4096);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+    if (ftruncate(fd, (off_t)h.records_offset) < 0 || write_full(fd, &h, sizeof(h), 0) < 0 ||
+        fdatasync(fd) < 0) {
+        close(fd);
+        return -1;
+    }
+    return close(fd);
+}
+
+static int gallery_map(struct s730b_gallery *g) {
+    struct stat st;
+
+    if (fstat(g->fd, &st) < 0 || (size_t)st.st_size < sizeof(struct s730b_gallery_header))
+        return -1;
+
+    if (g->map)
+        munmap(g->map, g->map_len);
+    g->map_len = (size_t)st.st_size;
+    g->map = mmap(NULL, g->map_len, PROT_READ, MAP_SHARED, g->fd, 0);
+    if (g->map == MAP_FAILED) {
+        g->map = NULL;
+        return -1;
+    }
+
+    g->hdr = (const struct s730b_gallery_header *)g->map;
+    g->index = (const struct s730b_gallery_entry *)(g->map + g->hdr->index_offset);
+    return 0;
+}
+
+// 다른 빌드/버전에서 만든 파일이거나 크기가 안 맞으면 거부
+static int header_ok(const struct s730b_gallery *g) {
+    const struct s730b_gallery_header *h = g->hdr;
+
+    if (memcmp(h->magic, GALLERY_MAGIC, sizeof(h->magic)) != 0 || h->version != GALLERY_VERSION ||
+        h->header_size != sizeof(*h) || h->template_size != sizeof(struct s730b_template) ||
+        h->max_pairs != MATCH_MAX_PAIRS || h->record_size % GALLERY_ALIGN != 0 ||
+        h->records_offset % GALLERY_ALIGN != 0 || h->count > h->capacity)
+        return 0;
+    if (h->index_offset + (uint64_t)h->capacity * sizeof(struct s730b_gallery_entry) > h->records_offset)
+        return 0;
+    return h->records_offset + (uint64_t)h->count * h->record_size <= g->map_len;
+}
+
+// index[from..to-1]: record i는 레코드 영역 i번째 칸에 있어야 함 (s730b_gallery_records가 연속이라고 가정)
+static int index_ok(const struct s730b_gallery *g, uint32_t from, uint32_t to) {
+    const uint64_t rsize = g->hdr->record_size;
+
+    for (uint32_t i = from; i < to; i++) {
+        uint64_t off = g->index[i].offset;
+        if (off != g->hdr->records_offset + i * rsize || off + rsize > g->map_len)
+            return 0;
+    }
+    return 1;
+}
+
+int s730b_gallery_open(struct s730b_gallery *g, const char *path, int writable) {
+    memset(g, 0, sizeof(*g));
+    g->writable = writable;
+    g->fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (g->fd < 0)
+        return -1;
+
+    if (gallery_map(g) < 0 || !header_ok(g) || !index_ok(g, 0, g->hdr->count)) {
+        s730b_gallery_close(g);
+        return -1;
+    }
+    g->count = (int)g->hdr->count;
+    return 0;
+}
+
+void s730b_gallery_close(struct s730b_gallery *g) {
+    if (g->map)
+        munmap(g->map, g->map_len);
+    if (g->fd >= 0)
+        close(g->fd);
+    memset(g, 0, sizeof(*g));
+    g->fd = -1;
+}
+
+int s730b_gallery_refresh(struct s730b_gallery *g) {
+    uint32_t count = __atomic_load_n(&g->hdr->count, __ATOMIC_ACQUIRE);
+    uint64_t need = g->hdr->records_offset + (uint64_t)count * g->hdr->record_size;
+
+    if (need > g->map_len && (gallery_map(g) < 0 || !header_ok(g)))
+        return -1;
+    if (count > (uint32_t)g->count && !index_ok(g, (uint32_t)g->count, count))
+        return -1;
+    g->count = (int)count;
+    return 0;
+}
+
+// flock 잡은 채로 부름: refresh -> 필요하면 늘림 -> record -> index -> commit
+static int gallery_append_locked(struct s730b_gallery *g, const struct s730b_template *t, uint32_t id) {
+    struct stat st;
+
+    if (s730b_gallery_refresh(g) < 0 || (uint32_t)g->count >= g->hdr->capacity)
+        return -1;
+
+    const uint32_t n = (uint32_t)g->count;
+    const uint64_t rsize = g->hdr->record_size;
+    const uint64_t off = g->hdr->records_offset + n * rsize;
+
+    // 파일은 GALLERY_GROW개 단위로 미리 늘려둠 (매번 ftruncate + 다시 mmap 안 하게)
+    // 다른 프로세스가 이미 더 늘려놨으면 줄이지 않고 그 크기로 다시 매핑만
+    if (off + rsize > g->map_len) {
+        uint64_t len = g->hdr->records_offset + ALIGN_UP(n + 1, GALLERY_GROW) * rsize;
+        if (fstat(g->fd, &st) < 0)
+            return -1;
+        if (len > (uint64_t)st.st_size && ftruncate(g->fd, (off_t)len) < 0)
+            return -1;
+        if (gallery_map(g) < 0)
+            return -1;
+    }
+
+    // 1) record (뒤쪽 padding은 0)
+    unsigned char pad[GALLERY_ALIGN] = {0};
+    if (write_full(g->fd, t, sizeof(*t), (off_t)off) < 0 ||
+        write_full(g->fd, pad, rsize - sizeof(*t), (off_t)(off + sizeof(*t))) < 0)
+        return -1;
+
+    // 2) index
+    struct s730b_gallery_entry e = { .offset = off, .id = id, .flags = 0 };
+    if (write_full(g->fd, &e, sizeof(e), (off_t)(g->hdr->index_offset + n * sizeof(e))) < 0 ||
+        fdatasync(g->fd) < 0)
+        return -1;
+
+    // 3) commit
+    uint32_t count = n + 1;
+    if (write_full(g->fd, &count, sizeof(count), (off_t)offsetof(struct s730b_gallery_header, count)) < 0 ||
+        fdatasync(g->fd) < 0)
+        return -1;
+
+    g->count = (int)count;
+    return (int)n;
+}
+
+int s730b_gallery_append(struct s730b_gallery *g, const struct s730b_template *t, uint32_t id) {
+    if (!g->writable)
+        return -1;
+
+    int r;
+    while ((r = flock(g->fd, LOCK_EX)) < 0 && errno == EINTR)
+        ;
+    if (r < 0)
+        return -1;
+    r = gallery_append_locked(g, t, id);
+    flock(g->fd, LOCK_UN);
+    return r;
+}
@@ -0,0 +1,88 @@
+/*
+ * s730b_gallery.h
+ *
+ * - 등록된 템플릿을 파일 하나에 모아두는 갤러리 포맷 (mmap으로 열어서 파싱 없이 바로 매칭)
+ * - 여러 프로세스가 같은 파일 열면 page cache 공유됨
+ *
+ * 파일 구조 (리틀엔디안, 이 머신 struct 그대로):
+ *
+ *   [header 64B][index: capacity x 16B][record 0][record 1]...
+ *
+ * - record = struct s730b_template 그대로, 64바이트 배수 크기/64바이트 정렬
+ *   -> 레코드 영역이 연속이라 s730b_identify()에 (records, stride)로 바로 넘길 수 있음
+ * - index[i] = record i의 파일 offset + 사용자 id + flags
+ * - append: record 쓰고 index 쓰고 fdatasync -> header의 count 올리고 fdatasync
+ *   (count가 commit 지점이라 중간에 죽어도 이전 상태 그대로)
+ * - append는 파일에 flock(LOCK_EX) 잡고 함 -> 여러 프로세스가 같이 append해도 됨 (읽기는 lock 없음)
+ * - index 칸이 다 차면 append 실패 (새 capacity로 다시 만들어야 함)
+ */
+
+#ifndef S730B_GALLERY_H
+#define S730B_GALLERY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "s730b_match.h"
+
+#define GALLERY_MAGIC            "S730BGAL"
+#define GALLERY_VERSION          1
+#define GALLERY_ALIGN            64
+#define GALLERY_DEFAULT_CAPACITY 65536      // index 1MB (ftruncate라 안 쓴 부분은 디스크 안 먹음)
+#define GALLERY_GROW             64         // 파일 늘릴 때 한 번에 늘리는 record 수
+
+struct s730b_gallery_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;       // sizeof(struct s730b_template)를 64 배수로 올린 값
+    uint32_t template_size;     // sizeof(struct s730b_template) (빌드 설정 다르면 못 엶)
+    uint32_t max_pairs;         // MATCH_MAX_PAIRS
+    uint32_t capacity;          // index 칸 수
+    uint32_t count;             // commit된 record 수
+    uint32_t reserved0;
+    uint64_t index_offset;
+    uint64_t records_offset;
+    uint8_t reserved[8];
+};
+
+struct s730b_gallery_entry {
+    uint64_t offset;
+    uint32_t id;                // 사용자/손가락 번호 (호출하는 쪽 마음대로)
+    uint32_t flags;             // 지금은 0 (나중에 삭제 표시 등)
+};
+
+struct s730b_gallery {
+    int fd;
+    int writable;
+    unsigned char *map;
+    size_t map_len;
+    const struct s730b_gallery_header *hdr;
+    const struct s730b_gallery_entry *index;
+    int count;
+};
+
+/* 빈 갤러리 파일 새로 만들기 (있으면 덮어씀), capacity <= 0 이면 기본값 */
+int s730b_gallery_create(const char *path, int capacity);
+
+/* 열기 + mmap, writable이면 append 가능 */
+int s730b_gallery_open(struct s730b_gallery *g, const char *path, int writable);
+void s730b_gallery_close(struct s730b_gallery *g);
+
+/* 끝에 하나 추가, 성공하면 record 번호 */
+int s730b_gallery_append(struct s730b_gallery *g, const struct s730b_template *t, uint32_t id);
+
+/* 다른 프로세스가 append 한 거 반영 (header count 다시 읽고 필요하면 다시 mmap) */
+int s730b_gallery_refresh(struct s730b_gallery *g);
+
+static inline const struct s730b_template *s730b_gallery_get(const struct s730b_gallery *g, int i) {
+    return (const struct s730b_template *)(g->map + g->index[i].offset);
+}
+
+/* 레코드 영역 시작 + 간격 (s730b_identify용) */
+static inline const void *s730b_gallery_records(const struct s730b_gallery *g, size_t *stride) {
+    *stride = g->hdr->record_size;
+    return g->map + g->hdr->records_offset;
+}
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * s730b_ident.c
+ *
+ * - 갤러리를 IDENT_BLOCK개 묶음 task로 나눠 s730b_pool에 넘김, worker별 top-k는 끝나고 합침
+ * - 지금 top-k 꼴찌 점수를 매칭 threshold로 넘겨서 못 들어올 후보는 중간에 버림
+ */
+
+#include <string.h>
+
+#include "s730b_ident.h"
+
+// worker별 top-k (점수 내림차순), cache line 따로 쓰게 64 정렬
+struct ident_topk {
+    struct s730b_ident_hit hit[IDENT_MAX_TOPK];
+    int n;
+    long compared;
+} __attribute__((aligned(64)));
+
+struct ident_job {
+    struct s730b_pool *pool;
+    const struct s730b_template *probe;
+    const unsigned char *gallery;
+    size_t stride;
+    const int *list;            // NULL이면 0..count-1 전부, 아니면 list[0..count-1]만
+    int count;
+    struct s730b_ident_opts opts;
+    int cancelled;
+    struct ident_topk local[POOL_MAX_THREADS];
+};
+
+static void topk_insert(struct ident_topk *t, int k, int index, int score) {
+    int pos;
+
+    if (t->n < k)
+        pos = t->n++;
+    else if (t->hit[k - 1].score >= score)
+        return;
+    else
+        pos = k - 1;
+
+    while (pos > 0 && t->hit[pos - 1].score < score) {
+        t->hit[pos] = t->hit[pos - 1];
+        pos--;
+    }
+    t->hit[pos].index = index;
+    t->hit[pos].score = score;
+}
+
+// top-k가 다 찼으면 꼴찌보다 높아야 들어옴, 아니면 threshold만 넘으면 됨
+static inline int topk_floor(const struct ident_topk *t, const struct s730b_ident_opts *o) {
+    if (t->n < o->topk)
+        return o->threshold;
+    int f = t->hit[o->topk - 1].score + 1;
+    return f > o->threshold ? f : o->threshold;
+}
+
+static void ident_task(void *arg, int task, int worker) {
+    struct ident_job *job = arg;
+    struct ident_topk *t = &job->local[worker];
+    const struct s730b_ident_opts *o = &job->opts;
+    int lo = task * IDENT_BLOCK;
+    int hi = lo + IDENT_BLOCK < job->count ? lo + IDENT_BLOCK : job->count;
+
+    for (int k = lo; k < hi; k++) {
+        const int i = job->list ? job->list[k] : k;
+        const struct s730b_template *g = (const void *)(job->gallery + (size_t)i * job->stride);
+        int need = topk_floor(t, o);
+
+        // need 못 넘는 후보는 매칭 중간에 포기, 넘으면 정확한 점수 다시 계산 (드물게만 일어남)
+        int score = s730b_match(job->probe, g, need);
+        t->compared++;
+        if (score < need)
+            continue;
+        score = s730b_match(job->probe, g, 0);
+        topk_insert(t, o->topk, i, score);
+
+        if (o->accept > 0 && score >= o->accept) {
+            __atomic_store_n(&job->cancelled, 1, __ATOMIC_RELAXED);
+            if (job->pool)
+                s730b_pool_cancel(job->pool);
+        }
+    }
+}
+
+int s730b_identify_list(struct s730b_pool *pool, const struct s730b_template *probe,
+                        const void *gallery, size_t stride, const int *list, int count,
+                        const struct s730b_ident_opts *opts, struct s730b_ident_hit *hits,
+                        struct s730b_ident_stats *stats) {
+    struct ident_job job;
+    int ntasks = (count + IDENT_BLOCK - 1) / IDENT_BLOCK;
+    int nworkers = pool ? pool->nthreads : 1;
+
+    memset(&job, 0, sizeof(job));
+    job.pool = pool;
+    job.probe = probe;
+    job.gallery = gallery;
+    job.stride = stride;
+    job.list = list;
+    job.count = count;
+    job.opts = *opts;
+    if (job.opts.topk < 1)
+        job.opts.topk = 1;
+    if (job.opts.topk > IDENT_MAX_TOPK)
+        job.opts.topk = IDENT_MAX_TOPK;
+    if (job.opts.threshold < 1)
+        job.opts.threshold = 1;
+
+    if (pool) {
+        s730b_pool_run(pool, ntasks, ident_task, &job);
+    } else {
+        for (int t = 0; t < ntasks && !job.cancelled; t++)
+            ident_task(&job, t, 0);
+    }
+
+    // worker별 결과 합치기
+    struct ident_topk merged = { .n = 0 };
+    long compared = 0;
+    for (int w = 0; w < nworkers; w++) {
+        compared += job.local[w].compared;
+        for (int i = 0; i < job.local[w].n; i++)
+            topk_insert(&merged, job.opts.topk, job.local[w].hit[i].index, job.local[w].hit[i].score);
+    }
+
+    memcpy(hits, merged.hit, merged.n * sizeof(hits[0]));
+    if (stats) {
+        stats->compared = compared;
+        stats->cancelled = job.cancelled;
+    }
+    return merged.n;
+}
+
+int s730b_identify(struct s730b_pool *pool, const struct s730b_template *probe,
+                   const void *gallery, int count, size_t stride,
+                   const struct s730b_ident_opts *opts, struct s730b_ident_hit *hits,
+                   struct s730b_ident_stats *stats) {
+    return s730b_identify_list(pool, probe, gallery, stride, NULL, count, opts, hits, stats);
+}
@@ -0,0 +1,56 @@
+/*
+ * s730b_ident.h
+ *
+ * - 1:N 식별 ("이 손가락 누구?"): probe 템플릿 하나를 갤러리 전체와 비교해서 상위 k개 리턴
+ * - 갤러리는 템플릿 묶음(IDENT_BLOCK개) 단위 task로 쪼개서 스레드 풀(work stealing)로 돌림
+ * - worker마다 자기 top-k를 따로 들고 있다가 끝나고 합침 (공유 상태 없음)
+ * - 조기 종료
+ *   1) 비교마다: 지금 top-k 꼴찌 점수를 threshold로 넘겨서 못 들어올 후보는 매칭 도중 포기
+ *   2) 전체: accept 점수 넘는 후보 나오면 남은 task 취소
+ */
+
+#ifndef S730B_IDENT_H
+#define S730B_IDENT_H
+
+#include <stddef.h>
+
+#include "s730b_match.h"
+#include "s730b_pool.h"
+
+#define IDENT_MAX_TOPK  16
+#define IDENT_BLOCK     32      // task 하나에 들어가는 템플릿 수
+
+struct s730b_ident_hit {
+    int index;                  // 갤러리 안 번호
+    int score;
+};
+
+struct s730b_ident_opts {
+    int topk;                   // 1..IDENT_MAX_TOPK
+    int threshold;              // 이 점수 미만은 결과에 안 넣음 (보통 MATCH_THRESHOLD)
+    int accept;                 // 이 점수 이상 나오면 검색 중단, 0 = 끝까지
+};
+
+struct s730b_ident_stats {
+    long compared;              // 실제로 비교한 템플릿 수 (조기 종료하면 count보다 작음)
+    int cancelled;
+};
+
+/*
+ * gallery: 템플릿 count개가 stride 바이트 간격으로 있는 배열
+ * - 메모리 배열이면 stride = sizeof(struct s730b_template), mmap 갤러리 파일이면 레코드 크기
+ * - pool = NULL 이면 호출 스레드 혼자
+ * - hits에 점수 내림차순으로 채우고 개수 리턴
+ */
+int s730b_identify(struct s730b_pool *pool, const struct s730b_template *probe,
+                   const void *gallery, int count, size_t stride,
+                   const struct s730b_ident_opts *opts, struct s730b_ident_hit *hits,
+                   struct s730b_ident_stats *stats);
+
+/* 갤러리 중 list[0..count-1] 번호만 비교 (s730b_prefilter로 추린 후보), hits의 index는 갤러리 번호 */
+int s730b_identify_list(struct s730b_pool *pool, const struct s730b_template *probe,
+                        const void *gallery, size_t stride, const int *list, int count,
+                        const struct s730b_ident_opts *opts, struct s730b_ident_hit *hits,
+                        struct s730b_ident_stats *stats);
+
+#endif
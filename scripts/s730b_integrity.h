@@ -0,0 +1,64 @@
+/*
+ * s730b_integrity.h
+ *
+ * - 캡처한 raw 프레임 검사: chunk 다 왔는지, 짧은 chunk, 이미지 부분 CRC32C, 앞 프레임이랑 똑같은지 (stale 버퍼)
+ * - 예전엔 s730b_proto_capture가 중간에 멈춰도 길이만 짧아지고 save_pgm_from_raw에서야 조용히 버려졌음
+ *   -> 캡처 바로 뒤에 s730b_frame_check 불러서 flags 보고 버리거나 다시 찍음
+ * - CRC32C: x86-64에서 SSE4.2 있으면 crc32 명령 (실행 시 확인), 없으면 slice-by-8 표
+ * - 중복: 최근 INTEGRITY_HISTORY 프레임 이미지 CRC랑 같으면 (센서 잡음 때문에 진짜 프레임끼리는 안 같음)
+ */
+
+#ifndef S730B_INTEGRITY_H
+#define S730B_INTEGRITY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "s730b_proto.h"
+
+#define INTEGRITY_HISTORY 4
+
+// s730b_frame_desc.flags (0 = 온전)
+#define FRAME_TRUNCATED     0x1     // chunk 덜 옴 / 길이 모자람
+#define FRAME_SHORT_CHUNK   0x2     // 256B 안 된 chunk (뒤 데이터 밀림)
+#define FRAME_NO_IMAGE      0x4     // 이미지 부분 (IMG_OFFSET + IMG_SIZE)까지도 안 옴
+#define FRAME_DUPLICATE     0x8     // 최근 프레임이랑 이미지 CRC 같음
+
+struct s730b_frame_desc {
+    int len;
+    int chunks_expected, chunks_received, short_chunks;
+    uint32_t crc;               // 이미지 부분 CRC32C (FRAME_NO_IMAGE면 0)
+    uint32_t flags;
+    int dup_age;                // FRAME_DUPLICATE면 몇 프레임 전이랑 같은지 (1 = 바로 앞)
+};
+
+// 세션 하나 (장치 열려 있는 동안) 최근 프레임 CRC
+struct s730b_integrity {
+    uint32_t recent[INTEGRITY_HISTORY];
+    int n, pos;
+    uint64_t frames, rejected, duplicates;
+};
+
+/* CRC32C (Castagnoli), crc = 앞 결과 이어서 (처음은 0) */
+uint32_t s730b_crc32c(uint32_t crc, const void *data, size_t len);
+
+/* 1 = SSE4.2 crc32 명령 씀 */
+int s730b_crc32c_hw(void);
+
+/* 표 버전 (벤치 비교용) */
+uint32_t s730b_crc32c_sw(uint32_t crc, const void *data, size_t len);
+
+void s730b_integrity_init(struct s730b_integrity *ig);
+
+/*
+ * 캡처 한 번 (PROTO_PROBE 없이 S730B_NUM_PACKETS) 검사해서 d 채움, 리턴 = d->flags
+ * - st = s730b_proto_capture(_recover) 통계 (NULL이면 길이로만)
+ * - 온전한 프레임만 CRC를 최근 목록에 넣음 (중복 / 망가진 건 안 넣음, 같은 게 계속 오면 계속 중복)
+ */
+uint32_t s730b_frame_check(struct s730b_integrity *ig, const unsigned char *buf, int len,
+                           const struct s730b_proto_stats *st, struct s730b_frame_desc *d);
+
+/* flags 한 줄 ("truncated,short_chunk" 등, 0이면 "ok") */
+const char *s730b_frame_flags_str(uint32_t flags, char *out, size_t cap);
+
+#endif
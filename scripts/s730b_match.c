@@ -0,0 +1,295 @@
+/*
+ * s730b_match.c
+ *
+ * - 템플릿 만들 때 쌍 표 (거리 + 양 끝 상대각) 거리순 정렬, 매칭은 두 표를 거리 창으로 같이 훑음
+ * - 쌍 회전 차이 히스토그램으로 회전 하나 고르고 그 회전에 맞는 쌍만 셈, threshold 못 넘을 게 보이면 바로 끝
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "s730b_frame.h"
+#include "s730b_match.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MATCH_DIST_TOL   8      // 쌍 거리 허용오차 (Q2, 2px) + 거리/16
+#define MATCH_BETA_TOL   14     // 상대각 허용오차 (0..255 단위, 약 20도)
+#define MATCH_ROT_BINS   32     // 전체 회전 히스토그램 칸 수 (칸당 8 = 11.25도)
+#define MATCH_MAX_EDGES  2048   // 호환되는 쌍 후보 최대 개수
+#define MATCH_MAX_WINDOWS 4     // 점수 계산해볼 회전 후보 최대 개수
+
+#define MATCH_DMAX_Q2    (MATCH_MAX_DIST * 4)
+
+// 호환되는 쌍 하나 = probe (p0, p1) <-> gallery (g0, g1) 대응 + 그때 회전량
+struct match_edge {
+    uint8_t p0, p1, g0, g1;
+    uint8_t rot;
+};
+
+static inline int adiff_u8(int a, int b) {
+    int d = (int8_t)(uint8_t)(a - b);
+    return d < 0 ? -d : d;
+}
+
+static inline uint8_t angle_u8(double dx, double dy) {
+    double a = atan2(dy, dx);
+    if (a < 0)
+        a += 2.0 * M_PI;
+    return (uint8_t)((int)lrint(a * 256.0 / (2.0 * M_PI)) & 255);
+}
+
+static inline int pair_dist_q2(const struct s730b_template *t, int i, int j) {
+    int dx = t->x[j] - t->x[i], dy = t->y[j] - t->y[i];
+    return (int)lrintf(sqrtf((float)(dx * dx + dy * dy)));
+}
+
+/*
+ * pair table은 거리 오름차순이어야 매칭에서 한 번만 훑으면 됨
+ * - 거리가 작은 정수(Q2, MATCH_DMAX_Q2 이하)라서 qsort 대신 counting sort
+ * - 자리 넘치면 먼 쌍부터 버려짐
+ */
+void s730b_template_finish(struct s730b_template *t) {
+    uint16_t start[MATCH_DMAX_Q2 + 2];
+
+    // 1) 거리별 개수
+    memset(start, 0, sizeof(start));
+    for (int i = 0; i < t->count; i++) {
+        for (int j = i + 1; j < t->count; j++) {
+            int d = pair_dist_q2(t, i, j);
+            if (d <= MATCH_DMAX_Q2)
+                start[d + 1]++;
+        }
+    }
+    for (int d = 0; d <= MATCH_DMAX_Q2; d++) {
+        int s = start[d] + start[d + 1];
+        start[d + 1] = (uint16_t)(s > MATCH_MAX_PAIRS ? MATCH_MAX_PAIRS : s);
+    }
+    t->npairs = start[MATCH_DMAX_Q2 + 1];
+
+    // 2) 제자리에 넣기
+    for (int i = 0; i < t->count; i++) {
+        for (int j = i + 1; j < t->count; j++) {
+            int d = pair_dist_q2(t, i, j);
+            if (d > MATCH_DMAX_Q2 || start[d] >= MATCH_MAX_PAIRS)
+                continue;
+
+            int k = start[d]++;
+            uint8_t phi = angle_u8(t->x[j] - t->x[i], t->y[j] - t->y[i]);
+            t->d[k] = (uint16_t)d;
+            t->phi[k] = phi;
+            t->b1[k] = (uint8_t)(t->angle[i] - phi);
+            t->b2[k] = (uint8_t)(t->angle[j] - phi);
+            t->pi[k] = (uint8_t)i;
+            t->pj[k] = (uint8_t)j;
+        }
+    }
+}
+
+void s730b_template_build(const struct s730b_minutiae *m, struct s730b_template *t) {
+    const int w = m->width > 0 ? m->width : IMG_WIDTH;
+
+    memset(t, 0, sizeof(*t));
+    t->count = m->count > MINU_MAX ? MINU_MAX : m->count;
+    for (int i = 0; i < t->count; i++) {
+        t->x[i] = (int16_t)(m->x[i] * 4 * IMG_WIDTH / w);
+        t->y[i] = (int16_t)(m->y[i] * 4 * IMG_WIDTH / w);
+        t->angle[i] = m->angle[i];
+        t->type[i] = m->type[i];
+    }
+    s730b_template_finish(t);
+}
+
+static inline int rot_bin(uint8_t rot) {
+    return ((rot + 4) >> 3) & (MATCH_ROT_BINS - 1);
+}
+
+/*
+ * 회전 후보 하나(bin 기준 +-1칸)에 대해 1:1 대응 + 거리 일관성 맞는 쌍만 셈
+ * - 첫 대응을 기준점(anchor)으로 잡고, 새로 대응되는 특징점은 anchor까지 거리가
+ *   probe/gallery 양쪽에서 비슷해야 받아줌 (평행이동 없이 모양만 봄)
+ */
+static int window_score(const struct s730b_template *P, const struct s730b_template *G,
+                        const struct match_edge *edges, int nedges, int bin, int threshold,
+                        uint8_t *pmap_out) {
+    uint8_t pmap[MINU_MAX], gmap[MINU_MAX];
+    int ap = -1, ag = -1, score = 0;
+
+    memset(pmap, 0xff, sizeof(pmap));
+    memset(gmap, 0xff, sizeof(gmap));
+
+    for (int e = 0; e < nedges; e++) {
+        const struct match_edge *E = &edges[e];
+        int db = (rot_bin(E->rot) - bin) & (MATCH_ROT_BINS - 1);
+        if (db > 1 && db < MATCH_ROT_BINS - 1)
+            continue;
+
+        const int pp[2] = { E->p0, E->p1 }, gg[2] = { E->g0, E->g1 };
+        int ok = 1;
+        for (int k = 0; k < 2 && ok; k++) {
+            int p = pp[k], g = gg[k];
+            if (pmap[p] == g)
+                continue;
+            if (pmap[p] != 0xff || gmap[g] != 0xff) {
+                ok = 0;
+                break;
+            }
+            if (ap >= 0 && p != ap) {
+                int dp = pair_dist_q2(P, ap, p), dg = pair_dist_q2(G, ag, g);
+                int tol = MATCH_DIST_TOL + (dp >> 4);
+                ok = dp - dg <= tol && dg - dp <= tol;
+            }
+        }
+        if (!ok)
+            continue;
+
+        for (int k = 0; k < 2; k++) {
+            pmap[pp[k]] = (uint8_t)gg[k];
+            gmap[gg[k]] = (uint8_t)pp[k];
+        }
+        if (ap < 0) {
+            ap = E->p0;
+            ag = E->g0;
+        }
+        if (++score >= threshold && threshold > 0)
+            break;
+    }
+    if (pmap_out)
+        memcpy(pmap_out, pmap, sizeof(pmap));
+    return score;
+}
+
+/* pmap != NULL이면 최고점 회전 후보의 probe -> gallery 대응표도 (0xff = 대응 없음) */
+static int match_core(const struct s730b_template *P, const struct s730b_template *G, int threshold,
+                      uint8_t *pmap) {
+    struct match_edge edges[MATCH_MAX_EDGES];
+    uint8_t cur[MINU_MAX];
+    int hist[MATCH_ROT_BINS] = {0};
+    int nedges = 0;
+
+    if (pmap)
+        memset(pmap, 0xff, MINU_MAX);
+    if (P->npairs == 0 || G->npairs == 0)
+        return 0;
+
+    /*
+     * 1) 두 pair table을 거리순으로 같이 훑으면서 호환되는 쌍 모으기
+     * - gallery 쪽은 [dp - tol, dp + tol] 구간만 봄 (lo는 계속 앞으로만 감)
+     * - gallery 쌍이 반대 방향(j->i)으로 저장돼 있을 수도 있어서 뒤집은 경우도 확인
+     */
+    int lo = 0;
+    for (int a = 0; a < P->npairs && nedges < MATCH_MAX_EDGES; a++) {
+        const int dp = P->d[a];
+        const int tol = MATCH_DIST_TOL + (dp >> 4);
+        const uint8_t pb1 = P->b1[a], pb2 = P->b2[a];
+
+        while (lo < G->npairs && G->d[lo] < dp - tol)
+            lo++;
+
+        for (int k = lo; k < G->npairs && G->d[k] <= dp + tol; k++) {
+            struct match_edge *E = &edges[nedges];
+
+            if (adiff_u8(pb1, G->b1[k]) <= MATCH_BETA_TOL && adiff_u8(pb2, G->b2[k]) <= MATCH_BETA_TOL) {
+                E->g0 = G->pi[k];
+                E->g1 = G->pj[k];
+                E->rot = (uint8_t)(G->phi[k] - P->phi[a]);
+            } else if (adiff_u8(pb1, G->b2[k] - 128) <= MATCH_BETA_TOL &&
+                       adiff_u8(pb2, G->b1[k] - 128) <= MATCH_BETA_TOL) {
+                E->g0 = G->pj[k];
+                E->g1 = G->pi[k];
+                E->rot = (uint8_t)(G->phi[k] + 128 - P->phi[a]);
+            } else {
+                continue;
+            }
+            E->p0 = P->pi[a];
+            E->p1 = P->pj[a];
+            hist[rot_bin(E->rot)]++;
+            if (++nedges >= MATCH_MAX_EDGES)
+                break;
+        }
+    }
+
+    /*
+     * 2) 회전 후보(이웃 3칸 합)가 큰 순서대로 점수 계산
+     * - 후보의 쌍 개수가 지금까지 최고점 이하면 더 볼 필요 없음
+     * - threshold 주면 넘는 순간 / 못 넘는 게 확실한 순간 바로 끝
+     */
+    int win[MATCH_ROT_BINS];
+    for (int b = 0; b < MATCH_ROT_BINS; b++)
+        win[b] = hist[(b - 1) & (MATCH_ROT_BINS - 1)] + hist[b] + hist[(b + 1) & (MATCH_ROT_BINS - 1)];
+
+    int best = 0;
+    for (int tries = 0; tries < MATCH_MAX_WINDOWS; tries++) {
+        int b = 0;
+        for (int k = 1; k < MATCH_ROT_BINS; k++)
+            if (win[k] > win[b])
+                b = k;
+        if (win[b] <= best || (threshold > 0 && win[b] < threshold))
+            break;
+        win[b] = -1;
+
+        int s = window_score(P, G, edges, nedges, b, threshold, pmap ? cur : NULL);
+        if (s > best) {
+            best = s;
+            if (pmap)
+                memcpy(pmap, cur, MINU_MAX);
+        }
+        if (threshold > 0 && best >= threshold)
+            break;
+    }
+    return best;
+}
+
+int s730b_match(const struct s730b_template *P, const struct s730b_template *G, int threshold) {
+    return match_core(P, G, threshold, NULL);
+}
+
+/*
+ * 대응된 특징점들로 강체 변환(회전 + 평행이동) 최소제곱 추정
+ * - 중심 빼고 나서 theta = atan2(sum(p x g), sum(p . g))
+ */
+int s730b_match_align(const struct s730b_template *P, const struct s730b_template *G, struct s730b_align *a) {
+    uint8_t pmap[MINU_MAX];
+    double cpx = 0, cpy = 0, cgx = 0, cgy = 0;
+    int n = 0;
+
+    memset(a, 0, sizeof(*a));
+    a->cos = 1.0f;
+    a->score = match_core(P, G, 0, pmap);
+
+    for (int i = 0; i < P->count; i++) {
+        if (pmap[i] == 0xff)
+            continue;
+        cpx += P->x[i];
+        cpy += P->y[i];
+        cgx += G->x[pmap[i]];
+        cgy += G->y[pmap[i]];
+        n++;
+    }
+    a->matched = n;
+    if (n < 2)
+        return a->score;
+    cpx /= n;
+    cpy /= n;
+    cgx /= n;
+    cgy /= n;
+
+    double sxx = 0, sxy = 0;
+    for (int i = 0; i < P->count; i++) {
+        if (pmap[i] == 0xff)
+            continue;
+        double px = P->x[i] - cpx, py = P->y[i] - cpy;
+        double gx = G->x[pmap[i]] - cgx, gy = G->y[pmap[i]] - cgy;
+        sxx += px * gx + py * gy;
+        sxy += px * gy - py * gx;
+    }
+    double th = atan2(sxy, sxx);
+    a->cos = (float)cos(th);
+    a->sin = (float)sin(th);
+    a->rot = (uint8_t)((int)lrint(th * 128.0 / M_PI) & 255);
+    a->tx = (float)(cgx - (a->cos * cpx - a->sin * cpy));
+    a->ty = (float)(cgy - (a->sin * cpx + a->cos * cpy));
+    return a->score;
+}
@@ -0,0 +1,70 @@
+/*
+ * s730b_match.h
+ *
+ * - s730b_minutiae 결과로 만든 템플릿끼리 1:1 점수 매기는 매처 (bozorth3 비슷한 pair table 방식)
+ * - 템플릿 만들 때 특징점 쌍(pair)마다 회전 불변 값(거리, 양 끝 상대각)을 계산해서
+ *   거리순 정렬된 SoA 배열로 들고 있음 -> 매칭은 두 배열을 거리 기준으로 같이 훑기만 하면 됨
+ * - 좌표/거리는 112x96 기준으로 정규화해서 224x192 (burst 합성) 템플릿이랑도 비교 가능
+ */
+
+#ifndef S730B_MATCH_H
+#define S730B_MATCH_H
+
+#include <stdint.h>
+
+#include "s730b_minutiae.h"
+
+#define MATCH_MAX_PAIRS   1024
+#define MATCH_MAX_DIST    80        // 이보다 먼 쌍은 안 씀 (112x96 기준 px, 피부 늘어남 오차 커짐)
+#define MATCH_MIN_MINUTIAE 4        // 이보다 적으면 등록/매칭 거부 (점수가 의미 없음)
+#define MATCH_THRESHOLD   6         // 이 점수 이상이면 같은 손가락 (bench match로 정한 값)
+
+/*
+ * 특징점 좌표/방향 + pair table
+ * - x, y: 112x96 기준 px x4 (Q2)
+ * - pair: d (Q2) 오름차순, phi = i->j 직선 방향, b1/b2 = 각 끝 특징점 방향 - phi
+ */
+struct s730b_template {
+    int count;
+    int npairs;
+    int16_t x[MINU_MAX];
+    int16_t y[MINU_MAX];
+    uint8_t angle[MINU_MAX];
+    uint8_t type[MINU_MAX];
+
+    uint16_t d[MATCH_MAX_PAIRS];
+    uint8_t phi[MATCH_MAX_PAIRS];
+    uint8_t b1[MATCH_MAX_PAIRS];
+    uint8_t b2[MATCH_MAX_PAIRS];
+    uint8_t pi[MATCH_MAX_PAIRS];
+    uint8_t pj[MATCH_MAX_PAIRS];
+};
+
+/* 특징점 -> 템플릿 (쌍이 MATCH_MAX_PAIRS 넘으면 가까운 것부터 채움) */
+void s730b_template_build(const struct s730b_minutiae *m, struct s730b_template *t);
+
+/* count/x/y/angle/type 직접 채운 템플릿의 pair table만 다시 만들기 (합성 템플릿용) */
+void s730b_template_finish(struct s730b_template *t);
+
+/* probe 좌표를 gallery 좌표로: g = R(rot) * p + (tx, ty), Q2 단위 */
+struct s730b_align {
+    int score;                  // s730b_match(probe, gallery, 0)이랑 같은 값
+    int matched;                // 대응된 특징점 수
+    uint8_t rot;                // 0..255 = 0..2pi
+    float cos, sin;
+    float tx, ty;
+};
+
+/*
+ * 두 템플릿 점수 (회전/평행이동 일관된 쌍 개수, 클수록 같은 손가락)
+ * - threshold > 0: 점수가 threshold 넘는 게 확인되면 바로 리턴 (verify용, 리턴값은 threshold 이상)
+ *                  threshold 못 넘는 게 확실해도 바로 리턴
+ * - threshold = 0: 끝까지 다 보고 정확한 점수 (벤치/ROC용)
+ */
+int s730b_match(const struct s730b_template *probe, const struct s730b_template *gallery, int threshold);
+
+/* 점수 + 대응된 특징점으로 최소제곱 정합 (대응 2개 미만이면 항등 변환) */
+int s730b_match_align(const struct s730b_template *probe, const struct s730b_template *gallery,
+                      struct s730b_align *align);
+
+#endif
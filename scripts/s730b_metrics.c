@@ -0,0 +1,270 @@
+/*
+ * s730b_metrics.c
+ *
+ * - slot 등록 / 합치기 / 내보내기, 카운터 이름 표
+ * - 이름은 Prometheus 규칙대로 (s730b_ 앞에, 카운터 _total, 시간 _seconds)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "s730b_metrics.h"
+
+static struct s730b_metrics_slot slots[METRICS_MAX_THREADS];
+static int nslots;
+
+__thread struct s730b_metrics_slot *s730b_metrics_tls;
+struct s730b_metrics_slot *const s730b_metrics_shared = &slots[METRICS_MAX_THREADS - 1];
+
+#define TIME_BOUNDS { 1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 10000000 }
+
+const uint64_t s730b_metrics_bounds[MH_COUNT][METRICS_BUCKETS - 1] = {
+    [MH_INIT_US]          = TIME_BOUNDS,
+    [MH_DETECT_US]        = TIME_BOUNDS,
+    [MH_CAPTURE_US]       = TIME_BOUNDS,
+    [MH_WAIT_TO_FRAME_US] = TIME_BOUNDS,
+    [MH_QUALITY]          = { 0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100 },
+};
+
+struct metric_desc {
+    const char *name;
+    const char *labels;         // NULL = 없음
+    const char *help;           // family 첫 항목에만
+};
+
+static const struct metric_desc counters[MC_COUNT] = {
+    [MC_INIT]               = { "s730b_init_total", NULL, "센서 init (0xC3 + init 명령) 횟수" },
+    [MC_INIT_FAIL]          = { "s730b_init_failures_total", NULL, "복구해도 실패한 init" },
+    [MC_DETECT_PROBE]       = { "s730b_detect_probes_total", NULL, "손가락 감지 probe" },
+    [MC_DETECT_FINGER]      = { "s730b_detect_decisions_total", "decision=\"finger\"", "probe 판정 결과" },
+    [MC_DETECT_EMPTY]       = { "s730b_detect_decisions_total", "decision=\"empty\"", NULL },
+    [MC_DETECT_GRAZE]       = { "s730b_detect_decisions_total", "decision=\"graze\"", NULL },
+    [MC_DETECT_ERROR]       = { "s730b_detect_decisions_total", "decision=\"error\"", NULL },
+    [MC_CAPTURE]            = { "s730b_captures_total", NULL, "프레임 캡처 요청" },
+    [MC_CAPTURE_FAIL]       = { "s730b_capture_failures_total", NULL, "복구해도 못 받은 캡처" },
+    [MC_CAPTURE_INCOMPLETE] = { "s730b_capture_incomplete_total", NULL, "chunk 덜 받은 프레임" },
+    [MC_CAPTURE_BYTES]      = { "s730b_capture_bytes_total", NULL, "캡처로 받은 raw 바이트" },
+    [MC_CHUNK_SHORT]        = { "s730b_short_chunks_total", NULL, "256B 안 된 데이터 chunk" },
+    [MC_RECOVER_RETRY]      = { "s730b_recover_actions_total", "action=\"retry\"", "init / 캡처 복구로 한 일" },
+    [MC_RECOVER_REINIT]     = { "s730b_recover_actions_total", "action=\"reinit\"", NULL },
+    [MC_RECOVER_CLEAR_HALT] = { "s730b_recover_actions_total", "action=\"clear_halt\"", NULL },
+    [MC_RECOVER_REOPEN]     = { "s730b_recover_actions_total", "action=\"reopen\"", NULL },
+    [MC_RECAPTURE_QUALITY]  = { "s730b_recaptures_total", NULL, "품질 미달로 다시 찍은 프레임" },
+    [MC_XFER_CTRL]          = { "s730b_usb_transfers_total", "endpoint=\"control\"", "USB transfer" },
+    [MC_XFER_OUT]           = { "s730b_usb_transfers_total", "endpoint=\"bulk_out\"", NULL },
+    [MC_XFER_IN]            = { "s730b_usb_transfers_total", "endpoint=\"bulk_in\"", NULL },
+    [MC_BYTES_CTRL]         = { "s730b_usb_bytes_total", "endpoint=\"control\"", "USB transfer 바이트 (성공한 것)" },
+    [MC_BYTES_OUT]          = { "s730b_usb_bytes_total", "endpoint=\"bulk_out\"", NULL },
+    [MC_BYTES_IN]           = { "s730b_usb_bytes_total", "endpoint=\"bulk_in\"", NULL },
+    [MC_ERR_CTRL_TIMEOUT]   = { "s730b_usb_errors_total", "endpoint=\"control\",error=\"timeout\"", "USB transfer 실패" },
+    [MC_ERR_CTRL_STALL]     = { "s730b_usb_errors_total", "endpoint=\"control\",error=\"stall\"", NULL },
+    [MC_ERR_CTRL_NODEV]     = { "s730b_usb_errors_total", "endpoint=\"control\",error=\"no_device\"", NULL },
+    [MC_ERR_CTRL_OTHER]     = { "s730b_usb_errors_total", "endpoint=\"control\",error=\"other\"", NULL },
+    [MC_ERR_OUT_TIMEOUT]    = { "s730b_usb_errors_total", "endpoint=\"bulk_out\",error=\"timeout\"", NULL },
+    [MC_ERR_OUT_STALL]      = { "s730b_usb_errors_total", "endpoint=\"bulk_out\",error=\"stall\"", NULL },
+    [MC_ERR_OUT_NODEV]      = { "s730b_usb_errors_total", "endpoint=\"bulk_out\",error=\"no_device\"", NULL },
+    [MC_ERR_OUT_OTHER]      = { "s730b_usb_errors_total", "endpoint=\"bulk_out\",error=\"other\"", NULL },
+    [MC_ERR_IN_TIMEOUT]     = { "s730b_usb_errors_total", "endpoint=\"bulk_in\",error=\"timeout\"", NULL },
+    [MC_ERR_IN_STALL]       = { "s730b_usb_errors_total", "endpoint=\"bulk_in\",error=\"stall\"", NULL },
+    [MC_ERR_IN_NODEV]       = { "s730b_usb_errors_total", "endpoint=\"bulk_in\",error=\"no_device\"", NULL },
+    [MC_ERR_IN_OTHER]       = { "s730b_usb_errors_total", "endpoint=\"bulk_in\",error=\"other\"", NULL },
+    [MC_FRAME_TRUNCATED]    = { "s730b_frame_rejects_total", "reason=\"truncated\"", "검사에서 버린 프레임" },
+    [MC_FRAME_SHORT_CHUNK]  = { "s730b_frame_rejects_total", "reason=\"short_chunk\"", NULL },
+    [MC_FRAME_DUPLICATE]    = { "s730b_frame_rejects_total", "reason=\"duplicate\"", NULL },
+};
+
+struct hist_desc {
+    const char *name;
+    const char *help;
+    double scale;               // 내보낼 때 곱함 (us -> 초)
+};
+
+static const struct hist_desc hists[MH_COUNT] = {
+    [MH_INIT_US]          = { "s730b_init_duration_seconds", "init 걸린 시간 (복구 포함)", 1e-6 },
+    [MH_DETECT_US]        = { "s730b_detect_probe_duration_seconds", "감지 probe 하나 (전송 + 판정)", 1e-6 },
+    [MH_CAPTURE_US]       = { "s730b_capture_duration_seconds", "캡처 전송 (복구 포함)", 1e-6 },
+    [MH_WAIT_TO_FRAME_US] = { "s730b_wait_to_frame_seconds", "손가락 기다리기 시작 ~ 쓸 프레임", 1e-6 },
+    [MH_QUALITY]          = { "s730b_frame_quality", "프레임 품질 점수 (0~100)", 1 },
+};
+
+struct s730b_metrics_slot *s730b_metrics_slot_get(void) {
+    int i = __atomic_fetch_add(&nslots, 1, __ATOMIC_RELAXED);
+    s730b_metrics_tls = i < METRICS_MAX_THREADS - 1 ? &slots[i] : s730b_metrics_shared;
+    return s730b_metrics_tls;
+}
+
+void s730b_metrics_read(struct s730b_metrics_snapshot *out) {
+    int n = __atomic_load_n(&nslots, __ATOMIC_RELAXED);
+
+    memset(out, 0, sizeof(*out));
+    out->threads = n;
+    // 공유 slot은 항상 (안 쓰였으면 0)
+    for (int s = 0; s < METRICS_MAX_THREADS; s++) {
+        if (s >= n && s != METRICS_MAX_THREADS - 1)
+            continue;
+        const struct s730b_metrics_slot *p = &slots[s];
+        for (int i = 0; i < MC_COUNT; i++)
+            out->c[i] += __atomic_load_n(&p->c[i], __ATOMIC_RELAXED);
+        for (int h = 0; h < MH_COUNT; h++) {
+            for (int b = 0; b < METRICS_BUCKETS; b++)
+                out->h[h][b] += __atomic_load_n(&p->h[h][b], __ATOMIC_RELAXED);
+            out->hsum[h] += __atomic_load_n(&p->hsum[h], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void s730b_metrics_reset(void) {
+    memset(slots, 0, sizeof(slots));
+}
+
+int s730b_metrics_write_prom(FILE *f, const struct s730b_metrics_snapshot *m) {
+    for (int i = 0; i < MC_COUNT; i++) {
+        const struct metric_desc *d = &counters[i];
+        if (d->help)
+            fprintf(f, "# HELP %s %s\n# TYPE %s counter\n", d->name, d->help, d->name);
+        if (d->labels)
+            fprintf(f, "%s{%s} %llu\n", d->name, d->labels, (unsigned long long)m->c[i]);
+        else
+            fprintf(f, "%s %llu\n", d->name, (unsigned long long)m->c[i]);
+    }
+    for (int h = 0; h < MH_COUNT; h++) {
+        const struct hist_desc *d = &hists[h];
+        uint64_t cum = 0;
+        fprintf(f, "# HELP %s %s\n# TYPE %s histogram\n", d->name, d->help, d->name);
+        for (int b = 0; b < METRICS_BUCKETS; b++) {
+            cum += m->h[h][b];
+            if (b < METRICS_BUCKETS - 1)
+                fprintf(f, "%s_bucket{le=\"%g\"} %llu\n", d->name, s730b_metrics_bounds[h][b] * d->scale,
+                        (unsigned long long)cum);
+            else
+                fprintf(f, "%s_bucket{le=\"+Inf\"} %llu\n", d->name, (unsigned long long)cum);
+        }
+        fprintf(f, "%s_sum %g\n%s_count %llu\n", d->name, m->hsum[h] * d->scale, d->name, (unsigned long long)cum);
+    }
+    return ferror(f) ? -1 : 0;
+}
+
+// label 문자열 key="v",... -> JSON "key":"v",...
+static void json_labels(FILE *f, const char *labels) {
+    for (const char *p = labels; *p; p++) {
+        if (p == labels || p[-1] == ',')
+            fputc('"', f);
+        if (*p == '=')
+            fputs("\":", f);
+        else
+            fputc(*p, f);
+    }
+}
+
+int s730b_metrics_write_json(FILE *f, const struct s730b_metrics_snapshot *m) {
+    fprintf(f, "{\"threads\":%d,\"counters\":[", m->threads);
+    for (int i = 0; i < MC_COUNT; i++) {
+        fprintf(f, "%s\n{\"name\":\"%s\",\"labels\":{", i ? "," : "", counters[i].name);
+        if (counters[i].labels)
+            json_labels(f, counters[i].labels);
+        fprintf(f, "},\"value\":%llu}", (unsigned long long)m->c[i]);
+    }
+    fputs("],\"histograms\":[", f);
+    for (int h = 0; h < MH_COUNT; h++) {
+        const struct hist_desc *d = &hists[h];
+        uint64_t count = 0;
+        fprintf(f, "%s\n{\"name\":\"%s\",\"le\":[", h ? "," : "", d->name);
+        for (int b = 0; b < METRICS_BUCKETS - 1; b++)
+            fprintf(f, "%s%g", b ? "," : "", s730b_metrics_bounds[h][b] * d->scale);
+        fputs("],\"buckets\":[", f);
+        for (int b = 0; b < METRICS_BUCKETS; b++) {
+            fprintf(f, "%s%llu", b ? "," : "", (unsigned long long)m->h[h][b]);
+            count += m->h[h][b];
+        }
+        fprintf(f, "],\"sum\":%g,\"count\":%llu}", m->hsum[h] * d->scale, (unsigned long long)count);
+    }
+    fputs("]}\n", f);
+    return ferror(f) ? -1 : 0;
+}
+
+int s730b_metrics_export(const char *path) {
+    struct s730b_metrics_snapshot m;
+    size_t n = strlen(path);
+    char *tmp = malloc(n + 5);
+    if (!tmp)
+        return -1;
+    memcpy(tmp, path, n);
+    memcpy(tmp + n, ".tmp", 5);
+
+    s730b_metrics_read(&m);
+    FILE *f = fopen(tmp, "w");
+    if (!f) {
+        free(tmp);
+        return -1;
+    }
+    int json = n >= 5 && strcmp(path + n - 5, ".json") == 0;
+    int r = json ? s730b_metrics_write_json(f, &m) : s730b_metrics_write_prom(f, &m);
+    if (fclose(f) != 0)
+        r = -1;
+    // textfile collector가 반쯤 쓴 파일 안 읽게
+    if (r == 0 && rename(tmp, path) != 0)
+        r = -1;
+    if (r < 0)
+        remove(tmp);
+    free(tmp);
+    return r;
+}
+
+/* ---------------- transport 감싸기 ---------------- */
+
+// 오류 코드 -> MC_ERR_*_TIMEOUT 기준 offset
+static int err_kind(int r) {
+    return r == S730B_ETIMEDOUT ? 0 : r == S730B_EPIPE ? 1 : r == S730B_ENODEV ? 2 : 3;
+}
+
+static int tap_control(void *ctx, uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+                       unsigned char *data, uint16_t len, unsigned timeout_ms) {
+    struct s730b_transport *in = ((struct s730b_metrics_tap *)ctx)->inner;
+    int r = in->control(in->ctx, request_type, request, value, index, data, len, timeout_ms);
+    struct s730b_metrics_slot *s = s730b_metrics_slot();
+    s730b_metrics_bump(&s->c[MC_XFER_CTRL], 1, s);
+    if (r < 0)
+        s730b_metrics_bump(&s->c[MC_ERR_CTRL_TIMEOUT + err_kind(r)], 1, s);
+    else
+        s730b_metrics_bump(&s->c[MC_BYTES_CTRL], (uint64_t)r, s);
+    return r;
+}
+
+static int tap_bulk(void *ctx, unsigned char ep, unsigned char *data, int len, int *transferred,
+                    unsigned timeout_ms) {
+    struct s730b_transport *in = ((struct s730b_metrics_tap *)ctx)->inner;
+    int r = in->bulk(in->ctx, ep, data, len, transferred, timeout_ms);
+    struct s730b_metrics_slot *s = s730b_metrics_slot();
+    int is_in = ep & 0x80;
+    s730b_metrics_bump(&s->c[is_in ? MC_XFER_IN : MC_XFER_OUT], 1, s);
+    s730b_metrics_bump(&s->c[is_in ? MC_BYTES_IN : MC_BYTES_OUT], (uint64_t)*transferred, s);
+    if (r < 0)
+        s730b_metrics_bump(&s->c[(is_in ? MC_ERR_IN_TIMEOUT : MC_ERR_OUT_TIMEOUT) + err_kind(r)], 1, s);
+    return r;
+}
+
+static int tap_clear_halt(void *ctx, unsigned char ep) {
+    struct s730b_transport *in = ((struct s730b_metrics_tap *)ctx)->inner;
+    return in->clear_halt ? in->clear_halt(in->ctx, ep) : 0;
+}
+
+static int tap_reopen(void *ctx) {
+    struct s730b_transport *in = ((struct s730b_metrics_tap *)ctx)->inner;
+    return in->reopen ? in->reopen(in->ctx) : S730B_ENODEV;
+}
+
+static uint64_t tap_now(void *ctx) {
+    return s730b_transport_now(((struct s730b_metrics_tap *)ctx)->inner);
+}
+
+void s730b_metrics_transport(struct s730b_metrics_tap *tap, struct s730b_transport *inner,
+                             struct s730b_transport *out) {
+    tap->inner = inner;
+    memset(out, 0, sizeof(*out));
+    out->ctx = tap;
+    out->control = tap_control;
+    out->bulk = tap_bulk;
+    out->clear_halt = inner->clear_halt ? tap_clear_halt : NULL;
+    out->reopen = inner->reopen ? tap_reopen : NULL;
+    out->now_ns = inner->now_ns ? tap_now : NULL;
+}
@@ -0,0 +1,151 @@
+/*
+ * s730b_metrics.h
+ *
+ * - 센서 경로 단계별 카운터 / 히스토그램 (init, 감지 probe, 캡처, chunk 재시도, endpoint별 오류, 품질, 대기 ~ 프레임)
+ * - 스레드마다 자기 slot에만 씀 (lock / atomic RMW 없음, relaxed store), 읽을 때 slot 전부 더함
+ *   - slot은 처음 쓸 때 잡음 (METRICS_MAX_THREADS 넘으면 마지막 slot 같이 씀 -> 거기만 atomic add)
+ * - 내보내기: Prometheus textfile (node_exporter textfile collector) 또는 JSON, 파일은 tmp에 쓰고 rename
+ * - USB transfer / endpoint별 오류는 s730b_metrics_transport (transport 감싸서 셈)
+ */
+
+#ifndef S730B_METRICS_H
+#define S730B_METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "s730b_transport.h"
+
+#define METRICS_MAX_THREADS 32
+#define METRICS_BUCKETS     12          // 히스토그램 칸 (마지막 = +Inf)
+
+// 카운터 (같은 이름 + label 다른 건 붙어 있어야 함, 이름 / label은 s730b_metrics.c 표)
+enum {
+    MC_INIT,
+    MC_INIT_FAIL,
+    MC_DETECT_PROBE,
+    MC_DETECT_FINGER,           // 판정: 손가락
+    MC_DETECT_EMPTY,            //       없음
+    MC_DETECT_GRAZE,            //       스침 (--texture-detect)
+    MC_DETECT_ERROR,            // probe 전송 실패
+    MC_CAPTURE,
+    MC_CAPTURE_FAIL,
+    MC_CAPTURE_INCOMPLETE,      // chunk 덜 받은 프레임
+    MC_CAPTURE_BYTES,
+    MC_CHUNK_SHORT,
+    MC_RECOVER_RETRY,           // 복구로 다시 한 시도 (s730b_recover.attempts - 1)
+    MC_RECOVER_REINIT,
+    MC_RECOVER_CLEAR_HALT,
+    MC_RECOVER_REOPEN,
+    MC_RECAPTURE_QUALITY,       // 품질 미달로 다시 찍음
+    MC_XFER_CTRL,               // transfer 수 (endpoint별)
+    MC_XFER_OUT,
+    MC_XFER_IN,
+    MC_BYTES_CTRL,
+    MC_BYTES_OUT,
+    MC_BYTES_IN,
+    MC_ERR_CTRL_TIMEOUT,        // 오류 (endpoint x 종류)
+    MC_ERR_CTRL_STALL,
+    MC_ERR_CTRL_NODEV,
+    MC_ERR_CTRL_OTHER,
+    MC_ERR_OUT_TIMEOUT,
+    MC_ERR_OUT_STALL,
+    MC_ERR_OUT_NODEV,
+    MC_ERR_OUT_OTHER,
+    MC_ERR_IN_TIMEOUT,
+    MC_ERR_IN_STALL,
+    MC_ERR_IN_NODEV,
+    MC_ERR_IN_OTHER,
+    MC_FRAME_TRUNCATED,         // 버린 프레임 (s730b_frame_check 이유별)
+    MC_FRAME_SHORT_CHUNK,
+    MC_FRAME_DUPLICATE,
+    MC_COUNT,
+};
+
+// 히스토그램 (시간은 us로 넣음, 내보낼 때 초)
+enum {
+    MH_INIT_US,
+    MH_DETECT_US,               // probe 하나 (전송 + 판정)
+    MH_CAPTURE_US,              // 캡처 전송 (복구 포함)
+    MH_WAIT_TO_FRAME_US,        // 손가락 기다리기 시작 ~ 쓸 프레임 나옴
+    MH_QUALITY,                 // 프레임 품질 점수 0~100
+    MH_COUNT,
+};
+
+struct s730b_metrics_slot {
+    uint64_t c[MC_COUNT];
+    uint64_t h[MH_COUNT][METRICS_BUCKETS];
+    uint64_t hsum[MH_COUNT];
+} __attribute__((aligned(64)));
+
+// 합친 값 (s730b_metrics_read)
+struct s730b_metrics_snapshot {
+    uint64_t c[MC_COUNT];
+    uint64_t h[MH_COUNT][METRICS_BUCKETS];
+    uint64_t hsum[MH_COUNT];
+    int threads;
+};
+
+struct s730b_metrics_slot *s730b_metrics_slot_get(void);
+extern __thread struct s730b_metrics_slot *s730b_metrics_tls;
+extern const uint64_t s730b_metrics_bounds[MH_COUNT][METRICS_BUCKETS - 1];
+
+static inline struct s730b_metrics_slot *s730b_metrics_slot(void) {
+    struct s730b_metrics_slot *s = s730b_metrics_tls;
+    return s ? s : s730b_metrics_slot_get();
+}
+
+// 공유 slot (스레드 너무 많을 때)만 atomic, 나머지는 자기 것만 씀
+extern struct s730b_metrics_slot *const s730b_metrics_shared;
+
+static inline void s730b_metrics_bump(uint64_t *p, uint64_t v, struct s730b_metrics_slot *s) {
+    if (__builtin_expect(s == s730b_metrics_shared, 0))
+        __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+    else
+        __atomic_store_n(p, *p + v, __ATOMIC_RELAXED);
+}
+
+static inline void s730b_metric_add(int id, uint64_t v) {
+    struct s730b_metrics_slot *s = s730b_metrics_slot();
+    s730b_metrics_bump(&s->c[id], v, s);
+}
+
+static inline void s730b_metric_inc(int id) {
+    s730b_metric_add(id, 1);
+}
+
+static inline void s730b_metric_observe(int id, uint64_t v) {
+    struct s730b_metrics_slot *s = s730b_metrics_slot();
+    const uint64_t *b = s730b_metrics_bounds[id];
+    int i = 0;
+    while (i < METRICS_BUCKETS - 1 && v > b[i])
+        i++;
+    s730b_metrics_bump(&s->h[id][i], 1, s);
+    s730b_metrics_bump(&s->hsum[id], v, s);
+}
+
+/* slot 전부 더해서 */
+void s730b_metrics_read(struct s730b_metrics_snapshot *out);
+
+/* 0으로 (벤치용, 다른 스레드가 쓰는 중이면 안 됨) */
+void s730b_metrics_reset(void);
+
+/* Prometheus text exposition / JSON, 0 = 성공 */
+int s730b_metrics_write_prom(FILE *f, const struct s730b_metrics_snapshot *m);
+int s730b_metrics_write_json(FILE *f, const struct s730b_metrics_snapshot *m);
+
+/* path에 내보냄 (path.tmp에 쓰고 rename), .json으로 끝나면 JSON, 0 = 성공, -1 = 실패 */
+int s730b_metrics_export(const char *path);
+
+/*
+ * inner를 감싸서 transfer 수 / 바이트 / endpoint별 오류 세는 transport (out)
+ * - clear_halt / reopen / now_ns는 inner 그대로 넘김, inner->ctx 바뀌어도 (reopen) 따라감
+ */
+struct s730b_metrics_tap {
+    struct s730b_transport *inner;
+};
+
+void s730b_metrics_transport(struct s730b_metrics_tap *tap, struct s730b_transport *inner,
+                             struct s730b_transport *out);
+
+#endif
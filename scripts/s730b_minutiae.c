@@ -0,0 +1,308 @@
+/*
+ * s730b_minutiae.c
+ *
+ * - 이진화 뒤 Zhang-Suen 세선화 (이웃 8개 코드 -> 지울지 표 하나, 미리 만들어 둠)
+ * - crossing number로 끝점 / 분기점, 방향은 세선 따라가서 0..255 각도
+ */
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "s730b_frame.h"
+#include "s730b_minutiae.h"
+
+#define MINU_BLOCK      8
+#define MINU_MAX_DIM    256
+#define MINU_PAD        (MINU_MAX_DIM + 2)
+#define MINU_TRACE      5       // 방향 잴 때 골격 따라갈 거리 (112x96 기준 px)
+#define MINU_MARGIN     5       // 배경/프레임 끝에서 이만큼은 떨어져 있어야 진짜 특징점으로 봄
+#define MINU_MIN_DIST   5       // 이보다 가까운 특징점 쌍은 끊긴 융선/가시(spur)로 보고 둘 다 버림
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// P2..P9 (북쪽부터 시계방향)
+static const int nb_dx[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const int nb_dy[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+static inline int nb_val(const uint8_t *p, int stride, int i) {
+    return p[nb_dy[i] * stride + nb_dx[i]];
+}
+
+// 0 -> 1 전환 수 (P2..P9, P2 순환)
+static inline int transitions(const uint8_t *p, int stride) {
+    int a = 0;
+    for (int i = 0; i < 8; i++)
+        a += !nb_val(p, stride, i) && nb_val(p, stride, (i + 1) & 7);
+    return a;
+}
+
+// 이웃 8개를 bit i = P(i+2)로 묶은 코드 (img 값은 0/1)
+static inline int nb_code(const uint8_t *p, int stride) {
+    const uint8_t *u = p - stride, *d = p + stride;
+    return u[0] | u[1] << 1 | p[1] << 2 | d[1] << 3 | d[0] << 4 | d[-1] << 5 | p[-1] << 6 | u[-1] << 7;
+}
+
+/*
+ * Zhang-Suen 삭제 조건을 이웃 코드 256개에 대해 미리 계산
+ * - bit0: 1단계에서 삭제, bit1: 2단계에서 삭제
+ */
+static void build_thin_lut(uint8_t *lut) {
+    for (int c = 0; c < 256; c++) {
+        int v[8], b = 0, a = 0;
+        for (int i = 0; i < 8; i++) {
+            v[i] = (c >> i) & 1;
+            b += v[i];
+        }
+        for (int i = 0; i < 8; i++)
+            a += !v[i] && v[(i + 1) & 7];
+
+        lut[c] = 0;
+        if (b < 2 || b > 6 || a != 1)
+            continue;
+        // v[0]=P2(N) v[2]=P4(E) v[4]=P6(S) v[6]=P8(W)
+        if (!(v[0] && v[2] && v[4]) && !(v[2] && v[4] && v[6]))
+            lut[c] |= 1;
+        if (!(v[0] && v[2] && v[6]) && !(v[0] && v[4] && v[6]))
+            lut[c] |= 2;
+    }
+}
+
+/*
+ * Zhang-Suen 세선화
+ * - img는 테두리 1px이 0인 (w+2)x(h+2) 버퍼, 그자리에서 골격만 남김
+ * - 한 단계 안에서는 원래 값 기준으로 판단해야 하니까 지울 픽셀은 row 단위로 모아뒀다가
+ *   다음 row까지 본 뒤에 지움 (y+1 row 판단엔 y-1 row가 필요 없음)
+ */
+static void thin_zhang_suen(uint8_t *img, int w, int h) {
+    const int stride = w + 2;
+    uint8_t lut[256];
+    uint8_t mark[2][MINU_PAD];
+    int changed;
+
+    build_thin_lut(lut);
+
+    do {
+        changed = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            const uint8_t bit = (uint8_t)(1 << pass);
+
+            for (int y = 1; y <= h + 1; y++) {
+                uint8_t *cur = mark[y & 1], *prev = mark[(y - 1) & 1];
+                uint8_t *row = img + y * stride;
+
+                if (y <= h) {
+                    for (int x = 1; x <= w; x++)
+                        cur[x] = row[x] && (lut[nb_code(row + x, stride)] & bit);
+                }
+
+                // 이전 row 확정
+                if (y > 1) {
+                    uint8_t *up = row - stride;
+                    int any = 0;
+                    for (int x = 1; x <= w; x++) {
+                        up[x] &= (uint8_t)!prev[x];
+                        any |= prev[x];
+                    }
+                    changed |= any;
+                }
+            }
+        }
+    } while (changed);
+}
+
+/*
+ * 골격 따라 steps칸 이동해서 끝 위치 리턴
+ * - (sx, sy)에서 시작, (ox, oy)는 출발점(특징점)이라 되돌아가지 않게 함
+ * - 4-이웃 먼저 봐서 대각선으로 새는 것 줄임
+ */
+static void trace_ridge(const uint8_t *img, int stride, int ox, int oy, int sx, int sy, int steps,
+                        int *ex, int *ey) {
+    static const int order[8] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+    int px = ox, py = oy, cx = sx, cy = sy;
+
+    for (int s = 1; s < steps; s++) {
+        int moved = 0;
+        for (int k = 0; k < 8; k++) {
+            int i = order[k];
+            int nx = cx + nb_dx[i], ny = cy + nb_dy[i];
+            if ((nx == px && ny == py) || (nx == ox && ny == oy))
+                continue;
+            // 이전 위치의 이웃으로 다시 들어가면 제자리 맴돌기라 제외
+            if (abs(nx - px) <= 1 && abs(ny - py) <= 1)
+                continue;
+            if (!img[ny * stride + nx])
+                continue;
+            px = cx;
+            py = cy;
+            cx = nx;
+            cy = ny;
+            moved = 1;
+            break;
+        }
+        if (!moved)
+            break;
+    }
+    *ex = cx;
+    *ey = cy;
+}
+
+static inline uint8_t angle_u8(double dx, double dy) {
+    double a = atan2(dy, dx);
+    if (a < 0)
+        a += 2.0 * M_PI;
+    return (uint8_t)((int)lrint(a * 256.0 / (2.0 * M_PI)) & 255);
+}
+
+static inline int angle_diff_u8(int a, int b) {
+    int d = (a - b) & 255;
+    return d > 128 ? 256 - d : d;
+}
+
+int s730b_extract_minutiae(const unsigned char *enh, int w, int h, struct s730b_minutiae *out) {
+    uint8_t img[MINU_PAD * MINU_PAD];
+    uint8_t fg[(MINU_MAX_DIM / MINU_BLOCK) * (MINU_MAX_DIM / MINU_BLOCK)];
+    const int stride = w + 2;
+    const int bw = w / MINU_BLOCK, bh = h / MINU_BLOCK;
+    const int scale = w / IMG_WIDTH > 1 ? w / IMG_WIDTH : 1;
+    const int margin = MINU_MARGIN * scale;
+    uint8_t keep[MINU_MAX];
+
+    memset(out, 0, sizeof(*out));
+    if (!enh || w > MINU_MAX_DIM || h > MINU_MAX_DIM || w % MINU_BLOCK || h % MINU_BLOCK)
+        return -1;
+    out->width = w;
+    out->height = h;
+
+    // 1) 배경 블록 (Gabor 출력에서 전부 255인 블록)
+    int nfg = 0;
+    for (int by = 0; by < bh; by++) {
+        for (int bx = 0; bx < bw; bx++) {
+            int any = 0;
+            for (int y = by * MINU_BLOCK; y < (by + 1) * MINU_BLOCK && !any; y++)
+                for (int x = bx * MINU_BLOCK; x < (bx + 1) * MINU_BLOCK; x++)
+                    any |= enh[(size_t)y * w + x] != 255;
+            fg[by * bw + bx] = (uint8_t)any;
+            nfg += any;
+        }
+    }
+    if (!nfg)
+        return 0;
+
+    // 2) 이진화: 융선(어두움) = 1
+    memset(img, 0, (size_t)stride * (h + 2));
+    for (int y = 0; y < h; y++) {
+        const unsigned char *src = enh + (size_t)y * w;
+        uint8_t *dst = img + (y + 1) * stride + 1;
+        for (int x = 0; x < w; x++)
+            dst[x] = src[x] < 128;
+    }
+
+    // 3) 세선화
+    thin_zhang_suen(img, w, h);
+
+    // 4) crossing number
+    for (int y = 1; y <= h; y++) {
+        for (int x = 1; x <= w; x++) {
+            const uint8_t *p = img + y * stride + x;
+            if (!*p)
+                continue;
+
+            int cn = transitions(p, stride);
+            if (cn != MINU_ENDING && cn != MINU_BIFURCATION)
+                continue;
+
+            // 배경/프레임 가장자리 근처는 가짜 끝점 투성이라 버림 (주변 margin px 안에 배경 블록 없어야 함)
+            int inside = 1;
+            for (int j = -1; j <= 1 && inside; j++) {
+                for (int i = -1; i <= 1; i++) {
+                    int sx = x - 1 + i * margin, sy = y - 1 + j * margin;
+                    if (sx < 0 || sy < 0 || sx >= w || sy >= h ||
+                        !fg[(sy / MINU_BLOCK) * bw + sx / MINU_BLOCK]) {
+                        inside = 0;
+                        break;
+                    }
+                }
+            }
+            if (!inside)
+                continue;
+
+            if (out->count >= MINU_MAX)
+                break;
+
+            /*
+             * 방향
+             * - 끝점: 융선 따라 들어간 지점 -> 끝점 방향
+             * - 분기점: 세 가지 중 서로 제일 가까운 두 가지의 평균 방향
+             */
+            int starts[3][2], ns = 0;
+            for (int i = 0; i < 8 && ns < 3; i++) {
+                if (!nb_val(p, stride, i) && nb_val(p, stride, (i + 1) & 7)) {
+                    int j = (i + 1) & 7;
+                    starts[ns][0] = x + nb_dx[j];
+                    starts[ns][1] = y + nb_dy[j];
+                    ns++;
+                }
+            }
+
+            uint8_t ang;
+            if (cn == MINU_ENDING) {
+                int ex, ey;
+                trace_ridge(img, stride, x, y, starts[0][0], starts[0][1], MINU_TRACE * scale, &ex, &ey);
+                ang = angle_u8(x - ex, y - ey);
+            } else {
+                uint8_t br[3];
+                for (int k = 0; k < 3; k++) {
+                    int ex, ey;
+                    trace_ridge(img, stride, x, y, starts[k][0], starts[k][1], MINU_TRACE * scale, &ex, &ey);
+                    br[k] = angle_u8(ex - x, ey - y);
+                }
+                int best = 0, bd = 256;
+                for (int k = 0; k < 3; k++) {
+                    int d = angle_diff_u8(br[k], br[(k + 1) % 3]);
+                    if (d < bd) {
+                        bd = d;
+                        best = k;
+                    }
+                }
+                int a0 = br[best], a1 = br[(best + 1) % 3];
+                int d = ((a1 - a0 + 128) & 255) - 128;
+                ang = (uint8_t)((a0 + d / 2) & 255);
+            }
+
+            int n = out->count++;
+            out->x[n] = (int16_t)(x - 1);
+            out->y[n] = (int16_t)(y - 1);
+            out->angle[n] = ang;
+            out->type[n] = (uint8_t)cn;
+        }
+    }
+
+    // 5) 너무 가까운 쌍 제거 (끊긴 융선 양 끝, 짧은 가시, 작은 구멍)
+    const int md = MINU_MIN_DIST * scale;
+    memset(keep, 1, sizeof(keep));
+    for (int i = 0; i < out->count; i++) {
+        for (int j = i + 1; j < out->count; j++) {
+            int dx = out->x[i] - out->x[j], dy = out->y[i] - out->y[j];
+            if (dx * dx + dy * dy < md * md) {
+                keep[i] = 0;
+                keep[j] = 0;
+            }
+        }
+    }
+
+    int n = 0;
+    for (int i = 0; i < out->count; i++) {
+        if (!keep[i])
+            continue;
+        out->x[n] = out->x[i];
+        out->y[n] = out->y[i];
+        out->angle[n] = out->angle[i];
+        out->type[n] = out->type[i];
+        n++;
+    }
+    out->count = n;
+    return 0;
+}
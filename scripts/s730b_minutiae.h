@@ -0,0 +1,42 @@
+/*
+ * s730b_minutiae.h
+ *
+ * - Gabor 강조된 프레임(s730b_gabor_enhance 출력)에서 바로 특징점(minutiae) 뽑기
+ * - 이진화 -> 세선화(Zhang-Suen) -> crossing number로 끝점/분기점 + 방향
+ * - NBIS(mindtct) 안 거치고 이 프로젝트 안에서 점수 매기기/색인용
+ * - 결과는 고정 크기 SoA (특징점마다 malloc 없음)
+ */
+
+#ifndef S730B_MINUTIAE_H
+#define S730B_MINUTIAE_H
+
+#include <stdint.h>
+
+#define MINU_MAX          128
+
+#define MINU_ENDING       1
+#define MINU_BIFURCATION  3     // crossing number 값 그대로 씀
+
+/*
+ * 좌표는 입력 프레임 기준 (x 오른쪽, y 아래)
+ * angle은 0..255 = 0..2pi (x축에서 시계방향, 이미지 좌표계 그대로)
+ * - 끝점: 융선이 끝나는 쪽을 가리킴
+ * - 분기점: 갈라진 두 가지 사이 방향
+ */
+struct s730b_minutiae {
+    int count;
+    int width;          // 추출한 프레임 크기 (112x96 or 224x192, 매칭할 때 배율 맞추기용)
+    int height;
+    int16_t x[MINU_MAX];
+    int16_t y[MINU_MAX];
+    uint8_t angle[MINU_MAX];
+    uint8_t type[MINU_MAX];
+};
+
+/*
+ * enh: s730b_gabor_enhance 출력 (융선 어두움, 배경 255), w/h는 8의 배수, 256 이하
+ * 0 = 성공 (0개여도), -1 = 크기 문제
+ */
+int s730b_extract_minutiae(const unsigned char *enh, int w, int h, struct s730b_minutiae *out);
+
+#endif
@@ -0,0 +1,685 @@
+/*
+ * s730b_png.c
+ *
+ * - 줄마다 Up / Paeth 필터 (SSE2, |잔차| 합 작은 쪽), deflate는 stored 또는 빠른 greedy LZ77 + dynamic Huffman
+ * - CRC32 / Adler32 / 길이 / 거리 코드 표는 처음 쓸 때 만듦
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "s730b_png.h"
+
+#define PNG_MAX_WIDTH  4096
+#define PNG_HASH_BITS  13
+#define PNG_CHAIN      4        // hash chain 최대 몇 개까지 볼지 (빠른 모드라 짧게)
+#define PNG_MIN_MATCH  3
+#define PNG_MAX_MATCH  258
+#define PNG_LAZY_INSERT 16      // 이보다 긴 match 안쪽 위치는 hash에 안 넣음 (zlib 빠른 모드처럼)
+#define PNG_WINDOW     32768
+#define PNG_STORED_MAX 65535
+#define PNG_OVERHEAD   128      // 시그니처 + IHDR + IDAT/IEND 헤더 + zlib 헤더/adler
+
+/* ---------------- CRC32 / Adler32 ---------------- */
+
+// slice-by-8 (바이트 하나씩이면 프레임당 30us 넘음)
+static uint32_t crc_table[8][256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void code_lut_init(void);
+
+static void crc_init(void) {
+    code_lut_init();
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        crc_table[0][n] = c;
+    }
+    for (uint32_t n = 0; n < 256; n++)
+        for (int t = 1; t < 8; t++)
+            crc_table[t][n] = crc_table[0][crc_table[t - 1][n] & 0xff] ^ (crc_table[t - 1][n] >> 8);
+}
+
+static uint32_t crc32_update(uint32_t crc, const unsigned char *p, size_t n) {
+    crc = ~crc;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint32_t lo = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        uint32_t hi = (uint32_t)p[4] | (uint32_t)p[5] << 8 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+        crc = crc_table[7][lo & 0xff] ^ crc_table[6][(lo >> 8) & 0xff] ^
+              crc_table[5][(lo >> 16) & 0xff] ^ crc_table[4][lo >> 24] ^
+              crc_table[3][hi & 0xff] ^ crc_table[2][(hi >> 8) & 0xff] ^
+              crc_table[1][(hi >> 16) & 0xff] ^ crc_table[0][hi >> 24];
+    }
+    while (n--)
+        crc = crc_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void adler_update(uint32_t *adler, const unsigned char *p, size_t n) {
+    uint32_t a = *adler & 0xffff, b = *adler >> 16;
+    while (n > 0) {
+        size_t k = n < 5552 ? n : 5552;     // 이 안에서는 32bit 안 넘침
+        n -= k;
+        while (k--) {
+            a += *p++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    *adler = b << 16 | a;
+}
+
+static inline void put_be32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+/* ---------------- 줄 뽑기 + 필터 ---------------- */
+
+// 출력 이미지 r번째 줄, 왼쪽 90도 회전이면 원본 (w-1-r)번째 열을 위에서 아래로
+static void get_row(const unsigned char *src, int w, int h, int rotate_90, int r, unsigned char *dst) {
+    if (!rotate_90) {
+        memcpy(dst, src + (size_t)r * w, w);
+        return;
+    }
+    const unsigned char *col = src + (w - 1 - r);
+    for (int y = 0; y < h; y++)
+        dst[y] = col[(size_t)y * w];
+}
+
+static inline int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+#ifdef __SSE2__
+// 8픽셀 Paeth 예측 (16bit), pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|
+static inline __m128i paeth8(__m128i a, __m128i b, __m128i c) {
+    const __m128i z = _mm_setzero_si128();
+    __m128i pa = _mm_sub_epi16(b, c), pb = _mm_sub_epi16(a, c);
+    __m128i pc = _mm_add_epi16(pa, pb);
+    pa = _mm_max_epi16(pa, _mm_sub_epi16(z, pa));
+    pb = _mm_max_epi16(pb, _mm_sub_epi16(z, pb));
+    pc = _mm_max_epi16(pc, _mm_sub_epi16(z, pc));
+    __m128i not_a = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+    __m128i not_b = _mm_cmpgt_epi16(pb, pc);
+    __m128i bc = _mm_or_si128(_mm_andnot_si128(not_b, b), _mm_and_si128(not_b, c));
+    return _mm_or_si128(_mm_andnot_si128(not_a, a), _mm_and_si128(not_a, bc));
+}
+
+// sum |(int8)v|, 16개
+static inline __m128i abs_sum16(__m128i v) {
+    const __m128i z = _mm_setzero_si128();
+    return _mm_sad_epu8(_mm_min_epu8(v, _mm_sub_epi8(z, v)), z);
+}
+#endif
+
+/*
+ * out[0] = 필터 종류, out[1..n] = 잔차, Up(2) / Paeth(4) 중 |잔차| 합 작은 쪽
+ * - cur/prev는 [-1]이 0인 줄 (Paeth 왼쪽 이웃 a/c를 따로 안 챙겨도 됨)
+ * - 예측값은 원본 픽셀에서 나오니까 줄 전체를 한 번에 계산 가능 (SSE2)
+ */
+static void filter_row(const unsigned char *cur, const unsigned char *prev, int n, unsigned char *out) {
+    unsigned char pr[PNG_MAX_WIDTH];
+    int su = 0, sp = 0, i = 0;
+
+#ifdef __SSE2__
+    const __m128i z = _mm_setzero_si128();
+    __m128i acc_u = z, acc_p = z;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(cur + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(prev + i));
+        __m128i a = _mm_loadu_si128((const __m128i *)(cur + i - 1));
+        __m128i c = _mm_loadu_si128((const __m128i *)(prev + i - 1));
+        __m128i lo = paeth8(_mm_unpacklo_epi8(a, z), _mm_unpacklo_epi8(b, z), _mm_unpacklo_epi8(c, z));
+        __m128i hi = paeth8(_mm_unpackhi_epi8(a, z), _mm_unpackhi_epi8(b, z), _mm_unpackhi_epi8(c, z));
+        __m128i up = _mm_sub_epi8(x, b), pa = _mm_sub_epi8(x, _mm_packus_epi16(lo, hi));
+        _mm_storeu_si128((__m128i *)(out + 1 + i), up);
+        _mm_storeu_si128((__m128i *)(pr + i), pa);
+        acc_u = _mm_add_epi64(acc_u, abs_sum16(up));
+        acc_p = _mm_add_epi64(acc_p, abs_sum16(pa));
+    }
+    su = _mm_cvtsi128_si32(acc_u) + _mm_cvtsi128_si32(_mm_srli_si128(acc_u, 8));
+    sp = _mm_cvtsi128_si32(acc_p) + _mm_cvtsi128_si32(_mm_srli_si128(acc_p, 8));
+#endif
+    for (; i < n; i++) {
+        out[1 + i] = (unsigned char)(cur[i] - prev[i]);
+        pr[i] = (unsigned char)(cur[i] - paeth(cur[i - 1], prev[i], prev[i - 1]));
+        su += abs((int8_t)out[1 + i]);
+        sp += abs((int8_t)pr[i]);
+    }
+
+    out[0] = 2;
+    if (sp < su) {
+        out[0] = 4;
+        memcpy(out + 1, pr, n);
+    }
+}
+
+/* ---------------- deflate (빠른 모드) ---------------- */
+
+struct bitw {
+    unsigned char *p, *end;
+    uint64_t acc;
+    int n;
+    int over;
+};
+
+static inline void put_bits(struct bitw *b, uint32_t v, int n) {
+    b->acc |= (uint64_t)v << b->n;
+    b->n += n;
+    while (b->n >= 8) {
+        if (b->p < b->end)
+            *b->p++ = (unsigned char)b->acc;
+        else
+            b->over = 1;
+        b->acc >>= 8;
+        b->n -= 8;
+    }
+}
+
+static void flush_bits(struct bitw *b) {
+    if (b->n > 0)
+        put_bits(b, 0, 8 - b->n);
+}
+
+static const uint16_t len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+static const uint8_t cl_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// 길이/거리 -> 코드 번호 표 (crc_init에서 같이 만듦), 거리 257 이상은 128 단위
+static uint8_t len_code_lut[PNG_MAX_MATCH + 1];
+static uint8_t dist_code_lut[512];
+
+static void code_lut_init(void) {
+    for (int l = PNG_MIN_MATCH, c = 0; l <= PNG_MAX_MATCH; l++) {
+        while (c < 28 && len_base[c + 1] <= l)
+            c++;
+        len_code_lut[l] = (uint8_t)c;
+    }
+    for (int d = 1, c = 0; d <= PNG_WINDOW; d++) {
+        while (c < 29 && dist_base[c + 1] <= d)
+            c++;
+        if (d <= 256)
+            dist_code_lut[d - 1] = (uint8_t)c;
+        else
+            dist_code_lut[256 + ((d - 1) >> 7)] = (uint8_t)c;
+    }
+}
+
+static inline int len_code(int len) {
+    return len_code_lut[len];
+}
+
+static inline int dist_code(int d) {
+    return d <= 256 ? dist_code_lut[d - 1] : dist_code_lut[256 + ((d - 1) >> 7)];
+}
+
+// LZ77 결과 하나: dist = 0이면 literal
+struct lz_tok {
+    uint16_t v;         // literal 값 또는 길이
+    uint16_t dist;
+};
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Huffman 코드 길이 (최대 limit)
+ * - 빈도순 정렬 + 두 큐 합치기, limit 넘으면 빈도를 반으로 줄여서 다시 (모양이 평평해짐)
+ * - 쓰는 기호가 2개 미만이면 하나 더 넣음 (zlib inflate는 불완전한 코드 거부)
+ */
+static void huff_lengths(const uint32_t *freq_in, int n, int limit, uint8_t *len) {
+    uint32_t freq[288], w[576];
+    int sym[288], parent[576], depth[576];
+
+    memcpy(freq, freq_in, n * sizeof(freq[0]));
+    int used = 0;
+    for (int i = 0; i < n; i++)
+        used += freq[i] != 0;
+    for (int i = 0; i < n && used < 2; i++) {
+        if (!freq[i]) {
+            freq[i] = 1;
+            used++;
+        }
+    }
+
+    for (;;) {
+        int m = 0;
+        memset(len, 0, n);
+        for (int i = 0; i < n; i++)
+            if (freq[i])
+                sym[m++] = i;
+        if (m < 2) {
+            for (int i = 0; i < m; i++)
+                len[sym[i]] = 1;
+            return;
+        }
+
+        // (빈도, 기호) 순 정렬
+        uint64_t key[288];
+        for (int i = 0; i < m; i++)
+            key[i] = (uint64_t)freq[sym[i]] << 16 | (uint64_t)sym[i];
+        qsort(key, m, sizeof(key[0]), cmp_u64);
+        for (int i = 0; i < m; i++) {
+            sym[i] = (int)(key[i] & 0xffff);
+            w[i] = (uint32_t)(key[i] >> 16);
+        }
+
+        int li = 0, ii = m, next = m;
+        while (next < 2 * m - 1) {
+            int pick[2];
+            for (int k = 0; k < 2; k++) {
+                if (li < m && (ii >= next || w[li] <= w[ii]))
+                    pick[k] = li++;
+                else
+                    pick[k] = ii++;
+            }
+            w[next] = w[pick[0]] + w[pick[1]];
+            parent[pick[0]] = parent[pick[1]] = next;
+            next++;
+        }
+
+        int maxlen = 0;
+        depth[2 * m - 2] = 0;
+        for (int i = 2 * m - 3; i >= 0; i--) {
+            depth[i] = depth[parent[i]] + 1;
+            if (i < m) {
+                len[sym[i]] = (uint8_t)depth[i];
+                if (depth[i] > maxlen)
+                    maxlen = depth[i];
+            }
+        }
+        if (maxlen <= limit)
+            return;
+        for (int i = 0; i < n; i++)
+            if (freq[i])
+                freq[i] = (freq[i] >> 1) | 1;
+    }
+}
+
+// 길이 -> canonical 코드 (deflate는 코드를 LSB부터 쓰니까 비트 뒤집어서 저장)
+static void huff_codes(const uint8_t *len, int n, uint16_t *code) {
+    int count[16] = {0}, next[16];
+    for (int i = 0; i < n; i++)
+        count[len[i]]++;
+    count[0] = 0;
+    next[0] = 0;
+    for (int b = 1; b < 16; b++)
+        next[b] = (next[b - 1] + count[b - 1]) << 1;
+    for (int i = 0; i < n; i++) {
+        if (!len[i])
+            continue;
+        uint32_t c = (uint32_t)next[len[i]]++, r = 0;
+        for (int b = 0; b < len[i]; b++)
+            r |= ((c >> b) & 1) << (len[i] - 1 - b);
+        code[i] = (uint16_t)r;
+    }
+}
+
+static int lz77(const unsigned char *p, int n, struct lz_tok *tok) {
+    int *head = malloc((1 << PNG_HASH_BITS) * sizeof(int));
+    int *prev = malloc((size_t)n * sizeof(int));
+    int nt = 0;
+
+    if (!head || !prev) {
+        free(head);
+        free(prev);
+        return -1;
+    }
+    memset(head, 0xff, (1 << PNG_HASH_BITS) * sizeof(int));
+
+#define LZ_HASH(q) ((((uint32_t)(q)[0] << 16 | (uint32_t)(q)[1] << 8 | (q)[2]) * 2654435761u) >> (32 - PNG_HASH_BITS))
+    for (int i = 0; i < n;) {
+        int best = 0, bd = 0;
+        const int maxl = n - i < PNG_MAX_MATCH ? n - i : PNG_MAX_MATCH;
+
+        if (maxl >= PNG_MIN_MATCH) {
+            uint32_t h = LZ_HASH(p + i);
+            int cand = head[h];
+            for (int chain = PNG_CHAIN; cand >= 0 && i - cand <= PNG_WINDOW && chain > 0; chain--) {
+                if (p[cand + best] == p[i + best]) {
+                    int l = 0;
+                    while (l < maxl && p[cand + l] == p[i + l])
+                        l++;
+                    if (l > best) {
+                        best = l;
+                        bd = i - cand;
+                        if (l == maxl)
+                            break;
+                    }
+                }
+                cand = prev[cand];
+            }
+            prev[i] = head[h];
+            head[h] = i;
+        }
+
+        if (best >= PNG_MIN_MATCH) {
+            tok[nt].v = (uint16_t)best;
+            tok[nt++].dist = (uint16_t)bd;
+            for (int k = 1; best <= PNG_LAZY_INSERT && k < best; k++) {
+                int j = i + k;
+                if (j + PNG_MIN_MATCH <= n) {
+                    uint32_t h = LZ_HASH(p + j);
+                    prev[j] = head[h];
+                    head[h] = j;
+                }
+            }
+            i += best;
+        } else {
+            tok[nt].v = p[i++];
+            tok[nt++].dist = 0;
+        }
+    }
+#undef LZ_HASH
+
+    free(head);
+    free(prev);
+    return nt;
+}
+
+// 블록 하나짜리 dynamic Huffman deflate, 리턴 = 바이트 수 (-1 = 넘침/메모리)
+static long deflate_fast(const unsigned char *p, int n, unsigned char *out, size_t cap) {
+    struct lz_tok *tok = malloc((size_t)(n + 1) * sizeof(*tok));
+    uint32_t lfreq[286] = {0}, dfreq[30] = {0}, cfreq[19] = {0};
+    uint8_t llen[286], dlen[30], clen[19];
+    uint16_t lcode[286], dcode[30], ccode[19];
+    struct bitw bw = { out, out + cap, 0, 0, 0 };
+
+    if (!tok)
+        return -1;
+    int nt = lz77(p, n, tok);
+    if (nt < 0) {
+        free(tok);
+        return -1;
+    }
+
+    for (int i = 0; i < nt; i++) {
+        if (tok[i].dist) {
+            lfreq[257 + len_code(tok[i].v)]++;
+            dfreq[dist_code(tok[i].dist)]++;
+        } else {
+            lfreq[tok[i].v]++;
+        }
+    }
+    lfreq[256] = 1;
+    huff_lengths(lfreq, 286, 15, llen);
+    huff_lengths(dfreq, 30, 15, dlen);
+    huff_codes(llen, 286, lcode);
+    huff_codes(dlen, 30, dcode);
+
+    int nlit = 286, ndist = 30;
+    while (nlit > 257 && !llen[nlit - 1])
+        nlit--;
+    while (ndist > 1 && !dlen[ndist - 1])
+        ndist--;
+
+    // 코드 길이들 RLE (16 = 앞 값 3~6번, 17 = 0 3~10번, 18 = 0 11~138번)
+    uint8_t all[286 + 30], rle[286 + 30], rle_extra[286 + 30];
+    int na = 0, nr = 0;
+    memcpy(all, llen, nlit);
+    memcpy(all + nlit, dlen, ndist);
+    na = nlit + ndist;
+    for (int i = 0; i < na;) {
+        int v = all[i], run = 1;
+        while (i + run < na && all[i + run] == v)
+            run++;
+        if (v == 0 && run >= 3) {
+            int r = run > 138 ? 138 : run;
+            rle[nr] = r >= 11 ? 18 : 17;
+            rle_extra[nr++] = (uint8_t)(r >= 11 ? r - 11 : r - 3);
+            i += r;
+        } else if (v != 0 && run >= 4) {
+            int r = run - 1 > 6 ? 6 : run - 1;
+            rle[nr] = (uint8_t)v;
+            rle_extra[nr++] = 0;
+            rle[nr] = 16;
+            rle_extra[nr++] = (uint8_t)(r - 3);
+            i += 1 + r;
+        } else {
+            rle[nr] = (uint8_t)v;
+            rle_extra[nr++] = 0;
+            i++;
+        }
+    }
+    for (int i = 0; i < nr; i++)
+        cfreq[rle[i]]++;
+    huff_lengths(cfreq, 19, 7, clen);
+    huff_codes(clen, 19, ccode);
+    int ncl = 19;
+    while (ncl > 4 && !clen[cl_order[ncl - 1]])
+        ncl--;
+
+    // 블록 헤더: BFINAL=1, BTYPE=2
+    put_bits(&bw, 1, 1);
+    put_bits(&bw, 2, 2);
+    put_bits(&bw, nlit - 257, 5);
+    put_bits(&bw, ndist - 1, 5);
+    put_bits(&bw, ncl - 4, 4);
+    for (int i = 0; i < ncl; i++)
+        put_bits(&bw, clen[cl_order[i]], 3);
+    for (int i = 0; i < nr; i++) {
+        put_bits(&bw, ccode[rle[i]], clen[rle[i]]);
+        if (rle[i] == 16)
+            put_bits(&bw, rle_extra[i], 2);
+        else if (rle[i] == 17)
+            put_bits(&bw, rle_extra[i], 3);
+        else if (rle[i] == 18)
+            put_bits(&bw, rle_extra[i], 7);
+    }
+
+    for (int i = 0; i < nt && !bw.over; i++) {
+        if (!tok[i].dist) {
+            put_bits(&bw, lcode[tok[i].v], llen[tok[i].v]);
+            continue;
+        }
+        int lc = len_code(tok[i].v), dc = dist_code(tok[i].dist);
+        put_bits(&bw, lcode[257 + lc], llen[257 + lc]);
+        if (len_extra[lc])
+            put_bits(&bw, tok[i].v - len_base[lc], len_extra[lc]);
+        put_bits(&bw, dcode[dc], dlen[dc]);
+        if (dist_extra[dc])
+            put_bits(&bw, tok[i].dist - dist_base[dc], dist_extra[dc]);
+    }
+    put_bits(&bw, lcode[256], llen[256]);
+    flush_bits(&bw);
+    free(tok);
+
+    return bw.over ? -1 : (long)(bw.p - out);
+}
+
+/* ---------------- PNG ---------------- */
+
+static size_t stored_size(size_t n) {
+    return n + 5 * ((n + PNG_STORED_MAX - 1) / PNG_STORED_MAX);
+}
+
+size_t s730b_png_bound(int w, int h) {
+    // 줄마다 필터 바이트 1개, 회전하면 줄 수가 w가 되니까 큰 쪽으로
+    size_t n = (size_t)w * h + (w > h ? w : h);
+    return stored_size(n) + PNG_OVERHEAD;
+}
+
+static unsigned char *put_chunk_head(unsigned char *p, uint32_t len, const char *type) {
+    put_be32(p, len);
+    memcpy(p + 4, type, 4);
+    return p + 8;
+}
+
+// chunk 끝: type부터 데이터 끝까지 CRC
+static unsigned char *put_chunk_crc(unsigned char *type, unsigned char *end) {
+    put_be32(end, crc32_update(0, type, (size_t)(end - type)));
+    return end + 4;
+}
+
+long s730b_png_encode(const unsigned char *src, int w, int h, int rotate_90, int level,
+                      unsigned char *out, size_t cap) {
+    const int ow = rotate_90 ? h : w, oh = rotate_90 ? w : h;
+    const size_t n = (size_t)oh * (ow + 1);
+    unsigned char rows[2][PNG_MAX_WIDTH + 1];   // [0] = 0 (왼쪽 바깥), 픽셀은 [1]부터
+    unsigned char filt[PNG_MAX_WIDTH + 1];
+    unsigned char *filtered = NULL;
+    uint32_t adler = 1;
+
+    if (!src || w <= 0 || h <= 0 || ow > PNG_MAX_WIDTH || cap < s730b_png_bound(w, h))
+        return -1;
+    pthread_once(&crc_once, crc_init);
+
+    // 시그니처 + IHDR (8bit grayscale)
+    static const unsigned char sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    unsigned char *p = out;
+    memcpy(p, sig, 8);
+    p += 8;
+    unsigned char *t = p + 4;
+    p = put_chunk_head(p, 13, "IHDR");
+    put_be32(p, (uint32_t)ow);
+    put_be32(p + 4, (uint32_t)oh);
+    p[8] = 8;
+    p[9] = 0;
+    p[10] = p[11] = p[12] = 0;
+    p = put_chunk_crc(t, p + 13);
+
+    // IDAT: 길이는 나중에 채움
+    unsigned char *idat = p;
+    t = p + 4;
+    p = put_chunk_head(p, 0, "IDAT");
+    unsigned char *z = p;
+    *p++ = 0x78;
+    *p++ = level == PNG_LEVEL_FAST ? 0x5e : 0x01;
+
+    if (level == PNG_LEVEL_FAST) {
+        filtered = malloc(n);
+        if (!filtered)
+            return -1;
+    }
+
+    /*
+     * 줄마다: 원본에서 (회전하면서) 뽑기 -> 필터
+     * - stored면 필터 결과를 바로 stored 블록에 붙임 (블록 크기는 n으로 미리 앎)
+     * - fast면 필터 결과를 모아뒀다가 deflate
+     */
+    memset(rows, 0, sizeof(rows));
+    size_t done = 0, block_left = 0;
+    for (int r = 0; r < oh; r++) {
+        unsigned char *cur = rows[r & 1] + 1, *prev = rows[(r & 1) ^ 1] + 1;
+        get_row(src, w, h, rotate_90, r, cur);
+        unsigned char *dst = filtered ? filtered + (size_t)r * (ow + 1) : filt;
+        filter_row(cur, prev, ow, dst);
+        adler_update(&adler, dst, ow + 1);
+        if (filtered)
+            continue;
+
+        for (int k = 0; k < ow + 1;) {
+            if (block_left == 0) {
+                size_t bl = n - done < PNG_STORED_MAX ? n - done : PNG_STORED_MAX;
+                *p++ = done + bl == n ? 1 : 0;
+                p[0] = (unsigned char)bl;
+                p[1] = (unsigned char)(bl >> 8);
+                p[2] = (unsigned char)~bl;
+                p[3] = (unsigned char)(~bl >> 8);
+                p += 4;
+                block_left = bl;
+            }
+            size_t m = (size_t)(ow + 1 - k) < block_left ? (size_t)(ow + 1 - k) : block_left;
+            memcpy(p, dst + k, m);
+            p += m;
+            k += (int)m;
+            done += m;
+            block_left -= m;
+        }
+    }
+
+    if (filtered) {
+        // 압축이 stored보다 크면 의미 없으니 stored 크기만큼만 허용
+        size_t room = stored_size(n);
+        long zl = deflate_fast(filtered, (int)n, p, room);
+        if (zl < 0 || (size_t)zl >= room) {
+            free(filtered);
+            return s730b_png_encode(src, w, h, rotate_90, PNG_LEVEL_STORED, out, cap);
+        }
+        p += zl;
+        free(filtered);
+    }
+
+    put_be32(p, adler);
+    p += 4;
+    put_be32(idat, (uint32_t)(p - z));
+    p = put_chunk_crc(t, p);
+
+    t = p + 4;
+    p = put_chunk_head(p, 0, "IEND");
+    p = put_chunk_crc(t, p);
+    return (long)(p - out);
+}
+
+static int write_all(const char *path, const unsigned char *buf, size_t len) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+    while (len > 0) {
+        ssize_t k = write(fd, buf, len);
+        if (k <= 0) {
+            close(fd);
+            return -1;
+        }
+        buf += k;
+        len -= (size_t)k;
+    }
+    return close(fd);
+}
+
+int s730b_write_png(const char *path, const unsigned char *src, int w, int h, int rotate_90, int level) {
+    size_t cap = s730b_png_bound(w, h);
+    unsigned char *buf = malloc(cap);
+    if (!buf)
+        return -1;
+    long len = s730b_png_encode(src, w, h, rotate_90, level, buf, cap);
+    int r = len < 0 ? -1 : write_all(path, buf, (size_t)len);
+    free(buf);
+    return r;
+}
+
+int s730b_write_pgm(const char *path, const unsigned char *src, int w, int h, int rotate_90) {
+    const int ow = rotate_90 ? h : w, oh = rotate_90 ? w : h;
+    unsigned char *buf = malloc((size_t)ow * oh + 32);
+    if (!buf)
+        return -1;
+
+    int hl = snprintf((char *)buf, 32, "P5\n%d %d\n255\n", ow, oh);
+    for (int r = 0; r < oh; r++)
+        get_row(src, w, h, rotate_90, r, buf + hl + (size_t)r * ow);
+    int ret = write_all(path, buf, (size_t)hl + (size_t)ow * oh);
+    free(buf);
+    return ret;
+}
@@ -0,0 +1,36 @@
+/*
+ * s730b_png.h
+ *
+ * - 8bit 흑백 프레임 -> PNG / PGM (Python + Pillow 안 거치고 C에서 바로)
+ * - 회전(왼쪽 90도)은 원본 버퍼에서 줄 뽑을 때 바로 처리 (회전용 복사본 없음)
+ * - PNG
+ *   - 줄마다 Up / Paeth 필터 중 |잔차| 합이 작은 쪽
+ *   - level 0: stored (압축 안 함, 제일 빠름)
+ *   - level 1: 빠른 deflate (3바이트 hash + 짧은 chain greedy LZ77 + 블록 하나짜리 dynamic Huffman)
+ *              stored보다 커지면 stored로 씀
+ * - PGM: 헤더 + 픽셀을 버퍼 하나에 만들어서 write 한 번
+ */
+
+#ifndef S730B_PNG_H
+#define S730B_PNG_H
+
+#include <stddef.h>
+
+#define PNG_LEVEL_STORED 0
+#define PNG_LEVEL_FAST   1
+
+/* s730b_png_encode에 넘길 out 버퍼 최소 크기 */
+size_t s730b_png_bound(int w, int h);
+
+/*
+ * src (w x h) -> out에 PNG 파일 내용, rotate_90이면 왼쪽으로 90도 돌린 (h x w) 이미지
+ * - 리턴 = 바이트 수, -1 = 메모리/크기 오류
+ */
+long s730b_png_encode(const unsigned char *src, int w, int h, int rotate_90, int level,
+                      unsigned char *out, size_t cap);
+
+/* 파일로 바로 (0 = 성공, -1 = 실패) */
+int s730b_write_png(const char *path, const unsigned char *src, int w, int h, int rotate_90, int level);
+int s730b_write_pgm(const char *path, const unsigned char *src, int w, int h, int rotate_90);
+
+#endif
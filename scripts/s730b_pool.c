@@ -0,0 +1,164 @@
+/*
+ * s730b_pool.c
+ *
+ * - worker마다 [시작, 끝) 구간 하나 (64bit에 같이 넣어서 CAS), 비면 남의 뒷쪽 절반 뺏음
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include "s730b_pool.h"
+
+#define RANGE_LO(r)       ((uint32_t)(r))
+#define RANGE_HI(r)       ((uint32_t)((r) >> 32))
+#define RANGE(lo, hi)     (((uint64_t)(hi) << 32) | (uint32_t)(lo))
+
+// 자기 구간 앞에서 하나 꺼냄
+static int range_pop(uint64_t *range, int *task) {
+    uint64_t r = __atomic_load_n(range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t lo = RANGE_LO(r), hi = RANGE_HI(r);
+        if (lo >= hi)
+            return 0;
+        if (__atomic_compare_exchange_n(range, &r, RANGE(lo + 1, hi), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *task = (int)lo;
+            return 1;
+        }
+    }
+}
+
+// 다른 worker 구간의 뒷쪽 절반(하나 남았으면 그것)을 뺏어서 내 구간으로
+static int range_steal(struct s730b_pool *pool, int worker) {
+    for (int k = 1; k < pool->nthreads; k++) {
+        struct s730b_pool_worker *victim = &pool->workers[(worker + k) % pool->nthreads];
+        uint64_t r = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        for (;;) {
+            uint32_t lo = RANGE_LO(r), hi = RANGE_HI(r);
+            if (lo >= hi)
+                break;
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (__atomic_compare_exchange_n(&victim->range, &r, RANGE(lo, mid), 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&pool->workers[worker].range, RANGE(mid, hi), __ATOMIC_RELEASE);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void pool_drain(struct s730b_pool *pool, int worker) {
+    uint64_t *mine = &pool->workers[worker].range;
+    int task;
+
+    while (!__atomic_load_n(&pool->cancel, __ATOMIC_RELAXED)) {
+        if (range_pop(mine, &task))
+            pool->fn(pool->arg, task, worker);
+        else if (!range_steal(pool, worker))
+            break;
+    }
+}
+
+static void *pool_thread(void *p) {
+    struct s730b_pool_worker *self = p;
+    struct s730b_pool *pool = self->pool;
+    unsigned seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->shutdown)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_drain(pool, self->id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0)
+            pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+int s730b_pool_init(struct s730b_pool *pool, int nthreads) {
+    memset(pool, 0, sizeof(*pool));
+
+    if (nthreads <= 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = n > 0 ? (int)n : 1;
+    }
+    if (nthreads > POOL_MAX_THREADS)
+        nthreads = POOL_MAX_THREADS;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // worker 0은 run()을 부른 스레드 자신
+    pool->nthreads = 1;
+    for (int i = 1; i < nthreads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+        if (pthread_create(&pool->threads[i], NULL, pool_thread, &pool->workers[i]) != 0)
+            break;
+        pool->nthreads++;
+    }
+    return pool->nthreads;
+}
+
+void s730b_pool_destroy(struct s730b_pool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->nthreads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+}
+
+void s730b_pool_run(struct s730b_pool *pool, int ntasks, s730b_pool_fn fn, void *arg) {
+    if (ntasks <= 0)
+        return;
+
+    if (pool->nthreads <= 1 || ntasks == 1) {
+        pool->cancel = 0;
+        for (int t = 0; t < ntasks && !pool->cancel; t++)
+            fn(arg, t, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->ntasks = ntasks;
+    pool->cancel = 0;
+    for (int i = 0; i < pool->nthreads; i++) {
+        uint32_t lo = (uint32_t)((int64_t)ntasks * i / pool->nthreads);
+        uint32_t hi = (uint32_t)((int64_t)ntasks * (i + 1) / pool->nthreads);
+        pool->workers[i].range = RANGE(lo, hi);
+    }
+    pool->running = pool->nthreads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_drain(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void s730b_pool_cancel(struct s730b_pool *pool) {
+    __atomic_store_n(&pool->cancel, 1, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,61 @@
+/*
+ * s730b_pool.h
+ *
+ * - 고정 개수 worker 스레드로 "0..n-1 작업을 나눠서 돌리기"만 하는 단순 스레드 풀
+ * - 작업 하나가 짧고(타일 하나, 템플릿 묶음 하나) 개수가 많을 때 쓰는 용도
+ * - 호출한 스레드도 같이 일함 -> 스레드 1개짜리 풀 = 그냥 순차 실행
+ * - work stealing: 처음엔 0..n-1을 worker 수만큼 연속 구간으로 나눠주고 (캐시/메모리 지역성),
+ *   자기 구간 다 끝낸 worker는 남의 구간 뒷쪽 절반을 뺏어옴
+ */
+
+#ifndef S730B_POOL_H
+#define S730B_POOL_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#define POOL_MAX_THREADS 64
+
+typedef void (*s730b_pool_fn)(void *arg, int task, int worker);
+
+struct s730b_pool;
+
+struct s730b_pool_worker {
+    struct s730b_pool *pool;
+    int id;
+    uint64_t range;             // 남은 task 구간 [lo, hi) = (hi << 32) | lo, CAS로만 바꿈
+} __attribute__((aligned(64)));
+
+struct s730b_pool {
+    pthread_t threads[POOL_MAX_THREADS];
+    struct s730b_pool_worker workers[POOL_MAX_THREADS];
+    int nthreads;               // 호출 스레드 포함 전체 worker 수
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned generation;        // run() 한 번마다 +1 (worker 깨우는 신호)
+    int running;                // 아직 일하는 중인 worker 수
+    int shutdown;
+
+    // 현재 run() 작업
+    s730b_pool_fn fn;
+    void *arg;
+    int ntasks;
+    int cancel;                 // s730b_pool_cancel() 불리면 1 (남은 task 안 꺼냄)
+};
+
+/* nthreads <= 0 이면 CPU 개수만큼 */
+int s730b_pool_init(struct s730b_pool *pool, int nthreads);
+void s730b_pool_destroy(struct s730b_pool *pool);
+
+/* fn(arg, task, worker)를 task = 0..ntasks-1 에 대해 병렬 실행, 다 끝나야 리턴 */
+void s730b_pool_run(struct s730b_pool *pool, int ntasks, s730b_pool_fn fn, void *arg);
+
+/*
+ * fn 안에서 불러서 지금 run()의 남은 task 건너뛰기 (이미 돌고 있는 건 끝까지 감)
+ * - 1:N 검색에서 확실한 결과 나왔을 때 조기 종료용
+ */
+void s730b_pool_cancel(struct s730b_pool *pool);
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * s730b_prefilter.c
+ *
+ * - 가까운 특징점 쌍 (거리, 양 끝 상대각) 양자화 -> hash -> 4096bit 중 하나
+ * - 점수 = probe bit 중 갤러리에도 켜진 비율, AND + popcount
+ */
+
+#include <string.h>
+
+#include "s730b_prefilter.h"
+
+#define DESC_DIST_CELL  12      // 거리 칸 크기 (Q2, 3px)
+#define DESC_ANGLE_SH   4       // 상대각 칸 = 256 >> 4 = 16칸 (22.5도)
+#define DESC_ANGLE_CELL (1 << DESC_ANGLE_SH)
+
+static inline void set_feature(struct s730b_descriptor *d, int qd, int qb1, int qb2) {
+    uint32_t key = ((uint32_t)qd << 8) | ((uint32_t)(qb1 & 15) << 4) | (uint32_t)(qb2 & 15);
+    uint32_t bit = (key * 2654435761u) >> (32 - PREFILTER_LOG2);
+    d->bits[bit >> 6] |= 1ull << (bit & 63);
+}
+
+// 칸 번호 + (soft면) 값이 더 가까운 쪽 이웃 칸
+static inline int cells(int v, int cell, int soft, int *c) {
+    c[0] = v / cell;
+    if (!soft)
+        return 1;
+    c[1] = (v % cell) * 2 < cell ? c[0] - 1 : c[0] + 1;
+    return 2;
+}
+
+/*
+ * 쌍 하나 = (i->j) 방향, (j->i) 방향 둘 다 넣음
+ * - 템플릿마다 i, j 순서가 달라도 같은 쌍이면 같은 bit가 켜지게
+ */
+static void add_pair(struct s730b_descriptor *d, int dq, uint8_t b1, uint8_t b2, int soft) {
+    const uint8_t fwd[2] = { b1, b2 }, rev[2] = { (uint8_t)(b2 - 128), (uint8_t)(b1 - 128) };
+    const uint8_t *dir[2] = { fwd, rev };
+    int cd[2], c1[2], c2[2];
+    int nd = cells(dq, DESC_DIST_CELL, soft, cd);
+
+    for (int k = 0; k < 2; k++) {
+        int n1 = cells(dir[k][0], DESC_ANGLE_CELL, soft, c1);
+        int n2 = cells(dir[k][1], DESC_ANGLE_CELL, soft, c2);
+        for (int a = 0; a < nd; a++)
+            for (int b = 0; b < n1; b++)
+                for (int c = 0; c < n2; c++)
+                    if (cd[a] >= 0)
+                        set_feature(d, cd[a], c1[b], c2[c]);
+    }
+}
+
+void s730b_descriptor_build(const struct s730b_template *t, int gallery, struct s730b_descriptor *d) {
+    memset(d, 0, sizeof(*d));
+    // pair table이 거리순이라 MAX_DIST 넘으면 끝
+    for (int k = 0; k < t->npairs && t->d[k] <= PREFILTER_MAX_DIST * 4; k++)
+        add_pair(d, t->d[k], t->b1[k], t->b2[k], gallery);
+}
+
+/*
+ * AND + popcount, word 수 고정이라 gcc가 다 펼침
+ * - target_clones: CPU에 popcnt/AVX2 있으면 그 버전으로 (없으면 일반 버전, 실행 시 자동 선택)
+ */
+__attribute__((target_clones("avx2", "popcnt", "default")))
+static int desc_overlap(const uint64_t *a, const uint64_t *b, int *pa) {
+    int common = 0, total = 0;
+    for (int k = 0; k < PREFILTER_WORDS; k++) {
+        common += __builtin_popcountll(a[k] & b[k]);
+        total += __builtin_popcountll(a[k]);
+    }
+    *pa = total;
+    return common;
+}
+
+int s730b_descriptor_score(const struct s730b_descriptor *probe, const struct s730b_descriptor *gallery) {
+    int total, common = desc_overlap(probe->bits, gallery->bits, &total);
+    return total ? common * 256 / total : 0;
+}
+
+int s730b_prefilter(const struct s730b_descriptor *probe, const struct s730b_descriptor *gallery, int count,
+                    int keep, int *out) {
+    int hist[257] = {0};
+
+    if (keep >= count) {
+        for (int i = 0; i < count; i++)
+            out[i] = i;
+        return count;
+    }
+    if (keep <= 0)
+        return 0;
+
+    // 1) 점수 + 히스토그램 (점수는 out에 임시로)
+    for (int i = 0; i < count; i++) {
+        int s = s730b_descriptor_score(probe, &gallery[i]);
+        out[i] = s;
+        hist[s]++;
+    }
+
+    // 2) 상위 keep개 커트라인
+    int cut = 256, acc = hist[256];
+    while (cut > 0 && acc < keep)
+        acc += hist[--cut];
+
+    // 3) 커트라인 초과는 전부, 딱 커트라인은 keep 찰 때까지 (쓰는 위치 <= 읽는 위치라 제자리 가능)
+    int above = acc - hist[cut], ties = keep - above, n = 0;
+    for (int i = 0; i < count; i++) {
+        int s = out[i];
+        if (s > cut || (s == cut && ties-- > 0))
+            out[n++] = i;
+    }
+    return n;
+}
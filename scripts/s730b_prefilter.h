@@ -0,0 +1,40 @@
+/*
+ * s730b_prefilter.h
+ *
+ * - 1:N 검색 전에 후보 줄이는 고정 길이 비트 descriptor (템플릿당 512B)
+ * - 가까운 특징점 쌍마다 회전/평행이동 불변 값 (거리, 양 끝 상대각)을 양자화해서 hash -> bit 하나
+ *   -> "같은 모양 쌍을 몇 개 공유하나"를 AND + popcount 한 번으로 셈
+ * - 갤러리 쪽은 양자화 경계 근처 값 때문에 놓치지 않게 이웃 칸까지 bit 켜둠 (soft),
+ *   probe 쪽은 자기 칸만 켬 -> 점수 = probe bit 중 갤러리에도 켜진 비율
+ */
+
+#ifndef S730B_PREFILTER_H
+#define S730B_PREFILTER_H
+
+#include <stdint.h>
+
+#include "s730b_match.h"
+
+#define PREFILTER_LOG2      12      // 4096 bit (1024로 줄이면 hash 충돌 때문에 놓치는 정답이 2~3배)
+#define PREFILTER_BITS      (1 << PREFILTER_LOG2)
+#define PREFILTER_WORDS     (PREFILTER_BITS / 64)
+#define PREFILTER_MAX_DIST  60      // 이보다 먼 쌍은 안 씀 (112x96 기준 px, 멀수록 피부 늘어남에 약함)
+
+struct s730b_descriptor {
+    uint64_t bits[PREFILTER_WORDS];
+} __attribute__((aligned(64)));
+
+/* gallery = 1이면 이웃 칸까지 켜는 갤러리용, 0이면 probe용 */
+void s730b_descriptor_build(const struct s730b_template *t, int gallery, struct s730b_descriptor *d);
+
+/* probe bit 중 gallery에도 있는 비율 (0..256) */
+int s730b_descriptor_score(const struct s730b_descriptor *probe, const struct s730b_descriptor *gallery);
+
+/*
+ * 갤러리 descriptor count개 중 점수 상위 keep개 번호를 out에 (점수 순서는 아님)
+ * - out은 count칸 있어야 함 (중간 계산에 씀), 리턴 = 고른 개수
+ */
+int s730b_prefilter(const struct s730b_descriptor *probe, const struct s730b_descriptor *gallery, int count,
+                    int keep, int *out);
+
+#endif
@@ -0,0 +1,325 @@
+/*
+ * s730b_proto.c
+ *
+ * - 730B init / 캡처 시퀀스 (예전 samsung_730b.c init_sensor / capture_fingerprint / detect_finger)
+ * - transfer는 전부 s730b_transport로 -> libusb 장치든 s730b_sim이든 같은 코드
+ */
+
+#include <string.h>
+
+#include "s730b_proto.h"
+
+const char *const s730b_proto_at_name[PROTO_AT_KINDS] = {
+    "-", "control 0xC3", "init bulk", "control 0xCA", "캡처 시작 bulk", "초기 상태 bulk IN", "bulk IN", "bulk ACK",
+};
+
+const uint16_t s730b_capture_indices[S730B_NUM_PACKETS] = {
+    0x032a, 0x042a, 0x052a, 0x062a,
+    0x072a, 0x082a, 0x092a, 0x0a2a,
+    0x0b2a, 0x0c2a, 0x0d2a, 0x0e2a,
+    0x0f2a, 0x102a, 0x112a, 0x122a,
+    0x132a, 0x142a, 0x152a, 0x162a,
+    0x172a, 0x182a, 0x192a, 0x1a2a,
+    0x1b2a, 0x1c2a, 0x1d2a, 0x1e2a,
+    0x1f2a, 0x202a, 0x212a, 0x222a,
+    0x232a, 0x242a, 0x252a, 0x262a,
+    0x272a, 0x282a, 0x292a, 0x2a2a,
+    0x2b2a, 0x2c2a, 0x2d2a, 0x2e2a,
+    0x2f2a, 0x302a, 0x312a, 0x322a,
+    0x332a, 0x342a, 0x352a, 0x362a,
+    0x372a, 0x382a, 0x392a, 0x3a2a,
+    0x3b2a, 0x3c2a, 0x3d2a, 0x3e2a,
+    0x3f2a, 0x402a, 0x412a, 0x422a,
+    0x432a, 0x442a, 0x452a, 0x462a,
+    0x472a, 0x482a, 0x492a, 0x4a2a,
+    0x4b2a, 0x4c2a, 0x4d2a, 0x4e2a,
+    0x4f2a, 0x502a, 0x512a, 0x522a,
+    0x532a, 0x542a, 0x552a, 0x562a,
+    0x572a,
+};
+
+const unsigned char s730b_c3_data[16] = {
+    0x80, 0x84, 0x1e, 0x00,
+    0x08, 0x00, 0x00, 0x01,
+    0x01, 0x01, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00
+};
+
+static const unsigned char cmd00[] = {0x4f, 0x80            };
+static const unsigned char cmd01[] = {0xa9, 0x4f, 0x80      };
+static const unsigned char cmd02[] = {0xa8, 0xb9, 0x00      };
+static const unsigned char cmd03[] = {0xa9, 0x60, 0x1b, 0x00};
+static const unsigned char cmd04[] = {0xa9, 0x50, 0x21, 0x00};
+static const unsigned char cmd05[] = {0xa9, 0x61, 0x00, 0x00};
+static const unsigned char cmd06[] = {0xa9, 0x62, 0x00, 0x1a};
+static const unsigned char cmd07[] = {0xa9, 0x63, 0x00, 0x1a};
+static const unsigned char cmd08[] = {0xa9, 0x64, 0x04, 0x0a};
+static const unsigned char cmd09[] = {0xa9, 0x66, 0x0f, 0x80};
+static const unsigned char cmd10[] = {0xa9, 0x67, 0x1b, 0x00};
+static const unsigned char cmd11[] = {0xa9, 0x68, 0x00, 0x0f};
+static const unsigned char cmd12[] = {0xa9, 0x69, 0x00, 0x14};
+static const unsigned char cmd13[] = {0xa9, 0x6a, 0x00, 0x19};
+static const unsigned char cmd14[] = {0xa9, 0x6c, 0x00, 0x19};
+static const unsigned char cmd15[] = {0xa9, 0x40, 0x43, 0x00};
+static const unsigned char cmd16[] = {0xa9, 0x41, 0x6f, 0x00};
+static const unsigned char cmd17[] = {0xa9, 0x55, 0x20, 0x00};
+static const unsigned char cmd18[] = {0xa9, 0x5f, 0x00, 0x00};
+static const unsigned char cmd19[] = {0xa9, 0x52, 0x27, 0x00};
+static const unsigned char cmd20[] = {0xa9, 0x09, 0x00, 0x00};
+static const unsigned char cmd21[] = {0xa9, 0x5d, 0x4d, 0x00};
+static const unsigned char cmd22[] = {0xa9, 0x51, 0xa8, 0x25};
+static const unsigned char cmd23[] = {0xa9, 0x03, 0x00      };
+static const unsigned char cmd24[] = {0xa9, 0x38, 0x01, 0x00};
+static const unsigned char cmd25[] = {0xa9, 0x3d, 0xff, 0x0f};
+static const unsigned char cmd26[] = {0xa9, 0x10, 0x60, 0x00};
+static const unsigned char cmd27[] = {0xa9, 0x3b, 0x14, 0x00};
+static const unsigned char cmd28[] = {0xa9, 0x2f, 0xf6, 0xff};
+static const unsigned char cmd29[] = {0xa9, 0x09, 0x00, 0x00};
+static const unsigned char cmd30[] = {0xa9, 0x0c, 0x00      };
+static const unsigned char cmd31[] = {0xa8, 0x20, 0x00, 0x00};
+static const unsigned char cmd32[] = {0xa9, 0x04, 0x00      };
+static const unsigned char cmd33[] = {0xa8, 0x08, 0x00      };
+static const unsigned char cmd34[] = {0xa9, 0x09, 0x00, 0x00};
+static const unsigned char cmd35[] = {0xa8, 0x3e, 0x00, 0x00};
+static const unsigned char cmd36[] = {0xa9, 0x03, 0x00, 0x00};
+static const unsigned char cmd37[] = {0xa8, 0x20, 0x00, 0x00};
+static const unsigned char cmd38[] = {0xa9, 0x10, 0x00, 0x01};
+static const unsigned char cmd39[] = {0xa9, 0x2f, 0xef, 0x00};
+static const unsigned char cmd40[] = {0xa9, 0x09, 0x00, 0x00};
+static const unsigned char cmd41[] = {0xa9, 0x5d, 0x4d, 0x00};
+static const unsigned char cmd42[] = {0xa9, 0x51, 0x3a, 0x25};
+static const unsigned char cmd43[] = {0xa9, 0x0c, 0x00      };
+static const unsigned char cmd44[] = {0xa8, 0x20, 0x00, 0x00};
+static const unsigned char cmd45[] = {0xa9, 0x04, 0x00, 0x00};
+static const unsigned char cmd46[] = {0xa9, 0x09, 0x00, 0x00};
+
+const struct s730b_cmd s730b_init_cmds[] = {
+    { cmd00, sizeof(cmd00) }, { cmd01, sizeof(cmd01) },
+    { cmd02, sizeof(cmd02) }, { cmd03, sizeof(cmd03) },
+    { cmd04, sizeof(cmd04) }, { cmd05, sizeof(cmd05) },
+    { cmd06, sizeof(cmd06) }, { cmd07, sizeof(cmd07) },
+    { cmd08, sizeof(cmd08) }, { cmd09, sizeof(cmd09) },
+    { cmd10, sizeof(cmd10) }, { cmd11, sizeof(cmd11) },
+    { cmd12, sizeof(cmd12) }, { cmd13, sizeof(cmd13) },
+    { cmd14, sizeof(cmd14) }, { cmd15, sizeof(cmd15) },
+    { cmd16, sizeof(cmd16) }, { cmd17, sizeof(cmd17) },
+    { cmd18, sizeof(cmd18) }, { cmd19, sizeof(cmd19) },
+    { cmd20, sizeof(cmd20) }, { cmd21, sizeof(cmd21) },
+    { cmd22, sizeof(cmd22) }, { cmd23, sizeof(cmd23) },
+    { cmd24, sizeof(cmd24) }, { cmd25, sizeof(cmd25) },
+    { cmd26, sizeof(cmd26) }, { cmd27, sizeof(cmd27) },
+    { cmd28, sizeof(cmd28) }, { cmd29, sizeof(cmd29) },
+    { cmd30, sizeof(cmd30) }, { cmd31, sizeof(cmd31) },
+    { cmd32, sizeof(cmd32) }, { cmd33, sizeof(cmd33) },
+    { cmd34, sizeof(cmd34) }, { cmd35, sizeof(cmd35) },
+    { cmd36, sizeof(cmd36) }, { cmd37, sizeof(cmd37) },
+    { cmd38, sizeof(cmd38) }, { cmd39, sizeof(cmd39) },
+    { cmd40, sizeof(cmd40) }, { cmd41, sizeof(cmd41) },
+    { cmd42, sizeof(cmd42) }, { cmd43, sizeof(cmd43) },
+    { cmd44, sizeof(cmd44) }, { cmd45, sizeof(cmd45) },
+    { cmd46, sizeof(cmd46) },
+};
+const size_t s730b_init_cmds_len = sizeof(s730b_init_cmds) / sizeof(s730b_init_cmds[0]);
+
+static int fail(struct s730b_proto_stats *st, int err, int at, int index) {
+    st->err = err;
+    st->at = at;
+    st->index = index;
+    return err;
+}
+
+int s730b_proto_init(struct s730b_transport *t, struct s730b_proto_stats *st) {
+    unsigned char c3[sizeof(s730b_c3_data)];
+    int r, transferred;
+
+    memset(st, 0, sizeof(*st));
+    memcpy(c3, s730b_c3_data, sizeof(c3));
+
+    // 1) control 0xC3 초기 설정 (Host->Device, Vendor, Device)
+    r = s730b_control(t, 0x40, 0xC3, 0x0000, 0x0000, c3, sizeof(c3), 500);
+    if (r < 0)
+        return fail(st, r, PROTO_AT_C3, 0);
+
+    // 2) 0xA9/0xA8 init 시퀀스
+    for (size_t i = 0; i < s730b_init_cmds_len; i++) {
+        r = s730b_bulk(t, S730B_EP_OUT, (unsigned char *)s730b_init_cmds[i].data, (int)s730b_init_cmds[i].len,
+                       &transferred, 500);
+        if (r < 0)
+            return fail(st, r, PROTO_AT_INIT, (int)i);
+    }
+    return 0;
+}
+
+int s730b_proto_capture(struct s730b_transport *t, int packets, int flags, unsigned char *buf, int cap,
+                        struct s730b_proto_stats *st) {
+    unsigned char tmp[S730B_CHUNK];
+    int r, transferred, total = 0;
+    uint64_t t_start = s730b_transport_now(t), chunk_sum = 0;
+
+    memset(st, 0, sizeof(*st));
+    if (packets > S730B_NUM_PACKETS)
+        packets = S730B_NUM_PACKETS;
+
+    // ---------- 1) chunk 0: 0xCA -> 시작 명령 -> 상태 응답 (ACK 없음) ----------
+    r = s730b_control(t, 0x40, 0xCA, 0x0003, s730b_capture_indices[0], NULL, 0, 500);
+    if (r < 0)
+        return fail(st, r, PROTO_AT_CA, 0);
+
+    unsigned char start_cmd[S730B_CHUNK] = { 0xa8, 0x06, 0x00, 0x00 };
+    r = s730b_bulk(t, S730B_EP_OUT, start_cmd, sizeof(start_cmd), &transferred, 500);
+    if (r < 0)
+        return fail(st, r, PROTO_AT_START, 0);
+
+    // 짧은 상태응답 (0~2 bytes), 캡처는 읽기만 하고 probe는 앞에 붙임
+    r = s730b_bulk(t, S730B_EP_IN, tmp, sizeof(tmp), &transferred, 500);
+    if (r < 0)
+        return fail(st, r, PROTO_AT_STATUS, 0);
+    st->status_len = transferred;
+    if ((flags & PROTO_PROBE) && transferred > 0 && transferred <= cap) {
+        memcpy(buf, tmp, transferred);
+        total = transferred;
+    }
+
+    // ---------- 2) 나머지 packet: 실제 데이터 + ACK ----------
+    for (int i = 1; i < packets; i++) {
+        uint64_t t_chunk = s730b_transport_now(t);
+
+        // CONTROL 0xCA: 패킷 설정
+        r = s730b_control(t, 0x40, 0xCA, 0x0003, s730b_capture_indices[i], NULL, 0, 500);
+        if (r < 0) {
+            fail(st, r, PROTO_AT_CA, i);
+            break;
+        }
+
+        r = s730b_bulk(t, S730B_EP_IN, tmp, sizeof(tmp), &transferred, flags & PROTO_PROBE ? 700 : 1000);
+        if (r < 0) {
+            fail(st, r, PROTO_AT_DATA, i);
+            break;
+        }
+        int got = transferred;
+        if (got == 0 || total + got > cap) {
+            fail(st, 0, PROTO_AT_DATA, i);
+            break;
+        }
+        memcpy(buf + total, tmp, got);
+        total += got;
+
+        // ACK (256 zeros)
+        unsigned char ack[S730B_CHUNK] = { 0 };
+        r = s730b_bulk(t, S730B_EP_OUT, ack, sizeof(ack), &transferred, 500);
+        if (r < 0) {
+            fail(st, r, PROTO_AT_ACK, i);
+            break;
+        }
+
+        uint32_t us = (uint32_t)((s730b_transport_now(t) - t_chunk) / 1000);
+        chunk_sum += us;
+        if (us > st->chunk_max_us)
+            st->chunk_max_us = us;
+        st->short_chunks += got != S730B_CHUNK;
+        st->chunks++;
+    }
+
+    st->total_us = (uint32_t)((s730b_transport_now(t) - t_start) / 1000);
+    st->chunk_avg_us = st->chunks ? (uint32_t)(chunk_sum / st->chunks) : 0;
+    return total;
+}
+
+/* ---------------- 복구 ---------------- */
+
+void s730b_recover_init(struct s730b_recover *rc) {
+    memset(rc, 0, sizeof(*rc));
+    rc->max_attempts = PROTO_MAX_ATTEMPTS;
+}
+
+static void recover_reset(struct s730b_recover *rc) {
+    rc->attempts = rc->reinits = rc->clears = rc->reopens = 0;
+    rc->recover_ns = 0;
+    rc->first_err = rc->first_at = 0;
+}
+
+// 실패 하나 기록 (t_try = 실패한 시도 시작) -> 다음 시도 전에 할 일 (1 = 장치 다시 열기)
+static int recover_note(struct s730b_transport *t, struct s730b_recover *rc, int err, int at, uint64_t t_try,
+                        uint64_t *t_fail) {
+    if (!*t_fail) {
+        *t_fail = t_try;
+        rc->first_err = err;
+        rc->first_at = at;
+    }
+    if (err == S730B_ENODEV)
+        return 1;
+    if (err == S730B_EPIPE && t->clear_halt) {
+        t->clear_halt(t->ctx, S730B_EP_IN);
+        t->clear_halt(t->ctx, S730B_EP_OUT);
+        rc->clears++;
+    }
+    return 0;
+}
+
+// 빠졌으면 다시 열기, 0 = 열림
+static int recover_reopen(struct s730b_transport *t, struct s730b_recover *rc) {
+    if (!t->reopen)
+        return S730B_ENODEV;
+    rc->reopens++;
+    return t->reopen(t->ctx);
+}
+
+int s730b_proto_init_recover(struct s730b_transport *t, struct s730b_recover *rc, struct s730b_proto_stats *st) {
+    uint64_t t_fail = 0;
+    int reopen = 0, r = 0;
+
+    recover_reset(rc);
+    while (rc->attempts < rc->max_attempts) {
+        uint64_t t_try = s730b_transport_now(t);
+        rc->attempts++;
+        if (reopen && (r = recover_reopen(t, rc)) < 0)
+            continue;
+        reopen = 0;
+        if (rc->attempts > 1)
+            rc->reinits++;
+        r = s730b_proto_init(t, st);
+        if (r == 0) {
+            rc->recover_ns = t_fail ? s730b_transport_now(t) - t_fail : 0;
+            return 0;
+        }
+        reopen = recover_note(t, rc, r, st->at, t_try, &t_fail);
+    }
+    return r < 0 ? r : S730B_EIO;
+}
+
+int s730b_proto_capture_recover(struct s730b_transport *t, int packets, int flags, unsigned char *buf, int cap,
+                                struct s730b_recover *rc, struct s730b_proto_stats *st) {
+    uint64_t t_fail = 0;
+    int reopen = 0, init = 0, len = S730B_EIO;
+
+    recover_reset(rc);
+    if (packets > S730B_NUM_PACKETS)
+        packets = S730B_NUM_PACKETS;
+    while (rc->attempts < rc->max_attempts) {
+        uint64_t t_try = s730b_transport_now(t);
+        rc->attempts++;
+        if (reopen && (len = recover_reopen(t, rc)) < 0)
+            continue;
+        reopen = 0;
+        // 첫 시도는 그냥 (호출한 쪽이 init 해둠), 실패 뒤에는 init부터
+        if (init) {
+            rc->reinits++;
+            int r = s730b_proto_init(t, st);
+            if (r < 0) {
+                len = r;
+                reopen = recover_note(t, rc, r, st->at, t_try, &t_fail);
+                continue;
+            }
+        }
+        init = 1;
+        len = s730b_proto_capture(t, packets, flags, buf, cap, st);
+        int err = len < 0 ? len : st->err;
+        if (len >= 0 && st->chunks == packets - 1 && !st->short_chunks) {
+            rc->recover_ns = t_fail ? s730b_transport_now(t) - t_fail : 0;
+            return len;
+        }
+        // 잘린 프레임 / 짧은 chunk도 실패로 치고 다시 (0 bytes면 코드 없음)
+        reopen = recover_note(t, rc, err ? err : S730B_EIO, st->at, t_try, &t_fail);
+    }
+    return len;
+}
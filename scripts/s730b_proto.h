@@ -0,0 +1,101 @@
+/*
+ * s730b_proto.h
+ *
+ * - 730B 프로토콜 시퀀스 (samsung_730b.c에서 빼냄, s730b_transport 위에서 돎)
+ *   1) init: control 0xC3 (16B 설정) -> bulk OUT init_cmds 47개
+ *   2) 캡처 / 감지 probe: 0xCA capture_indices[0] -> a8 06 시작 -> 상태 응답 (0~2B, ACK 없음)
+ *      -> packet i마다 0xCA capture_indices[i] -> bulk IN 256B -> ACK 256B (0)
+ * - 출력 안 함, 실패 위치 / 코드는 s730b_proto_stats로 (드라이버가 찍고, 벤치 / 시뮬레이터는 셈)
+ */
+
+#ifndef S730B_PROTO_H
+#define S730B_PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "s730b_transport.h"
+
+#define S730B_VID           0x04e8
+#define S730B_PID           0x730b
+#define S730B_EP_OUT        0x01
+#define S730B_EP_IN         0x82
+#define S730B_CHUNK         256
+#define S730B_NUM_PACKETS   85                              // capture_indices 수 (chunk 0 = 상태 응답)
+#define S730B_FRAME_BYTES   ((S730B_NUM_PACKETS - 1) * S730B_CHUNK)
+
+#define PROTO_PROBE         0x1     // 감지 probe: 상태 응답도 버퍼 앞에 넣고 bulk IN timeout 짧게
+
+// 실패 / 중단 지점
+enum {
+    PROTO_AT_NONE,
+    PROTO_AT_C3,        // control 0xC3
+    PROTO_AT_INIT,      // init 명령 (index = 명령 번호)
+    PROTO_AT_CA,        // control 0xCA (index = packet)
+    PROTO_AT_START,     // a8 06 시작 명령
+    PROTO_AT_STATUS,    // chunk 0 상태 응답
+    PROTO_AT_DATA,      // 데이터 chunk (index = packet)
+    PROTO_AT_ACK,       // ACK (index = packet)
+    PROTO_AT_KINDS,
+};
+
+extern const char *const s730b_proto_at_name[PROTO_AT_KINDS];
+
+extern const uint16_t s730b_capture_indices[S730B_NUM_PACKETS];
+extern const unsigned char s730b_c3_data[16];
+
+struct s730b_cmd {
+    const unsigned char *data;
+    size_t len;
+};
+
+extern const struct s730b_cmd s730b_init_cmds[];
+extern const size_t s730b_init_cmds_len;
+
+struct s730b_proto_stats {
+    int err;                    // 실패한 transfer 코드 (0 = 없음, 0 bytes 받아서 멈춘 것도 0)
+    int at, index;              // 실패 / 중단 지점 (PROTO_AT_*), 끝까지 가면 PROTO_AT_NONE
+    int chunks;                 // 받은 데이터 chunk
+    int short_chunks;           // 256B 안 된 chunk
+    int status_len;             // chunk 0 상태 응답 길이
+    uint32_t chunk_max_us, chunk_avg_us;   // 0xCA ~ ACK
+    uint32_t total_us;
+};
+
+/* 0xC3 + init 명령, 0 = 성공, 음수 = 실패 transfer 코드 (st에 지점) */
+int s730b_proto_init(struct s730b_transport *t, struct s730b_proto_stats *st);
+
+/*
+ * packets개 (capture_indices 앞에서부터, 캡처는 S730B_NUM_PACKETS) 받아서 buf에
+ * - 리턴 = 받은 바이트 (중간에 실패하면 거기까지, st->err), 음수 = chunk 0 단계 실패
+ * - buf는 (packets - 1) * 256 (+ PROTO_PROBE면 상태 응답 256) 이상
+ */
+int s730b_proto_capture(struct s730b_transport *t, int packets, int flags, unsigned char *buf, int cap,
+                        struct s730b_proto_stats *st);
+
+/*
+ * 복구해 가면서 init / 캡처
+ * - timeout / 짧은 chunk / 잘린 프레임 -> init 다시 하고 처음부터
+ * - stall (-9) -> clear_halt (있으면) + init, 장치 빠짐 (-4) -> reopen (있으면) + init
+ * - max_attempts번 (transfer 실패 한 번 = 시도 한 번) 안에 되면 성공, recover_ns = 처음 실패한 시도 시작 ~ 성공
+ */
+#define PROTO_MAX_ATTEMPTS 4
+
+struct s730b_recover {
+    int max_attempts;
+    // 마지막 호출 결과
+    int attempts, reinits, clears, reopens;
+    int first_err, first_at;    // 처음 실패한 transfer
+    uint64_t recover_ns;        // 처음 실패한 시도 시작 ~ 성공, 실패 없었으면 0
+};
+
+void s730b_recover_init(struct s730b_recover *rc);
+
+/* 0 = 성공, 음수 = 시도 다 써도 실패 (마지막 코드) */
+int s730b_proto_init_recover(struct s730b_transport *t, struct s730b_recover *rc, struct s730b_proto_stats *st);
+
+/* 온전한 프레임 (packets - 1 chunk, 짧은 것 없음) 받을 때까지, 리턴 = 바이트 / 음수 = 실패 */
+int s730b_proto_capture_recover(struct s730b_transport *t, int packets, int flags, unsigned char *buf, int cap,
+                                struct s730b_recover *rc, struct s730b_proto_stats *st);
+
+#endif
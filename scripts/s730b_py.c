@@ -0,0 +1,538 @@
+/*
+ * s730b_py.c
+ *
+ * - 파이썬 확장 모듈 _s730b: samsung_730b.py (Samsung730B)가 있으면 씀
+ *   - pyusb로 하면 캡처 한 번에 transfer 84 x 3개 + 매번 _log 포맷 / bytes 만들기 / bytearray.extend
+ *     -> init / 감지 probe / 캡처 전체를 s730b_proto (C 드라이버랑 같은 코드)로 한 번에
+ * - USB 전송하는 동안은 GIL 풂 (다른 파이썬 스레드 계속 돎), 같은 Device를 두 스레드가 동시에 쓰면 RuntimeError
+ * - 결과는 bytes (버퍼 프로토콜), capture_into(buf)는 bytearray / memoryview / numpy 같은 쓰기 되는 버퍼에 바로 씀
+ * - Device(sim=[raw...])면 libusb 대신 센서 모델 (s730b_sim), 장치 없이 벤치 / 테스트
+ * - control / bulk_out / bulk_in: transfer 하나씩 (pyusb 경로 그대로 흉내, 벤치 비교용)
+ * - libusb 없이 빌드: -DS730B_PY_NO_USB (sim만)
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef S730B_PY_NO_USB
+#include <libusb-1.0/libusb.h>
+#endif
+
+#include "s730b_integrity.h"
+#include "s730b_proto.h"
+#include "s730b_sim.h"
+
+typedef struct {
+    PyObject_HEAD
+    struct s730b_transport t;
+    struct s730b_sim *sim;          // sim이면
+#ifndef S730B_PY_NO_USB
+    libusb_context *usb;
+#endif
+    struct s730b_integrity ig;
+    struct s730b_proto_stats st;    // 마지막 init / 캡처 / probe
+    struct s730b_recover rc;
+    uint32_t frame_flags;           // 마지막 capture 프레임 검사 (s730b_frame_check)
+    int busy;                       // GIL 풀고 전송 중
+} DeviceObject;
+
+static PyObject *S730BError;
+
+// libusb 코드 그대로 errno 자리에 (OSError 하위)
+static PyObject *raise_usb(const char *what, int code) {
+    PyObject *e = Py_BuildValue("(is)", code, what);
+    if (e) {
+        PyErr_SetObject(S730BError, e);
+        Py_DECREF(e);
+    }
+    return NULL;
+}
+
+// PyErr_Format은 format이 ASCII여야 해서 (한글 메시지) snprintf로
+static PyObject *raise_fmt(PyObject *type, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static PyObject *raise_fmt(PyObject *type, const char *fmt, ...) {
+    char msg[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    PyErr_SetString(type, msg);
+    return NULL;
+}
+
+// GIL 풀기 전: 닫혔는지 / 다른 스레드가 쓰는 중인지
+static int device_enter(DeviceObject *d) {
+    if (!d->t.ctx) {
+        PyErr_SetString(S730BError, "장치가 열려있지 않음");
+        return -1;
+    }
+    if (d->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "다른 스레드가 쓰는 중");
+        return -1;
+    }
+    d->busy = 1;
+    return 0;
+}
+
+#ifndef S730B_PY_NO_USB
+static int usb_control(void *ctx, uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+                       unsigned char *data, uint16_t len, unsigned timeout_ms) {
+    return libusb_control_transfer(ctx, request_type, request, value, index, data, len, timeout_ms);
+}
+
+static int usb_bulk(void *ctx, unsigned char ep, unsigned char *data, int len, int *transferred,
+                    unsigned timeout_ms) {
+    return libusb_bulk_transfer(ctx, ep, data, len, transferred, timeout_ms);
+}
+
+static int usb_clear_halt(void *ctx, unsigned char ep) {
+    return libusb_clear_halt(ctx, ep);
+}
+
+static int device_open_usb(DeviceObject *d) {
+    libusb_device_handle *h;
+    int r = libusb_init(&d->usb);
+
+    if (r < 0) {
+        d->usb = NULL;
+        return r;
+    }
+    h = libusb_open_device_with_vid_pid(d->usb, S730B_VID, S730B_PID);
+    if (!h)
+        return LIBUSB_ERROR_NO_DEVICE;
+    if (libusb_kernel_driver_active(h, 0) == 1)
+        libusb_detach_kernel_driver(h, 0);
+    r = libusb_set_configuration(h, 1);
+    if (r == 0)
+        r = libusb_claim_interface(h, 0);
+    if (r < 0) {
+        libusb_close(h);
+        return r;
+    }
+    d->t.ctx = h;
+    d->t.control = usb_control;
+    d->t.bulk = usb_bulk;
+    d->t.clear_halt = usb_clear_halt;
+    return 0;
+}
+#endif
+
+static void device_close(DeviceObject *d) {
+#ifndef S730B_PY_NO_USB
+    if (!d->sim && d->t.ctx) {
+        libusb_release_interface(d->t.ctx, 0);
+        libusb_close(d->t.ctx);
+    }
+    if (d->usb)
+        libusb_exit(d->usb);
+    d->usb = NULL;
+#endif
+    PyMem_Free(d->sim);
+    d->sim = NULL;
+    d->t.ctx = NULL;
+}
+
+static int Device_init(DeviceObject *d, PyObject *args, PyObject *kw) {
+    static char *kwlist[] = { "sim", "scale", "seed", NULL };
+    PyObject *sim = Py_None;
+    double scale = 0;
+    unsigned int seed = 0x730b;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "|OdI", kwlist, &sim, &scale, &seed))
+        return -1;
+    device_close(d);
+    s730b_integrity_init(&d->ig);
+
+    if (sim == Py_None) {
+#ifdef S730B_PY_NO_USB
+        PyErr_SetString(S730BError, "libusb 없이 빌드됨 (sim=만 됨)");
+        return -1;
+#else
+        int r;
+        Py_BEGIN_ALLOW_THREADS
+        r = device_open_usb(d);
+        Py_END_ALLOW_THREADS
+        if (r < 0) {
+            device_close(d);
+            raise_usb("장치를 찾을 수 없음 (VID/PID or sudo..?)", r);
+            return -1;
+        }
+        return 0;
+#endif
+    }
+
+    // sim: raw 경로 하나 또는 여러 개
+    PyObject *seq = PyUnicode_Check(sim) || PyBytes_Check(sim) ? Py_BuildValue("(O)", sim)
+                                                              : PySequence_Fast(sim, "sim은 raw 경로 (목록)");
+    if (!seq)
+        return -1;
+    d->sim = PyMem_Calloc(1, sizeof(*d->sim));
+    if (!d->sim) {
+        Py_DECREF(seq);
+        PyErr_NoMemory();
+        return -1;
+    }
+    s730b_sim_init(d->sim, seed);
+    d->sim->timing.scale = scale;
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); i++) {
+        PyObject *path = NULL;
+        if (!PyUnicode_FSConverter(PySequence_Fast_GET_ITEM(seq, i), &path))
+            goto fail;
+        int r = s730b_sim_load(d->sim, PyBytes_AS_STRING(path), 0);
+        if (r < 0) {
+            raise_fmt(S730BError, "%s: 84 chunk raw 아님", PyBytes_AS_STRING(path));
+            Py_DECREF(path);
+            goto fail;
+        }
+        Py_DECREF(path);
+    }
+    Py_DECREF(seq);
+    if (!d->sim->nframes) {
+        PyErr_SetString(S730BError, "sim raw 없음");
+        device_close(d);
+        return -1;
+    }
+    s730b_sim_transport(d->sim, &d->t);
+    return 0;
+
+fail:
+    Py_DECREF(seq);
+    device_close(d);
+    return -1;
+}
+
+static void Device_dealloc(DeviceObject *d) {
+    device_close(d);
+    Py_TYPE(d)->tp_free((PyObject *)d);
+}
+
+static PyObject *Device_close(DeviceObject *d, PyObject *unused) {
+    (void)unused;
+    if (d->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "다른 스레드가 쓰는 중");
+        return NULL;
+    }
+    device_close(d);
+    Py_RETURN_NONE;
+}
+
+/* init(): 0xC3 + init 명령 (복구 포함) */
+static PyObject *Device_sensor_init(DeviceObject *d, PyObject *unused) {
+    int r;
+
+    (void)unused;
+    if (device_enter(d) < 0)
+        return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    s730b_recover_init(&d->rc);
+    r = s730b_proto_init_recover(&d->t, &d->rc, &d->st);
+    Py_END_ALLOW_THREADS
+    d->busy = 0;
+    if (r < 0)
+        return raise_usb(d->st.at == PROTO_AT_C3 ? "control 0xC3 전송 실패" : "init 실패", r);
+    Py_RETURN_NONE;
+}
+
+// GIL 없이 캡처, 리턴 = 바이트 / 음수
+static int device_capture(DeviceObject *d, int packets, int flags, int recover, unsigned char *buf, int cap) {
+    int len;
+
+    Py_BEGIN_ALLOW_THREADS
+    s730b_recover_init(&d->rc);
+    if (recover)
+        len = s730b_proto_capture_recover(&d->t, packets, flags, buf, cap, &d->rc, &d->st);
+    else
+        len = s730b_proto_capture(&d->t, packets, flags, buf, cap, &d->st);
+    Py_END_ALLOW_THREADS
+    return len;
+}
+
+static void device_check(DeviceObject *d, const unsigned char *buf, int len) {
+    struct s730b_frame_desc fd;
+
+    d->frame_flags = s730b_frame_check(&d->ig, buf, len, &d->st, &fd);
+}
+
+/* capture(recover=True) -> bytes: 풀 프레임 (84 chunk, 21504B) */
+static PyObject *Device_capture(DeviceObject *d, PyObject *args, PyObject *kw) {
+    static char *kwlist[] = { "recover", NULL };
+    int recover = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "|p", kwlist, &recover))
+        return NULL;
+    // 아직 아무도 못 보는 bytes라 GIL 없이 채워도 됨
+    PyObject *out = PyBytes_FromStringAndSize(NULL, S730B_FRAME_BYTES);
+    if (!out)
+        return NULL;
+    if (device_enter(d) < 0) {
+        Py_DECREF(out);
+        return NULL;
+    }
+    int len = device_capture(d, S730B_NUM_PACKETS, 0, recover, (unsigned char *)PyBytes_AS_STRING(out),
+                             S730B_FRAME_BYTES);
+    d->busy = 0;
+    if (len < 0) {
+        Py_DECREF(out);
+        return raise_usb("캡처 실패", len);
+    }
+    device_check(d, (unsigned char *)PyBytes_AS_STRING(out), len);
+    if (len < S730B_FRAME_BYTES && _PyBytes_Resize(&out, len) < 0)
+        return NULL;
+    return out;
+}
+
+/* capture_into(buf, recover=True) -> 받은 바이트: 쓰기 되는 버퍼 (21504B 이상)에 바로 */
+static PyObject *Device_capture_into(DeviceObject *d, PyObject *args, PyObject *kw) {
+    static char *kwlist[] = { "buf", "recover", NULL };
+    Py_buffer view;
+    int recover = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "w*|p", kwlist, &view, &recover))
+        return NULL;
+    if (view.len < S730B_FRAME_BYTES) {
+        PyBuffer_Release(&view);
+        return raise_fmt(PyExc_ValueError, "버퍼가 작음 (%zd < %d)", view.len, S730B_FRAME_BYTES);
+    }
+    if (device_enter(d) < 0) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+    // view 잡고 있는 동안 bytearray 크기 못 바꿈 (export 중)
+    int len = device_capture(d, S730B_NUM_PACKETS, 0, recover, view.buf, S730B_FRAME_BYTES);
+    d->busy = 0;
+    if (len >= 0)
+        device_check(d, view.buf, len);
+    PyBuffer_Release(&view);
+    if (len < 0)
+        return raise_usb("캡처 실패", len);
+    return PyLong_FromLong(len);
+}
+
+/* detect(packets=6) -> bytes: 감지 probe (상태 응답 + packets - 1 chunk, 복구 안 함) */
+static PyObject *Device_detect(DeviceObject *d, PyObject *args, PyObject *kw) {
+    static char *kwlist[] = { "packets", NULL };
+    int packets = 6;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "|i", kwlist, &packets))
+        return NULL;
+    if (packets < 1 || packets > S730B_NUM_PACKETS)
+        return raise_fmt(PyExc_ValueError, "packets는 1..%d", S730B_NUM_PACKETS);
+    int cap = packets * S730B_CHUNK;
+    PyObject *out = PyBytes_FromStringAndSize(NULL, cap);
+    if (!out)
+        return NULL;
+    if (device_enter(d) < 0) {
+        Py_DECREF(out);
+        return NULL;
+    }
+    int len = device_capture(d, packets, PROTO_PROBE, 0, (unsigned char *)PyBytes_AS_STRING(out), cap);
+    d->busy = 0;
+    if (len < 0) {
+        Py_DECREF(out);
+        return raise_usb("detect 실패", len);
+    }
+    if (len < cap && _PyBytes_Resize(&out, len) < 0)
+        return NULL;
+    return out;
+}
+
+/* control(request, value, index, data=None, timeout=500) -> 보낸 바이트 (vendor, host -> device) */
+static PyObject *Device_control(DeviceObject *d, PyObject *args, PyObject *kw) {
+    static char *kwlist[] = { "request", "value", "index", "data", "timeout", NULL };
+    unsigned int request, value, index, timeout = 500;
+    Py_buffer data = { 0 };
+    int r;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "III|z*I", kwlist, &request, &value, &index, &data, &timeout))
+        return NULL;
+    // 0xC3 데이터 16B라 복사해서 (data는 읽기 전용일 수 있음)
+    unsigned char tmp[64];
+    if (data.len > (Py_ssize_t)sizeof(tmp)) {
+        PyBuffer_Release(&data);
+        return raise_fmt(PyExc_ValueError, "control 데이터는 %zu B까지", sizeof(tmp));
+    }
+    if (device_enter(d) < 0) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    uint16_t len = (uint16_t)data.len;
+    if (len)
+        memcpy(tmp, data.buf, len);
+    Py_BEGIN_ALLOW_THREADS
+    r = s730b_control(&d->t, 0x40, (uint8_t)request, (uint16_t)value, (uint16_t)index, len ? tmp : NULL, len,
+                      timeout);
+    Py_END_ALLOW_THREADS
+    d->busy = 0;
+    PyBuffer_Release(&data);
+    if (r < 0)
+        return raise_usb("control 전송 실패", r);
+    return PyLong_FromLong(r);
+}
+
+/* bulk_out(data, timeout=500) -> 보낸 바이트 */
+static PyObject *Device_bulk_out(DeviceObject *d, PyObject *args, PyObject *kw) {
+    static char *kwlist[] = { "data", "timeout", NULL };
+    unsigned int timeout = 500;
+    Py_buffer data;
+    int r, n;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "y*|I", kwlist, &data, &timeout))
+        return NULL;
+    if (device_enter(d) < 0) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    r = s730b_bulk(&d->t, S730B_EP_OUT, data.buf, (int)data.len, &n, timeout);
+    Py_END_ALLOW_THREADS
+    d->busy = 0;
+    PyBuffer_Release(&data);
+    if (r < 0)
+        return raise_usb("bulk OUT 실패", r);
+    return PyLong_FromLong(n);
+}
+
+/* bulk_in(size=256, timeout=500) -> bytes, timeout이면 None (samsung_730b.py _bulk_in이랑 같게) */
+static PyObject *Device_bulk_in(DeviceObject *d, PyObject *args, PyObject *kw) {
+    static char *kwlist[] = { "size", "timeout", NULL };
+    unsigned int timeout = 500;
+    int size = S730B_CHUNK, r, n;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "|iI", kwlist, &size, &timeout))
+        return NULL;
+    if (size < 0)
+        return raise_fmt(PyExc_ValueError, "size < 0");
+    PyObject *out = PyBytes_FromStringAndSize(NULL, size);
+    if (!out)
+        return NULL;
+    if (device_enter(d) < 0) {
+        Py_DECREF(out);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    r = s730b_bulk(&d->t, S730B_EP_IN, (unsigned char *)PyBytes_AS_STRING(out), size, &n, timeout);
+    Py_END_ALLOW_THREADS
+    d->busy = 0;
+    if (r == S730B_ETIMEDOUT) {
+        Py_DECREF(out);
+        Py_RETURN_NONE;
+    }
+    if (r < 0) {
+        Py_DECREF(out);
+        return raise_usb("bulk IN 실패", r);
+    }
+    if (n < size && _PyBytes_Resize(&out, n) < 0)
+        return NULL;
+    return out;
+}
+
+/* stats() -> dict: 마지막 init / 캡처 / probe 통계 + 복구 + 프레임 검사 */
+static PyObject *Device_stats(DeviceObject *d, PyObject *unused) {
+    (void)unused;
+    return Py_BuildValue("{s:i,s:i,s:i,s:i,s:i,s:I,s:I,s:i,s:i,s:K,s:I}", "err", d->st.err, "at", d->st.at,
+                         "chunks", d->st.chunks, "short_chunks", d->st.short_chunks, "status_len",
+                         d->st.status_len, "total_us", d->st.total_us, "chunk_max_us", d->st.chunk_max_us,
+                         "attempts", d->rc.attempts, "reinits", d->rc.reinits,
+                         "recover_ns", (unsigned long long)d->rc.recover_ns, "frame_flags", d->frame_flags);
+}
+
+static PyObject *Device_enter(DeviceObject *d, PyObject *unused) {
+    (void)unused;
+    Py_INCREF(d);
+    return (PyObject *)d;
+}
+
+static PyObject *Device_exit(DeviceObject *d, PyObject *args) {
+    (void)args;
+    return Device_close(d, NULL);
+}
+
+static PyObject *Device_get_sim(DeviceObject *d, void *closure) {
+    (void)closure;
+    return PyBool_FromLong(d->sim != NULL);
+}
+
+static PyObject *Device_get_violations(DeviceObject *d, void *closure) {
+    (void)closure;
+    return PyLong_FromUnsignedLongLong(d->sim ? d->sim->violations : 0);
+}
+
+static PyObject *Device_get_frame_flags(DeviceObject *d, void *closure) {
+    (void)closure;
+    return PyLong_FromUnsignedLong(d->frame_flags);
+}
+
+static PyMethodDef Device_methods[] = {
+    { "init", (PyCFunction)Device_sensor_init, METH_NOARGS, "0xC3 + init 명령 (복구 포함)" },
+    { "capture", (PyCFunction)(void (*)(void))Device_capture, METH_VARARGS | METH_KEYWORDS,
+      "capture(recover=True) -> bytes (84 chunk)" },
+    { "capture_into", (PyCFunction)(void (*)(void))Device_capture_into, METH_VARARGS | METH_KEYWORDS,
+      "capture_into(buf, recover=True) -> 받은 바이트" },
+    { "detect", (PyCFunction)(void (*)(void))Device_detect, METH_VARARGS | METH_KEYWORDS,
+      "detect(packets=6) -> bytes (상태 응답 + chunk)" },
+    { "control", (PyCFunction)(void (*)(void))Device_control, METH_VARARGS | METH_KEYWORDS,
+      "control(request, value, index, data=None, timeout=500)" },
+    { "bulk_out", (PyCFunction)(void (*)(void))Device_bulk_out, METH_VARARGS | METH_KEYWORDS,
+      "bulk_out(data, timeout=500)" },
+    { "bulk_in", (PyCFunction)(void (*)(void))Device_bulk_in, METH_VARARGS | METH_KEYWORDS,
+      "bulk_in(size=256, timeout=500) -> bytes / None (timeout)" },
+    { "stats", (PyCFunction)Device_stats, METH_NOARGS, "마지막 전송 통계 dict" },
+    { "close", (PyCFunction)Device_close, METH_NOARGS, "장치 닫기" },
+    { "__enter__", (PyCFunction)Device_enter, METH_NOARGS, NULL },
+    { "__exit__", (PyCFunction)Device_exit, METH_VARARGS, NULL },
+    { NULL, NULL, 0, NULL },
+};
+
+static PyGetSetDef Device_getset[] = {
+    { "sim", (getter)Device_get_sim, NULL, "센서 모델이면 True", NULL },
+    { "violations", (getter)Device_get_violations, NULL, "sim: 프로토콜 어긴 횟수", NULL },
+    { "frame_flags", (getter)Device_get_frame_flags, NULL, "마지막 캡처 프레임 검사 (0 = 온전)", NULL },
+    { NULL, NULL, NULL, NULL, NULL },
+};
+
+static PyTypeObject DeviceType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "_s730b.Device",
+    .tp_basicsize = sizeof(DeviceObject),
+    .tp_dealloc = (destructor)Device_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Device(sim=None, scale=0.0, seed=0x730b): 730B 장치 (sim=raw 경로면 센서 모델)",
+    .tp_methods = Device_methods,
+    .tp_getset = Device_getset,
+    .tp_init = (initproc)Device_init,
+    .tp_new = PyType_GenericNew,
+};
+
+static struct PyModuleDef s730b_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "_s730b",
+    .m_doc = "Samsung 730B 캡처 엔진 (s730b_proto) 바인딩",
+    .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit__s730b(void) {
+    PyObject *m;
+
+    if (PyType_Ready(&DeviceType) < 0)
+        return NULL;
+    m = PyModule_Create(&s730b_module);
+    if (!m)
+        return NULL;
+    S730BError = PyErr_NewException("_s730b.Error", PyExc_OSError, NULL);
+    if (!S730BError || PyModule_AddObjectRef(m, "Error", S730BError) < 0 ||
+        PyModule_AddObjectRef(m, "Device", (PyObject *)&DeviceType) < 0 ||
+        PyModule_AddIntConstant(m, "FRAME_BYTES", S730B_FRAME_BYTES) < 0 ||
+        PyModule_AddIntConstant(m, "FRAME_TRUNCATED", FRAME_TRUNCATED) < 0 ||
+        PyModule_AddIntConstant(m, "FRAME_SHORT_CHUNK", FRAME_SHORT_CHUNK) < 0 ||
+        PyModule_AddIntConstant(m, "FRAME_NO_IMAGE", FRAME_NO_IMAGE) < 0 ||
+        PyModule_AddIntConstant(m, "FRAME_DUPLICATE", FRAME_DUPLICATE) < 0) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,104 @@
+/*
+ * s730b_quality.c
+ *
+ * - 8x8 블록마다 평균 / 분산 / gradient 방향 일관성 -> coverage x 대비 x 방향 일관성으로 점수 하나
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "s730b_quality.h"
+
+#define FG_MIN_STD      12     // 블록 표준편차가 이거보다 작으면 배경(평평함)
+#define FG_MIN_MEAN     16     // 거의 0인 블록 = 센서에 안 닿은 영역
+#define CONTRAST_GOOD   40.0   // 이 정도 대비면 대비 점수 만점
+#define COVERAGE_GOOD   0.80   // 이 정도 덮으면 coverage 점수 만점
+
+/*
+ * 블록 하나 통계
+ * - 평균/분산 + 중앙차분 gradient 구조텐서 (gxx, gyy, gxy)
+ * - 프레임 가장자리 픽셀은 차분할 이웃이 없으니 gradient에서만 뺌
+ */
+struct block_stat {
+    int sum;
+    int sumsq;
+    int gxx;
+    int gyy;
+    int gxy;
+};
+
+static void block_stats(const unsigned char *img, int w, int h, int bx, int by, struct block_stat *bs) {
+    memset(bs, 0, sizeof(*bs));
+
+    for (int y = by; y < by + QUALITY_BLOCK; y++) {
+        const unsigned char *row = img + (size_t)y * w;
+        const unsigned char *up = y > 0 ? row - w : row;
+        const unsigned char *down = y < h - 1 ? row + w : row;
+
+        for (int x = bx; x < bx + QUALITY_BLOCK; x++) {
+            int v = row[x];
+            bs->sum += v;
+            bs->sumsq += v * v;
+
+            int gx = (x > 0 && x < w - 1) ? row[x + 1] - row[x - 1] : 0;
+            int gy = down[x] - up[x];
+            bs->gxx += gx * gx;
+            bs->gyy += gy * gy;
+            bs->gxy += gx * gy;
+        }
+    }
+}
+
+int s730b_frame_quality(const unsigned char *img, int w, int h, struct s730b_quality *q) {
+    const double n = QUALITY_BLOCK * QUALITY_BLOCK;
+    int blocks = 0, fg = 0;
+    double contrast = 0.0, coherence = 0.0;
+
+    memset(q, 0, sizeof(*q));
+    if (!img || w < QUALITY_BLOCK || h < QUALITY_BLOCK || w % QUALITY_BLOCK || h % QUALITY_BLOCK)
+        return -1;
+
+    for (int by = 0; by < h; by += QUALITY_BLOCK) {
+        for (int bx = 0; bx < w; bx += QUALITY_BLOCK) {
+            struct block_stat bs;
+            block_stats(img, w, h, bx, by, &bs);
+            blocks++;
+
+            double mean = bs.sum / n;
+            double var = bs.sumsq / n - mean * mean;
+            double sd = var > 0 ? sqrt(var) : 0.0;
+            if (sd < FG_MIN_STD || mean < FG_MIN_MEAN)
+                continue;
+
+            // 구조텐서 coherence: 융선이 한 방향으로 흐르면 1, 노이즈면 0 근처
+            double gsum = (double)bs.gxx + bs.gyy;
+            double gdiff = (double)bs.gxx - bs.gyy;
+            double coh = gsum > 0 ? sqrt(gdiff * gdiff + 4.0 * (double)bs.gxy * bs.gxy) / gsum : 0.0;
+
+            fg++;
+            contrast += sd;
+            coherence += coh;
+        }
+    }
+
+    if (fg) {
+        q->coverage = (double)fg / blocks;
+        q->contrast = contrast / fg;
+        q->coherence = coherence / fg;
+    }
+
+    /*
+     * 점수 = coverage * 대비 * 방향성
+     * - 세개 다 0..1로 맞추고 곱함 -> 하나라도 나쁘면 점수가 확 떨어짐
+     * - coherence는 좋은 지문도 0.5~0.7 정도라 0.6을 만점 기준으로 잡음
+     */
+    double cov_s = q->coverage / COVERAGE_GOOD;
+    double con_s = q->contrast / CONTRAST_GOOD;
+    double coh_s = q->coherence / 0.6;
+    cov_s = cov_s > 1.0 ? 1.0 : cov_s;
+    con_s = con_s > 1.0 ? 1.0 : con_s;
+    coh_s = coh_s > 1.0 ? 1.0 : coh_s;
+
+    q->score = (int)(100.0 * cov_s * con_s * coh_s + 0.5);
+    return 0;
+}
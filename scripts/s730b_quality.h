@@ -0,0 +1,25 @@
+/*
+ * s730b_quality.h
+ *
+ * - 112x96 프레임 품질 점수 (매칭 가기 전에 빨리 걸러내기용)
+ * - 빈 프레임(none.raw), 반만 찍힌 프레임(half.raw), 흐린 프레임을 1ms 안에 판정해서
+ *   캡처 루프에서 바로 재캡처 할 수 있게 하는 게 목적
+ */
+
+#ifndef S730B_QUALITY_H
+#define S730B_QUALITY_H
+
+#define QUALITY_BLOCK     8
+#define QUALITY_MIN_SCORE 60   // 이 점수 미만이면 재캡처 대상 (half.raw ~48, default.raw 100)
+
+struct s730b_quality {
+    double coverage;    // 융선이 보이는 블록 비율 (0..1)
+    double contrast;    // 융선 블록들의 평균 표준편차
+    double coherence;   // 융선 블록들의 평균 방향 일관성 (0..1)
+    int score;          // 0..100
+};
+
+/* 0 = 성공, -1 = 크기가 블록 단위로 안 나눠짐 */
+int s730b_frame_quality(const unsigned char *img, int w, int h, struct s730b_quality *q);
+
+#endif
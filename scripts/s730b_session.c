@@ -0,0 +1,272 @@
+/*
+ * s730b_session.c
+ *
+ * - worker 스레드 하나가 큐 맨 앞 요청을 처리, 규칙은 s730b_session.h 참고
+ * - lock은 큐 / 상태만 잡고 전송하는 동안은 풂 (빠짐 / 붙음 이벤트가 전송 중에도 들어오게)
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include "s730b_session.h"
+
+enum { REQ_QUEUED, REQ_RUNNING, REQ_DONE };
+
+static uint64_t session_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void session_deadline(struct timespec *ts, unsigned ms) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void queue_remove(struct s730b_session *s, int i) {
+    memmove(&s->queue[i], &s->queue[i + 1], (size_t)(s->n - i - 1) * sizeof(s->queue[0]));
+    s->n--;
+}
+
+// 장치 없어짐으로 봄: 준비 풀고 붙음 이벤트 기다림 (lock 잡고)
+static void session_lost(struct s730b_session *s) {
+    if (s->ready || s->attached) {
+        s->detach_ns = session_now();
+        s->stats.detaches++;
+    }
+    s->ready = 0;
+    s->attached = 0;
+    s->need_open = 1;
+}
+
+// 붙은 뒤: 다시 열고 (claim) init, lock 없이
+static int session_replay(struct s730b_session *s, int need_open) {
+    struct s730b_proto_stats st;
+    struct s730b_recover rc;
+
+    if (need_open && s->t->reopen) {
+        int r = s->t->reopen(s->t->ctx);
+        if (r < 0)
+            return r;
+    }
+    s->io.ctx = s->t->ctx;      // reopen이 handle 바꿈
+    s730b_recover_init(&rc);
+    return s730b_proto_init_recover(&s->io, &rc, &st);
+}
+
+// 요청 하나 실행, lock 없이, 리턴 1 = 장치 빠져서 못 끝냄
+static int session_run(struct s730b_session *s, struct s730b_session_req *req) {
+    s730b_recover_init(&req->rc);
+    memset(&req->st, 0, sizeof(req->st));
+    switch (req->kind) {
+    case SESSION_INIT:
+        req->result = s730b_proto_init_recover(&s->io, &req->rc, &req->st);
+        break;
+    case SESSION_CAPTURE:
+        req->result = s730b_proto_capture_recover(&s->io, req->packets, req->flags, req->buf, req->cap, &req->rc,
+                                                  &req->st);
+        break;
+    default:
+        req->result = s730b_proto_capture(&s->io, req->packets, req->flags, req->buf, req->cap, &req->st);
+        break;
+    }
+    return req->result == S730B_ENODEV || req->st.err == S730B_ENODEV;
+}
+
+static void *session_main(void *arg) {
+    struct s730b_session *s = arg;
+
+    pthread_mutex_lock(&s->lock);
+    while (!s->stop) {
+        if (s->attached && !s->ready) {
+            uint64_t seq = s->attach_seq;
+            int need_open = s->need_open;
+            pthread_mutex_unlock(&s->lock);
+            int r = session_replay(s, need_open);
+            pthread_mutex_lock(&s->lock);
+            if (seq != s->attach_seq || !s->attached)
+                continue;       // 그 사이 또 빠졌다 붙음
+            if (r == 0) {
+                uint64_t now = session_now();
+                s->ready = 1;
+                s->need_open = 0;
+                if (s->attach_ns) {
+                    struct s730b_session_stats *x = &s->stats;
+                    x->reattaches++;
+                    x->reattach_ns_last = now - s->attach_ns;
+                    x->reattach_ns_sum += x->reattach_ns_last;
+                    if (x->reattach_ns_last > x->reattach_ns_max)
+                        x->reattach_ns_max = x->reattach_ns_last;
+                    x->outage_ns_last = s->detach_ns ? now - s->detach_ns : 0;
+                    if (x->outage_ns_last > x->outage_ns_max)
+                        x->outage_ns_max = x->outage_ns_last;
+                    s->attach_ns = 0;
+                }
+                continue;
+            }
+            // 열기 실패 = 못 찾음 -> 다음 붙음 이벤트까지, init 실패면 조금 쉬고 다시
+            s->stats.replay_failures++;
+            if (r == S730B_ENODEV) {
+                session_lost(s);
+            } else {
+                struct timespec ts;
+                session_deadline(&ts, SESSION_RETRY_MS);
+                pthread_cond_timedwait(&s->wake, &s->lock, &ts);
+            }
+            continue;
+        }
+
+        if (s->ready && s->n) {
+            struct s730b_session_req *req = s->queue[0];
+            uint64_t seq = s->attach_seq;
+            req->state = REQ_RUNNING;
+            pthread_mutex_unlock(&s->lock);
+            int lost = session_run(s, req);
+            pthread_mutex_lock(&s->lock);
+            if (lost) {
+                // 큐 맨 앞에 그대로, 붙으면 다시
+                req->state = REQ_QUEUED;
+                req->requeued++;
+                s->stats.requeued++;
+                if (seq == s->attach_seq)
+                    session_lost(s);
+                else
+                    s->ready = 0;   // 이미 다시 붙음 -> 바로 replay
+                pthread_cond_broadcast(&s->done);
+                continue;
+            }
+            queue_remove(s, 0);
+            req->state = REQ_DONE;
+            req->done_ns = session_now();
+            s->stats.completed++;
+            pthread_cond_broadcast(&s->done);
+            continue;
+        }
+
+        pthread_cond_wait(&s->wake, &s->lock);
+    }
+
+    // 남은 요청 실패로
+    while (s->n) {
+        s->queue[0]->result = S730B_ENODEV;
+        s->queue[0]->state = REQ_DONE;
+        queue_remove(s, 0);
+    }
+    pthread_cond_broadcast(&s->done);
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+int s730b_session_start(struct s730b_session *s, struct s730b_transport *t, int ready) {
+    pthread_condattr_t ca;
+
+    memset(s, 0, sizeof(*s));
+    s->t = t;
+    s->io = *t;
+    s->io.reopen = NULL;
+    s->attached = 1;
+    s->ready = ready;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&s->wake, &ca);
+    pthread_cond_init(&s->done, &ca);
+    pthread_condattr_destroy(&ca);
+    if (pthread_create(&s->thread, NULL, session_main, s) != 0) {
+        pthread_cond_destroy(&s->wake);
+        pthread_cond_destroy(&s->done);
+        pthread_mutex_destroy(&s->lock);
+        return -1;
+    }
+    s->running = 1;
+    return 0;
+}
+
+void s730b_session_stop(struct s730b_session *s) {
+    if (!s->running)
+        return;
+    pthread_mutex_lock(&s->lock);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+    pthread_cond_destroy(&s->wake);
+    pthread_cond_destroy(&s->done);
+    pthread_mutex_destroy(&s->lock);
+    s->running = 0;
+}
+
+void s730b_session_detached(struct s730b_session *s) {
+    pthread_mutex_lock(&s->lock);
+    session_lost(s);
+    pthread_cond_broadcast(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+}
+
+void s730b_session_attached(struct s730b_session *s) {
+    pthread_mutex_lock(&s->lock);
+    s->attach_seq++;
+    s->attached = 1;
+    s->ready = 0;
+    s->need_open = 1;
+    s->attach_ns = session_now();
+    pthread_cond_broadcast(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+}
+
+int s730b_session_submit(struct s730b_session *s, struct s730b_session_req *req, unsigned timeout_ms) {
+    struct timespec deadline;
+    int expired = 0;
+
+    req->state = REQ_QUEUED;
+    req->requeued = 0;
+    req->result = S730B_EIO;
+    req->submit_ns = session_now();
+    req->done_ns = 0;
+    if (timeout_ms)
+        session_deadline(&deadline, timeout_ms);
+
+    pthread_mutex_lock(&s->lock);
+    if (s->n == SESSION_QUEUE || s->stop) {
+        pthread_mutex_unlock(&s->lock);
+        return s->stop ? S730B_ENODEV : S730B_EOVERFLOW;
+    }
+    s->queue[s->n++] = req;
+    s->stats.requests++;
+    if (s->n > s->stats.queue_max)
+        s->stats.queue_max = s->n;
+    pthread_cond_broadcast(&s->wake);
+
+    while (req->state != REQ_DONE) {
+        // 시작 못 한 채로 시간 다 됨 -> 빼고 timeout (돌고 있으면 끝날 때까지, 그 사이 빠지면 그때 뺌)
+        if (expired && req->state == REQ_QUEUED) {
+            for (int i = 0; i < s->n; i++) {
+                if (s->queue[i] == req) {
+                    queue_remove(s, i);
+                    break;
+                }
+            }
+            req->result = S730B_ETIMEDOUT;
+            s->stats.timed_out++;
+            break;
+        }
+        int r = timeout_ms && !expired ? pthread_cond_timedwait(&s->done, &s->lock, &deadline)
+                                       : pthread_cond_wait(&s->done, &s->lock);
+        if (r == ETIMEDOUT)
+            expired = 1;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return req->result;
+}
+
+void s730b_session_get_stats(struct s730b_session *s, struct s730b_session_stats *out) {
+    pthread_mutex_lock(&s->lock);
+    *out = s->stats;
+    pthread_mutex_unlock(&s->lock);
+}
@@ -0,0 +1,93 @@
+/*
+ * s730b_session.h
+ *
+ * - 빠졌다 다시 꽂혀도 (USB reset, suspend/resume, 케이블) 안 죽는 센서 세션
+ * - 전송은 worker 스레드 하나만: init / 캡처 / probe 요청을 큐로 받아서 차례대로 (요청한 쪽은 끝날 때까지 기다림)
+ * - 장치 빠짐 / 붙음은 밖에서 알려줌 (드라이버 = libusb hotplug 콜백, 벤치 = 시뮬레이터)
+ *   - 빠지면 하던 요청은 큐 맨 앞에 그대로 두고, 붙으면 worker가 reopen (claim) + init 다시 한 뒤 이어서 처리
+ *   - 빠짐 이벤트보다 -4가 먼저 와도 똑같이 (붙음 이벤트 기다림)
+ * - 재연결 시간 = 붙음 이벤트 ~ init 끝 (reopen + claim + init), 빠짐 ~ 준비도 따로 셈
+ * - 시간은 CLOCK_MONOTONIC (시뮬레이터 가상 시계 아님, 빠져 있는 동안은 transfer가 없어서)
+ */
+
+#ifndef S730B_SESSION_H
+#define S730B_SESSION_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "s730b_proto.h"
+#include "s730b_transport.h"
+
+#define SESSION_QUEUE       16      // 한 번에 기다릴 수 있는 요청 수
+#define SESSION_RETRY_MS    100     // 붙었는데 reopen / init 실패하면 이만큼 쉬고 다시
+
+enum {
+    SESSION_INIT,       // init 다시 (s730b_proto_init_recover)
+    SESSION_CAPTURE,    // 프레임 (s730b_proto_capture_recover)
+    SESSION_PROBE,      // 감지 probe (s730b_proto_capture 한 번, 복구 안 함)
+};
+
+// 요청 하나 (요청한 쪽 스택에), 결과는 리턴 값 + st / rc
+struct s730b_session_req {
+    int kind;
+    int packets, flags;             // CAPTURE / PROBE
+    unsigned char *buf;
+    int cap;
+
+    int result;                     // init = 0, 캡처 / probe = 바이트, 음수 = 실패
+    struct s730b_proto_stats st;
+    struct s730b_recover rc;
+    int requeued;                   // 장치 빠져서 다시 한 횟수
+    uint64_t submit_ns, done_ns;
+    int state;
+};
+
+struct s730b_session_stats {
+    uint64_t requests, completed, timed_out;
+    uint64_t detaches, reattaches, replay_failures, requeued;
+    int queue_max;
+    uint64_t reattach_ns_last, reattach_ns_max, reattach_ns_sum;    // 붙음 ~ 준비
+    uint64_t outage_ns_last, outage_ns_max;                         // 빠짐 ~ 준비
+};
+
+struct s730b_session {
+    struct s730b_transport *t;
+    struct s730b_transport io;          // worker가 쓰는 복사본 (reopen 없음, 다시 열기는 worker가 붙음 뒤에만)
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake, done;
+    int running, stop;
+
+    int attached, ready, need_open;
+    uint64_t attach_seq;                // 붙음 이벤트 수 (-4 받았을 때 그 사이 붙었는지 보려고)
+    uint64_t detach_ns, attach_ns;
+
+    struct s730b_session_req *queue[SESSION_QUEUE];
+    int n;
+
+    struct s730b_session_stats stats;
+};
+
+/* worker 시작, ready = 1이면 이미 init 됨 (아니면 worker가 먼저 init), 0 = 성공, -1 = 스레드 실패 */
+int s730b_session_start(struct s730b_session *s, struct s730b_transport *t, int ready);
+
+/* 기다리던 요청 다 끝나면 worker 멈춤 (남은 요청은 S730B_ENODEV) */
+void s730b_session_stop(struct s730b_session *s);
+
+/* 장치 빠짐 / 붙음 (어느 스레드에서든, hotplug 콜백 안에서 불러도 됨 - 전송 안 함) */
+void s730b_session_detached(struct s730b_session *s);
+void s730b_session_attached(struct s730b_session *s);
+
+/*
+ * 요청 넣고 끝날 때까지 기다림, 리턴 = req->result
+ * - timeout_ms 안에 시작 못 하면 (장치 안 돌아옴) 큐에서 빼고 S730B_ETIMEDOUT, 0 = 무한
+ * - 큐 꽉 차면 S730B_EOVERFLOW
+ */
+int s730b_session_submit(struct s730b_session *s, struct s730b_session_req *req, unsigned timeout_ms);
+
+/* 통계 복사 (lock 잡고) */
+void s730b_session_get_stats(struct s730b_session *s, struct s730b_session_stats *out);
+
+#endif
@@ -0,0 +1,357 @@
+/*
+ * s730b_sim.c
+ *
+ * - 730B 센서 모델, 규칙은 s730b_sim.h 참고
+ * - 상태 하나 + 다음 init 명령 / packet 번호로 지금 받을 수 있는 transfer 정함
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "s730b_sim.h"
+
+enum {
+    SIM_OFF,        // 전원 들어옴, 0xC3 전
+    SIM_INIT,       // 0xC3 받음, init 명령 받는 중
+    SIM_READY,      // init 끝 / 프레임 끝
+    SIM_ARMED,      // 0xCA capture_indices[0]
+    SIM_STARTED,    // a8 06 받음, 상태 응답 대기
+    SIM_CHUNK,      // packet 끝 (chunk 0은 상태 응답 뒤), 다음 0xCA / bulk IN 대기
+    SIM_SELECTED,   // 0xCA capture_indices[packet], 데이터 대기
+    SIM_WAIT_ACK,   // 데이터 보냄, ACK 대기
+    SIM_HALT,       // 규칙 어김, 0xC3 전까지 응답 안 함
+};
+
+const char *const s730b_sim_fault_name[SIM_FAULTS] = { "stall", "timeout", "short", "disconnect" };
+
+static uint32_t sim_rand(struct s730b_sim *s) {
+    uint32_t x = s->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return s->rng = x;
+}
+
+// 장치 쪽 시간 (us), scale 만큼 진짜로 기다림
+static void sim_wait(struct s730b_sim *s, uint32_t us) {
+    if (s->timing.jitter_us)
+        us += sim_rand(s) % (s->timing.jitter_us + 1);
+    s->device_ns += (uint64_t)us * 1000;
+    if (s->timing.scale <= 0)
+        return;
+    uint64_t ns = (uint64_t)(us * 1000.0 * s->timing.scale);
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    nanosleep(&ts, NULL);
+}
+
+// 어긋난 transfer: 장치 멈춤 (다음 0xC3까지)
+static void sim_violation(struct s730b_sim *s, const char *what) {
+    s->violations++;
+    snprintf(s->last_violation, sizeof(s->last_violation), "%s", what);
+    s->state = SIM_HALT;
+}
+
+// 때가 아닌 bulk: NAK만 하다가 host timeout, 상태는 그대로
+static int sim_nak(struct s730b_sim *s, unsigned timeout_ms, const char *what) {
+    s->naks++;
+    s->violations++;
+    snprintf(s->last_violation, sizeof(s->last_violation), "%s", what);
+    sim_wait(s, timeout_ms * 1000);
+    return S730B_ETIMEDOUT;
+}
+
+// 주입할 fault (-1 = 없음), 걸어둔 한 번짜리 먼저
+static int sim_roll(struct s730b_sim *s, int at, int index) {
+    if (s->arm_fault >= 0 && s->arm_at == at && s->arm_index == index) {
+        int f = s->arm_fault;
+        s->arm_fault = -1;
+        return f;
+    }
+    for (int f = 0; f < SIM_FAULTS; f++) {
+        double p = s->fault_prob[at][f];
+        if (p > 0 && sim_rand(s) < p * 4294967296.0)
+            return f;
+    }
+    return -1;
+}
+
+// SHORT 말고 fault면 적용하고 리턴 값, 아니면 1
+static int sim_fault(struct s730b_sim *s, int f, int ep, uint32_t us, unsigned timeout_ms) {
+    switch (f) {
+    case SIM_FAULT_STALL:
+        // bulk endpoint는 clear_halt까지 계속 stall (control은 이번 것만)
+        s->faults[f]++;
+        if (ep)
+            s->halted |= 1u << (ep & 0x0f) << (ep & 0x80 ? 16 : 0);
+        sim_wait(s, us);
+        return S730B_EPIPE;
+    case SIM_FAULT_TIMEOUT:
+        s->faults[f]++;
+        sim_wait(s, timeout_ms * 1000);
+        return S730B_ETIMEDOUT;
+    case SIM_FAULT_DISCONNECT:
+        s->faults[f]++;
+        s->gone = 1;
+        return S730B_ENODEV;
+    }
+    return 1;
+}
+
+static int sim_control(void *ctx, uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+                       unsigned char *data, uint16_t len, unsigned timeout_ms) {
+    struct s730b_sim *s = ctx;
+    if (__atomic_load_n(&s->gone, __ATOMIC_RELAXED))
+        return S730B_ENODEV;
+    s->transfers++;
+
+    int at = request == 0xC3 ? PROTO_AT_C3 : request == 0xCA ? PROTO_AT_CA : PROTO_AT_NONE;
+    int idx = at == PROTO_AT_CA && index != s730b_capture_indices[0] ? s->packet + 1 : 0;
+    int r = sim_fault(s, sim_roll(s, at, idx), 0, s->timing.ctrl_us, timeout_ms);
+    if (r <= 0)
+        return r;
+    sim_wait(s, s->timing.ctrl_us);
+
+    if (request_type != 0x40 || at == PROTO_AT_NONE)
+        return S730B_EPIPE;
+
+    if (request == 0xC3) {
+        if (len != sizeof(s730b_c3_data) || !data || memcmp(data, s730b_c3_data, len) != 0) {
+            sim_violation(s, "0xC3 설정 다름");
+            return len;
+        }
+        s->state = SIM_INIT;
+        s->init_pos = 0;
+        return len;
+    }
+
+    // 0xCA: chunk 0이면 캡처 새로 시작, 아니면 다음 packet 순서대로
+    if (value != 0x0003) {
+        sim_violation(s, "0xCA wValue 다름");
+    } else if (index == s730b_capture_indices[0]) {
+        if (s->state < SIM_READY || s->state == SIM_HALT) {
+            sim_violation(s, "init 전 0xCA");
+            return 0;
+        }
+        s->state = SIM_ARMED;
+        s->packet = 0;
+        s->frame = s->finger && s->nframes ? s->next_frame++ % s->nframes : -1;
+    } else if (s->state == SIM_CHUNK && s->packet + 1 < S730B_NUM_PACKETS &&
+               index == s730b_capture_indices[s->packet + 1]) {
+        s->packet++;
+        s->state = SIM_SELECTED;
+    } else if (s->state != SIM_HALT) {
+        sim_violation(s, "0xCA wIndex 순서 어긋남");
+    }
+    return 0;
+}
+
+static int sim_bulk_out(struct s730b_sim *s, const unsigned char *data, int len, int *transferred,
+                        unsigned timeout_ms) {
+    int at = s->state == SIM_INIT ? PROTO_AT_INIT : s->state == SIM_ARMED ? PROTO_AT_START
+             : s->state == SIM_WAIT_ACK ? PROTO_AT_ACK : PROTO_AT_NONE;
+    uint32_t us = at == PROTO_AT_INIT ? s->timing.cmd_us : at == PROTO_AT_START ? s->timing.start_us : s->timing.ack_us;
+    int r = sim_fault(s, sim_roll(s, at, at == PROTO_AT_INIT ? s->init_pos : at == PROTO_AT_ACK ? s->packet : 0),
+                      S730B_EP_OUT, us, timeout_ms);
+    if (r <= 0)
+        return r;
+
+    switch (s->state) {
+    case SIM_INIT: {
+        const struct s730b_cmd *c = &s730b_init_cmds[s->init_pos];
+        sim_wait(s, us);
+        if ((size_t)len != c->len || memcmp(data, c->data, c->len) != 0) {
+            sim_violation(s, "init 명령 순서 / 내용 다름");
+        } else if (++s->init_pos == (int)s730b_init_cmds_len) {
+            s->state = SIM_READY;
+        }
+        *transferred = len;
+        return 0;
+    }
+    case SIM_ARMED:
+        sim_wait(s, us);
+        if (len != S730B_CHUNK || data[0] != 0xa8 || data[1] != 0x06)
+            sim_violation(s, "0xCA 뒤 시작 명령 아님");
+        else
+            s->state = SIM_STARTED;
+        *transferred = len;
+        return 0;
+    case SIM_WAIT_ACK:
+        sim_wait(s, us);
+        for (int i = 0; i < len; i++) {
+            if (data[i]) {
+                sim_violation(s, "ACK가 0 아님");
+                *transferred = len;
+                return 0;
+            }
+        }
+        if (len != S730B_CHUNK) {
+            sim_violation(s, "ACK 길이 다름");
+        } else if (s->packet + 1 == S730B_NUM_PACKETS) {
+            s->frames_done++;
+            s->state = SIM_READY;
+        } else {
+            s->state = SIM_CHUNK;
+        }
+        *transferred = len;
+        return 0;
+    }
+    return sim_nak(s, timeout_ms, s->state == SIM_CHUNK && s->packet == 0 ? "chunk 0 뒤 ACK" : "받을 때 아닌 bulk OUT");
+}
+
+static int sim_bulk_in(struct s730b_sim *s, unsigned char *data, int len, int *transferred, unsigned timeout_ms) {
+    int at = s->state == SIM_STARTED ? PROTO_AT_STATUS
+             : s->state == SIM_SELECTED || s->state == SIM_CHUNK ? PROTO_AT_DATA : PROTO_AT_NONE;
+    int f = sim_roll(s, at, at == PROTO_AT_DATA ? s->packet + (s->state == SIM_CHUNK) : 0);
+    int r = sim_fault(s, f, S730B_EP_IN, at == PROTO_AT_STATUS ? s->timing.status_us : s->timing.data_us, timeout_ms);
+    if (r <= 0)
+        return r;
+
+    if (s->state == SIM_STARTED) {
+        int n = s->frame >= 0 ? s->status_len[s->frame] : 0;
+        sim_wait(s, s->timing.status_us);
+        if (f == SIM_FAULT_SHORT) {
+            s->faults[f]++;
+            n = n ? n - 1 : 0;
+        }
+        if (n > len)
+            return S730B_EOVERFLOW;
+        if (n)
+            memcpy(data, s->status[s->frame], n);
+        *transferred = n;
+        s->state = SIM_CHUNK;
+        return 0;
+    }
+
+    // 0xCA 없이 bulk IN이면 다음 packet (Windows 드라이버 방식)
+    if (s->state == SIM_CHUNK && s->packet + 1 < S730B_NUM_PACKETS) {
+        s->packet++;
+        s->state = SIM_SELECTED;
+    }
+    if (s->state != SIM_SELECTED)
+        return sim_nak(s, timeout_ms, "보낼 데이터 없는데 bulk IN");
+
+    sim_wait(s, s->timing.data_us);
+    if (len < S730B_CHUNK)
+        return S730B_EOVERFLOW;
+    const unsigned char *src = s->frame >= 0 ? s->frames[s->frame] : s->blank;
+    int n = S730B_CHUNK;
+    if (f == SIM_FAULT_SHORT) {
+        s->faults[f]++;
+        n = 1 + (int)(sim_rand(s) % (S730B_CHUNK - 1));
+    }
+    memcpy(data, src + (s->packet - 1) * S730B_CHUNK, n);
+    *transferred = n;
+    s->state = SIM_WAIT_ACK;
+    return 0;
+}
+
+static int sim_bulk(void *ctx, unsigned char ep, unsigned char *data, int len, int *transferred,
+                    unsigned timeout_ms) {
+    struct s730b_sim *s = ctx;
+    if (__atomic_load_n(&s->gone, __ATOMIC_RELAXED))
+        return S730B_ENODEV;
+    s->transfers++;
+    if (s->halted & (1u << (ep & 0x0f) << (ep & 0x80 ? 16 : 0))) {
+        sim_wait(s, s->timing.ctrl_us);
+        return S730B_EPIPE;
+    }
+    if (ep == S730B_EP_OUT)
+        return sim_bulk_out(s, data, len, transferred, timeout_ms);
+    if (ep == S730B_EP_IN)
+        return sim_bulk_in(s, data, len, transferred, timeout_ms);
+    return S730B_EPIPE;
+}
+
+void s730b_sim_init(struct s730b_sim *s, uint32_t seed) {
+    memset(s, 0, sizeof(*s));
+    s->timing = (struct s730b_sim_timing){
+        .ctrl_us = 160, .cmd_us = 60, .start_us = 590, .status_us = 100, .data_us = 950, .ack_us = 700,
+        .enum_us = 300000, .jitter_us = 0, .scale = 1.0,
+    };
+    s->finger = 1;
+    s->frame = -1;
+    s->arm_fault = -1;
+    s->rng = seed ? seed : 0x730b;
+}
+
+int s730b_sim_load(struct s730b_sim *s, const char *path, int blank) {
+    unsigned char buf[S730B_FRAME_BYTES + 8];
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return -1;
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+
+    // C 드라이버 capture.raw는 데이터만, python 쪽은 앞에 상태 응답 2B
+    int status = (int)n - S730B_FRAME_BYTES;
+    if (status < 0 || status > 2)
+        return -1;
+    if (blank) {
+        memcpy(s->blank, buf + status, S730B_FRAME_BYTES);
+        return 0;
+    }
+    if (s->nframes == SIM_MAX_FRAMES)
+        return -1;
+    memcpy(s->frames[s->nframes], buf + status, S730B_FRAME_BYTES);
+    memcpy(s->status[s->nframes], buf, status);
+    s->status_len[s->nframes] = status;
+    s->nframes++;
+    return 0;
+}
+
+static int sim_clear_halt(void *ctx, unsigned char ep) {
+    struct s730b_sim *s = ctx;
+    if (__atomic_load_n(&s->gone, __ATOMIC_RELAXED))
+        return S730B_ENODEV;
+    sim_wait(s, s->timing.ctrl_us);
+    s->halted &= ~(1u << (ep & 0x0f) << (ep & 0x80 ? 16 : 0));
+    return 0;
+}
+
+// 다시 꽂고 다시 열기: 열거 시간만큼 걸림
+static int sim_reopen(void *ctx) {
+    struct s730b_sim *s = ctx;
+    sim_wait(s, s->timing.enum_us);
+    s730b_sim_replug(s);
+    return 0;
+}
+
+// 가상 시계 = 장치 쪽 시간 합 (scale 상관없이 같은 타임라인)
+static uint64_t sim_now(void *ctx) {
+    return ((struct s730b_sim *)ctx)->device_ns;
+}
+
+void s730b_sim_transport(struct s730b_sim *s, struct s730b_transport *t) {
+    t->ctx = s;
+    t->control = sim_control;
+    t->bulk = sim_bulk;
+    t->clear_halt = sim_clear_halt;
+    t->reopen = sim_reopen;
+    t->now_ns = sim_now;
+}
+
+void s730b_sim_set_fault(struct s730b_sim *s, int at, int fault, double prob) {
+    for (int a = 0; a < PROTO_AT_KINDS; a++) {
+        if (at == PROTO_AT_NONE || a == at)
+            s->fault_prob[a][fault] = prob;
+    }
+}
+
+void s730b_sim_arm(struct s730b_sim *s, int at, int index, int fault) {
+    s->arm_at = at;
+    s->arm_index = index;
+    s->arm_fault = fault;
+}
+
+void s730b_sim_unplug(struct s730b_sim *s) {
+    __atomic_store_n(&s->gone, 1, __ATOMIC_RELAXED);
+}
+
+void s730b_sim_replug(struct s730b_sim *s) {
+    s->halted = 0;
+    s->state = SIM_OFF;
+    s->init_pos = 0;
+    s->packet = 0;
+    __atomic_store_n(&s->gone, 0, __ATOMIC_RELEASE);
+}
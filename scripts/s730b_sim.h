@@ -0,0 +1,105 @@
+/*
+ * s730b_sim.h
+ *
+ * - 730B 센서 모델 (s730b_transport 구현): 장치 없이 프로토콜 코드(s730b_proto) 돌려보기 / 벤치 / 오류 시험
+ * - 트레이스(pcapng/)랑 docs/s730b_test_history.c에서 본 규칙대로 상태 따라감:
+ *   1) 0xC3 (16B 설정 그대로) -> init_cmds 47개 순서대로 -> 준비 (0xC3는 언제든 받음, 처음부터 다시)
+ *   2) 0xCA capture_indices[0] -> a8 06 시작 (256B) -> bulk IN 상태 응답 0~2B, ACK 없음
+ *   3) packet i: 0xCA capture_indices[i] (순서대로) -> bulk IN 256B -> ACK 256B (0) -> 다음
+ *      (Windows처럼 0xCA 없이 bulk IN 하면 다음 packet으로 넘어감)
+ * - 어긋나면 두 가지:
+ *   - 때가 아닌 bulk (chunk 0 뒤 ACK 등): 장치가 NAK만 -> timeout_ms 걸리고 -7, 상태는 그대로
+ *     (python-capture.pcapng chunk 0 ACK 500ms timeout 그대로)
+ *   - 틀린 0xC3 / init 명령 / 0xCA 순서 / 0 아닌 ACK: 장치 멈춤 -> 다음 0xC3까지 bulk 전부 timeout
+ * - 프레임은 sample/ 밑 raw (84 chunk, 앞 0~2B는 상태 응답으로), 손가락 없으면 blank 프레임
+ * - transfer마다 걸리는 시간 (진짜로 기다림, scale로 줄임 / 0이면 안 기다림) + 지점별 오류 주입 확률
+ * - transport now_ns = 장치 쪽 시간 합 (가상 시계), clear_halt / reopen (열거 시간 걸리고 replug)도 있음
+ */
+
+#ifndef S730B_SIM_H
+#define S730B_SIM_H
+
+#include <stdint.h>
+
+#include "s730b_proto.h"
+#include "s730b_transport.h"
+
+#define SIM_MAX_FRAMES 16
+
+enum {
+    SIM_FAULT_STALL,        // -9, transfer 안 일어남, bulk endpoint는 clear_halt까지 계속 -9
+    SIM_FAULT_TIMEOUT,      // timeout_ms 기다리고 -7, transfer 안 일어남
+    SIM_FAULT_SHORT,        // bulk IN만: 1~255B만 주고 다음으로 넘어감
+    SIM_FAULT_DISCONNECT,   // 장치 빠짐, s730b_sim_replug 전까지 전부 -4
+    SIM_FAULTS,
+};
+
+extern const char *const s730b_sim_fault_name[SIM_FAULTS];
+
+// transfer 하나 걸리는 시간 (us), 기본값은 python-capture.pcapng 평균
+struct s730b_sim_timing {
+    uint32_t ctrl_us;       // 0xC3 / 0xCA
+    uint32_t cmd_us;        // init 명령
+    uint32_t start_us;      // a8 06 시작
+    uint32_t status_us;     // chunk 0 상태 응답
+    uint32_t data_us;       // 256B bulk IN
+    uint32_t ack_us;        // ACK
+    uint32_t enum_us;       // reopen (다시 꽂고 열거)
+    uint32_t jitter_us;     // 0 ~ jitter 더함
+    double scale;           // 기다리는 시간 배율 (timeout 포함), 0 = 안 기다리고 시간만 셈
+};
+
+struct s730b_sim {
+    // 설정
+    struct s730b_sim_timing timing;
+    double fault_prob[PROTO_AT_KINDS][SIM_FAULTS];
+    int finger;                                 // 1 = 손가락 (frames), 0 = blank
+
+    // 프레임
+    unsigned char frames[SIM_MAX_FRAMES][S730B_FRAME_BYTES];
+    unsigned char status[SIM_MAX_FRAMES][2];
+    int status_len[SIM_MAX_FRAMES];
+    int nframes, next_frame;
+    unsigned char blank[S730B_FRAME_BYTES];
+
+    // 상태
+    int state;
+    int init_pos;                               // 다음 init 명령 번호
+    int packet;                                 // 지금 packet (capture_indices 번호)
+    int frame;                                  // 지금 보내는 프레임 (-1 = blank)
+    int gone;                                   // 빠짐 (SIM_FAULT_DISCONNECT)
+    uint32_t halted;                            // stall 걸린 bulk endpoint (OUT bit n, IN bit 16 + n)
+    int arm_at, arm_index, arm_fault;           // 한 번짜리 fault (s730b_sim_arm, -1 = 없음)
+    uint32_t rng;
+
+    // 통계
+    uint64_t transfers, frames_done, violations, naks;
+    uint64_t faults[SIM_FAULTS];
+    uint64_t device_ns;                         // 장치 쪽 시간 합 (scale 적용 전)
+    char last_violation[96];
+};
+
+void s730b_sim_init(struct s730b_sim *s, uint32_t seed);
+
+/* raw 하나 프레임으로 추가 (blank = 1이면 손가락 없을 때 프레임), 0 = 성공, -1 = 파일 / 길이 오류 */
+int s730b_sim_load(struct s730b_sim *s, const char *path, int blank);
+
+/* s730b_proto에 넘길 transport */
+void s730b_sim_transport(struct s730b_sim *s, struct s730b_transport *t);
+
+/* at 지점 (PROTO_AT_*, PROTO_AT_NONE = 전부) transfer마다 fault 확률 */
+void s730b_sim_set_fault(struct s730b_sim *s, int at, int fault, double prob);
+
+/*
+ * 다음에 at 지점 index번째 (init = 명령 번호, 0xCA / 데이터 / ACK = packet, 나머지 0) transfer에 fault 한 번
+ * - 확률 fault보다 먼저, 걸리면 풀림 (SIM_FAULT_SHORT는 상태 응답 / 데이터에만 먹음)
+ */
+void s730b_sim_arm(struct s730b_sim *s, int at, int index, int fault);
+
+/* 장치 뽑음 (다른 스레드에서 불러도 됨, 하던 transfer 다음부터 -4) */
+void s730b_sim_unplug(struct s730b_sim *s);
+
+/* 빠졌던 장치 다시 꽂음: 전원 처음 상태 (0xC3부터) */
+void s730b_sim_replug(struct s730b_sim *s);
+
+#endif
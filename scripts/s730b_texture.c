@@ -0,0 +1,129 @@
+/*
+ * s730b_texture.c
+ *
+ * - probe 줄을 16px 셀로 나눠 gradient 에너지 (SSE2 SAD) / 융선 주기 / 밝기 entropy
+ * - 셋 다 통과한 셀 비율 = coverage, entropy용 log 표는 처음 쓸 때 만듦
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "s730b_texture.h"
+
+#define TEX_MAX_ROWS     32
+#define TEX_MAX_COUNT    (TEXTURE_CELL * TEX_MAX_ROWS)
+#define TEX_DEADZONE     8          // 셀 평균에서 이만큼은 벗어나야 위/아래로 셈
+#define TEX_MIN_GRAD     (6 * 16)   // px당 gradient 최소 (Q4)
+#define TEX_MIN_ENTROPY  (1 * 256)  // entropy 최소 (Q8 bit)
+#define TEX_MIN_PERIOD   (4 * 16)   // 융선 주기 범위 (Q4 px), 짧으면 먼지/노이즈
+#define TEX_MAX_PERIOD   (24 * 16)  // 길면 얼룩/물 막 가장자리 (한쪽으로만 밝기 변함)
+
+// c * log2(c) (Q8), entropy = log2(N) - sum(c log2 c) / N
+static int32_t clog_lut[TEX_MAX_COUNT + 1];
+static pthread_once_t clog_once = PTHREAD_ONCE_INIT;
+
+static void clog_init(void) {
+    for (int c = 1; c <= TEX_MAX_COUNT; c++)
+        clog_lut[c] = (int32_t)lrint(c * log2((double)c) * 256.0);
+}
+
+// sum |a[i] - b[i]|, 16개
+static inline int sad16(const unsigned char *a, const unsigned char *b) {
+#ifdef __SSE2__
+    __m128i s = _mm_sad_epu8(_mm_loadu_si128((const __m128i *)a), _mm_loadu_si128((const __m128i *)b));
+    return _mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+#else
+    int s = 0;
+    for (int i = 0; i < 16; i++)
+        s += abs(a[i] - b[i]);
+    return s;
+#endif
+}
+
+static inline int sum16(const unsigned char *a) {
+    static const unsigned char zero[16];
+    return sad16(a, zero);
+}
+
+int s730b_texture_classify(const unsigned char *img, int len, int w, struct s730b_texture *t) {
+    int rows = w > 0 ? len / w : 0;
+    const int ncell = w / TEXTURE_CELL;
+    int textured = 0;
+    long grad = 0, period = 0, entropy = 0;
+
+    memset(t, 0, sizeof(*t));
+    if (!img || rows < 2 || w % TEXTURE_CELL)
+        return -1;
+    if (rows > TEX_MAX_ROWS)
+        rows = TEX_MAX_ROWS;
+    pthread_once(&clog_once, clog_init);
+
+    const int npx = TEXTURE_CELL * rows;
+    for (int c = 0; c < ncell; c++) {
+        const int x0 = c * TEXTURE_CELL;
+        // 줄 안에서만 차분: 첫 셀은 x[i+2]-x[i], 나머지는 x[i]-x[i-2]
+        const int d = c == 0 ? 2 : -2;
+        int gsum = 0, sum = 0;
+
+        for (int y = 0; y < rows; y++) {
+            const unsigned char *p = img + (size_t)y * w + x0;
+            gsum += sad16(p, p + d);
+            sum += sum16(p);
+            if (y + 1 < rows)
+                gsum += sad16(p, p + w);
+        }
+
+        int hist[16] = {0}, flips = 0;
+        int colside[TEXTURE_CELL] = {0};
+        const int mean = sum / npx;
+        for (int y = 0; y < rows; y++) {
+            const unsigned char *p = img + (size_t)y * w + x0;
+            int side = 0;
+            for (int i = 0; i < TEXTURE_CELL; i++) {
+                int v = p[i];
+                hist[v >> 4]++;
+                int s = v > mean + TEX_DEADZONE ? 1 : v < mean - TEX_DEADZONE ? -1 : 0;
+                if (!s)
+                    continue;
+                // 가로(줄 따라) + 세로(열 따라) 둘 다 셈 -> 융선 방향 상관없이
+                flips += side && s != side;
+                flips += colside[i] && s != colside[i];
+                side = s;
+                colside[i] = s;
+            }
+        }
+
+        int ent = 0;
+        for (int b = 0; b < 16; b++)
+            ent += clog_lut[hist[b]];
+        ent = (int)((clog_lut[npx] - ent) / npx);
+
+        const int g = gsum * 16 / npx;
+        // 지나간 길이 = 가로 npx + 세로 npx, 한 주기에 두 번 바뀜
+        const int per = flips ? 4 * npx * 16 / flips : TEX_MAX_PERIOD + 1;
+        if (g < TEX_MIN_GRAD || ent < TEX_MIN_ENTROPY || per < TEX_MIN_PERIOD || per > TEX_MAX_PERIOD)
+            continue;
+
+        textured++;
+        grad += g;
+        entropy += ent;
+        period += per;
+    }
+
+    t->coverage = (double)textured / ncell;
+    if (textured) {
+        t->grad = grad / 16.0 / textured;
+        t->period = period / 16.0 / textured;
+        t->entropy = entropy / 256.0 / textured;
+    }
+    t->present = t->coverage >= TEXTURE_MIN_COVERAGE;
+    t->graze = t->present && t->coverage < TEXTURE_FULL_COVERAGE;
+    return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * s730b_texture.h
+ *
+ * - 감지 probe (캡처 앞쪽 chunk 몇 개 = 이미지 윗줄 몇 줄)에 지문 무늬가 있는지 보는 분류기
+ * - has_fingerprint_in_detect()는 0x00/0xFF 개수만 세서 젖은 센서(0xFF 범벅) / 더러운 센서 / 살짝 스친 손가락
+ *   (half.raw)에서 틀림 -> 무늬 자체를 봄
+ * - probe 줄들을 16px 폭 셀로 나눠서 셀마다 세 가지 (전부 정수, gradient는 SSE2 psadbw)
+ *   1) gradient 에너지: 가로 |x[i+2] - x[i]| + 세로 |윗줄 - 아랫줄| (평평한 빈 센서 / 0xFF 범벅이면 0 근처)
+ *   2) 융선 주기: 셀 평균 기준 위/아래가 바뀌는 간격, 가로/세로 둘 다
+ *      (지문이면 5~16px, 먼지 점은 짧고 얼룩/물 막 가장자리는 한 번만 바뀌어서 김)
+ *   3) 밝기 히스토그램 entropy (융선/골이 섞여 있어야 높음)
+ * - 셋 다 통과한 셀 비율 = coverage -> 손가락 있음 + 스침(graze) 판정
+ */
+
+#ifndef S730B_TEXTURE_H
+#define S730B_TEXTURE_H
+
+#define TEXTURE_CELL          16
+#define TEXTURE_MIN_COVERAGE  0.15  // 이만큼 무늬 셀 있으면 손가락 있음 (112폭이면 셀 2개)
+#define TEXTURE_FULL_COVERAGE 0.45  // 이보다 적으면 스침 (풀 캡처해도 half.raw 같은 프레임)
+
+struct s730b_texture {
+    int present;        // 손가락 있음
+    int graze;          // present인데 coverage < TEXTURE_FULL_COVERAGE
+    double coverage;    // 무늬 셀 비율 (0..1)
+    double grad;        // 무늬 셀 평균 gradient (px당)
+    double period;      // 무늬 셀 평균 융선 주기 (px)
+    double entropy;     // 무늬 셀 평균 entropy (bit, 최대 4)
+};
+
+/*
+ * img = probe의 이미지 부분 (raw의 IMG_OFFSET부터), len 바이트를 w폭 줄로 봄 (남는 바이트 버림)
+ * - 0 = 성공, -1 = 줄이 2개 미만이거나 w가 TEXTURE_CELL 배수 아님
+ */
+int s730b_texture_classify(const unsigned char *img, int len, int w, struct s730b_texture *t);
+
+#endif
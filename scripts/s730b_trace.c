@@ -0,0 +1,811 @@
+/*
+ * s730b_trace.c
+ *
+ * - usbmon / USBPcap 캡처 파일(pcapng, pcap)을 스트리밍으로 읽어서 730B transfer 흐름 복원 (s730b_usbtrace)
+ * - 사용법: ./s730b_trace extract [옵션] 파일... / ./s730b_trace diff A B
+ *   -> transfer 종류별 걸린 시간 / 앞 transfer와 간격 (p50/p99/max), 캡처(프레임 / 감지 probe) 통계
+ *   -> -o DIR 이면 프레임 / probe를 raw로, --log DIR 이면 캡처 로그(s730b_caplog)로 (감지 통계 meta 포함)
+ * - diff: 트레이스 두 개를 구간(init / capture / idle)별로 짝 맞춰서 시간 차이, host 간격, 프로토콜 차이
+ * - 메모리는 파일 크기랑 상관없이 고정 (read 버퍼 1MB + 히스토그램 + 캡처 2개, diff는 구간 하나씩)
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "s730b_caplog.h"
+#include "s730b_frame.h"
+#include "s730b_usbtrace.h"
+
+#define HIST_SHIFT   4
+#define HIST_SUB     (1 << HIST_SHIFT)  // 2배마다 칸 16개 (오차 약 3%)
+#define HIST_BUCKETS (64 * HIST_SUB)
+
+/* ---------------- 시간 히스토그램 (로그 칸, 메모리 고정) ---------------- */
+
+struct hist {
+    uint64_t n, sum, max;
+    uint32_t b[HIST_BUCKETS];
+};
+
+static int hist_bucket(uint64_t v) {
+    if (v < HIST_SUB)
+        return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    return (msb - HIST_SHIFT + 1) * HIST_SUB + (int)((v >> (msb - HIST_SHIFT)) & (HIST_SUB - 1));
+}
+
+// 칸 가운데 값
+static uint64_t hist_value(int k) {
+    if (k < HIST_SUB)
+        return (uint64_t)k;
+    int sh = k / HIST_SUB - 1;
+    uint64_t lo = (uint64_t)(HIST_SUB + k % HIST_SUB) << sh;
+    return lo + ((1ull << sh) >> 1);
+}
+
+static void hist_add(struct hist *h, uint64_t v) {
+    h->n++;
+    h->sum += v;
+    if (v > h->max)
+        h->max = v;
+    h->b[hist_bucket(v)]++;
+}
+
+static uint64_t hist_pct(const struct hist *h, double p) {
+    uint64_t want = (uint64_t)(h->n * p), seen = 0;
+    for (int k = 0; k < HIST_BUCKETS; k++) {
+        seen += h->b[k];
+        if (seen > want)
+            return hist_value(k) < h->max ? hist_value(k) : h->max;
+    }
+    return h->max;
+}
+
+// us 단위 한 줄: n avg p50 p99 max
+static void hist_print(const char *name, const struct hist *h) {
+    if (!h->n)
+        return;
+    printf("    %-12s %8llu %9.1f %9.1f %9.1f %9.1f\n", name, (unsigned long long)h->n, h->sum / 1e3 / h->n,
+           hist_pct(h, 0.5) / 1e3, hist_pct(h, 0.99) / 1e3, h->max / 1e3);
+}
+
+/* ---------------- extract ---------------- */
+
+struct extract_opts {
+    const char *outdir;
+    const char *log_dir;
+    int log_flags;
+    int bus, dev;           // dev < 0 = 자동
+    int transfers;          // transfer마다 한 줄
+    long frame_no, probe_no;    // 출력 파일 번호 (입력 파일 여러 개면 이어서)
+};
+
+struct extract_stats {
+    struct hist dur[XF_KINDS];
+    struct hist gap[XF_KINDS];
+    struct hist frame_us, probe_us, chunk_us, wait_us;
+    long frames, complete, probes, short_frames, err_frames;
+    long probes_since;              // 마지막 프레임 뒤 probe 수
+    uint64_t first_probe;           // 그 첫 probe 시작
+};
+
+static int write_raw(const char *dir, const char *kind, long n, const unsigned char *buf, int len) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s_%06ld.raw", dir, kind, n);
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return -1;
+    size_t k = fwrite(buf, 1, (size_t)len, f);
+    return fclose(f) == 0 && k == (size_t)len ? 0 : -1;
+}
+
+static int on_capture(struct extract_opts *o, struct extract_stats *st, struct s730b_caplog *log,
+                      const struct s730b_capture *c) {
+    uint64_t dur = c->t_end - c->t_start;
+
+    if (c->probe) {
+        if (st->probes_since++ == 0)
+            st->first_probe = c->t_start;
+        hist_add(&st->probe_us, dur);
+        if (o->outdir && write_raw(o->outdir, "probe", o->probe_no++, c->data, c->len) < 0)
+            return -1;
+        st->probes++;
+        return 0;
+    }
+
+    int expected = c->chunks > TRACE_IMAGE_CHUNKS ? TRACE_FULL_CHUNKS : TRACE_IMAGE_CHUNKS;
+    int complete = c->chunks == expected && !c->errors && !c->short_chunks;
+    st->frames++;
+    st->complete += complete;
+    st->short_frames += c->short_chunks > 0;
+    st->err_frames += c->errors > 0;
+    hist_add(&st->frame_us, dur);
+    hist_add(&st->chunk_us, (uint64_t)c->chunk_max_us * 1000);
+    uint64_t wait = st->probes_since ? c->t_start - st->first_probe : 0;
+    if (st->probes_since)
+        hist_add(&st->wait_us, wait);
+
+    if (o->outdir && write_raw(o->outdir, "frame", o->frame_no++, c->data, c->len) < 0)
+        return -1;
+    if (log) {
+        struct s730b_caplog_meta m = { 0 };
+        m.ts_ns = c->t_start;
+        m.quality = -1;
+        m.flags = (complete ? CAPLOG_COMPLETE : 0) | (c->short_chunks ? CAPLOG_SHORT_CHUNK : 0);
+        m.chunks_expected = (uint16_t)expected;
+        m.chunks_received = (uint16_t)c->chunks;
+        m.detect_probes = (uint16_t)(st->probes_since > 0xffff ? 0xffff : st->probes_since);
+        m.wait_us = (uint32_t)(wait / 1000);
+        m.capture_us = (uint32_t)(dur / 1000);
+        m.chunk_max_us = c->chunk_max_us;
+        m.chunk_avg_us = c->chunk_avg_us;
+        // 오프라인이니까 버리지 말고 writer 따라잡을 때까지 기다림
+        while (s730b_caplog_append(log, c->data, c->len, &m) < 0) {
+            if (log->error || c->len > CAPLOG_MAX_FRAME)
+                return -1;
+            struct timespec ts = { 0, 1000 * 1000 };
+            nanosleep(&ts, NULL);
+        }
+    }
+    st->probes_since = 0;
+    return 0;
+}
+
+static int extract_file(struct extract_opts *o, const char *path, struct s730b_caplog *log) {
+    static struct s730b_pcap pc;
+    static struct s730b_xfer_tracker tr;
+    static struct s730b_capture_asm as;
+    static struct extract_stats st;
+    struct s730b_usb_pkt pkt;
+    struct s730b_xfer x;
+    const struct s730b_capture *done;
+    uint64_t t0_trace = 0;
+    int r;
+
+    if (s730b_pcap_open(&pc, path) < 0) {
+        fprintf(stderr, "[-] %s: pcap / pcapng 아님\n", path);
+        return -1;
+    }
+    s730b_xfer_init(&tr, o->bus, o->dev);
+    s730b_capture_init(&as);
+    memset(&st, 0, sizeof(st));
+
+    uint64_t t0 = s730b_now_ns();
+    while ((r = s730b_pcap_next(&pc, &pkt)) > 0) {
+        if (!s730b_xfer_feed(&tr, &pkt, &x))
+            continue;
+        if (!t0_trace)
+            t0_trace = x.t_submit;
+        hist_add(&st.dur[x.kind], x.t_complete - x.t_submit);
+        if (x.gap_ns)
+            hist_add(&st.gap[x.kind], x.gap_ns);
+        if (o->transfers)
+            printf("%.6f\t%s\t%02x\t%u\t%.1f\t%.1f\t%d\n", (x.t_submit - t0_trace) / 1e9,
+                   s730b_xfer_kind_name[x.kind], x.ep, x.len, (x.t_complete - x.t_submit) / 1e3, x.gap_ns / 1e3,
+                   x.status);
+        if (s730b_capture_feed(&as, &x, &done) && on_capture(o, &st, log, done) < 0) {
+            r = -1;
+            break;
+        }
+    }
+    if (r == 0 && s730b_capture_flush(&as, &done) && on_capture(o, &st, log, done) < 0)
+        r = -1;
+    uint64_t t1 = s730b_now_ns();
+    s730b_pcap_close(&pc);
+    if (r < 0) {
+        fprintf(stderr, "[-] %s: 깨진 블록 / 쓰기 실패 (%.1f MB 지점)\n", path, pc.bytes / 1e6);
+        return -1;
+    }
+
+    double sec = (t1 - t0) / 1e9;
+    printf("[+] %s: %.1f MB, packet %llu (모르는 것 %llu), 730B transfer %llu (짝 없음 %llu), %.3f s (%.0f MB/s)\n",
+           path, pc.bytes / 1e6, (unsigned long long)pc.packets, (unsigned long long)pc.skipped,
+           (unsigned long long)tr.transfers, (unsigned long long)tr.orphans, sec, pc.bytes / 1e6 / sec);
+    if (!tr.locked) {
+        printf("    730B 장치 못 찾음 (--dev BUS:DEV 로 지정)\n");
+        return 0;
+    }
+    printf("    장치 bus %u dev %u\n", tr.bus, tr.dev);
+    printf("    %-12s %8s %9s %9s %9s %9s   (transfer 걸린 시간, us)\n", "kind", "n", "avg", "p50", "p99", "max");
+    for (int k = 0; k < XF_KINDS; k++)
+        hist_print(s730b_xfer_kind_name[k], &st.dur[k]);
+    printf("    %-12s %8s %9s %9s %9s %9s   (앞 transfer 완료 ~ submit 간격, us)\n", "kind", "n", "avg", "p50", "p99",
+           "max");
+    for (int k = 0; k < XF_KINDS; k++)
+        hist_print(s730b_xfer_kind_name[k], &st.gap[k]);
+
+    printf("    프레임 %ld (완전 %ld, 짧은 chunk %ld, 오류 %ld), 감지 probe %ld\n", st.frames, st.complete,
+           st.short_frames, st.err_frames, st.probes);
+    printf("    %-12s %8s %9s %9s %9s %9s   (us)\n", "", "n", "avg", "p50", "p99", "max");
+    hist_print("frame", &st.frame_us);
+    hist_print("chunk max", &st.chunk_us);
+    hist_print("probe", &st.probe_us);
+    hist_print("probe->frame", &st.wait_us);
+    return 0;
+}
+
+static int cmd_extract(int argc, char **argv) {
+    struct extract_opts o = { .dev = -1 };
+    struct s730b_caplog log;
+    int nfiles = 0, failed = 0;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            o.outdir = argv[++i];
+        else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)
+            o.log_dir = argv[++i];
+        else if (strcmp(argv[i], "--log-compress") == 0)
+            o.log_flags = CAPLOG_OPEN_CODEC;
+        else if (strcmp(argv[i], "--dev") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d:%d", &o.bus, &o.dev) != 2)
+                return 1;
+        } else if (strcmp(argv[i], "--transfers") == 0)
+            o.transfers = 1;
+        else if (argv[i][0] == '-')
+            return 1;
+        else
+            argv[nfiles++] = argv[i];   // 앞으로 당겨서 파일 목록으로
+    }
+    if (nfiles == 0)
+        return 1;
+    if (o.outdir && mkdir(o.outdir, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "[-] %s 만들기 실패\n", o.outdir);
+        return 1;
+    }
+    if (o.log_dir && s730b_caplog_open(&log, o.log_dir, o.log_flags) < 0) {
+        fprintf(stderr, "[-] %s 캡처 로그 열기 실패\n", o.log_dir);
+        return 1;
+    }
+
+    for (int i = 0; i < nfiles; i++) {
+        if (extract_file(&o, argv[i], o.log_dir ? &log : NULL) < 0)
+            failed++;
+    }
+
+    if (o.log_dir) {
+        if (s730b_caplog_close(&log) < 0)
+            failed++;
+        printf("[+] 캡처 로그 %s: %llu개 기록, raw %.1f KB -> 파일 %.1f KB\n", o.log_dir,
+               (unsigned long long)log.written, log.raw_bytes / 1e3, log.bytes / 1e3);
+    }
+    return failed ? 2 : 0;
+}
+
+/* ---------------- diff ---------------- */
+
+#define DIFF_MAX_XFER   1024                    // 구간 하나에서 정렬할 transfer 최대 (넘으면 통계만)
+#define DIFF_WAIT_NS    (50ull * 1000 * 1000)   // 이 이상 간격은 host 오버헤드 아니고 대기 (손가락, 사용자)
+#define DIFF_SHOW       12                      // 구간마다 보여줄 차이 / 오류 줄 수
+#define DIFF_SIG        96
+
+enum { PH_INIT, PH_CAPTURE, PH_IDLE, PH_TYPES };
+
+static const char *const ph_name[PH_TYPES] = { "init", "capture", "idle" };
+
+struct diff_xfer {
+    uint64_t tok;               // 정렬 키: 종류 + control 요청 / 명령 앞 4B
+    uint64_t t_submit, t_complete, gap;
+    int32_t status;
+    uint8_t kind;
+};
+
+struct diff_phase {
+    int type;                   // PH_*
+    long no;                    // 같은 종류 안에서 번호 (1부터)
+    int n;                      // 저장한 transfer (DIFF_MAX_XFER까지)
+    long total;
+    uint64_t lead_gap;          // 앞 구간 끝 ~ 이 구간 첫 submit
+    uint64_t t_start, t_end;
+    uint64_t bus_ns, host_ns, wait_ns;
+    long data, errors;
+    int started;                // capture: 시작 명령 들어감
+    struct diff_xfer x[DIFF_MAX_XFER];
+};
+
+struct diff_sum {
+    long phases, transfers, data, errors;
+    uint64_t time, bus, host, wait;
+};
+
+struct diff_trace {
+    const char *path;
+    struct s730b_pcap pc;
+    struct s730b_xfer_tracker tr;
+    struct diff_xfer q[2];      // 미리 읽은 transfer (0xCA는 뒤 transfer 보고 구간 정함)
+    int nq;
+    int started, corrupt;
+    long no[PH_TYPES];
+    struct diff_phase ph;
+    struct diff_sum sum[PH_TYPES];
+};
+
+// control: 요청 / wValue / wIndex, bulk OUT 명령: 길이 + 앞 4B, 나머지는 종류만
+static uint64_t diff_token(const struct s730b_xfer *x) {
+    uint64_t t = (uint64_t)x->kind << 56;
+    if (x->has_setup)
+        return t | (uint64_t)x->setup[1] << 32 | (uint64_t)(x->setup[2] | x->setup[3] << 8) << 16 |
+               (uint64_t)(x->setup[4] | x->setup[5] << 8);
+    if (x->kind == XF_CMD || x->kind == XF_START) {
+        t |= (uint64_t)(x->len > 255 ? 255 : x->len) << 32;
+        for (uint32_t i = 0; i < 4 && i < x->data_len; i++)
+            t |= (uint64_t)x->data[i] << (24 - 8 * i);
+    }
+    return t;
+}
+
+static void diff_tok_str(uint64_t tok, char *s, size_t n) {
+    int kind = (int)(tok >> 56);
+    const char *name = s730b_xfer_kind_name[kind];
+    if (kind == XF_CTRL_CA)
+        snprintf(s, n, "%s %04x", name, (unsigned)(tok & 0xffff));
+    else if (kind == XF_CTRL_INIT || kind == XF_CTRL_VENDOR || kind == XF_CTRL_STD)
+        snprintf(s, n, "%s %02x v%04x i%04x", name, (unsigned)(tok >> 32) & 0xff, (unsigned)(tok >> 16) & 0xffff,
+                 (unsigned)tok & 0xffff);
+    else if (kind == XF_CMD || kind == XF_START)
+        snprintf(s, n, "%s %08x (%uB)", name, (unsigned)tok, (unsigned)(tok >> 32) & 0xff);
+    else
+        snprintf(s, n, "%s", name);
+}
+
+// transfer 하나 더 미리 읽기, 0 = 끝 (깨진 파일이면 corrupt)
+static int diff_fill(struct diff_trace *d) {
+    struct s730b_usb_pkt pkt;
+    struct s730b_xfer x;
+    int r;
+    while ((r = s730b_pcap_next(&d->pc, &pkt)) > 0) {
+        if (!s730b_xfer_feed(&d->tr, &pkt, &x))
+            continue;
+        struct diff_xfer *o = &d->q[d->nq++];
+        o->tok = diff_token(&x);
+        o->t_submit = x.t_submit;
+        o->t_complete = x.t_complete;
+        o->gap = x.gap_ns;
+        o->status = x.status;
+        o->kind = x.kind;
+        return 1;
+    }
+    if (r < 0)
+        d->corrupt = 1;
+    return 0;
+}
+
+// q[0]이 어디 속하는지: 2 = 캡처 시작, 1 = 캡처 쪽 (0xCA / 데이터 / ACK / 상태), 0 = 그 밖
+// 0xCA는 바로 뒤 transfer 따라감 (Windows는 명령마다 앞에 0xCA, 캡처는 0xCA + 시작)
+static int diff_class(struct diff_trace *d) {
+    int k = d->q[0].kind;
+    if (k == XF_CTRL_CA && (d->nq > 1 || diff_fill(d)))
+        k = d->q[1].kind;
+    if (k == XF_START)
+        return 2;
+    return k == XF_CTRL_CA || k == XF_DATA || k == XF_ACK || k == XF_STATUS;
+}
+
+static void diff_add(struct diff_phase *p, const struct diff_xfer *x) {
+    if (p->total++ == 0) {
+        p->t_start = x->t_submit;
+        p->lead_gap = x->gap;
+    } else if (x->gap >= DIFF_WAIT_NS)
+        p->wait_ns += x->gap;
+    else
+        p->host_ns += x->gap;
+    if (x->t_complete > p->t_end)
+        p->t_end = x->t_complete;
+    p->bus_ns += x->t_complete - x->t_submit;
+    p->data += x->kind == XF_DATA;
+    p->started |= x->kind == XF_START;
+    p->errors += x->status != 0;
+    if (p->n < DIFF_MAX_XFER)
+        p->x[p->n++] = *x;
+}
+
+/*
+ * 다음 구간, 0 = 끝
+ * - init: 처음 ~ 첫 캡처 시작 전, idle: 캡처 사이 (감지, Windows 폴링)
+ * - capture: (0xCA +) 시작 명령 ~ 0xCA / 데이터 / ACK / 상태 아닌 transfer 전
+ */
+static int diff_next_phase(struct diff_trace *d) {
+    struct diff_phase *p = &d->ph;
+    if (!d->nq && !diff_fill(d))
+        return 0;
+    int c = diff_class(d);
+    p->type = c == 2 ? PH_CAPTURE : d->started ? PH_IDLE : PH_INIT;
+    p->n = 0;
+    p->total = p->data = p->errors = 0;
+    p->started = 0;
+    p->t_end = p->bus_ns = p->host_ns = p->wait_ns = 0;
+    d->started = 1;
+    for (;;) {
+        diff_add(p, &d->q[0]);
+        d->q[0] = d->q[1];
+        if (--d->nq == 0 && !diff_fill(d))
+            break;
+        c = diff_class(d);
+        if (p->type == PH_CAPTURE ? c == 0 || (c == 2 && p->started) : c == 2)
+            break;
+    }
+    p->no = ++d->no[p->type];
+
+    struct diff_sum *s = &d->sum[p->type];
+    s->phases++;
+    s->transfers += p->total;
+    s->data += p->data;
+    s->errors += p->errors;
+    s->time += p->t_end - p->t_start;
+    s->bus += p->bus_ns;
+    s->host += p->host_ns;
+    s->wait += p->wait_ns;
+    return 1;
+}
+
+// 한글은 2칸으로 세서 w칸 맞춤
+static void diff_pad(const char *s, int w) {
+    int cols = 0;
+    for (const unsigned char *c = (const unsigned char *)s; *c; c++) {
+        if (*c < 0x80)
+            cols++;
+        else if (*c >= 0xe0)
+            cols += 2;
+    }
+    printf("%s%*s", s, w > cols ? w - cols : 0, "");
+}
+
+// prec 0 = 개수
+static void diff_row(const char *name, double a, double b, int has_a, int has_b, int prec) {
+    printf("    ");
+    diff_pad(name, 28);
+    if (has_a)
+        printf(" %12.*f", prec, a);
+    else
+        printf(" %12s", "-");
+    if (has_b)
+        printf(" %12.*f", prec, b);
+    else
+        printf(" %12s", "-");
+    if (has_a && has_b)
+        printf(" %+12.*f", prec, b - a);
+    printf("\n");
+}
+
+static void diff_phase_rows(const struct diff_phase *a, const struct diff_phase *b) {
+    diff_row("transfer", a ? a->total : 0, b ? b->total : 0, !!a, !!b, 0);
+    diff_row("시간 ms", a ? (a->t_end - a->t_start) / 1e6 : 0, b ? (b->t_end - b->t_start) / 1e6 : 0, !!a, !!b, 3);
+    diff_row("  bus ms (transfer 합)", a ? a->bus_ns / 1e6 : 0, b ? b->bus_ns / 1e6 : 0, !!a, !!b, 3);
+    diff_row("  host 간격 ms", a ? a->host_ns / 1e6 : 0, b ? b->host_ns / 1e6 : 0, !!a, !!b, 3);
+    diff_row("  대기 ms (간격 50ms 이상)", a ? a->wait_ns / 1e6 : 0, b ? b->wait_ns / 1e6 : 0, !!a, !!b, 3);
+    diff_row("앞 구간에서 ms", a ? a->lead_gap / 1e6 : 0, b ? b->lead_gap / 1e6 : 0, !!a, !!b, 3);
+}
+
+// status 실패한 transfer (chunk 0 ACK timeout 등)
+static int diff_errors(const char *side, const struct diff_phase *p, int shown) {
+    char s[64];
+    for (int i = 0; i < p->n && shown < DIFF_SHOW; i++) {
+        const struct diff_xfer *x = &p->x[i];
+        if (!x->status)
+            continue;
+        diff_tok_str(x->tok, s, sizeof(s));
+        printf("      ! %s#%-4d %-28s status %d, %.3f ms\n", side, i, s, x->status,
+               (x->t_complete - x->t_submit) / 1e6);
+        shown++;
+    }
+    return shown;
+}
+
+/* init / idle: transfer 순서 LCS 정렬 -> 같은 것끼리 시간 차이, 한쪽에만 있는 transfer */
+static uint16_t diff_lcs[(DIFF_MAX_XFER + 1) * (DIFF_MAX_XFER + 1)];
+
+static void diff_seq(const struct diff_phase *a, const struct diff_phase *b) {
+    int n = a->n, m = b->n, w = m + 1;
+    for (int i = n; i >= 0; i--) {
+        for (int j = m; j >= 0; j--) {
+            uint16_t *L = &diff_lcs[i * w + j];
+            if (i == n || j == m)
+                *L = 0;
+            else if (a->x[i].tok == b->x[j].tok)
+                *L = L[w + 1] + 1;
+            else
+                *L = L[w] > L[1] ? L[w] : L[1];
+        }
+    }
+
+    long same = 0, only_a = 0, only_b = 0;
+    double dur = 0, gap = 0;
+    int shown = 0, i = 0, j = 0;
+    char s[64];
+    struct { int i, j; double d; } top[3] = { { -1, -1, 0 }, { -1, -1, 0 }, { -1, -1, 0 } };
+    while (i < n || j < m) {
+        if (i < n && j < m && a->x[i].tok == b->x[j].tok) {
+            const struct diff_xfer *xa = &a->x[i], *xb = &b->x[j];
+            double dd = ((double)(xb->t_complete - xb->t_submit) - (double)(xa->t_complete - xa->t_submit)) / 1e3;
+            double dg = 0;
+            if (same && xa->gap < DIFF_WAIT_NS && xb->gap < DIFF_WAIT_NS)
+                dg = ((double)xb->gap - (double)xa->gap) / 1e3;
+            dur += dd;
+            gap += dg;
+            for (int k = 0; k < 3; k++) {
+                if (top[k].i < 0 || fabs(dd + dg) > fabs(top[k].d)) {
+                    memmove(&top[k + 1], &top[k], (2 - k) * sizeof(top[0]));
+                    top[k].i = i;
+                    top[k].j = j;
+                    top[k].d = dd + dg;
+                    break;
+                }
+            }
+            same++;
+            i++;
+            j++;
+        } else if (j == m || (i < n && diff_lcs[(i + 1) * w + j] >= diff_lcs[i * w + j + 1])) {
+            if (shown++ < DIFF_SHOW) {
+                diff_tok_str(a->x[i].tok, s, sizeof(s));
+                printf("      - A#%-4d %s\n", i, s);
+            }
+            only_a++;
+            i++;
+        } else {
+            if (shown++ < DIFF_SHOW) {
+                diff_tok_str(b->x[j].tok, s, sizeof(s));
+                printf("      + B#%-4d %s\n", j, s);
+            }
+            only_b++;
+            j++;
+        }
+    }
+    if (shown > DIFF_SHOW)
+        printf("      ... 차이 %d개 더\n", shown - DIFF_SHOW);
+    printf("    정렬: 같음 %ld, A에만 %ld, B에만 %ld%s\n", same, only_a, only_b,
+           a->n < a->total || b->n < b->total ? " (앞 1024개만)" : "");
+    if (!same)
+        return;
+    printf("    같은 transfer끼리 B-A: 걸린 시간 %+.1f us, host 간격 %+.1f us\n", dur, gap);
+    for (int k = 0; k < 3 && top[k].i >= 0; k++) {
+        diff_tok_str(a->x[top[k].i].tok, s, sizeof(s));
+        printf("      A#%-4d B#%-4d %-28s %+9.1f us\n", top[k].i, top[k].j, s, top[k].d);
+    }
+}
+
+/* capture: chunk 단위 (0xCA / 데이터 / ACK) 역할별 시간, chunk 모양 */
+struct diff_role {
+    long n;
+    uint64_t dur, gap, max;
+};
+
+struct diff_chunks {
+    int chunks;                     // 데이터 chunk 수 (chunk 0 = 데이터 전 시작 / 상태 / ACK)
+    char sig0[DIFF_SIG], sig1[DIFF_SIG];
+    int steady;                     // chunk 1이랑 모양 같은 chunk 수
+    struct diff_role role[2][XF_KINDS]; // [chunk 0?][kind]
+    struct hist period;             // chunk 시작 ~ 다음 chunk 시작
+};
+
+static void diff_chunk_scan(const struct diff_phase *p, struct diff_chunks *c) {
+    char cur[DIFF_SIG] = "";
+    int ch = 0, empty = 1, only_ca = 1;
+    uint64_t start = 0;
+    memset(c, 0, sizeof(*c));
+    for (int i = 0; i <= p->n; i++) {
+        const struct diff_xfer *x = i < p->n ? &p->x[i] : NULL;
+        // 0xCA는 새 chunk, 데이터는 앞에 0xCA만 있던 게 아니면 새 chunk (Windows는 0xCA 없이 data / ack 반복)
+        if (!x || (!empty && (x->kind == XF_CTRL_CA || (x->kind == XF_DATA && !only_ca)))) {
+            if (ch == 0)
+                memcpy(c->sig0, cur, sizeof(cur));
+            else if (ch == 1)
+                memcpy(c->sig1, cur, sizeof(cur));
+            if (ch >= 1)
+                c->steady += strcmp(cur, c->sig1) == 0;
+            if (!x)
+                break;
+            if (ch >= 1)
+                hist_add(&c->period, x->t_submit - start);
+            ch++;
+            cur[0] = 0;
+            empty = only_ca = 1;
+        }
+        if (empty)
+            start = x->t_submit;
+        empty = 0;
+        only_ca &= x->kind == XF_CTRL_CA;
+        size_t l = strlen(cur);
+        snprintf(cur + l, sizeof(cur) - l, "%s%s", l ? " " : "", s730b_xfer_kind_name[x->kind]);
+
+        struct diff_role *r = &c->role[ch == 0][x->kind];
+        uint64_t dur = x->t_complete - x->t_submit;
+        r->n++;
+        r->dur += dur;
+        if (i && x->gap < DIFF_WAIT_NS)
+            r->gap += x->gap;
+        if (dur > r->max)
+            r->max = dur;
+    }
+    c->chunks = p->data;
+}
+
+static void diff_capture(const struct diff_phase *a, const struct diff_phase *b) {
+    static struct diff_chunks ca, cb;
+    diff_chunk_scan(a, &ca);
+    diff_chunk_scan(b, &cb);
+
+    diff_row("데이터 chunk", ca.chunks, cb.chunks, 1, 1, 0);
+    printf("    chunk 0   A: %s\n", ca.sig0);
+    printf("              B: %s%s\n", cb.sig0, strcmp(ca.sig0, cb.sig0) ? "   <- 다름" : "");
+    printf("    chunk 1~  A: %s (%d/%d)\n", ca.sig1[0] ? ca.sig1 : "-", ca.steady, ca.chunks);
+    printf("              B: %s (%d/%d)%s\n", cb.sig1[0] ? cb.sig1 : "-", cb.steady, cb.chunks,
+           strcmp(ca.sig1, cb.sig1) ? "   <- 다름" : "");
+    if (ca.period.n || cb.period.n) {
+        printf("    chunk 주기 us        A n %4llu p50 %8.1f p99 %8.1f   B n %4llu p50 %8.1f p99 %8.1f\n",
+               (unsigned long long)ca.period.n, hist_pct(&ca.period, 0.5) / 1e3, hist_pct(&ca.period, 0.99) / 1e3,
+               (unsigned long long)cb.period.n, hist_pct(&cb.period, 0.5) / 1e3, hist_pct(&cb.period, 0.99) / 1e3);
+    }
+
+    printf("    ");
+    diff_pad("역할 (평균 us)", 16);
+    printf(" %5s %9s %9s %5s %9s %9s %10s %10s\n", "A n", "dur", "gap", "B n", "dur", "gap", "B-A dur", "B-A gap");
+    for (int z = 1; z >= 0; z--) {
+        for (int k = 0; k < XF_KINDS; k++) {
+            const struct diff_role *ra = &ca.role[z][k], *rb = &cb.role[z][k];
+            if (!ra->n && !rb->n)
+                continue;
+            char name[32];
+            snprintf(name, sizeof(name), "%s %s", z ? "c0" : "c1~", s730b_xfer_kind_name[k]);
+            double da = ra->n ? ra->dur / 1e3 / ra->n : 0, ga = ra->n ? ra->gap / 1e3 / ra->n : 0;
+            double db = rb->n ? rb->dur / 1e3 / rb->n : 0, gb = rb->n ? rb->gap / 1e3 / rb->n : 0;
+            printf("    %-16s %5ld %9.1f %9.1f %5ld %9.1f %9.1f", name, ra->n, da, ga, rb->n, db, gb);
+            if (ra->n && rb->n)
+                printf(" %+10.1f %+10.1f", db - da, gb - ga);
+            printf("\n");
+        }
+    }
+}
+
+static int diff_open(struct diff_trace *d, const char *path, int bus, int dev) {
+    memset(d, 0, sizeof(*d));
+    d->path = path;
+    if (s730b_pcap_open(&d->pc, path) < 0) {
+        fprintf(stderr, "[-] %s: pcap / pcapng 아님\n", path);
+        return -1;
+    }
+    s730b_xfer_init(&d->tr, bus, dev);
+    return 0;
+}
+
+static void diff_pair(const struct diff_phase *a, const struct diff_phase *b) {
+    const struct diff_phase *p = a ? a : b;
+    printf("== %s %ld", ph_name[p->type], p->no);
+    if (a && b && b->no != a->no)
+        printf(" / B %s %ld", ph_name[b->type], b->no);
+    printf("%s\n", !b ? " (A에만)" : !a ? " (B에만)" : "");
+    printf("    %28s %12s %12s %12s\n", "", "A", "B", "B-A");
+    diff_phase_rows(a, b);
+    if (a && b) {
+        if (p->type == PH_CAPTURE && b->type == PH_CAPTURE)
+            diff_capture(a, b);
+        else
+            diff_seq(a, b);
+    }
+    int shown = 0;
+    if (a)
+        shown = diff_errors("A", a, shown);
+    if (b)
+        diff_errors("B", b, shown);
+}
+
+static void diff_summary(const struct diff_trace *a, const struct diff_trace *b) {
+    printf("== 합계\n    %28s %12s %12s %12s\n", "", "A", "B", "B-A");
+    for (int t = 0; t < PH_TYPES; t++) {
+        const struct diff_sum *sa = &a->sum[t], *sb = &b->sum[t];
+        if (!sa->phases && !sb->phases)
+            continue;
+        printf("    %s\n", ph_name[t]);
+        diff_row("  구간 수", sa->phases, sb->phases, 1, 1, 0);
+        diff_row("  transfer", sa->transfers, sb->transfers, 1, 1, 0);
+        diff_row("  status 실패", sa->errors, sb->errors, 1, 1, 0);
+        diff_row("  평균 시간 ms", sa->phases ? sa->time / 1e6 / sa->phases : 0,
+                 sb->phases ? sb->time / 1e6 / sb->phases : 0, sa->phases > 0, sb->phases > 0, 3);
+        diff_row("  평균 bus ms", sa->phases ? sa->bus / 1e6 / sa->phases : 0,
+                 sb->phases ? sb->bus / 1e6 / sb->phases : 0, sa->phases > 0, sb->phases > 0, 3);
+        diff_row("  평균 host 간격 ms", sa->phases ? sa->host / 1e6 / sa->phases : 0,
+                 sb->phases ? sb->host / 1e6 / sb->phases : 0, sa->phases > 0, sb->phases > 0, 3);
+        if (t != PH_CAPTURE)
+            continue;
+        diff_row("  데이터 chunk", sa->data, sb->data, 1, 1, 0);
+        diff_row("  chunk당 시간 us", sa->data ? sa->time / 1e3 / sa->data : 0, sb->data ? sb->time / 1e3 / sb->data : 0,
+                 sa->data > 0, sb->data > 0, 3);
+        diff_row("  chunk당 bus us", sa->data ? sa->bus / 1e3 / sa->data : 0,
+                 sb->data ? sb->bus / 1e3 / sb->data : 0, sa->data > 0, sb->data > 0, 3);
+        diff_row("  chunk당 host 간격 us", sa->data ? sa->host / 1e3 / sa->data : 0,
+                 sb->data ? sb->host / 1e3 / sb->data : 0, sa->data > 0, sb->data > 0, 3);
+    }
+}
+
+static int cmd_diff(int argc, char **argv) {
+    static struct diff_trace ta, tb;
+    int bus = 0, dev = -1, max_show = 8, nfiles = 0;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            max_show = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--dev") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d:%d", &bus, &dev) != 2)
+                return 1;
+        } else if (argv[i][0] == '-')
+            return 1;
+        else
+            argv[nfiles++] = argv[i];
+    }
+    if (nfiles != 2)
+        return 1;
+    if (diff_open(&ta, argv[0], bus, dev) < 0 || diff_open(&tb, argv[1], bus, dev) < 0)
+        return 2;
+
+    printf("[*] A = %s\n    B = %s\n", ta.path, tb.path);
+    int ra = diff_next_phase(&ta), rb = diff_next_phase(&tb), shown = 0;
+    long hidden = 0;
+    while (ra || rb) {
+        int ca = ra && ta.ph.type == PH_CAPTURE, cb = rb && tb.ph.type == PH_CAPTURE;
+        // 캡처 / 캡처 밖끼리 짝, 안 맞으면 캡처 아닌 쪽이 한쪽에만 있는 구간
+        int use_a = ra && (!rb || ca == cb || !ca), use_b = rb && (!ra || ca == cb || !cb);
+        if (shown < max_show) {
+            diff_pair(use_a ? &ta.ph : NULL, use_b ? &tb.ph : NULL);
+            shown++;
+        } else
+            hidden++;
+        if (use_a)
+            ra = diff_next_phase(&ta);
+        if (use_b)
+            rb = diff_next_phase(&tb);
+    }
+    if (hidden)
+        printf("== ... 구간 %ld개 더 (-n 으로 늘림, 합계에는 포함)\n", hidden);
+    diff_summary(&ta, &tb);
+
+    int failed = 0;
+    const struct diff_trace *t[2] = { &ta, &tb };
+    for (int i = 0; i < 2; i++) {
+        if (t[i]->corrupt) {
+            fprintf(stderr, "[-] %s: 깨진 블록 (%.1f MB 지점)\n", t[i]->path, t[i]->pc.bytes / 1e6);
+            failed = 1;
+        }
+        if (!t[i]->tr.locked) {
+            fprintf(stderr, "[-] %s: 730B 장치 못 찾음 (--dev BUS:DEV 로 지정)\n", t[i]->path);
+            failed = 1;
+        }
+    }
+    s730b_pcap_close(&ta.pc);
+    s730b_pcap_close(&tb.pc);
+    return failed ? 2 : 0;
+}
+
+struct trace_cmd {
+    const char *name;
+    int (*fn)(int, char **);
+    const char *help;
+};
+
+static const struct trace_cmd trace_cmds[] = {
+    { "extract", cmd_extract,
+      "[-o DIR] [--log DIR [--log-compress]] [--dev BUS:DEV] [--transfers] 파일...\n"
+      "                  transfer 종류별 시간/간격 + 프레임 / 감지 probe 뽑기" },
+    { "diff", cmd_diff,
+      "[-n 구간수] [--dev BUS:DEV] A B\n"
+      "                  두 트레이스 구간(init / capture / idle)별 정렬: 시간 차이, host 간격, 프로토콜 차이" },
+};
+
+int main(int argc, char **argv) {
+    if (argc >= 2) {
+        for (size_t i = 0; i < sizeof(trace_cmds) / sizeof(trace_cmds[0]); i++) {
+            if (strcmp(argv[1], trace_cmds[i].name) == 0) {
+                int r = trace_cmds[i].fn(argc - 2, argv + 2);
+                if (r != 1)
+                    return r;
+                break;
+            }
+        }
+    }
+    fprintf(stderr, "usage: %s <command> ...\n\n", argv[0]);
+    for (size_t i = 0; i < sizeof(trace_cmds) / sizeof(trace_cmds[0]); i++)
+        fprintf(stderr, "  %-8s %s\n", trace_cmds[i].name, trace_cmds[i].help);
+    return 1;
+}
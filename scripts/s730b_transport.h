@@ -0,0 +1,53 @@
+/*
+ * s730b_transport.h
+ *
+ * - 730B 프로토콜 코드(s730b_proto)가 쓰는 USB 전송 인터페이스
+ * - 진짜 장치는 samsung_730b.c가 libusb로 채우고, 장치 없이 돌릴 때는 s730b_sim (센서 모델)
+ * - 리턴 값은 libusb랑 같게: control = 전송 바이트 수, bulk = 0 (+ *transferred), 실패 = 음수 S730B_E*
+ */
+
+#ifndef S730B_TRANSPORT_H
+#define S730B_TRANSPORT_H
+
+#include <stdint.h>
+#include <time.h>
+
+// libusb_error 값이랑 같음 (libusb 없이도 쓰려고 따로 둠)
+#define S730B_EIO        (-1)
+#define S730B_ENODEV     (-4)   // 장치 빠짐
+#define S730B_ETIMEDOUT  (-7)
+#define S730B_EOVERFLOW  (-8)
+#define S730B_EPIPE      (-9)   // endpoint stall
+
+struct s730b_transport {
+    void *ctx;
+    int (*control)(void *ctx, uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+                   unsigned char *data, uint16_t len, unsigned timeout_ms);
+    int (*bulk)(void *ctx, unsigned char ep, unsigned char *data, int len, int *transferred, unsigned timeout_ms);
+
+    // 없어도 됨 (NULL): 복구용 / 시계
+    int (*clear_halt)(void *ctx, unsigned char ep);     // stall 풀기
+    int (*reopen)(void *ctx);                           // 빠졌던 장치 다시 열기 (0 = 성공)
+    uint64_t (*now_ns)(void *ctx);                      // 시뮬레이터 가상 시계 (NULL이면 CLOCK_MONOTONIC)
+};
+
+static inline int s730b_control(struct s730b_transport *t, uint8_t request_type, uint8_t request, uint16_t value,
+                                uint16_t index, unsigned char *data, uint16_t len, unsigned timeout_ms) {
+    return t->control(t->ctx, request_type, request, value, index, data, len, timeout_ms);
+}
+
+static inline int s730b_bulk(struct s730b_transport *t, unsigned char ep, unsigned char *data, int len,
+                             int *transferred, unsigned timeout_ms) {
+    *transferred = 0;
+    return t->bulk(t->ctx, ep, data, len, transferred, timeout_ms);
+}
+
+static inline uint64_t s730b_transport_now(struct s730b_transport *t) {
+    if (t->now_ns)
+        return t->now_ns(t->ctx);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#endif
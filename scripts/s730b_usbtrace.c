@@ -0,0 +1,516 @@
+/*
+ * s730b_usbtrace.c
+ *
+ * - pcapng / pcap 블록 스트리밍 읽기 -> usbmon / USBPcap 헤더 파싱 -> submit / complete 짝 맞추기
+ * - transfer 역할 분류 (0xC3 / 0xCA / 시작 / 명령 / 데이터 / ACK / 상태) + 캡처 조립
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "s730b_usbtrace.h"
+
+#define PCAPNG_SHB      0x0A0D0D0Au
+#define PCAPNG_IDB      1u
+#define PCAPNG_EPB      6u
+#define PCAPNG_BOM      0x1A2B3C4Du
+#define PCAP_MAGIC_US   0xa1b2c3d4u
+#define PCAP_MAGIC_NS   0xa1b23c4du
+
+#define LINKTYPE_USB_LINUX        189     // usbmon 48B 헤더
+#define LINKTYPE_USB_LINUX_MMAP   220     // usbmon 64B 헤더
+#define LINKTYPE_USBPCAP          249
+
+#define S730B_VID 0x04e8
+#define S730B_PID 0x730b
+
+const char *const s730b_xfer_kind_name[XF_KINDS] = {
+    "other", "ctrl-std", "ctrl-C3", "ctrl-CA", "ctrl-vendor", "cmd", "start", "ack", "data", "status",
+};
+
+static inline uint16_t rd16(const unsigned char *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t rd32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t rd64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+/* ---------------- 1) 파일 읽기 ---------------- */
+
+// pos부터 n바이트 들어 있게 (모자라면 남은 거 앞으로 당기고 read), 1 = 됨, 0 = 파일 끝
+static int fill(struct s730b_pcap *p, size_t n) {
+    if (p->end - p->pos >= n)
+        return 1;
+    memmove(p->buf, p->buf + p->pos, p->end - p->pos);
+    p->end -= p->pos;
+    p->pos = 0;
+    while (p->end < n) {
+        ssize_t k = read(p->fd, p->buf + p->end, TRACE_BUF_SIZE - p->end);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return 0;
+        p->end += (size_t)k;
+    }
+    return 1;
+}
+
+// 버퍼보다 큰 블록: 있는 만큼 버리고 나머지는 lseek
+static int skip(struct s730b_pcap *p, uint64_t n) {
+    size_t have = p->end - p->pos;
+    if (n <= have) {
+        p->pos += n;
+        return 1;
+    }
+    p->pos = p->end = 0;
+    return lseek(p->fd, (off_t)(n - have), SEEK_CUR) < 0 ? 0 : 1;
+}
+
+// if_tsresol: 10^-v 또는 2^-v 초 -> ns = ts * num / den
+static void set_tsresol(struct s730b_pcap_if *f, unsigned v) {
+    f->ts_num = 1;
+    f->ts_den = 1;
+    if (v & 0x80) {
+        f->ts_num = 1000000000ull;
+        f->ts_den = 1ull << ((v & 0x7f) > 63 ? 63 : (v & 0x7f));
+    } else if (v <= 9) {
+        for (unsigned i = v; i < 9; i++)
+            f->ts_num *= 10;
+    } else {
+        for (unsigned i = 9; i < v && i < 28; i++)
+            f->ts_den *= 10;
+    }
+}
+
+int s730b_pcap_open(struct s730b_pcap *p, const char *path) {
+    memset(p, 0, sizeof(*p));
+    p->fd = open(path, O_RDONLY);
+    if (p->fd < 0)
+        return -1;
+    posix_fadvise(p->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (!(p->buf = malloc(TRACE_BUF_SIZE)) || !fill(p, 24))
+        goto fail;
+
+    uint32_t magic = rd32(p->buf);
+    if (magic == PCAPNG_SHB) {
+        // 블록은 next에서 (SHB 포함) 읽음, big-endian 파일은 안 받음
+        if (!fill(p, 12) || rd32(p->buf + 8) != PCAPNG_BOM)
+            goto fail;
+        p->ng = 1;
+        return 0;
+    }
+    if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS) {
+        p->nif = 1;
+        p->ifs[0].linktype = (uint16_t)rd32(p->buf + 20);
+        set_tsresol(&p->ifs[0], magic == PCAP_MAGIC_US ? 6 : 9);
+        p->pos = 24;
+        p->bytes = 24;
+        return 0;
+    }
+
+fail:
+    s730b_pcap_close(p);
+    return -1;
+}
+
+void s730b_pcap_close(struct s730b_pcap *p) {
+    if (p->fd >= 0)
+        close(p->fd);
+    free(p->buf);
+    p->buf = NULL;
+    p->fd = -1;
+}
+
+static void parse_idb(struct s730b_pcap *p, const unsigned char *b, uint32_t blen) {
+    if (p->nif >= TRACE_MAX_IF)
+        return;
+    struct s730b_pcap_if *f = &p->ifs[p->nif++];
+    f->linktype = rd16(b + 8);
+    set_tsresol(f, 6);
+    for (uint32_t o = 16; o + 4 <= blen - 4;) {
+        unsigned code = rd16(b + o), olen = rd16(b + o + 2);
+        if (code == 0 || o + 4 + olen > blen - 4)
+            break;
+        if (code == 9 && olen >= 1)
+            set_tsresol(f, b[o + 4]);
+        o += 4 + ((olen + 3) & ~3u);
+    }
+}
+
+// linktype별 헤더 -> pkt, 0 = USB packet 아님 / 모르는 형식
+static int parse_usb(uint16_t linktype, const unsigned char *d, uint32_t caplen, struct s730b_usb_pkt *pkt) {
+    if (linktype == LINKTYPE_USB_LINUX_MMAP || linktype == LINKTYPE_USB_LINUX) {
+        uint32_t hl = linktype == LINKTYPE_USB_LINUX_MMAP ? 64 : 48;
+        if (caplen < hl)
+            return 0;
+        pkt->id = rd64(d);
+        pkt->complete = d[8] != 'S';
+        pkt->type = d[9];
+        pkt->ep = d[10];
+        pkt->dev = d[11];
+        pkt->bus = rd16(d + 12);
+        pkt->has_setup = d[8] == 'S' && d[14] == 0;
+        pkt->status = (int32_t)rd32(d + 28);
+        pkt->len = rd32(d + 32);
+        memcpy(pkt->setup, d + 40, 8);
+        pkt->data = d + hl;
+        pkt->data_len = rd32(d + 36) < caplen - hl ? rd32(d + 36) : caplen - hl;
+        return pkt->type <= USB_BULK;
+    }
+    if (linktype == LINKTYPE_USBPCAP) {
+        if (caplen < 27)
+            return 0;
+        uint32_t hl = rd16(d);
+        if (hl < 27 || hl > caplen)
+            return 0;
+        uint32_t dl = rd32(d + 23);
+        pkt->id = rd64(d + 2);
+        pkt->status = (int32_t)rd32(d + 10);
+        pkt->complete = d[16] & 1;
+        pkt->bus = rd16(d + 17);
+        pkt->dev = rd16(d + 19);
+        pkt->ep = d[21];
+        pkt->type = d[22];
+        pkt->has_setup = 0;
+        pkt->data = d + hl;
+        pkt->data_len = dl < caplen - hl ? dl : caplen - hl;
+        if (pkt->type == USB_CTRL) {
+            // stage: 0 = setup (+ OUT 데이터), 3 = 완료 (+ IN 데이터), 1/2 (따로 나온 data/status) 는 무시
+            if (hl < 28 || (d[27] != 0 && d[27] != 3))
+                return 0;
+            if (d[27] == 0) {
+                if (pkt->data_len < 8)
+                    return 0;
+                pkt->has_setup = 1;
+                memcpy(pkt->setup, pkt->data, 8);
+                pkt->data += 8;
+                pkt->data_len -= 8;
+                dl = dl >= 8 ? dl - 8 : 0;
+            }
+        }
+        // 완료된 OUT은 길이를 안 줌
+        pkt->len = pkt->complete && !(pkt->ep & 0x80) ? TRACE_LEN_UNKNOWN : dl;
+        return pkt->type <= USB_BULK;
+    }
+    return 0;
+}
+
+int s730b_pcap_next(struct s730b_pcap *p, struct s730b_usb_pkt *pkt) {
+    for (;;) {
+        if (!p->ng) {
+            if (!fill(p, 16))
+                return 0;
+            const unsigned char *h = p->buf + p->pos;
+            uint64_t sec = rd32(h), frac = rd32(h + 4);
+            uint32_t caplen = rd32(h + 8);
+            if (caplen > TRACE_BUF_SIZE - 16) {
+                p->skipped++;
+                p->bytes += 16 + (uint64_t)caplen;
+                if (!skip(p, 16 + (uint64_t)caplen))
+                    return 0;
+                continue;
+            }
+            if (!fill(p, 16 + (size_t)caplen))
+                return 0;
+            h = p->buf + p->pos;
+            p->pos += 16 + caplen;
+            p->bytes += 16 + caplen;
+            memset(pkt, 0, sizeof(*pkt));
+            if (!parse_usb(p->ifs[0].linktype, h + 16, caplen, pkt)) {
+                p->skipped++;
+                continue;
+            }
+            pkt->ts_ns = sec * 1000000000ull + frac * p->ifs[0].ts_num;
+            p->packets++;
+            return 1;
+        }
+
+        if (!fill(p, 12))
+            return 0;
+        uint32_t type = rd32(p->buf + p->pos), blen = rd32(p->buf + p->pos + 4);
+        if (blen < 12 || (blen & 3))
+            return -1;
+        if (blen > TRACE_BUF_SIZE) {
+            p->skipped++;
+            p->bytes += blen;
+            if (!skip(p, blen))
+                return 0;
+            continue;
+        }
+        if (!fill(p, blen))
+            return 0;
+        const unsigned char *b = p->buf + p->pos;
+        p->pos += blen;
+        p->bytes += blen;
+
+        if (type == PCAPNG_SHB) {
+            if (blen < 28 || rd32(b + 8) != PCAPNG_BOM)
+                return -1;
+            p->nif = 0;     // 새 section -> interface 번호 다시
+        } else if (type == PCAPNG_IDB && blen >= 20) {
+            parse_idb(p, b, blen);
+        } else if (type == PCAPNG_EPB && blen >= 32) {
+            uint32_t ifid = rd32(b + 8), caplen = rd32(b + 20);
+            if (ifid >= (uint32_t)p->nif || caplen > blen - 32) {
+                p->skipped++;
+                continue;
+            }
+            const struct s730b_pcap_if *f = &p->ifs[ifid];
+            memset(pkt, 0, sizeof(*pkt));
+            if (!parse_usb(f->linktype, b + 28, caplen, pkt)) {
+                p->skipped++;
+                continue;
+            }
+            uint64_t ts = (uint64_t)rd32(b + 12) << 32 | rd32(b + 16);
+            pkt->ts_ns = (uint64_t)((unsigned __int128)ts * f->ts_num / f->ts_den);
+            p->packets++;
+            return 1;
+        }
+    }
+}
+
+/* ---------------- 2) transfer ---------------- */
+
+void s730b_xfer_init(struct s730b_xfer_tracker *t, int bus, int dev) {
+    memset(t, 0, sizeof(*t));
+    if (dev >= 0) {
+        t->locked = 1;
+        t->bus = (uint16_t)bus;
+        t->dev = (uint16_t)dev;
+    }
+}
+
+// 730B인지: device descriptor 응답의 VID/PID, 또는 730B vendor 요청
+static int is_s730b(const struct s730b_usb_pkt *pkt) {
+    if (pkt->type != USB_CTRL)
+        return 0;
+    if (pkt->complete && pkt->data_len >= 12 && pkt->data[0] == 18 && pkt->data[1] == 1)
+        return rd16(pkt->data + 8) == S730B_VID && rd16(pkt->data + 10) == S730B_PID;
+    if (pkt->has_setup && (pkt->setup[0] & 0x60) == 0x40) {
+        uint8_t r = pkt->setup[1];
+        return r == 0xC3 || r == 0xCA || r == 0xCC || r == 0xDA;
+    }
+    return 0;
+}
+
+static uint8_t classify(const struct s730b_xfer *x, int out_zero) {
+    if (x->type == USB_CTRL) {
+        if (!x->has_setup || (x->setup[0] & 0x60) != 0x40)
+            return XF_CTRL_STD;
+        switch (x->setup[1]) {
+        case 0xC3: return XF_CTRL_INIT;
+        case 0xCA: return XF_CTRL_CA;
+        default:   return XF_CTRL_VENDOR;
+        }
+    }
+    if (x->type != USB_BULK)
+        return XF_OTHER;
+    if (x->ep & 0x80)
+        return x->len >= TRACE_CHUNK ? XF_DATA : XF_STATUS;
+    if (x->data_len >= 2 && x->head[0] == 0xa8 && x->head[1] == 0x06)
+        return XF_START;
+    return out_zero && x->len > 0 ? XF_ACK : XF_CMD;
+}
+
+int s730b_xfer_feed(struct s730b_xfer_tracker *t, const struct s730b_usb_pkt *pkt, struct s730b_xfer *out) {
+    if (!t->locked && is_s730b(pkt)) {
+        t->locked = 1;
+        t->bus = pkt->bus;
+        t->dev = pkt->dev;
+    }
+    if (!t->locked || pkt->bus != t->bus || pkt->dev != t->dev)
+        return 0;
+
+    if (!pkt->complete) {
+        // 빈 칸, 없으면 제일 오래된 거 버림
+        struct s730b_xfer_pending *s = NULL, *oldest = &t->pend[0];
+        for (int i = 0; i < TRACE_PENDING; i++) {
+            if (!t->pend[i].used) {
+                s = &t->pend[i];
+                break;
+            }
+            if (t->pend[i].ts < oldest->ts)
+                oldest = &t->pend[i];
+        }
+        if (!s) {
+            s = oldest;
+            t->orphans++;
+        }
+        s->used = 1;
+        s->id = pkt->id;
+        s->ep = pkt->ep;
+        s->ts = pkt->ts_ns;
+        s->has_setup = pkt->has_setup;
+        memcpy(s->setup, pkt->setup, 8);
+        s->len = pkt->len;
+        s->head_len = pkt->data_len < TRACE_HEAD ? pkt->data_len : TRACE_HEAD;
+        memcpy(s->head, pkt->data, s->head_len);
+        s->out_zero = 1;
+        for (uint32_t i = 0; i < pkt->data_len && s->out_zero; i++)
+            s->out_zero = pkt->data[i] == 0;
+        return 0;
+    }
+
+    struct s730b_xfer_pending *s = NULL;
+    for (int i = 0; i < TRACE_PENDING; i++) {
+        if (t->pend[i].used && t->pend[i].id == pkt->id && t->pend[i].ep == pkt->ep) {
+            s = &t->pend[i];
+            break;
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->type = pkt->type;
+    out->ep = pkt->ep;
+    out->status = pkt->status;
+    out->t_complete = pkt->ts_ns;
+    int out_zero = 0;
+    if (s) {
+        s->used = 0;
+        out->t_submit = s->ts;
+        out->has_setup = s->has_setup;
+        memcpy(out->setup, s->setup, 8);
+        memcpy(out->head, s->head, s->head_len);
+        out_zero = s->out_zero;
+    } else {
+        out->t_submit = pkt->ts_ns;
+        out->no_submit = 1;
+        t->orphans++;
+    }
+
+    int in = pkt->type == USB_CTRL && out->has_setup ? (out->setup[0] & 0x80) != 0 : (pkt->ep & 0x80) != 0;
+    if (in) {
+        out->len = pkt->len == TRACE_LEN_UNKNOWN ? pkt->data_len : pkt->len;
+        out->data = pkt->data;
+        out->data_len = pkt->data_len;
+    } else {
+        out->len = pkt->len != TRACE_LEN_UNKNOWN ? pkt->len : s ? s->len : 0;
+        out->data = out->head;
+        out->data_len = s ? s->head_len : 0;
+    }
+    out->kind = classify(out, out_zero);
+
+    if (t->last_complete && out->t_submit > t->last_complete)
+        out->gap_ns = out->t_submit - t->last_complete;
+    if (out->t_complete > t->last_complete)
+        t->last_complete = out->t_complete;
+    t->transfers++;
+    return 1;
+}
+
+/* ---------------- 3) 캡처 조립 ---------------- */
+
+void s730b_capture_init(struct s730b_capture_asm *a) {
+    memset(a, 0, sizeof(*a));
+}
+
+static void capture_close(struct s730b_capture_asm *a, const struct s730b_capture **done) {
+    struct s730b_capture *c = &a->cap[a->cur];
+    c->probe = c->chunks < TRACE_FRAME_CHUNKS;
+    c->chunk_avg_us = c->chunks ? (uint32_t)(a->chunk_sum / c->chunks / 1000) : 0;
+    *done = c;
+    a->cur ^= 1;
+    a->open = 0;
+}
+
+static void capture_begin(struct s730b_capture_asm *a, uint64_t t_start) {
+    struct s730b_capture *c = &a->cap[a->cur];
+    c->t_start = c->t_end = t_start;
+    c->chunks = c->short_chunks = c->errors = c->probe = 0;
+    c->chunk_max_us = c->chunk_avg_us = 0;
+    c->status_len = c->len = 0;
+    a->last_chunk = t_start;
+    a->chunk_sum = 0;
+    a->open = 1;
+}
+
+static void capture_append(struct s730b_capture *c, const unsigned char *data, uint32_t have, uint32_t len) {
+    if (c->len + len > sizeof(c->data))
+        return;
+    // snaplen 때문에 잘렸으면 나머지는 0
+    uint32_t n = have < len ? have : len;
+    memcpy(c->data + c->len, data, n);
+    memset(c->data + c->len + n, 0, len - n);
+    c->len += (int)len;
+}
+
+int s730b_capture_feed(struct s730b_capture_asm *a, const struct s730b_xfer *x, const struct s730b_capture **done) {
+    struct s730b_capture *c = &a->cap[a->cur];
+    int ended = 0;
+    uint64_t ca_ts = a->ca_ts;
+
+    a->ca_ts = 0;
+    switch (x->kind) {
+    case XF_CTRL_CA:
+        a->ca_ts = x->t_submit;
+        break;
+    case XF_START:
+        if (a->open) {
+            capture_close(a, done);
+            ended = 1;
+            c = &a->cap[a->cur];
+        }
+        capture_begin(a, ca_ts ? ca_ts : x->t_submit);
+        break;
+    case XF_CMD:
+    case XF_CTRL_INIT:
+    case XF_CTRL_VENDOR:
+    case XF_CTRL_STD:
+        if (a->open) {
+            capture_close(a, done);
+            return 1;
+        }
+        return 0;
+    case XF_DATA:
+        if (a->open && x->status == 0) {
+            uint64_t dt = x->t_complete - a->last_chunk;
+            a->last_chunk = x->t_complete;
+            a->chunk_sum += dt;
+            if (dt / 1000 > c->chunk_max_us)
+                c->chunk_max_us = (uint32_t)(dt / 1000);
+            c->chunks++;
+            capture_append(c, x->data, x->data_len, TRACE_CHUNK);
+        }
+        break;
+    case XF_STATUS:
+        if (a->open && x->status == 0 && x->len > 0) {
+            if (c->chunks == 0 && c->status_len == 0) {
+                c->status_len = x->data_len < sizeof(c->status) ? (int)x->data_len : (int)sizeof(c->status);
+                memcpy(c->status, x->data, c->status_len);
+            } else {
+                c->short_chunks++;
+                capture_append(c, x->data, x->data_len, x->len);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (a->open) {
+        if (x->status != 0)
+            c->errors++;
+        if (x->t_complete > c->t_end)
+            c->t_end = x->t_complete;
+    }
+    return ended;
+}
+
+int s730b_capture_flush(struct s730b_capture_asm *a, const struct s730b_capture **done) {
+    if (!a->open)
+        return 0;
+    capture_close(a, done);
+    return 1;
+}
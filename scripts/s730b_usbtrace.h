@@ -0,0 +1,165 @@
+/*
+ * s730b_usbtrace.h
+ *
+ * - USB 캡처 파일 (pcapng / pcap, usbmon(220, 189) / USBPcap(249)) 스트리밍 파서
+ *   Wireshark 손으로 보기 / on.txt 같은 텍스트 export 대신
+ * - 층 3개, 전부 메모리 고정 (파일 크기 상관없이 read 버퍼 + pending 표 + 캡처 하나):
+ *   1) s730b_pcap: 블록 단위로 읽어서 packet 하나씩 (submit / complete, setup, 데이터) 꺼냄
+ *   2) s730b_xfer_tracker: submit / complete 짝 맞춰서 transfer 하나로 (걸린 시간, 앞 transfer랑 간격)
+ *      + 730B 프로토콜 역할로 분류 (0xC3 init, 0xCA, a8 06 시작, 명령, 256B 데이터, ACK, 상태 응답)
+ *   3) s730b_capture_asm: 시작 명령 ~ 다음 명령까지 데이터 chunk 모아서 캡처 하나 (프레임 / 감지 probe)
+ * - 730B 장치는 자동으로 찾음: 04e8:730b device descriptor 응답 또는 730B vendor 요청 (0xC3/0xCA/0xCC/0xDA)
+ *   처음 나온 (bus, device)
+ * - 캡처 데이터는 samsung_730b.c capture_fingerprint랑 같게 256B 데이터 chunk만 (chunk 0 상태 응답은 따로)
+ */
+
+#ifndef S730B_USBTRACE_H
+#define S730B_USBTRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_BUF_SIZE      (1u << 20)  // read 버퍼 (블록이 이거보다 크면 건너뜀)
+#define TRACE_MAX_IF        8
+#define TRACE_PENDING       64          // 아직 완료 안 된 transfer 최대 수
+#define TRACE_HEAD          16          // OUT transfer는 앞 16B만 기억 (명령 구분용)
+#define TRACE_CHUNK         256
+#define TRACE_MAX_CHUNKS    128
+#define TRACE_FRAME_CHUNKS  32          // 데이터 chunk 이 이상이면 프레임, 아니면 감지 probe (<= 6)
+#define TRACE_FULL_CHUNKS   84          // 완전한 프레임 (capture_indices 85개 - chunk 0 상태 응답)
+#define TRACE_IMAGE_CHUNKS  42          // Windows 드라이버는 이미지 부분(10752B)만 읽음
+#define TRACE_LEN_UNKNOWN   0xffffffffu // USBPcap OUT 완료는 길이 안 줌 -> submit 때 길이
+
+/* ---------------- 1) packet ---------------- */
+
+enum { USB_ISO, USB_INTR, USB_CTRL, USB_BULK };
+
+struct s730b_usb_pkt {
+    uint64_t ts_ns;
+    uint64_t id;                // usbmon URB id / USBPcap IRP id (submit-complete 짝)
+    uint16_t bus, dev;
+    uint8_t type;               // USB_*
+    uint8_t ep;                 // 0x80 = IN
+    uint8_t complete;           // 0 = submit, 1 = complete
+    uint8_t has_setup;
+    int32_t status;             // 0 = 성공 (usbmon: -errno, USBPcap: USBD_STATUS)
+    uint8_t setup[8];
+    uint32_t len;               // submit: 요청(usbmon) / 보낸(USBPcap) 길이, complete: 실제 길이 (모르면 TRACE_LEN_UNKNOWN)
+    const unsigned char *data;  // 캡처된 데이터 (다음 next 부르기 전까지만 유효)
+    uint32_t data_len;
+};
+
+struct s730b_pcap_if {
+    uint16_t linktype;
+    uint64_t ts_num, ts_den;    // ns = ts * num / den
+};
+
+struct s730b_pcap {
+    int fd;
+    unsigned char *buf;
+    size_t pos, end;
+    int ng;                     // 1 = pcapng, 0 = pcap
+    int nif;
+    struct s730b_pcap_if ifs[TRACE_MAX_IF];
+    uint64_t bytes;             // 읽은 바이트
+    uint64_t packets;           // 꺼낸 USB packet
+    uint64_t skipped;           // 모르는 linktype / 너무 큰 블록 / 잘린 packet
+};
+
+/* 파일 열고 헤더 확인, 0 = 성공, -1 = pcap/pcapng 아님 */
+int s730b_pcap_open(struct s730b_pcap *p, const char *path);
+
+/* 다음 USB packet, 1 = 꺼냄, 0 = 끝, -1 = 깨진 파일 */
+int s730b_pcap_next(struct s730b_pcap *p, struct s730b_usb_pkt *pkt);
+
+void s730b_pcap_close(struct s730b_pcap *p);
+
+/* ---------------- 2) transfer ---------------- */
+
+enum {
+    XF_OTHER,       // 다른 endpoint, interrupt 등
+    XF_CTRL_STD,    // 표준 요청 (descriptor, configuration ...)
+    XF_CTRL_INIT,   // vendor 0xC3
+    XF_CTRL_CA,     // vendor 0xCA (chunk 선택)
+    XF_CTRL_VENDOR, // 그 밖의 vendor 요청 (Windows 0xCC / 0xDA 등)
+    XF_CMD,         // bulk OUT 레지스터 명령 (a9 / a8 ...)
+    XF_START,       // bulk OUT a8 06 캡처 시작
+    XF_ACK,         // bulk OUT 0으로 채운 ACK
+    XF_DATA,        // bulk IN 256B 데이터 chunk
+    XF_STATUS,      // bulk IN 짧은 응답 (chunk 0 상태 등)
+    XF_KINDS,
+};
+
+extern const char *const s730b_xfer_kind_name[XF_KINDS];
+
+struct s730b_xfer {
+    uint64_t t_submit, t_complete;  // submit 못 봤으면 t_submit = t_complete
+    uint64_t gap_ns;                // 바로 앞 transfer 완료 ~ 이 submit (host 쪽 시간), 첫 transfer면 0
+    uint8_t kind;                   // XF_*
+    uint8_t type, ep;
+    uint8_t has_setup, no_submit;
+    uint8_t setup[8];
+    int32_t status;
+    uint32_t len;                   // 실제 전송 길이 (control은 data stage만)
+    const unsigned char *data;      // IN: 받은 데이터, OUT: 앞 TRACE_HEAD 바이트 (head)
+    uint32_t data_len;
+    unsigned char head[TRACE_HEAD];
+};
+
+struct s730b_xfer_pending {
+    uint64_t id, ts;
+    uint8_t ep, used, has_setup;
+    uint8_t setup[8];
+    uint32_t len, head_len;
+    int out_zero;                   // OUT 데이터 전부 0
+    unsigned char head[TRACE_HEAD];
+};
+
+struct s730b_xfer_tracker {
+    int locked;                     // 730B (bus, dev) 찾음
+    uint16_t bus, dev;
+    uint64_t last_complete;
+    uint64_t transfers;
+    uint64_t orphans;               // submit 없이 complete만 / pending 넘쳐서 버린 것
+    struct s730b_xfer_pending pend[TRACE_PENDING];
+};
+
+/* dev < 0 이면 자동으로 찾음 */
+void s730b_xfer_init(struct s730b_xfer_tracker *t, int bus, int dev);
+
+/* packet 하나 넣기, 1 = transfer 하나 완성 (*out), 0 = 아직 */
+int s730b_xfer_feed(struct s730b_xfer_tracker *t, const struct s730b_usb_pkt *pkt, struct s730b_xfer *out);
+
+/* ---------------- 3) 캡처 조립 ---------------- */
+
+struct s730b_capture {
+    uint64_t t_start, t_end;        // 시작 (chunk 0 0xCA 또는 시작 명령 submit) ~ 마지막 transfer 완료
+    int chunks;                     // 받은 256B 데이터 chunk
+    int short_chunks;               // 256B 안 되는 데이터 (0 아닌 짧은 IN, 첫 상태 응답 빼고)
+    int errors;                     // status 실패한 transfer
+    int probe;                      // chunks < TRACE_FRAME_CHUNKS
+    uint32_t chunk_max_us, chunk_avg_us;    // 데이터 chunk 사이 간격 (첫 chunk는 시작부터)
+    unsigned char status[4];        // 첫 짧은 응답
+    int status_len;
+    int len;
+    unsigned char data[TRACE_MAX_CHUNKS * TRACE_CHUNK];
+};
+
+struct s730b_capture_asm {
+    struct s730b_capture cap[2];    // 쓰는 중 / 방금 끝난 것 (done이 가리킴)
+    int cur;
+    int open;
+    uint64_t ca_ts;                 // 바로 앞 transfer가 0xCA였으면 그 submit 시각
+    uint64_t last_chunk;
+    uint64_t chunk_sum;
+};
+
+void s730b_capture_init(struct s730b_capture_asm *a);
+
+/* transfer 하나 넣기, 1 = 캡처 하나 끝남 (*done, 다음 feed 전까지 유효) */
+int s730b_capture_feed(struct s730b_capture_asm *a, const struct s730b_xfer *x, const struct s730b_capture **done);
+
+/* 파일 끝: 열려 있던 캡처 마무리, 1 = 있음 */
+int s730b_capture_flush(struct s730b_capture_asm *a, const struct s730b_capture **done);
+
+#endif
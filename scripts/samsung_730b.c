@@ -2,228 +2,404 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 #include <libusb-1.0/libusb.h>
 
-#define SAMSUNG730B_VID 0x04e8
-#define SAMSUNG730B_PID 0x730b
+#include "s730b_caplog.h"
+#include "s730b_detect.h"
+#include "s730b_enhance.h"
+#include "s730b_enroll.h"
+#include "s730b_frame.h"
+#include "s730b_fusion.h"
+#include "s730b_gallery.h"
+#include "s730b_ident.h"
+#include "s730b_integrity.h"
+#include "s730b_match.h"
+#include "s730b_metrics.h"
+#include "s730b_minutiae.h"
+#include "s730b_png.h"
+#include "s730b_proto.h"
+#include "s730b_quality.h"
+#include "s730b_session.h"
+#include "s730b_texture.h"
+
+#define BULK_PACKET_SIZE S730B_CHUNK
+
+#define CAPTURE_MAX_RETRY 3
+
+#define REOPEN_TRIES 30             // 다시 꽂힌 장치 찾기: 100ms 간격, 약 3초 (열거 시간)
+#define SESSION_WAIT_MS 60000       // 장치 빠졌을 때 요청이 다시 붙기 기다리는 시간
+
+#define FINGER_LOST_PACKETS 6       // 떼기 감지 probe (plain): 2 chunk면 손가락 있어도 빈 걸로 나옴 (capture.raw 앞 512B ff=0.27)
+#define FINGER_LOST_CONFIRM 2       // 연속 이만큼 "없음"이어야 뗀 걸로 봄
+#define FINGER_LOST_MAX_PROBES 200  // 50ms 간격, 약 10초
+#define DETECT_PROBE_PACKETS 3      // --baseline-detect 쓸 때 probe (상태 + 데이터 2 chunk)
+#define TEXTURE_PROBE_PACKETS 6     // --texture-detect 쓸 때 probe (2 packet이면 offset 뒤 이미지 2줄뿐 -> 주기 / entropy 못 믿음)
+
+// 커맨드라인 옵션
+struct capture_opts {
+    int destripe;       // PGM 저장 전 세로줄/가로줄 제거
+    int min_quality;    // 이 점수 미만 프레임은 재캡처 / burst에서 제외
+    int burst;          // >1 이면 burst 캡처 + 합성
+    int enhance;        // Gabor 융선 강조 결과도 따로 저장
+    int enroll;         // >0 이면 N번 눌러서 등록 (누름 -> 캡처 -> 뗌 반복)
+    const char *identify_path; // 한 번 눌러서 이 갤러리 파일에서 1:N 검색 (top-k + latency 출력)
+    int baseline_detect; // 손가락 감지를 빈 센서 baseline 차이로 (짧은 probe)
+    int texture_detect; // 손가락 감지를 probe 무늬(gradient/융선 주기/entropy)로, 스침이면 캡처 안 함
+    int png;            // 이미지 저장을 PGM 대신 PNG로
+    const char *log_dir; // 캡처한 raw를 capture.raw 대신 이 디렉터리 캡처 로그에 append
+    int log_compress;   // 캡처 로그 레코드를 무손실 압축 (writer 스레드에서)
+    int no_hotplug;     // hotplug 세션 안 씀 (빠지면 예전처럼 복구 몇 번 해보고 종료)
+    const char *metrics_path; // 단계별 카운터를 이 파일로 (Prometheus textfile, .json이면 JSON), 프레임마다 + 끝날 때
+};
+
+static struct capture_opts opts = {
+    .destripe = 1,
+    .min_quality = QUALITY_MIN_SCORE,
+};
+
+// --baseline-detect: 장치 열려 있는 동안 빈 센서 probe 기억
+static struct s730b_detect finger_detect;
+
+// --log: 캡처 로그 + 마지막 감지/전송 통계 (capture_fingerprint / wait_finger가 채움)
+static struct s730b_caplog capture_log;
+static int capture_log_on;
+static struct s730b_caplog_meta capture_meta;
+
+// 열린 장치 (libusb handle을 s730b_transport로 감쌈, 프로토콜 코드는 이걸로만)
+static struct s730b_transport usb_transport;
+
+// 실제로 쓰는 transport: usb_transport를 카운터로 감쌈 (transfer 수 / endpoint별 오류)
+static struct s730b_metrics_tap usb_tap;
+static struct s730b_transport sensor;
+static uint64_t wait_start_ns;      // wait_finger 시작 (대기 ~ 프레임)
 
-#define BULK_EP_OUT 0x01
-#define BULK_EP_IN  0x82
-#define BULK_PACKET_SIZE 256
+// 캡처 프레임 검사 (chunk 수 / 짧은 chunk / 이미지 CRC32C 중복), 장치 열려 있는 동안 최근 프레임 기억
+static struct s730b_integrity frame_check;
 
-#define IMG_OFFSET 180
-#define IMG_WIDTH  112
-#define IMG_HEIGHT 96
+// hotplug 세션: 전송은 session worker가, libusb 이벤트는 usb_event_main이 (빠짐 / 붙음 -> session)
+static struct s730b_session session;
+static int session_on;
+static libusb_hotplug_callback_handle hotplug_handle;
+static pthread_t usb_event_thread;
+static volatile int usb_events_stop;
 
 libusb_device_handle* _libusb_initializing();
-static void init_sensor(libusb_device_handle*);
-static int capture_fingerprint(libusb_device_handle*, unsigned char**, int*);
-static int detect_finger(libusb_device_handle*, unsigned char**, int*, int);
+static void usb_close_all(void);
+static void start_hotplug_session(void);
+static void init_sensor(struct s730b_transport*);
+static int capture_fingerprint(struct s730b_transport*, unsigned char**, int*);
+static int capture_good_frame(struct s730b_transport*, unsigned char**, int*, int, struct s730b_quality*);
+static int capture_burst(struct s730b_transport*, const struct capture_opts*);
+static int enroll_session(struct s730b_transport*, const struct capture_opts*);
+static int identify_session(struct s730b_transport*, const struct capture_opts*);
+static int save_enhanced(const unsigned char*, int, int, const char*);
+static int detect_finger(struct s730b_transport*, unsigned char**, int*, int*, int);
 static int has_fingerprint_in_detect(const unsigned char*, int);
-static int wait_finger(libusb_device_handle*);
+static int probe_packets(int);
+static int finger_in_probe(const unsigned char*, int, int, int);
+static void log_capture(const unsigned char*, int, int, uint32_t);
+static void close_capture_log(void);
+static void export_metrics(void);
+static int wait_finger(struct s730b_transport*);
+static int wait_finger_lost(struct s730b_transport*);
 static int save_pgm_from_raw(const unsigned char*, int, const char*, int);
+static int save_pgm(const unsigned char*, int, int, const char*, int);
 static void die(const char*, int);
 
-static const uint16_t capture_indices[] = {
-    0x032a, 0x042a, 0x052a, 0x062a,
-    0x072a, 0x082a, 0x092a, 0x0a2a,
-    0x0b2a, 0x0c2a, 0x0d2a, 0x0e2a,
-    0x0f2a, 0x102a, 0x112a, 0x122a,
-    0x132a, 0x142a, 0x152a, 0x162a,
-    0x172a, 0x182a, 0x192a, 0x1a2a,
-    0x1b2a, 0x1c2a, 0x1d2a, 0x1e2a,
-    0x1f2a, 0x202a, 0x212a, 0x222a,
-    0x232a, 0x242a, 0x252a, 0x262a,
-    0x272a, 0x282a, 0x292a, 0x2a2a,
-    0x2b2a, 0x2c2a, 0x2d2a, 0x2e2a,
-    0x2f2a, 0x302a, 0x312a, 0x322a,
-    0x332a, 0x342a, 0x352a, 0x362a,
-    0x372a, 0x382a, 0x392a, 0x3a2a,
-    0x3b2a, 0x3c2a, 0x3d2a, 0x3e2a,
-    0x3f2a, 0x402a, 0x412a, 0x422a,
-    0x432a, 0x442a, 0x452a, 0x462a,
-    0x472a, 0x482a, 0x492a, 0x4a2a,
-    0x4b2a, 0x4c2a, 0x4d2a, 0x4e2a,
-    0x4f2a, 0x502a, 0x512a, 0x522a,
-    0x532a, 0x542a, 0x552a, 0x562a,
-    0x572a,
-};
-static const size_t CAPTURE_NUM_PACKETS = sizeof(capture_indices) / sizeof(capture_indices[0]);
-
-struct cmd_def {
-    const unsigned char *data;
-    size_t len;
-};
-
-static const unsigned char cmd00[] = {0x4f, 0x80            };
-static const unsigned char cmd01[] = {0xa9, 0x4f, 0x80      };
-static const unsigned char cmd02[] = {0xa8, 0xb9, 0x00      };
-static const unsigned char cmd03[] = {0xa9, 0x60, 0x1b, 0x00};
-static const unsigned char cmd04[] = {0xa9, 0x50, 0x21, 0x00};
-static const unsigned char cmd05[] = {0xa9, 0x61, 0x00, 0x00};
-static const unsigned char cmd06[] = {0xa9, 0x62, 0x00, 0x1a};
-static const unsigned char cmd07[] = {0xa9, 0x63, 0x00, 0x1a};
-static const unsigned char cmd08[] = {0xa9, 0x64, 0x04, 0x0a};
-static const unsigned char cmd09[] = {0xa9, 0x66, 0x0f, 0x80};
-static const unsigned char cmd10[] = {0xa9, 0x67, 0x1b, 0x00};
-static const unsigned char cmd11[] = {0xa9, 0x68, 0x00, 0x0f};
-static const unsigned char cmd12[] = {0xa9, 0x69, 0x00, 0x14};
-static const unsigned char cmd13[] = {0xa9, 0x6a, 0x00, 0x19};
-static const unsigned char cmd14[] = {0xa9, 0x6c, 0x00, 0x19};
-static const unsigned char cmd15[] = {0xa9, 0x40, 0x43, 0x00};
-static const unsigned char cmd16[] = {0xa9, 0x41, 0x6f, 0x00};
-static const unsigned char cmd17[] = {0xa9, 0x55, 0x20, 0x00};
-static const unsigned char cmd18[] = {0xa9, 0x5f, 0x00, 0x00};
-static const unsigned char cmd19[] = {0xa9, 0x52, 0x27, 0x00};
-static const unsigned char cmd20[] = {0xa9, 0x09, 0x00, 0x00};
-static const unsigned char cmd21[] = {0xa9, 0x5d, 0x4d, 0x00};
-static const unsigned char cmd22[] = {0xa9, 0x51, 0xa8, 0x25};
-static const unsigned char cmd23[] = {0xa9, 0x03, 0x00      };
-static const unsigned char cmd24[] = {0xa9, 0x38, 0x01, 0x00};
-static const unsigned char cmd25[] = {0xa9, 0x3d, 0xff, 0x0f};
-static const unsigned char cmd26[] = {0xa9, 0x10, 0x60, 0x00};
-static const unsigned char cmd27[] = {0xa9, 0x3b, 0x14, 0x00};
-static const unsigned char cmd28[] = {0xa9, 0x2f, 0xf6, 0xff};
-static const unsigned char cmd29[] = {0xa9, 0x09, 0x00, 0x00};
-static const unsigned char cmd30[] = {0xa9, 0x0c, 0x00      };
-static const unsigned char cmd31[] = {0xa8, 0x20, 0x00, 0x00};
-static const unsigned char cmd32[] = {0xa9, 0x04, 0x00      };
-static const unsigned char cmd33[] = {0xa8, 0x08, 0x00      };
-static const unsigned char cmd34[] = {0xa9, 0x09, 0x00, 0x00};
-static const unsigned char cmd35[] = {0xa8, 0x3e, 0x00, 0x00};
-static const unsigned char cmd36[] = {0xa9, 0x03, 0x00, 0x00};
-static const unsigned char cmd37[] = {0xa8, 0x20, 0x00, 0x00};
-static const unsigned char cmd38[] = {0xa9, 0x10, 0x00, 0x01};
-static const unsigned char cmd39[] = {0xa9, 0x2f, 0xef, 0x00};
-static const unsigned char cmd40[] = {0xa9, 0x09, 0x00, 0x00};
-static const unsigned char cmd41[] = {0xa9, 0x5d, 0x4d, 0x00};
-static const unsigned char cmd42[] = {0xa9, 0x51, 0x3a, 0x25};
-static const unsigned char cmd43[] = {0xa9, 0x0c, 0x00      };
-static const unsigned char cmd44[] = {0xa8, 0x20, 0x00, 0x00};
-static const unsigned char cmd45[] = {0xa9, 0x04, 0x00, 0x00};
-static const unsigned char cmd46[] = {0xa9, 0x09, 0x00, 0x00};
-
-static const struct cmd_def init_cmds[] = {
-    { cmd00, sizeof(cmd00) }, { cmd01, sizeof(cmd01) },
-    { cmd02, sizeof(cmd02) }, { cmd03, sizeof(cmd03) },
-    { cmd04, sizeof(cmd04) }, { cmd05, sizeof(cmd05) },
-    { cmd06, sizeof(cmd06) }, { cmd07, sizeof(cmd07) },
-    { cmd08, sizeof(cmd08) }, { cmd09, sizeof(cmd09) },
-    { cmd10, sizeof(cmd10) }, { cmd11, sizeof(cmd11) },
-    { cmd12, sizeof(cmd12) }, { cmd13, sizeof(cmd13) },
-    { cmd14, sizeof(cmd14) }, { cmd15, sizeof(cmd15) },
-    { cmd16, sizeof(cmd16) }, { cmd17, sizeof(cmd17) },
-    { cmd18, sizeof(cmd18) }, { cmd19, sizeof(cmd19) },
-    { cmd20, sizeof(cmd20) }, { cmd21, sizeof(cmd21) },
-    { cmd22, sizeof(cmd22) }, { cmd23, sizeof(cmd23) },
-    { cmd24, sizeof(cmd24) }, { cmd25, sizeof(cmd25) },
-    { cmd26, sizeof(cmd26) }, { cmd27, sizeof(cmd27) },
-    { cmd28, sizeof(cmd28) }, { cmd29, sizeof(cmd29) },
-    { cmd30, sizeof(cmd30) }, { cmd31, sizeof(cmd31) },
-    { cmd32, sizeof(cmd32) }, { cmd33, sizeof(cmd33) },
-    { cmd34, sizeof(cmd34) }, { cmd35, sizeof(cmd35) },
-    { cmd36, sizeof(cmd36) }, { cmd37, sizeof(cmd37) },
-    { cmd38, sizeof(cmd38) }, { cmd39, sizeof(cmd39) },
-    { cmd40, sizeof(cmd40) }, { cmd41, sizeof(cmd41) },
-    { cmd42, sizeof(cmd42) }, { cmd43, sizeof(cmd43) },
-    { cmd44, sizeof(cmd44) }, { cmd45, sizeof(cmd45) },
-    { cmd46, sizeof(cmd46) },
-};
-static const size_t init_cmds_len = sizeof(init_cmds) / sizeof(init_cmds[0]);
 
 
 int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-destripe") == 0)
+            opts.destripe = 0;
+        else if (strcmp(argv[i], "--min-quality") == 0 && i + 1 < argc)
+            opts.min_quality = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--burst") == 0 && i + 1 < argc)
+            opts.burst = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--enhance") == 0)
+            opts.enhance = 1;
+        else if (strcmp(argv[i], "--enroll") == 0 && i + 1 < argc)
+            opts.enroll = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--identify") == 0 && i + 1 < argc)
+            opts.identify_path = argv[++i];
+        else if (strcmp(argv[i], "--baseline-detect") == 0)
+            opts.baseline_detect = 1;
+        else if (strcmp(argv[i], "--texture-detect") == 0)
+            opts.texture_detect = 1;
+        else if (strcmp(argv[i], "--png") == 0)
+            opts.png = 1;
+        else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)
+            opts.log_dir = argv[++i];
+        else if (strcmp(argv[i], "--log-compress") == 0)
+            opts.log_compress = 1;
+        else if (strcmp(argv[i], "--no-hotplug") == 0)
+            opts.no_hotplug = 1;
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+            opts.metrics_path = argv[++i];
+    }
+    if (opts.metrics_path)
+        atexit(export_metrics);
+
     printf("========================================\n  ");
     printf("      samsung 730b libusb test            \n");
     printf("========================================\n\n");
     
     printf("[*] 센서 초기화 중...\n");
-    libusb_device_handle* dev = _libusb_initializing();
+    _libusb_initializing();
     printf("[+] 센서 초기화 완료\n");
+    if (!opts.no_hotplug)
+        start_hotplug_session();
+
+    if (opts.log_dir) {
+        if (s730b_caplog_open(&capture_log, opts.log_dir, opts.log_compress ? CAPLOG_OPEN_CODEC : 0) < 0)
+            die("캡처 로그 열기 실패", -1);
+        capture_log_on = 1;
+        atexit(close_capture_log);
+        printf("[*] 캡처 로그: %s (세그먼트 %u)\n", opts.log_dir, capture_log.segment);
+    }
+
+    if (opts.enroll > 0) {
+        int er = enroll_session(&sensor, &opts);
+        usb_close_all();
+        if (er < 0)
+            die("등록 실패", er);
+        printf("[+] 프로그램 종료\n\12");
+        return 0;
+    }
+
+    if (opts.identify_path) {
+        int ir = identify_session(&sensor, &opts);
+        usb_close_all();
+        if (ir < 0)
+            die("1:N 검색 실패", ir);
+        printf("[+] 프로그램 종료\n\12");
+        return 0;
+    }
 
     printf("[*] 손가락을 센서위에 올려놓으세요...\n\12");
-    if (!wait_finger(dev)) {
-        libusb_release_interface(dev, 0);
-        libusb_close(dev);
-        libusb_exit(NULL);
+    if (!wait_finger(&sensor)) {
+        usb_close_all();
         die("finger detect timeout", -1);
         return 1;
     }
     
+    if (opts.burst > 1) {
+        int br = capture_burst(&sensor, &opts);
+        usb_close_all();
+        if (br < 0)
+            die("burst 캡처 실패", br);
+        printf("[+] 프로그램 종료\n\12");
+        return 0;
+    }
+
     unsigned char *buf = NULL;
     int len = 0;
-    int r = capture_fingerprint(dev, &buf, &len);
+    struct s730b_quality q;
+    int r = capture_good_frame(&sensor, &buf, &len, opts.min_quality, &q);
     if (r < 0 || !buf)
         die("캡처 실패", r);
 
     int non_zero = 0;
     for (int i = 0; i < len; i++)
         if (buf[i] != 0) non_zero++;
-    printf("[+] 지문캡처 완료: %d bytes, non-zero=%d bytes\n", len, non_zero);
-
-    const char *fname = "capture.raw";
-    FILE *f = fopen(fname, "wb");
-    if (!f)
-        die("capture.raw 열기 실패", -1);
-    fwrite(buf, 1, len, f);
-    fclose(f);
-    printf("[+] RAW 저장됨: %s\n", fname);
+    printf("[+] 지문캡처 완료: %d bytes, non-zero=%d bytes, quality=%d\n", len, non_zero, q.score);
+
+    // --log면 capture_good_frame에서 이미 로그에 들어감
+    if (!capture_log_on) {
+        const char *fname = "capture.raw";
+        FILE *f = fopen(fname, "wb");
+        if (!f)
+            die("capture.raw 열기 실패", -1);
+        fwrite(buf, 1, len, f);
+        fclose(f);
+        printf("[+] RAW 저장됨: %s\n", fname);
+    }
+
+    // RAW는 원본 그대로 두고 PGM용으로만 세로줄/가로줄 제거
+    if (opts.destripe && len >= IMG_OFFSET + IMG_SIZE)
+        s730b_destripe(buf + IMG_OFFSET, IMG_WIDTH, IMG_HEIGHT);
     save_pgm_from_raw(buf, len, "capture.pgm", 1);
+    if (opts.enhance && len >= IMG_OFFSET + IMG_SIZE)
+        save_enhanced(buf + IMG_OFFSET, IMG_WIDTH, IMG_HEIGHT, "capture_enhanced.pgm");
 
     free(buf);
 
-    libusb_release_interface(dev, 0);
-    libusb_close(dev);
-    libusb_exit(NULL);
+    usb_close_all();
 
     printf("[+] 프로그램 종료\n\12");
     return 0;
 }
 
-static void init_sensor(libusb_device_handle *dev) {
-    int r;
+// 복구 했으면 한 줄 (처음 실패 지점 / 한 일 / 걸린 시간)
+static void print_recover(const char *what, const struct s730b_recover *rc) {
+    if (rc->attempts <= 1 && !rc->recover_ns)
+        return;
+    fprintf(stderr, "[*] %s 복구: %s err=%d -> 시도 %d번 (init %d, clear_halt %d, reopen %d), %.1f ms\n", what,
+            s730b_proto_at_name[rc->first_at], rc->first_err, rc->attempts, rc->reinits, rc->clears, rc->reopens,
+            rc->recover_ns / 1e6);
+}
 
-    // 1) control 0xC3 초기 설정
-    unsigned char c3_data[16] = {
-        0x80, 0x84, 0x1e, 0x00,
-        0x08, 0x00, 0x00, 0x01,
-        0x01, 0x01, 0x00, 0x00,
-        0x01, 0x00, 0x00, 0x00
-    };
-
-    r = libusb_control_transfer(
-        dev,
-        0x40,        // Host->Device, Vendor, Device
-        0xC3,
-        0x0000,
-        0x0000,
-        c3_data,
-        sizeof(c3_data),
-        500
-    );
+static void count_recover(const struct s730b_recover *rc) {
+    if (rc->attempts > 1)
+        s730b_metric_add(MC_RECOVER_RETRY, (uint64_t)(rc->attempts - 1));
+    s730b_metric_add(MC_RECOVER_REINIT, (uint64_t)rc->reinits);
+    s730b_metric_add(MC_RECOVER_CLEAR_HALT, (uint64_t)rc->clears);
+    s730b_metric_add(MC_RECOVER_REOPEN, (uint64_t)rc->reopens);
+}
 
+// stall / timeout / 장치 빠짐은 s730b_proto_init_recover가 다시 해보고, 그래도 안 되면 die
+static void init_sensor(struct s730b_transport *dev) {
+    struct s730b_proto_stats st;
+    struct s730b_recover rc;
+    uint64_t t0 = s730b_now_ns();
+    int r;
+    if (session_on) {
+        struct s730b_session_req req = { .kind = SESSION_INIT };
+        r = s730b_session_submit(&session, &req, SESSION_WAIT_MS);
+        st = req.st;
+        rc = req.rc;
+    } else {
+        s730b_recover_init(&rc);
+        r = s730b_proto_init_recover(dev, &rc, &st);
+    }
+    print_recover("init", &rc);
+    s730b_metric_inc(MC_INIT);
+    s730b_metric_observe(MH_INIT_US, (s730b_now_ns() - t0) / 1000);
+    count_recover(&rc);
     if (r < 0)
+        s730b_metric_inc(MC_INIT_FAIL);
+
+    if (r < 0 && st.at == PROTO_AT_C3)
         die("control 0xC3 전송 실패", r);
+    if (r < 0) {
+        fprintf(stderr, "[-] init bulk 전송 실패 idx=%d, err=%d\n", st.index, r);
+        die("init 실패", r);
+    }
+}
+
+// s730b_transport -> libusb
+static int usb_control(void *ctx, uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+                       unsigned char *data, uint16_t len, unsigned timeout_ms) {
+    return libusb_control_transfer(ctx, request_type, request, value, index, data, len, timeout_ms);
+}
 
-    // 2) 0xA9/0xA8 init 시퀀스
-    for (size_t i = 0; i < init_cmds_len; i++) {
-        const unsigned char *cmd = init_cmds[i].data;
-        size_t len = init_cmds[i].len;
-
-        int transferred = 0;
-        r = libusb_bulk_transfer(
-            dev,
-            BULK_EP_OUT,
-            (unsigned char *)cmd,
-            (int)len,
-            &transferred,
-            500
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] init bulk 전송 실패 idx=%zu, err=%d\n", i, r);
-            die("init 실패", r);
+static int usb_bulk(void *ctx, unsigned char ep, unsigned char *data, int len, int *transferred,
+                    unsigned timeout_ms) {
+    return libusb_bulk_transfer(ctx, ep, data, len, transferred, timeout_ms);
+}
+
+static int usb_clear_halt(void *ctx, unsigned char ep) {
+    return libusb_clear_halt(ctx, ep);
+}
+
+// 빠졌다 다시 꽂힌 장치 새로 열기 (예전 handle 닫고 VID/PID로 다시 찾음), die 안 함
+static int usb_reopen(void *ctx) {
+    libusb_device_handle *dev = NULL;
+    int r;
+
+    if (ctx) {
+        libusb_release_interface(ctx, 0);
+        libusb_close(ctx);
+        usb_transport.ctx = NULL;
+    }
+    for (int i = 0; i < REOPEN_TRIES && !dev; i++) {
+        dev = libusb_open_device_with_vid_pid(NULL, S730B_VID, S730B_PID);
+        if (!dev) {
+            struct timespec ts = { 0, 100 * 1000 * 1000 }; // 100ms
+            nanosleep(&ts, NULL);
         }
     }
+    if (!dev)
+        return LIBUSB_ERROR_NO_DEVICE;
+
+    if (libusb_kernel_driver_active(dev, 0) == 1)
+        libusb_detach_kernel_driver(dev, 0);
+    r = libusb_set_configuration(dev, 1);
+    if (r == 0)
+        r = libusb_claim_interface(dev, 0);
+    if (r < 0) {
+        libusb_close(dev);
+        return r;
+    }
+    usb_transport.ctx = dev;
+    fprintf(stderr, "[*] 장치 다시 열림\n");
+    return 0;
+}
+
+static int usb_hotplug_cb(libusb_context *ctx, libusb_device *d, libusb_hotplug_event ev, void *user) {
+    (void)ctx;
+    (void)d;
+    (void)user;
+    if (ev == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED) {
+        fprintf(stderr, "[*] 장치 붙음 -> 다시 열고 init\n");
+        s730b_session_attached(&session);
+    } else {
+        fprintf(stderr, "[*] 장치 빠짐 -> 요청은 다시 붙을 때까지 대기\n");
+        s730b_session_detached(&session);
+    }
+    return 0;
+}
+
+// hotplug 콜백은 libusb 이벤트 처리 안에서만 불림 -> 따로 돌림
+static void *usb_event_main(void *arg) {
+    (void)arg;
+    while (!usb_events_stop) {
+        struct timeval tv = { 0, 100 * 1000 };
+        libusb_handle_events_timeout_completed(NULL, &tv, NULL);
+    }
+    return NULL;
+}
+
+// 장치 열고 init 끝난 뒤: hotplug 되면 세션으로 (안 되면 예전처럼 직접 전송)
+static void start_hotplug_session(void) {
+    if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+        fprintf(stderr, "[*] libusb hotplug 안 됨, 세션 없이\n");
+        return;
+    }
+    if (s730b_session_start(&session, &sensor, 1) < 0)
+        return;
+    int r = libusb_hotplug_register_callback(NULL, LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+                                             LIBUSB_HOTPLUG_NO_FLAGS, S730B_VID, S730B_PID, LIBUSB_HOTPLUG_MATCH_ANY,
+                                             usb_hotplug_cb, NULL, &hotplug_handle);
+    if (r < 0) {
+        s730b_session_stop(&session);
+        return;
+    }
+    if (pthread_create(&usb_event_thread, NULL, usb_event_main, NULL) != 0) {
+        libusb_hotplug_deregister_callback(NULL, hotplug_handle);
+        s730b_session_stop(&session);
+        return;
+    }
+    session_on = 1;
+}
+
+static void stop_hotplug_session(void) {
+    struct s730b_session_stats x;
+
+    if (!session_on)
+        return;
+    s730b_session_get_stats(&session, &x);
+    s730b_session_stop(&session);
+    usb_events_stop = 1;
+    pthread_join(usb_event_thread, NULL);
+    libusb_hotplug_deregister_callback(NULL, hotplug_handle);
+    session_on = 0;
+    if (x.detaches)
+        printf("[*] 세션: 빠짐 %llu번, 다시 붙음 %llu번 (붙음 -> 준비 avg %.1f ms / max %.1f ms), 다시 한 요청 %llu\n",
+               (unsigned long long)x.detaches, (unsigned long long)x.reattaches,
+               x.reattaches ? x.reattach_ns_sum / 1e6 / x.reattaches : 0, x.reattach_ns_max / 1e6,
+               (unsigned long long)x.requeued);
+}
+
+static void usb_close_all(void) {
+    stop_hotplug_session();
+    if (usb_transport.ctx) {
+        libusb_release_interface(usb_transport.ctx, 0);
+        libusb_close(usb_transport.ctx);
+        usb_transport.ctx = NULL;
+    }
+    libusb_exit(NULL);
 }
 
 libusb_device_handle* _libusb_initializing() {
@@ -232,7 +408,7 @@ libusb_device_handle* _libusb_initializing() {
     if (r < 0)
         die("libusb_init 실패", r);
 
-    dev = libusb_open_device_with_vid_pid(NULL, SAMSUNG730B_VID, SAMSUNG730B_PID);
+    dev = libusb_open_device_with_vid_pid(NULL, S730B_VID, S730B_PID);
     if (!dev)
         die("장치를 찾을 수 없음 (VID/PID or sudo..?)", -1);
 
@@ -250,287 +426,632 @@ libusb_device_handle* _libusb_initializing() {
     if (r < 0)
         die("claim_interface 실패", r);
 
-    init_sensor(dev);
+    usb_transport.ctx = dev;
+    usb_transport.control = usb_control;
+    usb_transport.bulk = usb_bulk;
+    usb_transport.clear_halt = usb_clear_halt;
+    usb_transport.reopen = usb_reopen;
+    s730b_metrics_transport(&usb_tap, &usb_transport, &sensor);
+    init_sensor(&sensor);
     return dev;
 }
 
-static int capture_fingerprint(libusb_device_handle *dev, unsigned char **out_buf, int *out_len) {
-    int r;
-    int transferred;
-    int total_len = 0;
-    int capacity = (int)CAPTURE_NUM_PACKETS * BULK_PACKET_SIZE + 1024;
+// 프로토콜 실패 한 줄 (예전 capture_fingerprint / detect_finger 메시지 그대로)
+static void print_proto_error(const char *prefix, const struct s730b_proto_stats *st) {
+    if (st->at == PROTO_AT_NONE)
+        return;
+    if (st->err == 0)
+        fprintf(stderr, "[*] %spacket=%d 에서 0 bytes 들어옴, 종료\n", prefix, st->index);
+    else
+        fprintf(stderr, "[-] %s%s 실패 packet=%d, err=%d\n", prefix, s730b_proto_at_name[st->at], st->index, st->err);
+}
+
+// 잘린 프레임 / 짧은 chunk / stall / 빠짐은 init부터 다시 (s730b_proto_capture_recover)
+static int capture_fingerprint(struct s730b_transport *dev, unsigned char **out_buf, int *out_len) {
+    struct s730b_proto_stats st;
+    struct s730b_recover rc;
+    int capacity = S730B_FRAME_BYTES;
     unsigned char *buf = malloc(capacity);
 
     if (!buf)
         die("malloc 실패", -1);
 
-    // ---------- 1) 첫 packet: 상태응답 ----------
-    {
-        uint16_t wIndex0 = capture_indices[0];
-
-        // CONTROL 0xCA (첫 packet)
-        r = libusb_control_transfer(
-            dev,
-            0x40,
-            0xCA,
-            0x0003,
-            wIndex0,
-            NULL,
-            0,
-            500
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] control 0xCA 실패 packet=0, err=%d\n", r);
-            goto out_fail;
-        }
-
-        // 캡처 시작명령 (a8 06 00 00 ...)
-        unsigned char start_cmd[256];
-        memset(start_cmd, 0, sizeof(start_cmd));
-        start_cmd[0] = 0xa8;
-        start_cmd[1] = 0x06;
-        start_cmd[2] = 0x00;
-        start_cmd[3] = 0x00;
-
-        r = libusb_bulk_transfer(
-            dev,
-            BULK_EP_OUT,
-            start_cmd,
-            sizeof(start_cmd),
-            &transferred,
-            500
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] 캡처 시작 bulk 전송 실패 (packet=0, err=%d)\n", r);
-            goto out_fail;
-        }
+    uint64_t t0 = s730b_now_ns();
+    int len;
+    if (session_on) {
+        struct s730b_session_req req = {
+            .kind = SESSION_CAPTURE, .packets = S730B_NUM_PACKETS, .buf = buf, .cap = capacity,
+        };
+        len = s730b_session_submit(&session, &req, SESSION_WAIT_MS);
+        st = req.st;
+        rc = req.rc;
+        if (req.requeued)
+            fprintf(stderr, "[*] 캡처 중 장치 빠짐 -> 다시 붙은 뒤 캡처 (%d번)\n", req.requeued);
+    } else {
+        s730b_recover_init(&rc);
+        len = s730b_proto_capture_recover(dev, S730B_NUM_PACKETS, 0, buf, capacity, &rc, &st);
+    }
+    print_proto_error("", &st);
+    print_recover("캡처", &rc);
+    s730b_metric_inc(MC_CAPTURE);
+    s730b_metric_observe(MH_CAPTURE_US, (s730b_now_ns() - t0) / 1000);
+    count_recover(&rc);
+    s730b_metric_add(MC_CHUNK_SHORT, (uint64_t)st.short_chunks);
+    if (len < 0)
+        s730b_metric_inc(MC_CAPTURE_FAIL);
+    else
+        s730b_metric_add(MC_CAPTURE_BYTES, (uint64_t)len);
+    if (len < 0) {
+        free(buf);
+        *out_buf = NULL;
+        *out_len = 0;
+        return -1;
+    }
 
-        // 첫 bulk IN: 짧은 상태응답 읽기만함 (2 bytes)
-        unsigned char tmp0[256];
-        r = libusb_bulk_transfer(
-            dev,
-            BULK_EP_IN,
-            tmp0,
-            sizeof(tmp0),
-            &transferred,
-            500
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] 초기 상태 bulk IN 실패 packet=0, err=%d\n", r);
-            goto out_fail;
-        }
+    capture_meta.flags = 0;
+    capture_meta.chunks_expected = (uint16_t)(S730B_NUM_PACKETS - 1);
+    capture_meta.chunks_received = (uint16_t)st.chunks;
+    capture_meta.chunk_max_us = st.chunk_max_us;
+    capture_meta.chunk_avg_us = st.chunk_avg_us;
+    capture_meta.capture_us = st.total_us;
+    if (st.short_chunks)
+        capture_meta.flags |= CAPLOG_SHORT_CHUNK;
+    if (capture_meta.chunks_received == capture_meta.chunks_expected)
+        capture_meta.flags |= CAPLOG_COMPLETE;
+    else
+        s730b_metric_inc(MC_CAPTURE_INCOMPLETE);
+
+    // 잘린 / 밀린 / 앞이랑 똑같은 프레임은 여기서 버림 (부른 쪽이 다시 찍음)
+    struct s730b_frame_desc fd;
+    uint32_t bad = s730b_frame_check(&frame_check, buf, len, &st, &fd);
+    capture_meta.image_crc = fd.crc;
+    if (bad) {
+        char why[64];
+        fprintf(stderr, "[-] 프레임 버림: %s (chunk %d/%d, 짧은 chunk %d, %d bytes, crc=%08x",
+                s730b_frame_flags_str(bad, why, sizeof(why)), fd.chunks_received, fd.chunks_expected, fd.short_chunks,
+                len, fd.crc);
+        if (bad & FRAME_DUPLICATE)
+            fprintf(stderr, ", %d 프레임 전이랑 같음", fd.dup_age);
+        fprintf(stderr, ")\n");
+        if (bad & (FRAME_TRUNCATED | FRAME_NO_IMAGE))
+            s730b_metric_inc(MC_FRAME_TRUNCATED);
+        if (bad & FRAME_SHORT_CHUNK)
+            s730b_metric_inc(MC_FRAME_SHORT_CHUNK);
+        if (bad & FRAME_DUPLICATE)
+            s730b_metric_inc(MC_FRAME_DUPLICATE);
+        free(buf);
+        *out_buf = NULL;
+        *out_len = 0;
+        return -1;
     }
 
-    // ---------- 2) 나머지 packet: 실제 데이터 + ACK ----------
-    for (size_t i = 1; i < CAPTURE_NUM_PACKETS; i++) {
-        uint16_t wIndex = capture_indices[i];
+    *out_buf = buf;
+    *out_len = len;
+    return 0;
+}
 
-        // CONTROL 0xCA: 패킷 설정
-        r = libusb_control_transfer(dev, 0x40, 0xCA, 0x0003, wIndex, NULL, 0, 500);
-        if (r < 0) {
-            fprintf(stderr, "[-] control 0xCA 실패 packet=%zu, err=%d\n", i, r);
-            break;
-        }
+/*
+ * 품질 점수 보고 바로 재캡처
+ * - 빈/반쪽/흐린 프레임이면 verify까지 안 가고 여기서 다시 찍음 (손가락은 그대로 있다고 봄)
+ * - CAPTURE_MAX_RETRY번 다 못넘으면 그중 점수 제일 좋은 프레임 돌려줌
+ */
+static int capture_good_frame(struct s730b_transport *dev, unsigned char **out_buf, int *out_len,
+                              int min_quality, struct s730b_quality *out_q) {
+    unsigned char *best = NULL;
+    int best_len = 0;
+    struct s730b_quality best_q = { 0 };
+    best_q.score = -1;
+
+    for (int attempt = 0; attempt < CAPTURE_MAX_RETRY; attempt++) {
+        unsigned char *buf = NULL;
+        int len = 0;
+        struct s730b_quality q = { 0 };
+
+        if (attempt > 0)
+            init_sensor(dev);
 
-        unsigned char tmp[256];
-        r = libusb_bulk_transfer(
-            dev,
-            BULK_EP_IN,
-            tmp,
-            sizeof(tmp),
-            &transferred,
-            1000
-        );
-
-        if (r < 0) {
-            fprintf(stderr, "[-] bulk IN 실패 packet=%zu, err=%d\n", i, r);
-            break;
-        }
-        if (transferred == 0) {
-            fprintf(stderr, "[*] packet=%zu 에서 0 bytes 들어옴, 종료\n", i);
-            break;
+        uint64_t t0 = s730b_now_ns();
+        int r = capture_fingerprint(dev, &buf, &len);
+        uint64_t t1 = s730b_now_ns();
+        if (r < 0 || !buf)
+            continue;
+
+        if (len >= IMG_OFFSET + IMG_SIZE)
+            s730b_frame_quality(buf + IMG_OFFSET, IMG_WIDTH, IMG_HEIGHT, &q);
+        uint64_t t2 = s730b_now_ns();
+        s730b_metric_observe(MH_QUALITY, (uint64_t)(q.score < 0 ? 0 : q.score));
+        log_capture(buf, len, q.score, attempt > 0 ? CAPLOG_RETRY : 0);
+
+        printf("[*] capture %d/%d: %d bytes, quality=%d (coverage=%.2f, contrast=%.1f, coherence=%.2f)"
+               " capture=%.1fms score=%.3fms\n",
+               attempt + 1, CAPTURE_MAX_RETRY, len, q.score, q.coverage, q.contrast, q.coherence,
+               (t1 - t0) / 1e6, (t2 - t1) / 1e6);
+
+        if (q.score > best_q.score) {
+            free(best);
+            best = buf;
+            best_len = len;
+            best_q = q;
+        } else {
+            free(buf);
         }
 
-        if (total_len + transferred > capacity) {
-            capacity *= 2;
-            buf = realloc(buf, capacity);
-            if (!buf)
-                die("realloc(die)", -1);
-        }
-        memcpy(buf + total_len, tmp, transferred);
-        total_len += transferred;
-
-        // ACK (256 zeros)
-        unsigned char ack[256] = {0};
-        r = libusb_bulk_transfer(
-            dev,
-            BULK_EP_OUT,
-            ack,
-            sizeof(ack),
-            &transferred,
-            500
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] bulk ACK 실패 packet=%zu, err=%d\n", i, r);
+        if (q.score >= min_quality)
             break;
-        }
+        fprintf(stderr, "[-] 품질 낮음 (score=%d < %d), 재캡처\n", q.score, min_quality);
+        s730b_metric_inc(MC_RECAPTURE_QUALITY);
     }
 
-    *out_buf = buf;
-    *out_len = total_len;
-    return 0;
+    if (!best)
+        return -1;
+    if (wait_start_ns) {
+        s730b_metric_observe(MH_WAIT_TO_FRAME_US, (s730b_now_ns() - wait_start_ns) / 1000);
+        wait_start_ns = 0;
+    }
+    if (opts.metrics_path)
+        export_metrics();
 
-out_fail:
-    free(buf);
-    *out_buf = NULL;
-    *out_len = 0;
-    return -1;
+    *out_buf = best;
+    *out_len = best_len;
+    *out_q = best_q;
+    return 0;
 }
 
-static int detect_finger(libusb_device_handle *dev, unsigned char **out_buf, int *out_len, int max_packets) {
-    int r;
-    int transferred;
-    int total_len = 0;
-    int capacity = max_packets * BULK_PACKET_SIZE + 256;
-    unsigned char *buf = malloc(capacity);
-
-    if (!buf)
-        die("detect malloc fail", -1);
+/*
+ * burst 캡처 + 다중 프레임 합성
+ * - 한 세션에서 K장 연속 캡처 (프레임 사이 init_sensor() 안함)
+ * - USB 스레드(main)는 캡처만 계속 하고, 받은 프레임은 worker 스레드가 바로
+ *   destripe + 정합(shift 추정) 해둠 -> 마지막 프레임 끝나면 합성만 남음
+ * - 품질 낮은 프레임은 정합/합성에서 뺌, 첫 번째로 통과한 프레임이 기준(reference)
+ */
+struct burst_job {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned char frames[FUSION_MAX_FRAMES][IMG_SIZE];
+    struct s730b_shift shifts[FUSION_MAX_FRAMES];
+    int queued;     // USB 쪽에서 넣은 프레임 수
+    int closed;     // USB 쪽 캡처 끝남
+    int destripe;   // 정합 전에 destripe (--no-destripe면 0)
+    uint64_t busy_ns;
+};
 
-    // packet 0: 상태 응답만
-    {
-        uint16_t wIndex0 = capture_indices[0];
-
-        r = libusb_control_transfer(
-            dev,
-            0x40,
-            0xCA,
-            0x0003,
-            wIndex0,
-            NULL,
-            0,
-            500
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] detect: control 0xCA 실패 packet=0, err=%d\n", r);
-            goto out_fail;
-        }
+static void *burst_worker(void *arg) {
+    struct burst_job *job = arg;
+    int next = 0;
 
-        unsigned char start_cmd[256];
-        memset(start_cmd, 0, sizeof(start_cmd));
-        start_cmd[0] = 0xa8;
-        start_cmd[1] = 0x06;
-        start_cmd[2] = 0x00;
-        start_cmd[3] = 0x00;
-
-        r = libusb_bulk_transfer(
-            dev,
-            BULK_EP_OUT,
-            start_cmd,
-            sizeof(start_cmd),
-            &transferred,
-            500
-        );
-        if (r < 0) {
-            goto out_fail;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        while (next >= job->queued && !job->closed)
+            pthread_cond_wait(&job->cond, &job->lock);
+        if (next >= job->queued && job->closed) {
+            pthread_mutex_unlock(&job->lock);
+            break;
         }
+        pthread_mutex_unlock(&job->lock);
+
+        uint64_t t0 = s730b_now_ns();
+        if (job->destripe)
+            s730b_destripe(job->frames[next], IMG_WIDTH, IMG_HEIGHT);
+        if (next == 0)
+            job->shifts[0] = (struct s730b_shift){ 0.0f, 0.0f, 0 };
+        else
+            s730b_register_shift(job->frames[0], job->frames[next], IMG_WIDTH, IMG_HEIGHT, &job->shifts[next]);
+        job->busy_ns += s730b_now_ns() - t0;
+        next++;
+    }
+    return NULL;
+}
 
-        unsigned char tmp0[256];
-        r = libusb_bulk_transfer(
-            dev,
-            BULK_EP_IN,
-            tmp0,
-            sizeof(tmp0),
-            &transferred,
-            500
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] detect: 초기 상태 bulk IN 실패 packet=0, err=%d\n", r);
-            goto out_fail;
+static int capture_burst(struct s730b_transport *dev, const struct capture_opts *o) {
+    static struct burst_job job;
+    int count = o->burst;
+    const unsigned char *frames[FUSION_MAX_FRAMES];
+    uint64_t frame_ns[FUSION_MAX_FRAMES];
+    pthread_t worker;
+    int saved_raw = 0;
+
+    if (count > FUSION_MAX_FRAMES)
+        count = FUSION_MAX_FRAMES;
+
+    memset(&job, 0, sizeof(job));
+    job.destripe = o->destripe;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.cond, NULL);
+    if (pthread_create(&worker, NULL, burst_worker, &job) != 0)
+        die("burst worker 생성 실패", -1);
+
+    uint64_t t_start = s730b_now_ns();
+    for (int i = 0; i < count; i++) {
+        unsigned char *buf = NULL;
+        int len = 0;
+        struct s730b_quality q = { 0 };
+
+        uint64_t t0 = s730b_now_ns();
+        int r = capture_fingerprint(dev, &buf, &len);
+        frame_ns[i] = s730b_now_ns() - t0;
+        if (r < 0 || !buf) {
+            fprintf(stderr, "[-] burst %d/%d 캡처 실패\n", i + 1, count);
+            continue;
         }
 
-        if (transferred > 0) {
-            if (total_len + transferred > capacity) {
-                capacity *= 2;
-                buf = realloc(buf, capacity);
-                if (!buf)
-                    die("detect realloc 실패", -1);
+        if (len >= IMG_OFFSET + IMG_SIZE)
+            s730b_frame_quality(buf + IMG_OFFSET, IMG_WIDTH, IMG_HEIGHT, &q);
+        s730b_metric_observe(MH_QUALITY, (uint64_t)(q.score < 0 ? 0 : q.score));
+        log_capture(buf, len, q.score, CAPLOG_BURST);
+        printf("[*] burst %d/%d: %d bytes, quality=%d, %.1fms\n",
+               i + 1, count, len, q.score, frame_ns[i] / 1e6);
+
+        if (q.score >= o->min_quality) {
+            // worker가 destripe하니까 원본 그대로 넘김 (아래 capture.pgm용 destripe 전에)
+            pthread_mutex_lock(&job.lock);
+            memcpy(job.frames[job.queued], buf + IMG_OFFSET, IMG_SIZE);
+            job.queued++;
+            pthread_cond_signal(&job.cond);
+            pthread_mutex_unlock(&job.lock);
+
+            // 첫 통과 프레임은 원래처럼 capture.raw / capture.pgm으로도 남김
+            if (!saved_raw) {
+                FILE *f = capture_log_on ? NULL : fopen("capture.raw", "wb");
+                if (f) {
+                    fwrite(buf, 1, len, f);
+                    fclose(f);
+                }
+                if (o->destripe)
+                    s730b_destripe(buf + IMG_OFFSET, IMG_WIDTH, IMG_HEIGHT);
+                save_pgm_from_raw(buf, len, "capture.pgm", 1);
+                saved_raw = 1;
             }
-            memcpy(buf + total_len, tmp0, transferred);
-            total_len += transferred;
         }
+        free(buf);
+    }
+    uint64_t t_usb = s730b_now_ns();
+
+    pthread_mutex_lock(&job.lock);
+    job.closed = 1;
+    pthread_cond_signal(&job.cond);
+    pthread_mutex_unlock(&job.lock);
+    pthread_join(worker, NULL);
+    pthread_mutex_destroy(&job.lock);
+    pthread_cond_destroy(&job.cond);
+
+    int n = job.queued;
+    if (n == 0) {
+        fprintf(stderr, "[-] burst: 품질 통과한 프레임 없음\n");
+        return -1;
+    }
+
+    for (int k = 0; k < n; k++) {
+        frames[k] = job.frames[k];
+        if (k > 0)
+            printf("[*] frame %d shift: dx=%.2f dy=%.2f (rms=%d)\n",
+                   k, job.shifts[k].dx, job.shifts[k].dy, job.shifts[k].rms);
     }
 
-    // packet 1: 일부 데이터만 읽고 ACK
-    for (int i = 1; i < max_packets; i++) {
-        uint16_t wIndex = capture_indices[i];
-
-        r = libusb_control_transfer(
-            dev,
-            0x40,
-            0xCA,
-            0x0003,
-            wIndex,
-            NULL,
-            0,
-            500
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] detect: control 0xCA 실패 packet=%d, err=%d\n", i, r);
+    unsigned char fused[IMG_SIZE * FUSION_SCALE * FUSION_SCALE];
+    s730b_fuse_frames(frames, job.shifts, n, IMG_WIDTH, IMG_HEIGHT, fused);
+    uint64_t t_end = s730b_now_ns();
+
+    save_pgm(fused, IMG_WIDTH * FUSION_SCALE, IMG_HEIGHT * FUSION_SCALE, "capture_fused.pgm", 1);
+    if (o->enhance)
+        save_enhanced(fused, IMG_WIDTH * FUSION_SCALE, IMG_HEIGHT * FUSION_SCALE, "capture_fused_enhanced.pgm");
+
+    /*
+     * latency 리포트
+     * - 추가 프레임당 비용 = (burst 전체 - 첫 프레임) / (K - 1)
+     * - tail = USB 끝난 뒤 정합 마무리 + 합성에 걸린 시간 (worker가 USB랑 겹쳐서 일한 만큼 줄어듦)
+     */
+    double total_ms = (t_end - t_start) / 1e6;
+    double first_ms = frame_ns[0] / 1e6;
+    printf("[+] burst 완료: %d/%d 프레임 합성, total=%.1fms, first=%.1fms", n, count, total_ms, first_ms);
+    if (count > 1)
+        printf(", +%.1fms/추가프레임", (total_ms - first_ms) / (count - 1));
+    printf(", worker=%.2fms (USB랑 겹침), tail=%.2fms\n", job.busy_ns / 1e6, (t_end - t_usb) / 1e6);
+    return 0;
+}
+
+/*
+ * N번 눌러서 등록 (장치 한 번 열고 계속 씀)
+ * - USB 스레드(main): 손가락 대기 -> 캡처 -> 뗄 때까지 짧은 probe 반복 -> 다음 누름
+ * - worker 스레드: 받은 프레임 destripe -> Gabor -> 특징점 -> 템플릿 (사용자가 손가락 떼고
+ *   다시 누르는 동안 처리 끝남) -> 마지막에 s730b_enroll_compose로 합성만 남음
+ */
+struct enroll_job {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned char frames[ENROLL_MAX_STAGES][IMG_SIZE];
+    struct s730b_template templates[ENROLL_MAX_STAGES];
+    uint64_t proc_ns[ENROLL_MAX_STAGES];
+    int destripe;
+    int queued;
+    int closed;
+};
+
+static void *enroll_worker(void *arg) {
+    struct enroll_job *job = arg;
+    struct s730b_gabor_bank bank;
+    unsigned char enh[IMG_SIZE];
+    struct s730b_minutiae m;
+    int next = 0;
+
+    s730b_gabor_bank_init(&bank, ENH_PERIOD_NATIVE);
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        while (next >= job->queued && !job->closed)
+            pthread_cond_wait(&job->cond, &job->lock);
+        if (next >= job->queued && job->closed) {
+            pthread_mutex_unlock(&job->lock);
             break;
         }
+        pthread_mutex_unlock(&job->lock);
 
-        unsigned char tmp[256];
-        r = libusb_bulk_transfer(
-            dev,
-            BULK_EP_IN,
-            tmp,
-            sizeof(tmp),
-            &transferred,
-            700
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] detect: bulk IN 실패 packet=%d, err=%d\n", i, r);
-            break;
+        uint64_t t0 = s730b_now_ns();
+        unsigned char *img = job->frames[next];
+        char fname[32];
+
+        // PGM은 옵션 따라, 특징점은 항상 destripe한 걸로 뽑음
+        if (!job->destripe) {
+            snprintf(fname, sizeof(fname), "enroll_%d.pgm", next + 1);
+            save_pgm(img, IMG_WIDTH, IMG_HEIGHT, fname, 1);
         }
-        if (transferred == 0) {
-            fprintf(stderr, "[*] detect: packet=%d 에서 0 bytes, 종료\n", i);
-            break;
+        s730b_destripe(img, IMG_WIDTH, IMG_HEIGHT);
+        if (job->destripe) {
+            snprintf(fname, sizeof(fname), "enroll_%d.pgm", next + 1);
+            save_pgm(img, IMG_WIDTH, IMG_HEIGHT, fname, 1);
         }
 
-        if (total_len + transferred > capacity) {
-            capacity *= 2;
-            buf = realloc(buf, capacity);
-            if (!buf)
-                die("detect realloc 실패", -1);
+        memset(&m, 0, sizeof(m));
+        if (s730b_gabor_enhance(&bank, img, IMG_WIDTH, IMG_HEIGHT, enh, NULL) == 0)
+            s730b_extract_minutiae(enh, IMG_WIDTH, IMG_HEIGHT, &m);
+        s730b_template_build(&m, &job->templates[next]);
+        job->proc_ns[next] = s730b_now_ns() - t0;
+        next++;
+    }
+    return NULL;
+}
+
+static int enroll_session(struct s730b_transport *dev, const struct capture_opts *o) {
+    static struct enroll_job job;
+    int count = o->enroll;
+    uint64_t wait_ns[ENROLL_MAX_STAGES], cap_ns[ENROLL_MAX_STAGES], lift_ns[ENROLL_MAX_STAGES];
+    int quality[ENROLL_MAX_STAGES];
+    pthread_t worker;
+    int r = 0;
+
+    if (count > ENROLL_MAX_STAGES)
+        count = ENROLL_MAX_STAGES;
+
+    memset(&job, 0, sizeof(job));
+    job.destripe = o->destripe;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.cond, NULL);
+    if (pthread_create(&worker, NULL, enroll_worker, &job) != 0)
+        die("enroll worker 생성 실패", -1);
+
+    uint64_t t_start = s730b_now_ns();
+    for (int i = 0; i < count; i++) {
+        unsigned char *buf = NULL;
+        int len = 0;
+        struct s730b_quality q = { 0 };
+
+        printf("[*] 등록 %d/%d: 손가락을 센서위에 올려놓으세요...\n", i + 1, count);
+        uint64_t t0 = s730b_now_ns();
+        if (!wait_finger(dev)) {
+            fprintf(stderr, "[-] 등록 %d/%d: 손가락 대기 시간 초과\n", i + 1, count);
+            r = -1;
+            break;
         }
-        memcpy(buf + total_len, tmp, transferred);
-        total_len += transferred;
-
-        unsigned char ack[256] = {0};
-        r = libusb_bulk_transfer(
-            dev,
-            BULK_EP_OUT,
-            ack,
-            sizeof(ack),
-            &transferred,
-            500
-        );
-        if (r < 0) {
-            fprintf(stderr, "[-] detect: bulk ACK 실패 packet=%d, err=%d\n", i, r);
+        uint64_t t1 = s730b_now_ns();
+        int cr = capture_good_frame(dev, &buf, &len, o->min_quality, &q);
+        uint64_t t2 = s730b_now_ns();
+        if (cr < 0 || !buf || len < IMG_OFFSET + IMG_SIZE) {
+            fprintf(stderr, "[-] 등록 %d/%d: 캡처 실패\n", i + 1, count);
+            free(buf);
+            r = -1;
             break;
         }
+
+        pthread_mutex_lock(&job.lock);
+        memcpy(job.frames[job.queued], buf + IMG_OFFSET, IMG_SIZE);
+        job.queued++;
+        pthread_cond_signal(&job.cond);
+        pthread_mutex_unlock(&job.lock);
+        free(buf);
+
+        wait_ns[i] = t1 - t0;
+        cap_ns[i] = t2 - t1;
+        quality[i] = q.score;
+
+        // 마지막 누름은 뗄 때까지 안 기다림
+        if (i + 1 < count) {
+            printf("[*] 등록 %d/%d: 캡처 완료 (quality=%d), 손가락을 떼세요\n", i + 1, count, q.score);
+            if (!wait_finger_lost(dev)) {
+                fprintf(stderr, "[-] 등록 %d/%d: 손가락 떼기 대기 시간 초과\n", i + 1, count);
+                r = -1;
+                break;
+            }
+        }
+        lift_ns[i] = s730b_now_ns() - t2;
     }
+    uint64_t t_usb = s730b_now_ns();
+
+    pthread_mutex_lock(&job.lock);
+    job.closed = 1;
+    pthread_cond_signal(&job.cond);
+    pthread_mutex_unlock(&job.lock);
+    pthread_join(worker, NULL);
+    pthread_mutex_destroy(&job.lock);
+    pthread_cond_destroy(&job.cond);
+
+    int n = job.queued;
+    if (r < 0 || n == 0)
+        return -1;
 
-    *out_buf = buf;
-    *out_len = total_len;
+    static struct s730b_template comp;
+    static struct s730b_gallery g;
+    struct s730b_enroll_info info;
+    const struct s730b_template *stages[ENROLL_MAX_STAGES];
+    for (int k = 0; k < n; k++)
+        stages[k] = &job.templates[k];
+    s730b_enroll_compose(stages, n, &comp, &info);
+    uint64_t t_end = s730b_now_ns();
+
+    /*
+     * enroll.gal: record 0 = 합성 템플릿 (id 0), 그 뒤로 합성에 못 붙은 누름 (id = 누름 번호)
+     * - 합성 템플릿으로 verify 실패하면 나머지 record도 비교 (s730b_enroll.h)
+     */
+    int leftover = 0;
+    if (s730b_gallery_create("enroll.gal", ENROLL_MAX_STAGES + 1) < 0 || s730b_gallery_open(&g, "enroll.gal", 1) < 0) {
+        fprintf(stderr, "[-] enroll.gal 만들기 실패\n");
+        return -1;
+    }
+    int ar = s730b_gallery_append(&g, &comp, 0);
+    for (int k = 0; k < n && ar >= 0; k++) {
+        if (info.stage_score[k] >= 0)
+            continue;
+        ar = s730b_gallery_append(&g, &job.templates[k], (uint32_t)(k + 1));
+        leftover++;
+    }
+    s730b_gallery_close(&g);
+    if (ar < 0) {
+        fprintf(stderr, "[-] enroll.gal 쓰기 실패\n");
+        return -1;
+    }
+    printf("[+] 등록 갤러리 저장됨: enroll.gal (합성 1개 + 따로 %d개)\n", leftover);
+
+    /*
+     * latency 리포트
+     * - wait = 손가락 감지까지 (사용자 시간 포함), capture = 감지 -> 프레임 받음 (재캡처 포함)
+     * - lift = 캡처 끝 -> 뗀 거 확인, proc = worker 처리 (USB랑 겹침)
+     * - tail = 마지막 캡처 뒤 남은 처리 + 합성
+     */
+    for (int k = 0; k < n; k++)
+        printf("[*] press %d: quality=%d, minutiae=%d, %s, wait=%.1fms capture=%.1fms lift=%.1fms proc=%.2fms\n",
+               k + 1, quality[k], job.templates[k].count,
+               info.stage_score[k] >= 0 ? "merged" : "not merged",
+               wait_ns[k] / 1e6, cap_ns[k] / 1e6, lift_ns[k] / 1e6, job.proc_ns[k] / 1e6);
+    printf("[+] 등록 완료: %d번 눌러서 %d개 합성, 특징점 %d개, session=%.1fms, tail=%.2fms\n",
+           n, info.used, comp.count, (t_end - t_start) / 1e6, (t_end - t_usb) / 1e6);
     return 0;
+}
 
-out_fail:
+/*
+ * --identify GALLERY: 한 번 눌러서 갤러리 전체에서 1:N 검색
+ * - 갤러리는 읽기 전용으로 열고 레코드 영역을 그대로 s730b_identify에 넘김 (복사 없음)
+ * - 특징점은 enroll이랑 같은 경로 (destripe -> Gabor -> 특징점), 저장 옵션은 안 봄
+ */
+static int identify_session(struct s730b_transport *dev, const struct capture_opts *o) {
+    static struct s730b_gallery g;
+    static struct s730b_gabor_bank bank;
+    static struct s730b_template probe;
+    static struct s730b_minutiae m;
+    static struct s730b_pool pool;
+    unsigned char img[IMG_SIZE], enh[IMG_SIZE];
+    struct s730b_ident_hit hits[IDENT_MAX_TOPK];
+    struct s730b_ident_stats st = { 0 };
+    struct s730b_ident_opts io = { .topk = 5, .threshold = MATCH_THRESHOLD, .accept = 0 };
+    unsigned char *buf = NULL;
+    int len = 0;
+    struct s730b_quality q = { 0 };
+    size_t stride;
+
+    if (s730b_gallery_open(&g, o->identify_path, 0) < 0) {
+        fprintf(stderr, "[-] 갤러리 열기 실패: %s\n", o->identify_path);
+        return -1;
+    }
+    printf("[*] 갤러리: %s (%d개)\n", o->identify_path, g.count);
+
+    printf("[*] 손가락을 센서위에 올려놓으세요...\n\12");
+    if (!wait_finger(dev)) {
+        s730b_gallery_close(&g);
+        fprintf(stderr, "[-] 손가락 대기 시간 초과\n");
+        return -1;
+    }
+    uint64_t t0 = s730b_now_ns();
+    int cr = capture_good_frame(dev, &buf, &len, o->min_quality, &q);
+    uint64_t t1 = s730b_now_ns();
+    if (cr < 0 || !buf || len < IMG_OFFSET + IMG_SIZE) {
+        free(buf);
+        s730b_gallery_close(&g);
+        fprintf(stderr, "[-] 캡처 실패\n");
+        return -1;
+    }
+    memcpy(img, buf + IMG_OFFSET, IMG_SIZE);
     free(buf);
-    *out_buf = NULL;
-    *out_len = 0;
-    return -1;
+
+    s730b_gabor_bank_init(&bank, ENH_PERIOD_NATIVE);
+    s730b_destripe(img, IMG_WIDTH, IMG_HEIGHT);
+    memset(&m, 0, sizeof(m));
+    if (s730b_gabor_enhance(&bank, img, IMG_WIDTH, IMG_HEIGHT, enh, NULL) == 0)
+        s730b_extract_minutiae(enh, IMG_WIDTH, IMG_HEIGHT, &m);
+    s730b_template_build(&m, &probe);
+    uint64_t t2 = s730b_now_ns();
+
+    // 갤러리 작으면 스레드 띄우는 게 더 느림
+    int pooled = g.count >= 4 * IDENT_BLOCK;
+    if (pooled && s730b_pool_init(&pool, 0) < 0)
+        pooled = 0;
+    const void *records = s730b_gallery_records(&g, &stride);
+    int nh = s730b_identify(pooled ? &pool : NULL, &probe, records, g.count, stride, &io, hits, &st);
+    uint64_t t3 = s730b_now_ns();
+    if (pooled)
+        s730b_pool_destroy(&pool);
+
+    if (nh < 0) {
+        s730b_gallery_close(&g);
+        fprintf(stderr, "[-] 검색 실패\n");
+        return -1;
+    }
+    printf("[+] 캡처 quality=%d, 특징점 %d개\n", q.score, probe.count);
+    if (nh == 0)
+        printf("[-] 일치 없음 (threshold %d)\n", io.threshold);
+    for (int k = 0; k < nh; k++)
+        printf("[+] #%d: record %d, id=%u, score=%d\n",
+               k + 1, hits[k].index, g.index[hits[k].index].id, hits[k].score);
+    printf("[*] capture=%.1fms template=%.2fms search=%.2fms (%s비교 %ld개, 중간 포기 %d개)\n",
+           (t1 - t0) / 1e6, (t2 - t1) / 1e6, (t3 - t2) / 1e6,
+           pooled ? "스레드 " : "", st.compared, st.cancelled);
+    s730b_gallery_close(&g);
+    return 0;
+}
+
+// out_status = 앞쪽 상태 응답 길이 (이미지 데이터는 buf + out_status부터)
+static int detect_finger(struct s730b_transport *dev, unsigned char **out_buf, int *out_len, int *out_status,
+                         int max_packets) {
+    struct s730b_proto_stats st;
+    int capacity = max_packets * BULK_PACKET_SIZE + 256;
+    unsigned char *buf = malloc(capacity);
+
+    if (!buf)
+        die("detect malloc fail", -1);
+
+    // packet 0 상태 응답 + 일부 데이터만 읽고 ACK
+    uint64_t t0 = s730b_now_ns();
+    int len;
+    if (session_on) {
+        struct s730b_session_req req = {
+            .kind = SESSION_PROBE, .packets = max_packets, .flags = PROTO_PROBE, .buf = buf, .cap = capacity,
+        };
+        len = s730b_session_submit(&session, &req, SESSION_WAIT_MS);
+        st = req.st;
+    } else {
+        len = s730b_proto_capture(dev, max_packets, PROTO_PROBE, buf, capacity, &st);
+    }
+    print_proto_error("detect: ", &st);
+    s730b_metric_inc(MC_DETECT_PROBE);
+    s730b_metric_observe(MH_DETECT_US, (s730b_now_ns() - t0) / 1000);
+    if (len < 0) {
+        s730b_metric_inc(MC_DETECT_ERROR);
+        free(buf);
+        *out_buf = NULL;
+        *out_len = 0;
+        *out_status = 0;
+        return -1;
+    }
+
+    *out_buf = buf;
+    *out_len = len;
+    *out_status = st.status_len;
+    return 0;
 }
 
 static int has_fingerprint_in_detect(const unsigned char *data, int len) {
@@ -563,18 +1084,107 @@ static int has_fingerprint_in_detect(const unsigned char *data, int len) {
     return 0;
 }
 
-static int wait_finger(libusb_device_handle *dev) {
+/*
+ * probe 판정 (--texture-detect면 s730b_texture, --baseline-detect면 s730b_detect, 아니면 원래 절대 문턱)
+ * - detect_finger 결과 앞에는 chunk 0 상태 응답(몇 바이트)이 붙어 있어서 뺌
+ * - 무늬 판정에서 스침(coverage 낮음)이면 풀 캡처해도 half.raw 같은 프레임이라 없는 걸로 침
+ */
+static int probe_decision(const unsigned char *buf, int len, int status) {
+    if (opts.texture_detect) {
+        struct s730b_texture t;
+        if (len - status < IMG_OFFSET ||
+            s730b_texture_classify(buf + status + IMG_OFFSET, len - status - IMG_OFFSET, IMG_WIDTH, &t) < 0)
+            return MC_DETECT_EMPTY;
+        capture_meta.detect_score = (int32_t)(t.coverage * 1000);
+        return t.graze ? MC_DETECT_GRAZE : t.present ? MC_DETECT_FINGER : MC_DETECT_EMPTY;
+    }
+    if (opts.baseline_detect) {
+        struct s730b_detect_score sc = { 0 };
+        int r = s730b_detect_probe(&finger_detect, buf + status, len - status, &sc);
+        capture_meta.detect_score = sc.sad;
+        return r == 1 ? MC_DETECT_FINGER : MC_DETECT_EMPTY;
+    }
+    return has_fingerprint_in_detect(buf, len) ? MC_DETECT_FINGER : MC_DETECT_EMPTY;
+}
+
+/*
+ * probe packet 수: 판정은 texture > baseline > 원래 순서라 (probe_decision) 고르는 것도 같은 순서
+ * - plain = 둘 다 안 쓸 때 (wait_finger 6, wait_finger_lost FINGER_LOST_PACKETS)
+ */
+static int probe_packets(int plain) {
+    if (opts.texture_detect)
+        return TEXTURE_PROBE_PACKETS;
+    if (opts.baseline_detect)
+        return DETECT_PROBE_PACKETS;
+    return plain;
+}
+
+/*
+ * lifting = 0 (누름 기다림): 스침은 없는 걸로 (풀 캡처 안 함)
+ * lifting = 1 (떼기 기다림): 스침은 아직 덜 뗀 걸로 (있음)
+ */
+static int finger_in_probe(const unsigned char *buf, int len, int status, int lifting) {
+    int d = probe_decision(buf, len, status);
+    s730b_metric_inc(d);
+    if (d == MC_DETECT_GRAZE && !lifting)
+        printf("[*] 스침 (coverage=%.2f), 풀 캡처 안 함\n", capture_meta.detect_score / 1000.0);
+    return d == MC_DETECT_FINGER || (lifting && d == MC_DETECT_GRAZE);
+}
+
+// --metrics: 지금까지 카운터 파일로 (tmp에 쓰고 rename)
+static void export_metrics(void) {
+    if (s730b_metrics_export(opts.metrics_path) < 0)
+        fprintf(stderr, "[-] metrics 내보내기 실패: %s\n", opts.metrics_path);
+}
+
+/*
+ * --log: 캡처한 프레임 그대로 + 마지막 감지/전송 통계를 캡처 로그에
+ * - 큐에 복사만 하고 바로 리턴 (파일 쓰기는 writer 스레드), 큐 꽉 차면 버림
+ */
+static void log_capture(const unsigned char *buf, int len, int quality, uint32_t flags) {
+    if (!capture_log_on)
+        return;
+
+    struct s730b_caplog_meta m = capture_meta;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    m.ts_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    m.quality = (int16_t)quality;
+    m.flags |= flags;
+    if (s730b_caplog_append(&capture_log, buf, len, &m) < 0)
+        fprintf(stderr, "[-] 캡처 로그 큐 꽉 참, 프레임 버림\n");
+}
+
+// 프로그램 끝날 때 (die() 포함) 큐 비우고 index 붙여서 닫음
+static void close_capture_log(void) {
+    if (!capture_log_on)
+        return;
+    capture_log_on = 0;
+    if (s730b_caplog_close(&capture_log) < 0)
+        fprintf(stderr, "[-] 캡처 로그 닫기 실패\n");
+    else
+        printf("[+] 캡처 로그: %llu개 기록 (버림 %llu), 세그먼트 %u까지, raw %.1f KB -> 파일 %.1f KB\n",
+               (unsigned long long)capture_log.written, (unsigned long long)capture_log.dropped,
+               capture_log.segment, capture_log.raw_bytes / 1e3, capture_log.bytes / 1e3);
+}
+
+static int wait_finger(struct s730b_transport *dev) {
     const int max_loop = 10;
     const int detect_per_loop = 10;
+    uint64_t t0 = s730b_now_ns();
 
+    wait_start_ns = t0;
+    capture_meta.detect_probes = 0;
     for (int loop = 0; loop < max_loop; loop++) {
         for (int i = 0; i < detect_per_loop; i++) {
             init_sensor(dev);
+            capture_meta.detect_probes++;
+            capture_meta.wait_us = (uint32_t)((s730b_now_ns() - t0) / 1000);
             unsigned char *buf = NULL;
-            int len = 0;
-            int r = detect_finger(dev, &buf, &len, 6);
+            int len = 0, status = 0;
+            int r = detect_finger(dev, &buf, &len, &status, probe_packets(6));
             if (r == 0 && buf) {
-                int finger = has_fingerprint_in_detect(buf, len);
+                int finger = finger_in_probe(buf, len, status, 0);
                 free(buf);
                 init_sensor(dev);
                 if (finger) return 1;
@@ -587,6 +1197,37 @@ static int wait_finger(libusb_device_handle *dev) {
     return 0;
 }
 
+/*
+ * 손가락 뗐는지 확인 (등록 누름 사이)
+ * - wait_finger랑 같은 detect 방식 + 같은 probe 크기, 간격만 50ms
+ *   (짧은 probe는 --baseline-detect일 때만, --texture-detect면 스침도 아직 있는 걸로 봄)
+ * - 중간에 한 번 잘못 읽혀도 안 넘어가게 연속 FINGER_LOST_CONFIRM번 "없음"일 때만 뗀 걸로 봄
+ */
+static int wait_finger_lost(struct s730b_transport *dev) {
+    int absent = 0;
+
+    for (int i = 0; i < FINGER_LOST_MAX_PROBES; i++) {
+        init_sensor(dev);
+        unsigned char *buf = NULL;
+        int len = 0, status = 0;
+        int finger = 1;
+        int r = detect_finger(dev, &buf, &len, &status, probe_packets(FINGER_LOST_PACKETS));
+        if (r == 0 && buf)
+            finger = finger_in_probe(buf, len, status, 1);
+        free(buf);
+
+        absent = finger ? 0 : absent + 1;
+        if (absent >= FINGER_LOST_CONFIRM) {
+            init_sensor(dev);
+            return 1;
+        }
+
+        struct timespec ts = { 0, 50 * 1000 * 1000 }; // 50ms
+        nanosleep(&ts, NULL);
+    }
+    return 0;
+}
+
 static int save_pgm_from_raw(const unsigned char *raw, int raw_len, const char *fname, int rotate_90) {
     int needed = IMG_OFFSET + IMG_WIDTH * IMG_HEIGHT;
     if (raw_len < needed) {
@@ -594,63 +1235,70 @@ static int save_pgm_from_raw(const unsigned char *raw, int raw_len, const char *
         return -1;
     }
 
-    const unsigned char *src = raw + IMG_OFFSET;
-
-    int w = IMG_WIDTH;
-    int h = IMG_HEIGHT;
-
-    const unsigned char *img_data = NULL;
-    unsigned char *rotated = NULL;
+    return save_pgm(raw + IMG_OFFSET, IMG_WIDTH, IMG_HEIGHT, fname, rotate_90);
+}
 
-    if (!rotate_90) {
-        img_data = src;
-    } else {
-        rotated = malloc(w * h);
-        if (!rotated) {
-            fprintf(stderr, "[-] rotate용 메모리 malloc 실패\n");
+/*
+ * 회전은 s730b_write_pgm/png가 줄 뽑으면서 바로 함 (회전 복사본 없음)
+ * - --png면 확장자 .pgm -> .png 바꿔서 PNG로
+ */
+static int save_pgm(const unsigned char *src, int w, int h, const char *fname, int rotate_90) {
+    const int ow = rotate_90 ? h : w, oh = rotate_90 ? w : h;
+
+    if (opts.png) {
+        char png_name[256];
+        const char *dot = strrchr(fname, '.');
+        int base = dot ? (int)(dot - fname) : (int)strlen(fname);
+        snprintf(png_name, sizeof(png_name), "%.*s.png", base, fname);
+
+        if (s730b_write_png(png_name, src, w, h, rotate_90, PNG_LEVEL_FAST) < 0) {
+            fprintf(stderr, "[-] %s 쓰기 실패\n", png_name);
             return -1;
         }
-
-        // 왼쪽으로 90도 회전
-        for (int y = 0; y < h; y++) {
-            for (int x = 0; x < w; x++) {
-                int src_idx = y * w + x;
-                int x2 = y;
-                int y2 = (w - 1 - x);
-                int dst_idx = y2 * h + x2;
-                rotated[dst_idx] = src[src_idx];
-            }
-        }
-
-        int tmp = w;
-        w = h;
-        h = tmp;
-        img_data = rotated;
+        printf("[+] PNG 저장됨: %s (width=%d, height=%d, rotate_90=%d)\n",
+               png_name, ow, oh, rotate_90);
+        return 0;
     }
 
-    FILE *f = fopen(fname, "wb");
-    if (!f) {
-        fprintf(stderr, "[-] %s 열기 실패\n", fname);
-        free(rotated);
+    if (s730b_write_pgm(fname, src, w, h, rotate_90) < 0) {
+        fprintf(stderr, "[-] %s 쓰기 실패\n", fname);
         return -1;
     }
 
-    fprintf(f, "P5\n%d %d\n255\n", w, h);
+    printf("[+] PGM 저장됨: %s (width=%d, height=%d, rotate_90=%d)\n",
+           fname, ow, oh, rotate_90);
+    return 0;
+}
 
-    size_t img_size = (size_t)(w * h);
-    if (fwrite(img_data, 1, img_size, f) != img_size) {
-        fprintf(stderr, "[-] PGM 데이터 쓰기 실패\n");
-        fclose(f);
-        free(rotated);
+/*
+ * Gabor 융선 강조 결과 저장 + 특징점 개수 출력
+ * - bank는 해상도(배율)별로 처음 한 번만 만듦
+ */
+static int save_enhanced(const unsigned char *img, int w, int h, const char *fname) {
+    static struct s730b_gabor_bank bank;
+    unsigned char *out = malloc((size_t)w * h);
+    if (!out)
         return -1;
-    }
 
-    fclose(f);
-    free(rotated);
+    float period = ENH_PERIOD_NATIVE * w / IMG_WIDTH;
+    if (bank.period != period)
+        s730b_gabor_bank_init(&bank, period);
+
+    uint64_t t0 = s730b_now_ns();
+    int r = s730b_gabor_enhance(&bank, img, w, h, out, NULL);
+    uint64_t t1 = s730b_now_ns();
+    if (r == 0) {
+        struct s730b_minutiae m;
+        s730b_extract_minutiae(out, w, h, &m);
+        uint64_t t2 = s730b_now_ns();
+
+        printf("[*] Gabor enhance %dx%d: %.2fms, minutiae %d개: %.2fms\n",
+               w, h, (t1 - t0) / 1e6, m.count, (t2 - t1) / 1e6);
+        r = save_pgm(out, w, h, fname, 1);
+    }
 
-    printf("[+] PGM 저장됨: %s (width=%d, height=%d, rotate_90=%d)\n",
-           fname, w, h, rotate_90);
-    return 0;
+    free(out);
+    return r;
 }
 
 static void die(const char *msg, int err) {
@@ -9,16 +9,31 @@ Samsung 730B 지문인식 드라이버
   - 유효 지문 영역: offset 180부터 112x96 (세로줄/가로줄 없는 오프셋과 해상도)
   - 왼쪽으로 90도 회전해야 내가보는 방향과 맞음
 
+- 같은 디렉터리에 _s730b 확장 모듈 (s730b_py.c) 빌드돼 있으면 init/감지/캡처를 C(s730b_proto)로 함
+  - pyusb면 캡처 한 번에 transfer 84 x 3개를 파이썬에서 하나씩 -> 확장은 한 번 불러서 끝 (USB 도는 동안 GIL 풂)
+  - --no-native: 예전처럼 pyusb로
+
 Copylight 2025 lignah
 """
 
-import usb.core
-import usb.util
 import time
 import argparse
 from datetime import datetime
 from enum import Enum, auto
 
+try:
+    import usb.core
+    import usb.util
+    HAS_PYUSB = True
+except ImportError:
+    HAS_PYUSB = False
+
+try:
+    import _s730b
+    HAS_NATIVE = True
+except ImportError:
+    HAS_NATIVE = False
+
 try:
     from PIL import Image
     HAS_PIL = True
@@ -43,6 +58,13 @@ class CaptureError(Samsung730BError):
     """캡처 실패"""
 
 
+def frame_flags_str(flags):
+    """_s730b.Device.frame_flags -> "truncated,duplicate" (s730b_frame_flags_str이랑 같은 이름)"""
+    names = [(_s730b.FRAME_TRUNCATED, "truncated"), (_s730b.FRAME_SHORT_CHUNK, "short_chunk"),
+             (_s730b.FRAME_NO_IMAGE, "no_image"), (_s730b.FRAME_DUPLICATE, "duplicate")]
+    return ",".join(name for bit, name in names if flags & bit) or f"0x{flags:x}"
+
+
 class Samsung730B:
     VID = 0x04e8
     PID = 0x730b
@@ -62,13 +84,27 @@ class Samsung730B:
     CAPTURE_PACKET_SIZE = 256
     CAPTURE_NUM_PACKETS = 85
     CAPTURE_START_INDEX = 0x032A
-
-    def __init__(self, debug=False):
+    CAPTURE_MAX_RETRY = 3       # native: 잘린 / 밀린 / 중복 프레임이면 다시 찍는 횟수 (C capture_good_frame이랑 같음)
+
+    def __init__(self, debug=False, native=None, sim=None, sim_scale=0.0):
+        """
+        native: None = _s730b 있으면 씀, True = 꼭 씀, False = pyusb
+        sim: raw 경로 목록이면 장치 대신 센서 모델 (_s730b 필요, 벤치용)
+             native=False면 transfer 하나씩 파이썬 경로 그대로 (pyusb 대신 _s730b.Device.control/bulk_*)
+        sim_scale: 센서 모델 transfer 시간 배율 (0 = 안 기다림, 1 = 트레이스 시간 그대로)
+        """
         self.dev = None
         self.ep_out = None
         self.ep_in = None
+        self.native = None      # _s730b.Device: init/감지/캡처 통째로
+        self.io = None          # _s730b.Device: transfer 하나씩 (sim + native=False)
         self.state = SensorState.DISCONNECTED
         self.debug = debug
+        self.sim = sim
+        self.sim_scale = sim_scale
+        self.use_native = HAS_NATIVE if native is None else native
+        if (self.use_native or sim) and not HAS_NATIVE:
+            raise Samsung730BError("_s730b 확장 모듈 없음 (README 빌드 참고)")
 
     # ---------- 내부 헬퍼 ----------
 
@@ -77,7 +113,7 @@ class Samsung730B:
             print(f"[DEBUG] {msg}")
 
     def _ensure_open(self):
-        if not self.dev:
+        if not self.dev and not self.io:
             raise Samsung730BError("장치가 열려있지 않음")
 
     # ---------- 장치 제어 ----------
@@ -86,6 +122,28 @@ class Samsung730B:
         """장치 열고 센서 초기화함"""
         self.state = SensorState.INITIALIZING
 
+        if self.use_native or self.sim:
+            try:
+                if self.sim:
+                    d = _s730b.Device(sim=self.sim, scale=self.sim_scale)
+                else:
+                    d = _s730b.Device()
+            except _s730b.Error as e:
+                self.state = SensorState.ERROR
+                raise Samsung730BError(f"Samsung 730B 장치를 찾을 수 없음: {e}") from e
+            if self.use_native:
+                self.native = d
+            else:
+                self.io = d
+            self._log(f"_s730b {'native' if self.use_native else 'transfer 단위'}{' (sim)' if self.sim else ''}")
+            self._init_sensor()
+            self.state = SensorState.IDLE
+            return True
+
+        if not HAS_PYUSB:
+            self.state = SensorState.ERROR
+            raise Samsung730BError("pyusb 없음 (pip install pyusb) 또는 _s730b 빌드")
+
         self.dev = usb.core.find(idVendor=self.VID, idProduct=self.PID)
         if self.dev is None:
             self.state = SensorState.ERROR
@@ -116,6 +174,11 @@ class Samsung730B:
 
     def close(self):
         """장치 닫기"""
+        for d in (self.native, self.io):
+            if d is not None:
+                d.close()
+        self.native = None
+        self.io = None
         if self.dev:
             try:
                 usb.util.dispose_resources(self.dev)
@@ -142,6 +205,8 @@ class Samsung730B:
         if request == 0xCA:
             self._log(f"[CTRL-0xCA] wIndex=0x{index:04x}")
 
+        if self.io is not None:
+            return self.io.control(request, value, index, data, timeout=timeout)
         return self.dev.ctrl_transfer(
             bmRequestType, request, value, index,
             data, timeout=timeout
@@ -150,12 +215,21 @@ class Samsung730B:
     def _bulk_out(self, data, timeout=500):
         self._ensure_open()
         self._log(f"bulk OUT ({len(data)} bytes): {data[:16].hex(' ')} ...")
+        if self.io is not None:
+            return self.io.bulk_out(data, timeout=timeout)
         return self.ep_out.write(data, timeout=timeout)
 
     def _bulk_in(self, size=None, timeout=500):
         self._ensure_open()
         if size is None:
             size = self.BULK_PACKET_SIZE
+        if self.io is not None:
+            data = self.io.bulk_in(size, timeout=timeout)
+            if data is None:
+                self._log("bulk IN 타임아웃")
+            else:
+                self._log(f"bulk IN ({len(data)} bytes): {data[:16].hex(' ')} ...")
+            return data
         try:
             data = bytes(self.ep_in.read(size, timeout=timeout))
             self._log(f"bulk IN ({len(data)} bytes): {data[:16].hex(' ')} ...")
@@ -169,6 +243,14 @@ class Samsung730B:
     def _init_sensor(self):
         """센서 초기화 루틴 : Windows 초기화시퀀스 그대로 재현함"""
 
+        if self.native is not None:
+            self._log("init (_s730b)")
+            try:
+                self.native.init()
+            except _s730b.Error as e:
+                raise Samsung730BError(f"센서 초기화 실패: {e}") from e
+            return
+
         # 1) control 0xC3 초기 설정
         ctrl_data = bytes([
             0x80, 0x84, 0x1e, 0x00,
@@ -284,6 +366,16 @@ class Samsung730B:
             raise Samsung730BError(f"캡처 가능 상태가 아님: {self.state}")
 
         self.state = SensorState.CAPTURING
+
+        if self.native is not None:
+            try:
+                return self.native.detect(max_packets)
+            except _s730b.Error as e:
+                self._log(f"detect 실패: {e}")
+                return b""
+            finally:
+                self.state = SensorState.IDLE
+
         image_data = bytearray()
 
         # ---------- packet 0 : 상태 응답 ----------
@@ -352,11 +444,36 @@ class Samsung730B:
 
     # ---------- 캡처 ----------
 
-    def capture(self):
+    def capture(self, ignore_flags=0):
+        """
+        ignore_flags: native에서 못 본 척할 프레임 검사 bit (예: sim으로 같은 raw 돌릴 때 FRAME_DUPLICATE)
+        """
         if self.state not in (SensorState.IDLE, SensorState.AWAIT_FINGER):
             raise Samsung730BError(f"캡처 가능 상태가 아님: {self.state}")
 
         self.state = SensorState.CAPTURING
+
+        if self.native is not None:
+            # 84 packet 전부 C에서 (짧은 chunk / timeout이면 init부터 다시, 최대 4번)
+            # 프레임 검사 걸리면 C capture_fingerprint처럼 버리고 다시 찍음
+            try:
+                for attempt in range(self.CAPTURE_MAX_RETRY):
+                    data = self.native.capture()
+                    bad = self.native.frame_flags & ~ignore_flags
+                    self._log(f"capture (_s730b): {len(data)} bytes, {self.native.stats()}")
+                    if not bad:
+                        break
+                    print(f"[-] 프레임 버림 ({attempt + 1}/{self.CAPTURE_MAX_RETRY}): {frame_flags_str(bad)}")
+                else:
+                    raise CaptureError(f"[-] 캡처 실패: {self.CAPTURE_MAX_RETRY}번 다 프레임 검사 걸림 ({frame_flags_str(bad)})")
+            except _s730b.Error as e:
+                raise CaptureError(f"[-] 캡처 실패: {e}") from e
+            finally:
+                self.state = SensorState.IDLE
+            if len(data) == 0:
+                raise CaptureError("[-] 캡처된 데이터가 비어 있음")
+            return data
+
         image_data = bytearray()
 
         # ---------- 1) packet 0 : 상태 응답만 처리 ----------
@@ -465,6 +582,79 @@ def convert_raw_to_png(path, prefix="from_c", offset=180, width=112, height=96,
     img.save(out)
     print("saved", out)
 
+# ---------- 벤치 (pyusb vs _s730b) ----------
+
+def bench_capture(n, sim=None, sim_scale=0.0):
+    """
+    캡처 n번 지연: 파이썬 transfer 경로 (장치면 pyusb, sim이면 같은 코드가 _s730b transfer 하나씩) vs _s730b.capture
+    - 혼자 한 번, 다른 파이썬 스레드가 계속 돌고 있을 때 (경쟁) 한 번
+      (transfer마다 GIL 놓았다 다시 잡으면 그때마다 switch interval 5ms까지 밀림, _s730b는 캡처당 한 번)
+    """
+    import statistics
+    import threading
+
+    def run(scanner, busy):
+        ticks = [0]
+        stop = threading.Event()
+
+        def spin():
+            while not stop.is_set():
+                ticks[0] += 1
+
+        th = threading.Thread(target=spin, daemon=True) if busy else None
+        if th:
+            th.start()
+        lat = []
+        t_all = time.perf_counter()
+        for _ in range(n):
+            t0 = time.perf_counter()
+            data = scanner.capture(ignore_flags)
+            lat.append((time.perf_counter() - t0) * 1e3)
+        t_all = time.perf_counter() - t_all
+        if th:
+            stop.set()
+            th.join()
+        lat.sort()
+        p99 = lat[min(len(lat) - 1, int(len(lat) * 0.99))]
+        return statistics.median(lat), p99, lat[-1], len(data), ticks[0] / t_all
+
+    # sim은 같은 raw를 돌려 쓰니까 중복 프레임은 당연함
+    ignore_flags = _s730b.FRAME_DUPLICATE if sim and HAS_NATIVE else 0
+    modes = [("pyusb" if not sim else "python", False), ("_s730b", True)]
+    results = {}
+    for name, native in modes:
+        if not native and not sim and not HAS_PYUSB:
+            print(f"[-] {name}: pyusb 없음, 건너뜀")
+            continue
+        if (native or sim) and not HAS_NATIVE:
+            print(f"[-] {name}: _s730b 없음, 건너뜀")
+            continue
+
+        scanner = Samsung730B(native=native, sim=sim, sim_scale=sim_scale)
+        try:
+            scanner.open()
+            first = scanner.capture(ignore_flags)      # 첫 캡처는 뺌 (import / 캐시)
+            idle = run(scanner, False)
+            busy = run(scanner, True)
+        except Samsung730BError as e:
+            print(f"[-] {name}: {e}")
+            continue
+        finally:
+            scanner.close()
+
+        results[name] = (idle[0], busy[0], first)
+        for what, r in (("혼자", idle), ("경쟁", busy)):
+            extra = f", 다른 스레드 {r[4] / 1e3:.0f} k/s" if what == "경쟁" else ""
+            print(f"[*] {name:7s} {what} 캡처 {n}번: p50 {r[0]:8.3f} ms, p99 {r[1]:8.3f} ms, "
+                  f"max {r[2]:8.3f} ms, {r[3]} bytes{extra}")
+
+    if len(results) == 2:
+        (a_idle, a_busy, fa), (b_idle, b_busy, fb) = results.values()
+        print(f"[*] _s730b p50: 혼자 {a_idle / b_idle:.1f}배, 경쟁 {a_busy / b_busy:.1f}배 빠름, "
+              f"프레임 {'같음' if fa == fb else '다름'}")
+    return 0
+
+
 # ---------- CLI ----------
 
 def parse_args():
@@ -483,6 +673,22 @@ def parse_args():
         "--prefix", type=str, default=None,
         help="저장될 파일이름 prefix지정 (기본: timestamp)"
     )
+    p.add_argument(
+        "--no-native", action="store_true",
+        help="_s730b 확장 있어도 pyusb로"
+    )
+    p.add_argument(
+        "--bench", type=int, default=0, metavar="N",
+        help="캡처 N번 지연 비교 (pyusb vs _s730b) 후 종료"
+    )
+    p.add_argument(
+        "--sim", nargs="+", default=None, metavar="RAW",
+        help="장치 대신 센서 모델 (_s730b 필요, raw 파일들을 프레임으로)"
+    )
+    p.add_argument(
+        "--sim-scale", type=float, default=0.0,
+        help="센서 모델 transfer 시간 배율 (0 = 안 기다림, 1 = 트레이스 시간 그대로)"
+    )
     return p.parse_args()
 
 
@@ -494,10 +700,17 @@ def main():
     print("=" * 50)
     print()
 
+    if args.bench:
+        return bench_capture(args.bench, sim=args.sim, sim_scale=args.sim_scale)
+
+    dev_args = dict(debug=args.debug, native=False if args.no_native else None,
+                    sim=args.sim, sim_scale=args.sim_scale)
+
     # 1) detect 전용 인스턴스
-    detector = Samsung730B(debug=args.debug)
+    detector = None
 
     try:
+        detector = Samsung730B(**dev_args)
         detector.open()
         print("[+] 드라이버 초기화 완료\n")
 
@@ -515,10 +728,11 @@ def main():
         print(f"\n[예상치 못한 오류 - detect 단계] {e}")
         return 1
     finally:
-        detector.close()
+        if detector:
+            detector.close()
 
     # 2) capture 전용 인스턴스
-    scanner = Samsung730B(debug=args.debug)
+    scanner = Samsung730B(**dev_args)
 
     try:
         # 2-1) 장치 새로 열기 + 초기화